@@ -11,6 +11,10 @@ struct _ClipiumApp {
     ClipiumWatcher  *watcher;
     ClipiumPaster   *paster;
     ClipiumWindow   *window;
+    guint            compress_source;
+    guint            expire_source;
+    GThread         *compress_thread;
+    gint             compress_running; /* atomic */
 };
 
 G_DEFINE_TYPE(ClipiumApp, clipium_app, ADW_TYPE_APPLICATION)
@@ -33,6 +37,66 @@ on_ipc_show(gpointer user_data)
     g_idle_add(show_window_idle, user_data);
 }
 
+/* --- Content loader for metadata-only entries (any thread) --- */
+
+static GBytes *
+load_content_from_db(guint64 id, gpointer user_data)
+{
+    return clipium_db_load_content(user_data, id);
+}
+
+/* --- Archive tier: evicted entries, searched in the database --- */
+
+static void
+search_archive_in_db(const char *query, guint limit, GArray *results, gpointer user_data)
+{
+    clipium_db_search_archive(user_data, query, limit, results);
+}
+
+/* --- Compression tier: periodic pass on a worker thread --- */
+
+static gpointer
+compress_thread_func(gpointer user_data)
+{
+    ClipiumApp *self = user_data;
+    guint n = clipium_store_compress_cold(self->store, CLIPIUM_COMPRESS_MIN_BYTES,
+                                          (gint64)CLIPIUM_COMPRESS_IDLE_S * G_USEC_PER_SEC);
+    if (n > 0)
+        g_debug("Compressed %u cold entries", n);
+    g_atomic_int_set(&self->compress_running, 0);
+    return NULL;
+}
+
+static gboolean
+compress_tick(gpointer user_data)
+{
+    ClipiumApp *self = CLIPIUM_APP(user_data);
+
+    /* Skip this tick if the previous pass is still going */
+    if (!g_atomic_int_compare_and_exchange(&self->compress_running, 0, 1))
+        return G_SOURCE_CONTINUE;
+    if (self->compress_thread)
+        g_thread_join(self->compress_thread);
+    self->compress_thread = g_thread_new("clipium-compress", compress_thread_func, self);
+    return G_SOURCE_CONTINUE;
+}
+
+/* --- TTL expiry: advance the store's timer wheel on the main loop --- */
+
+static gboolean
+expire_tick(gpointer user_data)
+{
+    ClipiumApp *self = CLIPIUM_APP(user_data);
+
+    guint n = clipium_store_expire(self->store, g_get_real_time());
+    if (n > 0) {
+        if (self->db)
+            clipium_db_persist(self->db, self->store);
+        g_debug("Expired %u entries", n);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
 /* --- Actions --- */
 
 static void
@@ -75,13 +139,45 @@ clipium_app_startup(GApplication *app)
 
     /* Initialize store */
     self->store = clipium_store_new(CLIPIUM_MAX_ENTRIES);
+    clipium_store_set_max_bytes(self->store, clipium_max_bytes());
+
+    ClipiumEvictKind evict_kind;
+    if (clipium_evict_kind_from_string(clipium_evict_policy_name(), &evict_kind))
+        clipium_store_set_evict_policy(self->store, evict_kind);
+    else
+        g_warning("Unknown eviction policy '%s', using %s",
+                  clipium_evict_policy_name(), CLIPIUM_EVICT_POLICY);
+
+    if (!clipium_store_set_ttl_rules(self->store, clipium_ttl_rules())) {
+        g_warning("Invalid TTL rules '%s', nothing will expire", clipium_ttl_rules());
+        clipium_store_set_ttl_rules(self->store, CLIPIUM_TTL_RULES);
+    }
+    clipium_store_set_typo_edits(self->store, clipium_typo_edits());
 
     /* Open database and load entries */
     g_autofree char *db_path = clipium_db_path();
     self->db = clipium_db_open(db_path);
     if (self->db) {
         clipium_db_init(self->db);
-        clipium_db_load_all(self->db, self->store);
+        /* Archived entries are read on demand whether or not content is lazy */
+        clipium_store_set_content_loader(self->store, load_content_from_db, self->db);
+        clipium_store_set_archive(self->store, search_archive_in_db, self->db);
+
+        /* Trim what an earlier run, or a larger cap, left behind before
+         * loading, so only what the store keeps is read */
+        clipium_db_set_history(self->db, clipium_history_size());
+        guint trimmed = clipium_db_compact(self->db, CLIPIUM_MAX_ENTRIES);
+        if (trimmed > 0)
+            g_message("Archived or dropped %u database rows", trimmed);
+
+        if (clipium_lazy_content()) {
+            clipium_db_load_metadata(self->db, self->store);
+        } else {
+            clipium_db_load_all(self->db, self->store);
+        }
+
+        /* From here on every store change is mirrored to the database */
+        clipium_store_set_journal(self->store, TRUE);
     }
 
     /* Start IPC server */
@@ -92,6 +188,13 @@ clipium_app_startup(GApplication *app)
     /* Start clipboard watcher */
     self->watcher = clipium_watcher_start(self->store, self->db);
 
+    self->compress_source = g_timeout_add_seconds(CLIPIUM_COMPRESS_INTERVAL_S,
+                                                  compress_tick, self);
+
+    /* Drop whatever expired while the daemon was not running right away */
+    expire_tick(self);
+    self->expire_source = g_timeout_add_seconds(CLIPIUM_TTL_INTERVAL_S, expire_tick, self);
+
     /* Initialize paster */
     self->paster = clipium_paster_new();
 
@@ -129,9 +232,21 @@ clipium_app_shutdown(GApplication *app)
 {
     ClipiumApp *self = CLIPIUM_APP(app);
 
+    g_clear_handle_id(&self->compress_source, g_source_remove);
+    g_clear_handle_id(&self->expire_source, g_source_remove);
+    if (self->compress_thread)
+        g_thread_join(self->compress_thread);
+    self->compress_thread = NULL;
+
     clipium_watcher_stop(self->watcher);
     clipium_ipc_server_stop(self->ipc);
     clipium_paster_free(self->paster);
+    clipium_store_set_content_loader(self->store, NULL, NULL);
+    clipium_store_set_archive(self->store, NULL, NULL);
+    if (self->db)
+        clipium_db_persist(self->db, self->store);
+    if (self->db && !clipium_db_flush(self->db, CLIPIUM_DB_FLUSH_TIMEOUT_MS * 1000))
+        g_warning("Database writes still pending after %d ms", CLIPIUM_DB_FLUSH_TIMEOUT_MS);
     clipium_db_close(self->db);
     clipium_store_free(self->store);
 
@@ -0,0 +1,190 @@
+#include "clipium-attrs.h"
+#include "clipium-query.h"
+
+/* What a slot is indexed under; also the key of its node in by_time */
+typedef struct {
+    guint        slot;
+    const char  *mime_type;
+    gboolean     pinned;
+    gint64       timestamp;
+} AttrRecord;
+
+struct _ClipiumAttrIndex {
+    GHashTable *by_mime;   /* interned mime type → GHashTable set of slots */
+    GHashTable *pinned;    /* set of slots */
+    GTree      *by_time;   /* AttrRecord* by (timestamp, slot) */
+    GPtrArray  *records;   /* AttrRecord*, indexed by slot, or NULL */
+};
+
+#define SLOT_KEY(slot) GUINT_TO_POINTER(slot)
+
+static gint
+record_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const AttrRecord *x = a, *y = b;
+    if (x->timestamp != y->timestamp)
+        return (x->timestamp > y->timestamp) - (x->timestamp < y->timestamp);
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+/* --- Public API --- */
+
+ClipiumAttrIndex *
+clipium_attr_index_new(void)
+{
+    ClipiumAttrIndex *index = g_new0(ClipiumAttrIndex, 1);
+    index->by_mime = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                           (GDestroyNotify)g_hash_table_unref);
+    index->pinned = g_hash_table_new(g_direct_hash, g_direct_equal);
+    index->by_time = g_tree_new_full(record_compare, NULL, NULL, NULL);
+    index->records = g_ptr_array_new_with_free_func(g_free);
+    return index;
+}
+
+void
+clipium_attr_index_free(ClipiumAttrIndex *index)
+{
+    if (!index) return;
+    g_hash_table_destroy(index->by_mime);
+    g_hash_table_destroy(index->pinned);
+    g_tree_destroy(index->by_time);
+    g_ptr_array_unref(index->records);
+    g_free(index);
+}
+
+void
+clipium_attr_index_clear(ClipiumAttrIndex *index)
+{
+    g_hash_table_remove_all(index->by_mime);
+    g_hash_table_remove_all(index->pinned);
+    g_tree_remove_all(index->by_time);
+    g_ptr_array_set_size(index->records, 0);
+}
+
+void
+clipium_attr_index_insert(ClipiumAttrIndex *index,
+                          guint             slot,
+                          const char       *mime_type,
+                          gboolean          pinned,
+                          gint64            timestamp)
+{
+    clipium_attr_index_remove(index, slot);
+
+    AttrRecord *record = g_new(AttrRecord, 1);
+    record->slot = slot;
+    record->mime_type = mime_type;
+    record->pinned = pinned;
+    record->timestamp = timestamp;
+    if (slot >= index->records->len)
+        g_ptr_array_set_size(index->records, slot + 1);
+    g_ptr_array_index(index->records, slot) = record;
+
+    GHashTable *set = g_hash_table_lookup(index->by_mime, mime_type);
+    if (!set) {
+        set = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(index->by_mime, (gpointer)mime_type, set);
+    }
+    g_hash_table_add(set, SLOT_KEY(slot));
+    if (pinned)
+        g_hash_table_add(index->pinned, SLOT_KEY(slot));
+    g_tree_insert(index->by_time, record, record);
+}
+
+void
+clipium_attr_index_remove(ClipiumAttrIndex *index, guint slot)
+{
+    if (slot >= index->records->len || !g_ptr_array_index(index->records, slot))
+        return;
+
+    AttrRecord *record = g_ptr_array_index(index->records, slot);
+    GHashTable *set = g_hash_table_lookup(index->by_mime, record->mime_type);
+    g_hash_table_remove(set, SLOT_KEY(slot));
+    if (g_hash_table_size(set) == 0)
+        g_hash_table_remove(index->by_mime, record->mime_type);
+    g_hash_table_remove(index->pinned, SLOT_KEY(slot));
+    g_tree_remove(index->by_time, record);
+
+    g_free(record);
+    g_ptr_array_index(index->records, slot) = NULL;
+}
+
+/* Distinct mime types are few, so matching the pattern against each is
+ * cheap next to touching the slots */
+guint
+clipium_attr_index_count_mime(ClipiumAttrIndex *index, const char *pattern)
+{
+    guint count = 0;
+    GHashTableIter iter;
+    gpointer mime, set;
+    g_hash_table_iter_init(&iter, index->by_mime);
+    while (g_hash_table_iter_next(&iter, &mime, &set)) {
+        if (clipium_mime_matches(pattern, mime))
+            count += g_hash_table_size(set);
+    }
+    return count;
+}
+
+guint
+clipium_attr_index_mime(ClipiumAttrIndex *index, const char *pattern, GArray *slots)
+{
+    guint before = slots->len;
+    GHashTableIter iter, set_iter;
+    gpointer mime, set, slot;
+    g_hash_table_iter_init(&iter, index->by_mime);
+    while (g_hash_table_iter_next(&iter, &mime, &set)) {
+        if (!clipium_mime_matches(pattern, mime))
+            continue;
+        g_hash_table_iter_init(&set_iter, set);
+        while (g_hash_table_iter_next(&set_iter, &slot, NULL)) {
+            guint s = GPOINTER_TO_UINT(slot);
+            g_array_append_val(slots, s);
+        }
+    }
+    return slots->len - before;
+}
+
+guint
+clipium_attr_index_count_pinned(ClipiumAttrIndex *index)
+{
+    return g_hash_table_size(index->pinned);
+}
+
+guint
+clipium_attr_index_pinned(ClipiumAttrIndex *index, GArray *slots)
+{
+    guint before = slots->len;
+    GHashTableIter iter;
+    gpointer slot;
+    g_hash_table_iter_init(&iter, index->pinned);
+    while (g_hash_table_iter_next(&iter, &slot, NULL)) {
+        guint s = GPOINTER_TO_UINT(slot);
+        g_array_append_val(slots, s);
+    }
+    return slots->len - before;
+}
+
+/* The tree does not keep subtree sizes, so this walks the range, but never
+ * past the size of whatever index it competes with */
+guint
+clipium_attr_index_count_since(ClipiumAttrIndex *index, gint64 since, guint cap)
+{
+    guint count = 0;
+    AttrRecord probe = { .slot = 0, .timestamp = since };
+    for (GTreeNode *node = g_tree_lower_bound(index->by_time, &probe); node && count < cap;
+         node = g_tree_node_next(node))
+        count++;
+    return count;
+}
+
+guint
+clipium_attr_index_since(ClipiumAttrIndex *index, gint64 since, GArray *slots)
+{
+    guint before = slots->len;
+    AttrRecord probe = { .slot = 0, .timestamp = since };
+    for (GTreeNode *node = g_tree_lower_bound(index->by_time, &probe); node;
+         node = g_tree_node_next(node)) {
+        const AttrRecord *record = g_tree_node_key(node);
+        g_array_append_val(slots, record->slot);
+    }
+    return slots->len - before;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Secondary indexes over the attributes structured queries filter on,
+ * keyed by store slot: a slot set per mime type, the set of pinned slots
+ * and a search tree ordered by timestamp. Each slot also remembers what
+ * it was indexed under, so removal needs nothing but the slot. */
+typedef struct _ClipiumAttrIndex ClipiumAttrIndex;
+
+ClipiumAttrIndex *clipium_attr_index_new   (void);
+void              clipium_attr_index_free  (ClipiumAttrIndex *index);
+void              clipium_attr_index_clear (ClipiumAttrIndex *index);
+
+/* Index `slot`, replacing whatever it had. `mime_type` must be interned. */
+void              clipium_attr_index_insert(ClipiumAttrIndex *index,
+                                            guint             slot,
+                                            const char       *mime_type,
+                                            gboolean          pinned,
+                                            gint64            timestamp);
+void              clipium_attr_index_remove(ClipiumAttrIndex *index, guint slot);
+
+/* Lookups append matching slots (guint) to `slots` and return how many.
+ * The counts let a caller start from the most selective index. */
+guint             clipium_attr_index_count_mime (ClipiumAttrIndex *index, const char *pattern);
+guint             clipium_attr_index_mime       (ClipiumAttrIndex *index,
+                                                 const char       *pattern,
+                                                 GArray           *slots);
+guint             clipium_attr_index_count_pinned(ClipiumAttrIndex *index);
+guint             clipium_attr_index_pinned     (ClipiumAttrIndex *index, GArray *slots);
+
+/* How many slots have a timestamp at or after `since`, counting no
+ * further than `cap` */
+guint             clipium_attr_index_count_since(ClipiumAttrIndex *index,
+                                                 gint64            since,
+                                                 guint             cap);
+
+/* Slots with a timestamp at or after `since`, oldest first */
+guint             clipium_attr_index_since      (ClipiumAttrIndex *index,
+                                                 gint64            since,
+                                                 GArray           *slots);
+
+G_END_DECLS
@@ -5,6 +5,8 @@
 #define CLIPIUM_APP_ID       "io.github.clipium"
 #define CLIPIUM_VERSION      "0.1.0"
 #define CLIPIUM_MAX_ENTRIES  1000
+#define CLIPIUM_MAX_BYTES    (256 * 1024 * 1024)  /* default content memory budget */
+#define CLIPIUM_HISTORY_MAX  10000  /* database rows, live and archived */
 #define CLIPIUM_PREVIEW_LEN  100
 #define CLIPIUM_CARD_WIDTH   450
 #define CLIPIUM_CARD_HEIGHT  500
@@ -26,6 +28,142 @@
 #define CLIPIUM_KEY_LEFTCTRL  29
 #define CLIPIUM_KEY_V         47
 
+/* Eviction: how many of the oldest unpinned entries to weigh by size × age
+ * when the memory budget is exceeded */
+#define CLIPIUM_EVICT_WINDOW 16
+
+/* Database writes queue up for the writer thread, at most
+ * CLIPIUM_DB_QUEUE_MAX at a time, and commit CLIPIUM_DB_BATCH_MAX to a
+ * transaction. Shutdown waits CLIPIUM_DB_FLUSH_TIMEOUT_MS for the queue to
+ * drain. */
+#define CLIPIUM_DB_QUEUE_MAX        4096
+#define CLIPIUM_DB_BATCH_MAX        512
+#define CLIPIUM_DB_FLUSH_TIMEOUT_MS 2000
+
+/* A metadata-only load indexes text rows in the background,
+ * CLIPIUM_DB_INDEX_CHUNK per hold of the connection */
+#define CLIPIUM_DB_INDEX_CHUNK      64
+
+/* Full-text search indexes at most this much of each text entry, which
+ * bounds what the resident indexes cost per entry (see `status`). A hit
+ * the preview does not explain is confirmed against the content; a search
+ * reads at most CLIPIUM_SEARCH_CONFIRM_MAX entries that are not in memory
+ * to do so, and a result that needed more is partial. */
+#define CLIPIUM_INDEX_MAX_BYTES    (64 * 1024)
+#define CLIPIUM_SEARCH_CONFIRM_MAX 32
+
+/* Preview scans of at least CLIPIUM_SEARCH_PARALLEL_MIN rows are split into
+ * chunks of CLIPIUM_SEARCH_CHUNK and scored on a worker pool */
+#define CLIPIUM_SEARCH_PARALLEL_MIN 8192
+#define CLIPIUM_SEARCH_CHUNK        2048
+
+/* Progressive searches (popup, streaming IPC) scan previews in slices of
+ * CLIPIUM_SEARCH_SLICE rows, report the best matches so far after
+ * CLIPIUM_SEARCH_FIRST_MS and then every CLIPIUM_SEARCH_REFINE_MS, and
+ * settle for what they have after CLIPIUM_SEARCH_BUDGET_MS */
+#define CLIPIUM_SEARCH_SLICE       16384
+#define CLIPIUM_SEARCH_FIRST_MS    8
+#define CLIPIUM_SEARCH_REFINE_MS   40
+#define CLIPIUM_SEARCH_BUDGET_MS   500
+
+/* Recent search results kept per store generation */
+#define CLIPIUM_SEARCH_CACHE_SIZE 32
+
+/* Literal and regex searches scan full content in chunks of
+ * CLIPIUM_GREP_CHUNK entries and return what they found after
+ * CLIPIUM_GREP_BUDGET_MS. Regexes see the first CLIPIUM_GREP_REGEX_MAX_BYTES
+ * of each entry, which with PCRE's own match limit bounds a single match.
+ * The last CLIPIUM_REGEX_CACHE_SIZE patterns stay compiled. */
+#define CLIPIUM_GREP_CHUNK           64
+#define CLIPIUM_GREP_BUDGET_MS       250
+#define CLIPIUM_GREP_REGEX_MAX_BYTES (256 * 1024)
+#define CLIPIUM_REGEX_CACHE_SIZE     16
+
+/* Typo-tolerant search: when fuzzy matching finds fewer results than asked
+ * for, text entries with words within a few edits of every query word fill
+ * the rest. CLIPIUM_TYPOS sets the most edits per word (1 or 2); off unless
+ * set. */
+static inline guint
+clipium_typo_edits(void)
+{
+    const char *edits = g_getenv("CLIPIUM_TYPOS");
+    return (edits && *edits) ? (guint)MIN(g_ascii_strtoull(edits, NULL, 10), 2) : 0;
+}
+
+/* Frecency: each copy, paste and fetch of an entry counts one, halving
+ * every CLIPIUM_FRECENCY_HALF_LIFE_S. Search adds
+ * CLIPIUM_FRECENCY_WEIGHT × ln(1 + frecency) to an entry's match score. */
+#define CLIPIUM_FRECENCY_HALF_LIFE_S (3 * 24 * 60 * 60)
+#define CLIPIUM_FRECENCY_WEIGHT      8
+
+/* Content cache for entries loaded metadata-only from the database */
+#define CLIPIUM_CONTENT_CACHE_BYTES (32 * 1024 * 1024)
+
+/* Keep only metadata resident at startup and read content on demand.
+ * Set CLIPIUM_LAZY_CONTENT=0 to load every blob up front. */
+static inline gboolean
+clipium_lazy_content(void)
+{
+    const char *lazy = g_getenv("CLIPIUM_LAZY_CONTENT");
+    return !(lazy && g_str_equal(lazy, "0"));
+}
+
+/* Compression tier: text entries of at least CLIPIUM_COMPRESS_MIN_BYTES that
+ * have not been used for CLIPIUM_COMPRESS_IDLE_S are zlib-compressed in
+ * memory by a pass that runs every CLIPIUM_COMPRESS_INTERVAL_S */
+#define CLIPIUM_COMPRESS_MIN_BYTES  (64 * 1024)
+#define CLIPIUM_COMPRESS_IDLE_S     600
+#define CLIPIUM_COMPRESS_INTERVAL_S 60
+
+/* Time-to-live rules (see clipium_store_set_ttl_rules). None by default:
+ * expiry deletes history, so it is opt-in through CLIPIUM_TTL, e.g.
+ * "text/plain=30d". Expiry runs off a timer wheel with
+ * CLIPIUM_TTL_TICK_USEC resolution, advanced from the main loop every
+ * CLIPIUM_TTL_INTERVAL_S. */
+#define CLIPIUM_TTL_RULES      ""
+#define CLIPIUM_TTL_TICK_USEC  G_USEC_PER_SEC
+#define CLIPIUM_TTL_INTERVAL_S 30
+
+static inline const char *
+clipium_ttl_rules(void)
+{
+    const char *rules = g_getenv("CLIPIUM_TTL");
+    return rules ? rules : CLIPIUM_TTL_RULES;
+}
+
+/* Eviction policy name, overridable with CLIPIUM_EVICT_POLICY
+ * (fifo, lru, lfu or arc) */
+#define CLIPIUM_EVICT_POLICY "lru"
+
+static inline const char *
+clipium_evict_policy_name(void)
+{
+    const char *name = g_getenv("CLIPIUM_EVICT_POLICY");
+    return (name && *name) ? name : CLIPIUM_EVICT_POLICY;
+}
+
+/* Memory budget in bytes, overridable with CLIPIUM_MAX_MB (0 = unlimited) */
+static inline gsize
+clipium_max_bytes(void)
+{
+    const char *mb = g_getenv("CLIPIUM_MAX_MB");
+    if (mb && *mb)
+        return (gsize)g_ascii_strtoull(mb, NULL, 10) * 1024 * 1024;
+    return CLIPIUM_MAX_BYTES;
+}
+
+/* Rows the database keeps, live and archived, overridable with
+ * CLIPIUM_HISTORY (0 = unlimited). The archive gives up its oldest rows to
+ * stay within it. */
+static inline guint
+clipium_history_size(void)
+{
+    const char *rows = g_getenv("CLIPIUM_HISTORY");
+    if (rows && *rows)
+        return (guint)MIN(g_ascii_strtoull(rows, NULL, 10), G_MAXUINT);
+    return CLIPIUM_HISTORY_MAX;
+}
+
 /* Helper to get XDG paths */
 static inline const char *
 clipium_runtime_dir(void)
@@ -2,6 +2,144 @@
 #include "clipium-config.h"
 #include <string.h>
 
+/* PRAGMA user_version. 0: hex SHA-256 TEXT hashes, 1: 16-byte BLOB hashes,
+ * 2: usage columns (see ClipiumUsage), 3: archived column */
+#define DB_SCHEMA_VERSION 3
+
+#define CLIPS_TABLE_SQL(name)                 \
+    "CREATE TABLE IF NOT EXISTS " name " ("   \
+    "  id INTEGER PRIMARY KEY,"               \
+    "  content BLOB NOT NULL,"                \
+    "  mime_type TEXT NOT NULL,"              \
+    "  hash BLOB UNIQUE NOT NULL,"            \
+    "  preview TEXT,"                         \
+    "  timestamp INTEGER NOT NULL,"           \
+    "  pinned INTEGER DEFAULT 0,"             \
+    "  size INTEGER NOT NULL,"                \
+    "  uses INTEGER NOT NULL DEFAULT 0,"      \
+    "  last_used INTEGER NOT NULL DEFAULT 0," \
+    "  frecency REAL NOT NULL DEFAULT 0,"     \
+    "  archived INTEGER NOT NULL DEFAULT 0"   \
+    ");"
+
+/* Entries evicted from the store stay in clips with `archived` set. The
+ * text of archived text entries is indexed in clips_fts, which the
+ * triggers keep in step with clips. It holds no copy of the text
+ * (content=''), so a delete hands it the same text back, and the trigram
+ * tokenizer matches substrings of three or more characters, like the
+ * store's own index. */
+#define ARCHIVE_TEXT(row) \
+    "CAST(substr(" row ".content, 1, " G_STRINGIFY(CLIPIUM_INDEX_MAX_BYTES) ") AS TEXT)"
+
+#define ARCHIVE_INDEX_SQL                                                             \
+    "CREATE VIRTUAL TABLE IF NOT EXISTS clips_fts USING fts5("                        \
+    "  body, content='', tokenize='trigram');"                                        \
+    "CREATE TRIGGER IF NOT EXISTS clips_fts_insert AFTER INSERT ON clips "            \
+    "WHEN new.archived AND new.mime_type LIKE 'text/%' BEGIN "                        \
+    "  INSERT INTO clips_fts (rowid, body) VALUES (new.id, " ARCHIVE_TEXT("new") ");" \
+    "END;"                                                                            \
+    "CREATE TRIGGER IF NOT EXISTS clips_fts_archive AFTER UPDATE OF archived ON clips " \
+    "WHEN new.archived AND NOT old.archived AND new.mime_type LIKE 'text/%' BEGIN "   \
+    "  INSERT INTO clips_fts (rowid, body) VALUES (new.id, " ARCHIVE_TEXT("new") ");" \
+    "END;"                                                                            \
+    "CREATE TRIGGER IF NOT EXISTS clips_fts_unarchive AFTER UPDATE OF archived ON clips " \
+    "WHEN old.archived AND NOT new.archived AND old.mime_type LIKE 'text/%' BEGIN "   \
+    "  INSERT INTO clips_fts (clips_fts, rowid, body) "                               \
+    "  VALUES ('delete', old.id, " ARCHIVE_TEXT("old") ");"                           \
+    "END;"                                                                            \
+    "CREATE TRIGGER IF NOT EXISTS clips_fts_delete AFTER DELETE ON clips "            \
+    "WHEN old.archived AND old.mime_type LIKE 'text/%' BEGIN "                        \
+    "  INSERT INTO clips_fts (clips_fts, rowid, body) "                               \
+    "  VALUES ('delete', old.id, " ARCHIVE_TEXT("old") ");"                           \
+    "END;"
+
+/* What the archive hands back: enough to list an entry, not its content */
+#define ARCHIVE_ENTRY_COLUMNS "c.id, c.mime_type, c.hash, c.preview, c.timestamp, c.pinned, c.size"
+
+/* --- Statement cache --- */
+
+/* Statements run over and over are prepared once and kept for the life of
+ * the connection */
+typedef enum {
+    DB_STMT_SAVE,
+    DB_STMT_DELETE,
+    DB_STMT_PIN,
+    DB_STMT_USAGE,
+    DB_STMT_ARCHIVE,
+    DB_STMT_BUMP,
+    DB_STMT_RETAIN_LIVE,
+    DB_STMT_RETAIN_ARCHIVE,
+    DB_STMT_CONTENT,
+    DB_STMT_ARCHIVE_SEARCH,
+    DB_STMT_ARCHIVED,
+    DB_N_STMTS
+} DbStmt;
+
+static const char *const db_stmt_sql[DB_N_STMTS] = {
+    [DB_STMT_SAVE] = "INSERT OR REPLACE INTO clips "
+                     "(id, content, mime_type, hash, preview, timestamp, pinned, size) "
+                     "VALUES (?, ?, ?, ?, ?, ?, ?, ?);",
+    [DB_STMT_DELETE] = "DELETE FROM clips WHERE id = ?;",
+    [DB_STMT_PIN] = "UPDATE clips SET pinned = ? WHERE id = ?;",
+    [DB_STMT_USAGE] = "UPDATE clips SET uses = ?, last_used = ?, frecency = ? WHERE id = ?;",
+    [DB_STMT_ARCHIVE] = "UPDATE clips SET archived = 1 WHERE id = ?;",
+    [DB_STMT_BUMP] = "UPDATE clips SET timestamp = ?, uses = ?, last_used = ?, frecency = ? "
+                     "WHERE id = ?;",
+    /* Archive the oldest unpinned live rows beyond what the store keeps:
+     * it keeps ?1 entries, pinned ones included */
+    [DB_STMT_RETAIN_LIVE] = "UPDATE clips SET archived = 1 WHERE id IN ("
+                            "  SELECT id FROM clips WHERE archived = 0 AND NOT pinned "
+                            "  ORDER BY timestamp DESC LIMIT -1 OFFSET max(0, ?1 - "
+                            "    (SELECT COUNT(*) FROM clips WHERE archived = 0 AND pinned)));",
+    /* Delete the oldest archived rows while the table holds more than ?1 */
+    [DB_STMT_RETAIN_ARCHIVE] = "DELETE FROM clips WHERE id IN ("
+                               "  SELECT id FROM clips WHERE archived = 1 "
+                               "  ORDER BY timestamp, id "
+                               "  LIMIT max(0, (SELECT COUNT(*) FROM clips) - ?1));",
+    [DB_STMT_CONTENT] = "SELECT content FROM clips WHERE id = ?;",
+    [DB_STMT_ARCHIVE_SEARCH] = "SELECT " ARCHIVE_ENTRY_COLUMNS " FROM clips_fts "
+                               "JOIN clips c ON c.id = clips_fts.rowid "
+                               "WHERE clips_fts MATCH ? AND c.archived = 1 "
+                               "ORDER BY c.timestamp DESC LIMIT ?;",
+    [DB_STMT_ARCHIVED] = "SELECT " ARCHIVE_ENTRY_COLUMNS " FROM clips c "
+                         "WHERE c.id = ? AND c.archived = 1;",
+};
+
+/* Caller holds db->lock, and hands the statement to db_stmt_done */
+static sqlite3_stmt *
+db_stmt(ClipiumDb *db, DbStmt which)
+{
+    if (!db->db)
+        return NULL;
+    if (!db->stmts[which] &&
+        sqlite3_prepare_v3(db->db, db_stmt_sql[which], -1, SQLITE_PREPARE_PERSISTENT,
+                           &db->stmts[which], NULL) != SQLITE_OK) {
+        g_warning("Failed to prepare statement: %s", sqlite3_errmsg(db->db));
+        return NULL;
+    }
+    return db->stmts[which];
+}
+
+static void
+db_stmt_done(sqlite3_stmt *stmt)
+{
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+/* Caller holds db->lock */
+static void
+db_stmts_finalize(ClipiumDb *db)
+{
+    for (guint i = 0; i < DB_N_STMTS; i++)
+        g_clear_pointer(&db->stmts[i], sqlite3_finalize);
+}
+
+static void db_writer_start(ClipiumDb *db);
+static void db_writer_stop (ClipiumDb *db);
+
+/* --- Connection --- */
+
 ClipiumDb *
 clipium_db_open(const char *path)
 {
@@ -19,6 +157,8 @@ clipium_db_open(const char *path)
         return NULL;
     }
 
+    cdb->stmts = g_new0(sqlite3_stmt *, DB_N_STMTS);
+    db_writer_start(cdb);
     return cdb;
 }
 
@@ -26,16 +166,131 @@ void
 clipium_db_close(ClipiumDb *db)
 {
     if (!db) return;
+    g_atomic_int_set(&db->index_stop, TRUE);
+    clipium_db_wait_indexed(db);
+    db_writer_stop(db);
     g_mutex_lock(&db->lock);
+    db_stmts_finalize(db);
     if (db->db)
         sqlite3_close(db->db);
     db->db = NULL;
     g_mutex_unlock(&db->lock);
     g_mutex_clear(&db->lock);
+    g_free(db->stmts);
     g_free(db->path);
     g_free(db);
 }
 
+/* Caller holds db->lock */
+static gint64
+db_query_int(ClipiumDb *db, const char *sql)
+{
+    sqlite3_stmt *stmt;
+    gint64 value = 0;
+    if (sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            value = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+/* Version 1 → 2: the usage columns; existing rows start unused */
+static gboolean
+db_migrate_usage(ClipiumDb *db)
+{
+    char *err = NULL;
+    if (sqlite3_exec(db->db,
+                     "BEGIN;"
+                     "ALTER TABLE clips ADD COLUMN uses INTEGER NOT NULL DEFAULT 0;"
+                     "ALTER TABLE clips ADD COLUMN last_used INTEGER NOT NULL DEFAULT 0;"
+                     "ALTER TABLE clips ADD COLUMN frecency REAL NOT NULL DEFAULT 0;"
+                     "COMMIT;", NULL, NULL, &err) != SQLITE_OK) {
+        g_warning("Usage migration failed: %s", err);
+        sqlite3_free(err);
+        sqlite3_exec(db->db, "ROLLBACK;", NULL, NULL, NULL);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Version 2 → 3: the archived column; every existing row is live */
+static gboolean
+db_migrate_archive(ClipiumDb *db)
+{
+    char *err = NULL;
+    if (sqlite3_exec(db->db, "ALTER TABLE clips ADD COLUMN archived INTEGER NOT NULL DEFAULT 0;",
+                     NULL, NULL, &err) != SQLITE_OK) {
+        g_warning("Archive migration failed: %s", err);
+        sqlite3_free(err);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Version 0 → 1: rebuild clips with binary hashes recomputed from content.
+ * Runs in one transaction; rows are copied newest-first with INSERT OR
+ * IGNORE, so should two contents collide the newest one is kept. */
+static gboolean
+db_migrate_binary_hash(ClipiumDb *db)
+{
+    char *err = NULL;
+    if (sqlite3_exec(db->db, "BEGIN; DROP TABLE IF EXISTS clips_migrate; "
+                     CLIPS_TABLE_SQL("clips_migrate"), NULL, NULL, &err) != SQLITE_OK) {
+        g_warning("Hash migration failed to start: %s", err);
+        sqlite3_free(err);
+        sqlite3_exec(db->db, "ROLLBACK;", NULL, NULL, NULL);
+        return FALSE;
+    }
+
+    sqlite3_stmt *read = NULL, *write = NULL;
+    gboolean ok =
+        sqlite3_prepare_v2(db->db,
+            "SELECT id, content, mime_type, preview, timestamp, pinned, size "
+            "FROM clips ORDER BY timestamp DESC;", -1, &read, NULL) == SQLITE_OK &&
+        sqlite3_prepare_v2(db->db,
+            "INSERT OR IGNORE INTO clips_migrate "
+            "(id, content, mime_type, hash, preview, timestamp, pinned, size) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?);", -1, &write, NULL) == SQLITE_OK;
+
+    guint migrated = 0;
+    while (ok && sqlite3_step(read) == SQLITE_ROW) {
+        const void *blob = sqlite3_column_blob(read, 1);
+        int blob_len = sqlite3_column_bytes(read, 1);
+        ClipiumHash hash;
+        clipium_hash_data(blob, (gsize)blob_len, &hash);
+
+        sqlite3_bind_int64(write, 1, sqlite3_column_int64(read, 0));
+        sqlite3_bind_blob(write, 2, blob, blob_len, SQLITE_TRANSIENT);
+        sqlite3_bind_value(write, 3, sqlite3_column_value(read, 2));
+        sqlite3_bind_blob(write, 4, hash.bytes, CLIPIUM_HASH_LEN, SQLITE_TRANSIENT);
+        sqlite3_bind_value(write, 5, sqlite3_column_value(read, 3));
+        sqlite3_bind_int64(write, 6, sqlite3_column_int64(read, 4));
+        sqlite3_bind_int(write, 7, sqlite3_column_int(read, 5));
+        sqlite3_bind_int64(write, 8, sqlite3_column_int64(read, 6));
+        ok = sqlite3_step(write) == SQLITE_DONE;
+        sqlite3_reset(write);
+        if (ok)
+            migrated++;
+    }
+    sqlite3_finalize(read);
+    sqlite3_finalize(write);
+
+    if (ok)
+        ok = sqlite3_exec(db->db, "DROP TABLE clips; "
+                          "ALTER TABLE clips_migrate RENAME TO clips; COMMIT;",
+                          NULL, NULL, &err) == SQLITE_OK;
+    if (!ok) {
+        g_warning("Hash migration failed: %s", err ? err : sqlite3_errmsg(db->db));
+        sqlite3_free(err);
+        sqlite3_exec(db->db, "ROLLBACK;", NULL, NULL, NULL);
+        return FALSE;
+    }
+
+    g_message("Migrated %u entries to binary content hashes", migrated);
+    return TRUE;
+}
+
 gboolean
 clipium_db_init(ClipiumDb *db)
 {
@@ -48,6 +303,7 @@ clipium_db_init(ClipiumDb *db)
         "PRAGMA synchronous=NORMAL;",
         "PRAGMA cache_size=-8000;",
         "PRAGMA busy_timeout=5000;",
+        "PRAGMA recursive_triggers=ON;",  /* REPLACE fires delete triggers */
         NULL
     };
 
@@ -62,42 +318,71 @@ clipium_db_init(ClipiumDb *db)
         }
     }
 
-    const char *create_sql =
-        "CREATE TABLE IF NOT EXISTS clips ("
-        "  id INTEGER PRIMARY KEY,"
-        "  content BLOB NOT NULL,"
-        "  mime_type TEXT NOT NULL,"
-        "  hash TEXT UNIQUE NOT NULL,"
-        "  preview TEXT,"
-        "  timestamp INTEGER NOT NULL,"
-        "  pinned INTEGER DEFAULT 0,"
-        "  size INTEGER NOT NULL"
-        ");";
+    /* A version-0 database with a clips table still has hex hashes and is
+     * rebuilt with every column; a version-1 one lacks the usage columns
+     * and a version-2 one the archived column */
+    gint64 version = db_query_int(db, "PRAGMA user_version;");
+    gboolean have_clips = db_query_int(db,
+        "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'clips';") > 0;
+
+    gboolean ok = TRUE;
+    if (version < 1 && have_clips) {
+        ok = db_migrate_binary_hash(db);
+    } else if (have_clips) {
+        if (version < 2)
+            ok = db_migrate_usage(db);
+        if (ok && version < 3)
+            ok = db_migrate_archive(db);
+    } else {
+        char *err = NULL;
+        ok = sqlite3_exec(db->db, CLIPS_TABLE_SQL("clips"), NULL, NULL, &err) == SQLITE_OK;
+        if (!ok) {
+            g_warning("CREATE TABLE failed: %s", err);
+            sqlite3_free(err);
+        }
+    }
+
+    if (ok && version < DB_SCHEMA_VERSION)
+        ok = sqlite3_exec(db->db, "PRAGMA user_version = " G_STRINGIFY(DB_SCHEMA_VERSION) ";",
+                          NULL, NULL, NULL) == SQLITE_OK;
 
+    /* Without FTS5 evicted entries are still kept, just not searchable */
     char *err = NULL;
-    int rc = sqlite3_exec(db->db, create_sql, NULL, NULL, &err);
-    if (rc != SQLITE_OK) {
-        g_warning("CREATE TABLE failed: %s", err);
+    db->archive = ok && sqlite3_exec(db->db, ARCHIVE_INDEX_SQL, NULL, NULL, &err) == SQLITE_OK;
+    if (ok && !db->archive) {
+        g_warning("Archive index unavailable: %s", err);
         sqlite3_free(err);
-        g_mutex_unlock(&db->lock);
-        return FALSE;
     }
 
     g_mutex_unlock(&db->lock);
-    return TRUE;
+    return ok;
 }
 
-gboolean
-clipium_db_load_all(ClipiumDb *db, ClipiumStore *store)
+/* Shared by load_all and load_metadata. Without content the blob column is
+ * not even selected, so SQLite never reads the overflow pages holding it. */
+static gboolean
+db_load(ClipiumDb *db, ClipiumStore *store, gboolean with_content)
 {
     g_return_val_if_fail(db != NULL, FALSE);
 
     g_mutex_lock(&db->lock);
 
-    const char *sql = "SELECT id, content, mime_type, hash, preview, timestamp, pinned, size "
-                      "FROM clips ORDER BY timestamp DESC;";
-
+    /* Row count is only a reservation hint for the bulk load */
+    guint expected = 0;
     sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db->db, "SELECT COUNT(*) FROM clips WHERE archived = 0;",
+                           -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            expected = (guint)sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+
+    const char *sql = with_content
+        ? "SELECT id, content, mime_type, hash, preview, timestamp, pinned, size, "
+          "uses, last_used, frecency FROM clips WHERE archived = 0 ORDER BY timestamp DESC;"
+        : "SELECT id, NULL, mime_type, hash, preview, timestamp, pinned, size, "
+          "uses, last_used, frecency FROM clips WHERE archived = 0 ORDER BY timestamp DESC;";
+
     int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
         g_warning("Failed to prepare load query: %s", sqlite3_errmsg(db->db));
@@ -106,129 +391,541 @@ clipium_db_load_all(ClipiumDb *db, ClipiumStore *store)
     }
 
     guint count = 0;
+    clipium_store_bulk_begin(store, expected);
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         guint64 id = (guint64)sqlite3_column_int64(stmt, 0);
         const void *blob = sqlite3_column_blob(stmt, 1);
         int blob_len = sqlite3_column_bytes(stmt, 1);
         const char *mime = (const char *)sqlite3_column_text(stmt, 2);
-        const char *hash = (const char *)sqlite3_column_text(stmt, 3);
+        const ClipiumHash *hash = sqlite3_column_blob(stmt, 3);
+        int hash_len = sqlite3_column_bytes(stmt, 3);
         const char *preview = (const char *)sqlite3_column_text(stmt, 4);
         gint64 timestamp = sqlite3_column_int64(stmt, 5);
         gboolean pinned = sqlite3_column_int(stmt, 6) != 0;
         gsize size = (gsize)sqlite3_column_int64(stmt, 7);
+        ClipiumUsage usage = {
+            .hits = (guint)sqlite3_column_int64(stmt, 8),
+            .last_used = sqlite3_column_int64(stmt, 9),
+            .frecency = sqlite3_column_double(stmt, 10),
+        };
 
         /* Skip rows with NULL required fields */
-        if (!mime || !hash) {
-            g_warning("Skipping corrupt row id=%" G_GUINT64_FORMAT " (NULL mime or hash)", id);
+        if (!mime || !hash || hash_len != CLIPIUM_HASH_LEN) {
+            g_warning("Skipping corrupt row id=%" G_GUINT64_FORMAT " (bad mime or hash)", id);
             continue;
         }
 
-        GBytes *content = g_bytes_new(blob, (gsize)blob_len);
-        clipium_store_load_entry(store, id, content, mime, hash, preview,
-                                 timestamp, pinned, size);
-        g_bytes_unref(content);
+        g_autoptr(GBytes) content = with_content ? g_bytes_new(blob, (gsize)blob_len) : NULL;
+        clipium_store_bulk_append(store, id, content, mime, hash, preview,
+                                  timestamp, pinned, size, &usage);
         count++;
     }
-
+    clipium_store_bulk_end(store);
     sqlite3_finalize(stmt);
+
+    /* Archived rows keep their IDs, so new entries must not reuse them */
+    clipium_store_reserve_ids(store, (guint64)db_query_int(db, "SELECT MAX(id) FROM clips;"));
+
     g_mutex_unlock(&db->lock);
     g_message("Loaded %u entries from database", count);
     return TRUE;
 }
 
-void
-clipium_db_save(ClipiumDb *db, const ClipiumEntry *entry)
+gboolean
+clipium_db_load_all(ClipiumDb *db, ClipiumStore *store)
 {
-    g_return_if_fail(db != NULL && entry != NULL && entry->content != NULL);
+    return db_load(db, store, TRUE);
+}
 
-    g_mutex_lock(&db->lock);
+typedef struct {
+    ClipiumDb    *db;
+    ClipiumStore *store;
+    gint64        below;  /* rows with a lower id are left to index */
+} DbIndexer;
+
+/* Index up to CLIPIUM_DB_INDEX_CHUNK text rows below indexer->below,
+ * newest first; FALSE once there are none left. Only the indexed head of
+ * each blob is copied out under the connection lock; the index is built
+ * after it is released. */
+static gboolean
+db_index_chunk(DbIndexer *indexer)
+{
+    ClipiumDb *db = indexer->db;
+    guint64 ids[CLIPIUM_DB_INDEX_CHUNK];
+    GBytes *texts[CLIPIUM_DB_INDEX_CHUNK];
+    guint rows = 0;
 
-    if (!db->db) {
+    g_mutex_lock(&db->lock);
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db->db, "SELECT id, substr(content, 1, ?) FROM clips "
+                           "WHERE archived = 0 AND mime_type LIKE 'text/%' AND id < ? "
+                           "ORDER BY id DESC LIMIT ?;",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        g_warning("Failed to prepare index query: %s", sqlite3_errmsg(db->db));
         g_mutex_unlock(&db->lock);
-        return;
+        return FALSE;
     }
+    sqlite3_bind_int(stmt, 1, CLIPIUM_INDEX_MAX_BYTES);
+    sqlite3_bind_int64(stmt, 2, indexer->below);
+    sqlite3_bind_int(stmt, 3, CLIPIUM_DB_INDEX_CHUNK);
+    while (rows < CLIPIUM_DB_INDEX_CHUNK && sqlite3_step(stmt) == SQLITE_ROW) {
+        ids[rows] = (guint64)sqlite3_column_int64(stmt, 0);
+        texts[rows] = g_bytes_new(sqlite3_column_blob(stmt, 1),
+                                  (gsize)sqlite3_column_bytes(stmt, 1));
+        rows++;
+    }
+    sqlite3_finalize(stmt);
+    g_mutex_unlock(&db->lock);
 
-    const char *sql = "INSERT OR REPLACE INTO clips "
-                      "(id, content, mime_type, hash, preview, timestamp, pinned, size) "
-                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
+    for (guint i = 0; i < rows; i++) {
+        clipium_store_index_content(indexer->store, ids[i], texts[i]);
+        g_bytes_unref(texts[i]);
+        indexer->below = (gint64)ids[i];
+    }
+    return rows == CLIPIUM_DB_INDEX_CHUNK;
+}
 
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        g_warning("Failed to prepare save: %s", sqlite3_errmsg(db->db));
-        g_mutex_unlock(&db->lock);
-        return;
+/* Stream text blobs through the store's full-text index once; each one is
+ * dropped as soon as its trigrams are taken, so content stays on disk.
+ * The connection is only held to copy a chunk out, never while the store
+ * indexes it, so the writer and content loads wait at most for one read. */
+static gpointer
+db_index_thread(gpointer user_data)
+{
+    DbIndexer *indexer = user_data;
+    while (!g_atomic_int_get(&indexer->db->index_stop)) {
+        if (!db_index_chunk(indexer))
+            break;
     }
+    g_free(indexer);
+    return NULL;
+}
+
+gboolean
+clipium_db_load_metadata(ClipiumDb *db, ClipiumStore *store)
+{
+    clipium_db_wait_indexed(db);
+    if (!db_load(db, store, FALSE))
+        return FALSE;
+
+    /* Rows saved from here on arrive with their content and are indexed
+     * by the store itself */
+    DbIndexer *indexer = g_new0(DbIndexer, 1);
+    indexer->db = db;
+    indexer->store = store;
+    g_mutex_lock(&db->lock);
+    indexer->below = db_query_int(db, "SELECT MAX(id) FROM clips;") + 1;
+    g_mutex_unlock(&db->lock);
+    g_atomic_int_set(&db->index_stop, FALSE);
+    db->indexer = g_thread_new("clipium-db-index", db_index_thread, indexer);
+    return TRUE;
+}
+
+void
+clipium_db_wait_indexed(ClipiumDb *db)
+{
+    g_return_if_fail(db != NULL);
+    if (db->indexer)
+        g_thread_join(g_steal_pointer(&db->indexer));
+}
 
-    gsize content_len;
-    const guchar *content_data = g_bytes_get_data(entry->content, &content_len);
+GBytes *
+clipium_db_load_content(ClipiumDb *db, guint64 id)
+{
+    g_return_val_if_fail(db != NULL, NULL);
 
-    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)entry->id);
-    sqlite3_bind_blob(stmt, 2, content_data, (int)content_len, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, entry->mime_type, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, entry->hash, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 5, entry->preview, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int64(stmt, 6, entry->timestamp);
-    sqlite3_bind_int(stmt, 7, entry->pinned ? 1 : 0);
-    sqlite3_bind_int64(stmt, 8, (sqlite3_int64)entry->size);
+    g_mutex_lock(&db->lock);
+    sqlite3_stmt *stmt = db_stmt(db, DB_STMT_CONTENT);
+    if (!stmt) { g_mutex_unlock(&db->lock); return NULL; }
 
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
-        g_warning("Failed to save entry %" G_GUINT64_FORMAT ": %s", entry->id, sqlite3_errmsg(db->db));
+    GBytes *content = NULL;
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)id);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const void *blob = sqlite3_column_blob(stmt, 0);
+        int blob_len = sqlite3_column_bytes(stmt, 0);
+        content = g_bytes_new(blob, (gsize)blob_len);
+    }
 
-    sqlite3_finalize(stmt);
+    db_stmt_done(stmt);
     g_mutex_unlock(&db->lock);
+    return content;
 }
 
-/* Async save using GTask */
+/* --- Writer thread --- */
+
+/* Every write is an operation on the writer's queue. The writer takes
+ * whatever has piled up (up to CLIPIUM_DB_BATCH_MAX) and runs it in one
+ * transaction, so a burst of clips costs one commit rather than one each,
+ * and queue order is commit order. Callers of the synchronous functions
+ * wait for their operations; the _async ones return at once. */
+typedef enum {
+    DB_OP_SAVE,
+    DB_OP_DELETE,
+    DB_OP_PIN,
+    DB_OP_USAGE,
+    DB_OP_ARCHIVE,
+    DB_OP_BUMP,
+    DB_OP_RETAIN,
+    DB_OP_CLEAR,
+} DbOpKind;
+
+/* What a waiting caller learns of its operations */
 typedef struct {
-    ClipiumDb *db;
-    ClipiumEntry entry_copy;
-} SaveTaskData;
+    guint    remaining;
+    gboolean ok;
+    gint64   changes;  /* rows the operations touched */
+} DbWait;
+
+typedef struct {
+    DbOpKind      kind;
+    guint64       id;
+    const ClipiumEntry *row;    /* DB_OP_SAVE */
+    ClipiumEntry       *entry;  /* the reference held on `row`, if async */
+    gboolean      pinned;     /* DB_OP_PIN */
+    gint64        timestamp;  /* DB_OP_BUMP */
+    ClipiumUsage  usage;      /* DB_OP_USAGE, DB_OP_BUMP */
+    guint         keep_live;  /* DB_OP_RETAIN: entries the store keeps, 0 = any */
+    DbWait       *wait;    /* NULL for async operations */
+    gboolean      ok;
+    gint64        changes;
+} DbOp;
+
+struct _ClipiumDbWriter {
+    GThread  *thread;
+    GQueue    pending;    /* DbOp*, oldest first */
+    guint     in_flight;  /* taken by the writer, not yet finished */
+    gboolean  stopping;
+    GMutex    lock;
+    GCond     work;       /* pending grew, or stopping */
+    GCond     done;       /* a batch finished, freeing room in the queue */
+    GMutex    persist_lock;  /* held from taking store changes to queuing them */
+    guint     history;    /* rows to retain, 0 = all; see clipium_db_set_history */
+    guint64   batches;
+    guint64   ops;
+};
+
+static void
+db_op_free(DbOp *op)
+{
+    if (op->entry)
+        clipium_entry_unref(op->entry);
+    g_free(op);
+}
+
+/* Retention: archive live rows the store would not keep, then trim the
+ * archive, oldest first, to the history size. Caller holds db->lock. */
+static gboolean
+db_retain(ClipiumDb *db, DbOp *op)
+{
+    guint history = g_atomic_int_get(&db->writer->history);
+    const struct { DbStmt which; guint limit; } steps[] = {
+        { DB_STMT_RETAIN_LIVE,    op->keep_live },
+        { DB_STMT_RETAIN_ARCHIVE, history },
+    };
+
+    for (guint i = 0; i < G_N_ELEMENTS(steps); i++) {
+        if (steps[i].limit == 0)
+            continue;
+        sqlite3_stmt *stmt = db_stmt(db, steps[i].which);
+        if (!stmt)
+            return FALSE;
+        sqlite3_bind_int64(stmt, 1, steps[i].limit);
+        gboolean ok = sqlite3_step(stmt) == SQLITE_DONE;
+        if (ok)
+            op->changes += sqlite3_changes(db->db);
+        else
+            g_warning("Failed to apply retention: %s", sqlite3_errmsg(db->db));
+        db_stmt_done(stmt);
+        if (!ok)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Caller holds db->lock */
+static gboolean
+db_op_run(ClipiumDb *db, DbOp *op)
+{
+    if (op->kind == DB_OP_CLEAR) {
+        char *err = NULL;
+        if (sqlite3_exec(db->db, "DELETE FROM clips;", NULL, NULL, &err) != SQLITE_OK) {
+            g_warning("Failed to clear: %s", err);
+            sqlite3_free(err);
+            return FALSE;
+        }
+        op->changes = sqlite3_changes(db->db);
+        return TRUE;
+    }
+    if (op->kind == DB_OP_RETAIN)
+        return db_retain(db, op);
+
+    static const DbStmt stmt_of[] = {
+        [DB_OP_SAVE] = DB_STMT_SAVE,     [DB_OP_DELETE] = DB_STMT_DELETE,
+        [DB_OP_PIN] = DB_STMT_PIN,       [DB_OP_USAGE] = DB_STMT_USAGE,
+        [DB_OP_ARCHIVE] = DB_STMT_ARCHIVE, [DB_OP_BUMP] = DB_STMT_BUMP,
+    };
+    sqlite3_stmt *stmt = db_stmt(db, stmt_of[op->kind]);
+    if (!stmt)
+        return FALSE;
+
+    switch (op->kind) {
+    case DB_OP_SAVE: {
+        const ClipiumEntry *entry = op->row;
+        gsize content_len;
+        const guchar *content_data = g_bytes_get_data(entry->content, &content_len);
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)entry->id);
+        sqlite3_bind_blob(stmt, 2, content_data, (int)content_len, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, entry->mime_type, -1, SQLITE_STATIC);
+        sqlite3_bind_blob(stmt, 4, entry->hash.bytes, CLIPIUM_HASH_LEN, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 5, entry->preview, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 6, entry->timestamp);
+        sqlite3_bind_int(stmt, 7, entry->pinned ? 1 : 0);
+        sqlite3_bind_int64(stmt, 8, (sqlite3_int64)entry->size);
+        break;
+    }
+    case DB_OP_PIN:
+        sqlite3_bind_int(stmt, 1, op->pinned ? 1 : 0);
+        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)op->id);
+        break;
+    case DB_OP_BUMP:
+        sqlite3_bind_int64(stmt, 1, op->timestamp);
+        sqlite3_bind_int64(stmt, 2, op->usage.hits);
+        sqlite3_bind_int64(stmt, 3, op->usage.last_used);
+        sqlite3_bind_double(stmt, 4, op->usage.frecency);
+        sqlite3_bind_int64(stmt, 5, (sqlite3_int64)op->id);
+        break;
+    case DB_OP_USAGE:
+        sqlite3_bind_int64(stmt, 1, op->usage.hits);
+        sqlite3_bind_int64(stmt, 2, op->usage.last_used);
+        sqlite3_bind_double(stmt, 3, op->usage.frecency);
+        sqlite3_bind_int64(stmt, 4, (sqlite3_int64)op->id);
+        break;
+    default:  /* DB_OP_DELETE, DB_OP_ARCHIVE */
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)op->id);
+        break;
+    }
+
+    gboolean ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (ok)
+        op->changes = sqlite3_changes(db->db);
+    else if (op->kind == DB_OP_SAVE)
+        g_warning("Failed to save entry %" G_GUINT64_FORMAT ": %s",
+                  op->id, sqlite3_errmsg(db->db));
+    db_stmt_done(stmt);
+    return ok;
+}
+
+/* One transaction for the batch. A failed statement only undoes itself;
+ * a failed commit fails them all. */
+static void
+db_run_batch(ClipiumDb *db, GPtrArray *batch)
+{
+    g_mutex_lock(&db->lock);
+    /* Retention runs once per batch, after everything else */
+    DbOp *retain = NULL;
+    for (guint i = 0; i < batch->len; i++) {
+        DbOp *op = g_ptr_array_index(batch, i);
+        if (op->kind == DB_OP_RETAIN && (!retain || op->keep_live > retain->keep_live))
+            retain = op;
+    }
+
+    gboolean in_transaction = sqlite3_exec(db->db, "BEGIN;", NULL, NULL, NULL) == SQLITE_OK;
+    for (guint i = 0; i < batch->len; i++) {
+        DbOp *op = g_ptr_array_index(batch, i);
+        op->ok = op->kind == DB_OP_RETAIN || db_op_run(db, op);
+    }
+    if (retain)
+        retain->ok = db_op_run(db, retain);
+    if (in_transaction && sqlite3_exec(db->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        g_warning("Failed to commit %u writes: %s", batch->len, sqlite3_errmsg(db->db));
+        sqlite3_exec(db->db, "ROLLBACK;", NULL, NULL, NULL);
+        for (guint i = 0; i < batch->len; i++)
+            ((DbOp *)g_ptr_array_index(batch, i))->ok = FALSE;
+    }
+    g_mutex_unlock(&db->lock);
+}
+
+/* Caller holds writer->lock */
+static void
+db_op_finish(DbOp *op)
+{
+    if (op->wait) {
+        op->wait->remaining--;
+        op->wait->ok = op->wait->ok && op->ok;
+        op->wait->changes += op->changes;
+    }
+    db_op_free(op);
+}
+
+static gpointer
+db_writer_thread(gpointer user_data)
+{
+    ClipiumDb *db = user_data;
+    ClipiumDbWriter *w = db->writer;
+    g_autoptr(GPtrArray) batch = g_ptr_array_new();
+
+    g_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->pending.length == 0 && !w->stopping)
+            g_cond_wait(&w->work, &w->lock);
+        if (w->pending.length == 0)
+            break;
+
+        while (w->pending.length > 0 && batch->len < CLIPIUM_DB_BATCH_MAX)
+            g_ptr_array_add(batch, g_queue_pop_head(&w->pending));
+        w->in_flight = batch->len;
+        g_cond_broadcast(&w->done);  /* there is room in the queue again */
+        g_mutex_unlock(&w->lock);
+
+        db_run_batch(db, batch);
+
+        g_mutex_lock(&w->lock);
+        for (guint i = 0; i < batch->len; i++)
+            db_op_finish(g_ptr_array_index(batch, i));
+        w->batches++;
+        w->ops += batch->len;
+        w->in_flight = 0;
+        g_ptr_array_set_size(batch, 0);
+        g_cond_broadcast(&w->done);
+    }
+    g_mutex_unlock(&w->lock);
+    return NULL;
+}
 
 static void
-save_task_data_free(gpointer data)
+db_writer_start(ClipiumDb *db)
 {
-    SaveTaskData *d = data;
-    clipium_entry_clear(&d->entry_copy);
-    g_free(d);
+    ClipiumDbWriter *w = g_new0(ClipiumDbWriter, 1);
+    g_queue_init(&w->pending);
+    g_mutex_init(&w->lock);
+    g_mutex_init(&w->persist_lock);
+    g_cond_init(&w->work);
+    g_cond_init(&w->done);
+    db->writer = w;
+    w->thread = g_thread_new("clipium-db-writer", db_writer_thread, db);
+}
+
+/* Stop the writer once its batch in progress is done. Whatever is still
+ * queued is dropped: clipium_db_flush first to keep it. */
+static void
+db_writer_stop(ClipiumDb *db)
+{
+    ClipiumDbWriter *w = db->writer;
+    g_mutex_lock(&w->lock);
+    guint dropped = w->pending.length;
+    DbOp *op;
+    while ((op = g_queue_pop_head(&w->pending)))
+        db_op_finish(op);  /* a waiting caller sees it fail */
+    w->stopping = TRUE;
+    g_cond_broadcast(&w->work);
+    g_cond_broadcast(&w->done);
+    g_mutex_unlock(&w->lock);
+
+    g_thread_join(w->thread);
+    if (dropped > 0)
+        g_warning("Dropped %u unwritten database operations", dropped);
+
+    g_cond_clear(&w->work);
+    g_cond_clear(&w->done);
+    g_mutex_clear(&w->persist_lock);
+    g_mutex_clear(&w->lock);
+    g_free(w);
+    db->writer = NULL;
 }
 
+/* Queue `ops` in order, waiting for room while the queue is full. With
+ * `wait` set, also wait until the writer has run them all. */
 static void
-save_task_thread(GTask        *task,
-                 gpointer      source_object,
-                 gpointer      task_data,
-                 GCancellable *cancellable)
+db_submit(ClipiumDb *db, DbOp **ops, guint n_ops, DbWait *wait)
+{
+    ClipiumDbWriter *w = db->writer;
+    g_mutex_lock(&w->lock);
+    for (guint i = 0; i < n_ops; i++) {
+        while (w->pending.length >= CLIPIUM_DB_QUEUE_MAX && !w->stopping)
+            g_cond_wait(&w->done, &w->lock);
+        ops[i]->wait = wait;
+        if (wait)
+            wait->remaining++;
+        if (w->stopping) {
+            ops[i]->ok = FALSE;
+            db_op_finish(ops[i]);
+            continue;
+        }
+        g_queue_push_tail(&w->pending, ops[i]);
+    }
+    g_cond_signal(&w->work);
+    while (wait && wait->remaining > 0)
+        g_cond_wait(&w->done, &w->lock);
+    g_mutex_unlock(&w->lock);
+}
+
+static DbOp *
+db_op_new(DbOpKind kind, guint64 id)
+{
+    DbOp *op = g_new0(DbOp, 1);
+    op->kind = kind;
+    op->id = id;
+    return op;
+}
+
+/* Run one operation and wait for it; TRUE if it succeeded */
+static gboolean
+db_run_one(ClipiumDb *db, DbOp *op, gint64 *changes)
 {
-    (void)source_object;
-    (void)cancellable;
-    SaveTaskData *d = task_data;
-    clipium_db_save(d->db, &d->entry_copy);
-    g_task_return_boolean(task, TRUE);
+    DbWait wait = { .ok = TRUE };
+    db_submit(db, &op, 1, &wait);
+    if (changes)
+        *changes = wait.changes;
+    return wait.ok;
 }
 
+gboolean
+clipium_db_flush(ClipiumDb *db, gint64 timeout_usec)
+{
+    g_return_val_if_fail(db != NULL, FALSE);
+
+    ClipiumDbWriter *w = db->writer;
+    gint64 deadline = timeout_usec > 0 ? g_get_monotonic_time() + timeout_usec : G_MAXINT64;
+    g_mutex_lock(&w->lock);
+    while (w->pending.length > 0 || w->in_flight > 0) {
+        if (!g_cond_wait_until(&w->done, &w->lock, deadline))
+            break;
+    }
+    gboolean flushed = w->pending.length == 0 && w->in_flight == 0;
+    g_mutex_unlock(&w->lock);
+    return flushed;
+}
+
+void
+clipium_db_writer_stats(ClipiumDb *db, guint64 *batches, guint64 *ops)
+{
+    g_mutex_lock(&db->writer->lock);
+    *batches = db->writer->batches;
+    *ops = db->writer->ops;
+    g_mutex_unlock(&db->writer->lock);
+}
+
+/* --- Writes --- */
+
 void
-clipium_db_save_async(ClipiumDb *db, const ClipiumEntry *entry)
+clipium_db_save(ClipiumDb *db, const ClipiumEntry *entry)
 {
     g_return_if_fail(db != NULL && entry != NULL && entry->content != NULL);
 
-    SaveTaskData *d = g_new0(SaveTaskData, 1);
-    d->db = db;
-    d->entry_copy = (ClipiumEntry){
-        .id        = entry->id,
-        .content   = g_bytes_ref(entry->content),
-        .mime_type = g_strdup(entry->mime_type),
-        .preview   = g_strdup(entry->preview),
-        .hash      = g_strdup(entry->hash),
-        .timestamp = entry->timestamp,
-        .pinned    = entry->pinned,
-        .size      = entry->size,
-    };
+    /* This waits for the write, so the entry can be borrowed */
+    DbOp *op = db_op_new(DB_OP_SAVE, entry->id);
+    op->row = entry;
+    db_run_one(db, op, NULL);
+}
+
+void
+clipium_db_save_async(ClipiumDb *db, ClipiumEntry *entry)
+{
+    g_return_if_fail(db != NULL && entry != NULL && entry->content != NULL);
 
-    GTask *task = g_task_new(NULL, NULL, NULL, NULL);
-    g_task_set_task_data(task, d, save_task_data_free);
-    g_task_run_in_thread(task, save_task_thread);
-    g_object_unref(task);
+    DbOp *op = db_op_new(DB_OP_SAVE, entry->id);
+    op->row = op->entry = clipium_entry_ref(entry);
+    db_submit(db, &op, 1, NULL);
 }
 
 gboolean
@@ -236,58 +933,210 @@ clipium_db_delete(ClipiumDb *db, guint64 id)
 {
     g_return_val_if_fail(db != NULL, FALSE);
 
-    g_mutex_lock(&db->lock);
-    if (!db->db) { g_mutex_unlock(&db->lock); return FALSE; }
+    gint64 changes;
+    return db_run_one(db, db_op_new(DB_OP_DELETE, id), &changes) && changes > 0;
+}
 
-    const char *sql = "DELETE FROM clips WHERE id = ?;";
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) { g_mutex_unlock(&db->lock); return FALSE; }
+void
+clipium_db_delete_async(ClipiumDb *db, const guint64 *ids, guint n_ids)
+{
+    g_return_if_fail(db != NULL);
 
-    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)id);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    g_mutex_unlock(&db->lock);
-    return rc == SQLITE_DONE;
+    /* Queued together, so they share a batch */
+    g_autofree DbOp **ops = g_new(DbOp *, n_ids);
+    for (guint i = 0; i < n_ids; i++)
+        ops[i] = db_op_new(DB_OP_DELETE, ids[i]);
+    db_submit(db, ops, n_ids, NULL);
 }
 
 gboolean
 clipium_db_clear(ClipiumDb *db)
 {
     g_return_val_if_fail(db != NULL, FALSE);
+    return db_run_one(db, db_op_new(DB_OP_CLEAR, 0), NULL);
+}
+
+gboolean
+clipium_db_update_pin(ClipiumDb *db, guint64 id, gboolean pinned)
+{
+    g_return_val_if_fail(db != NULL, FALSE);
+
+    DbOp *op = db_op_new(DB_OP_PIN, id);
+    op->pinned = pinned;
+    return db_run_one(db, op, NULL);
+}
+
+static DbOp *
+db_usage_op(guint64 id, const ClipiumUsage *usage)
+{
+    DbOp *op = db_op_new(DB_OP_USAGE, id);
+    op->usage = *usage;
+    return op;
+}
+
+/* --- Archive --- */
+
+/* A row of ARCHIVE_ENTRY_COLUMNS as a metadata-only entry, or NULL */
+static ClipiumEntry *
+db_archived_entry(sqlite3_stmt *stmt)
+{
+    guint64 id = (guint64)sqlite3_column_int64(stmt, 0);
+    const char *mime = (const char *)sqlite3_column_text(stmt, 1);
+    const ClipiumHash *hash = sqlite3_column_blob(stmt, 2);
+    int hash_len = sqlite3_column_bytes(stmt, 2);
+    if (!mime || !hash || hash_len != CLIPIUM_HASH_LEN) {
+        g_warning("Skipping corrupt row id=%" G_GUINT64_FORMAT " (bad mime or hash)", id);
+        return NULL;
+    }
+    return clipium_entry_new(id, NULL, mime, (const char *)sqlite3_column_text(stmt, 3), hash,
+                             sqlite3_column_int64(stmt, 4), sqlite3_column_int(stmt, 5) != 0,
+                             (gsize)sqlite3_column_int64(stmt, 6));
+}
+
+/* Every word of `query` the trigram index can look up, quoted, so FTS5
+ * takes them as phrases that must all occur; NULL if there are none */
+static char *
+archive_match_query(const char *query)
+{
+    g_auto(GStrv) words = g_strsplit_set(query, " \t\n", -1);
+    GString *match = g_string_new(NULL);
+    for (guint i = 0; words[i]; i++) {
+        if (g_utf8_strlen(words[i], -1) < 3)
+            continue;
+        g_auto(GStrv) parts = g_strsplit(words[i], "\"", -1);
+        g_autofree char *escaped = g_strjoinv("\"\"", parts);
+        g_string_append_printf(match, "%s\"%s\"", match->len ? " " : "", escaped);
+    }
+    if (match->len == 0) {
+        g_string_free(match, TRUE);
+        return NULL;
+    }
+    return g_string_free(match, FALSE);
+}
+
+void
+clipium_db_search_archive(ClipiumDb *db, const char *query, guint limit, GArray *results)
+{
+    g_return_if_fail(db != NULL && query != NULL && results != NULL);
+
+    g_autofree char *match = archive_match_query(query);
+    if (!match || limit == 0)
+        return;
 
     g_mutex_lock(&db->lock);
-    if (!db->db) { g_mutex_unlock(&db->lock); return FALSE; }
+    sqlite3_stmt *stmt = db->archive ? db_stmt(db, DB_STMT_ARCHIVE_SEARCH) : NULL;
+    if (!stmt) { g_mutex_unlock(&db->lock); return; }
 
-    char *err = NULL;
-    int rc = sqlite3_exec(db->db, "DELETE FROM clips;", NULL, NULL, &err);
-    if (rc != SQLITE_OK) {
-        g_warning("Failed to clear: %s", err);
-        sqlite3_free(err);
-        g_mutex_unlock(&db->lock);
-        return FALSE;
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, limit);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        ClipiumEntry *e = db_archived_entry(stmt);
+        if (e)
+            g_array_append_val(results, e);
     }
+    if (rc != SQLITE_DONE)
+        g_warning("Archive search failed: %s", sqlite3_errmsg(db->db));
+
+    db_stmt_done(stmt);
     g_mutex_unlock(&db->lock);
-    return TRUE;
 }
 
-gboolean
-clipium_db_update_pin(ClipiumDb *db, guint64 id, gboolean pinned)
+ClipiumEntry *
+clipium_db_get_archived(ClipiumDb *db, guint64 id)
 {
-    g_return_val_if_fail(db != NULL, FALSE);
+    g_return_val_if_fail(db != NULL, NULL);
 
     g_mutex_lock(&db->lock);
-    if (!db->db) { g_mutex_unlock(&db->lock); return FALSE; }
+    sqlite3_stmt *stmt = db_stmt(db, DB_STMT_ARCHIVED);
+    if (!stmt) { g_mutex_unlock(&db->lock); return NULL; }
 
-    const char *sql = "UPDATE clips SET pinned = ? WHERE id = ?;";
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) { g_mutex_unlock(&db->lock); return FALSE; }
+    ClipiumEntry *entry = NULL;
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)id);
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        entry = db_archived_entry(stmt);
 
-    sqlite3_bind_int(stmt, 1, pinned ? 1 : 0);
-    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)id);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    db_stmt_done(stmt);
     g_mutex_unlock(&db->lock);
-    return rc == SQLITE_DONE;
+    return entry;
+}
+
+/* --- Store changes and retention --- */
+
+guint
+clipium_db_persist(ClipiumDb *db, ClipiumStore *store)
+{
+    g_return_val_if_fail(db != NULL && store != NULL, 0);
+
+    /* Callers on different threads must queue the journal in the order it
+     * was taken: one that took older changes may not queue them after one
+     * that took newer ones */
+    g_mutex_lock(&db->writer->persist_lock);
+    g_autoptr(GArray) changes = clipium_store_take_changes(store);
+    g_autoptr(GPtrArray) ops = g_ptr_array_sized_new(changes->len + 1);
+    gboolean evicted = FALSE;
+
+    for (guint i = 0; i < changes->len; i++) {
+        const ClipiumStoreChange *change = &g_array_index(changes, ClipiumStoreChange, i);
+        DbOp *op;
+        switch (change->kind) {
+        case CLIPIUM_CHANGE_ADDED:
+            op = db_op_new(DB_OP_SAVE, change->id);
+            op->row = op->entry = clipium_entry_ref(change->entry);
+            g_ptr_array_add(ops, op);
+            op = db_usage_op(change->id, &change->usage);
+            break;
+        case CLIPIUM_CHANGE_BUMPED:
+            op = db_op_new(DB_OP_BUMP, change->id);
+            op->timestamp = change->timestamp;
+            op->usage = change->usage;
+            break;
+        case CLIPIUM_CHANGE_USED:
+            op = db_usage_op(change->id, &change->usage);
+            break;
+        case CLIPIUM_CHANGE_PINNED:
+            op = db_op_new(DB_OP_PIN, change->id);
+            op->pinned = change->pinned;
+            break;
+        case CLIPIUM_CHANGE_EVICTED:
+            op = db_op_new(DB_OP_ARCHIVE, change->id);
+            evicted = TRUE;
+            break;
+        case CLIPIUM_CHANGE_REMOVED:
+            op = db_op_new(DB_OP_DELETE, change->id);
+            break;
+        case CLIPIUM_CHANGE_CLEARED:
+        default:
+            op = db_op_new(DB_OP_CLEAR, 0);
+            break;
+        }
+        g_ptr_array_add(ops, op);
+    }
+
+    /* Every eviction grows the archive */
+    if (evicted)
+        g_ptr_array_add(ops, db_op_new(DB_OP_RETAIN, 0));
+
+    db_submit(db, (DbOp **)ops->pdata, ops->len, NULL);
+    g_mutex_unlock(&db->writer->persist_lock);
+    return changes->len;
+}
+
+void
+clipium_db_set_history(ClipiumDb *db, guint max_rows)
+{
+    g_return_if_fail(db != NULL);
+    g_atomic_int_set(&db->writer->history, max_rows);
+}
+
+guint
+clipium_db_compact(ClipiumDb *db, guint keep_live)
+{
+    g_return_val_if_fail(db != NULL, 0);
+
+    DbOp *op = db_op_new(DB_OP_RETAIN, 0);
+    op->keep_live = keep_live;
+    gint64 changes = 0;
+    db_run_one(db, op, &changes);
+    return (guint)changes;
 }
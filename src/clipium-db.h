@@ -7,20 +7,94 @@
 
 G_BEGIN_DECLS
 
+typedef struct _ClipiumDbWriter ClipiumDbWriter;
+
+/* Writes go through a single writer thread, which commits whatever has
+ * queued up as one transaction. The plain write functions wait for their
+ * operation; the _async ones only queue it (blocking while the queue is
+ * full). Either way operations commit in the order they were made. */
 typedef struct {
-    sqlite3 *db;
-    char    *path;
-    GMutex   lock;
+    sqlite3          *db;
+    char             *path;
+    gboolean          archive;  /* the archive's full-text index is there */
+    sqlite3_stmt    **stmts;    /* prepared on first use */
+    ClipiumDbWriter  *writer;
+    GThread          *indexer;     /* see clipium_db_load_metadata */
+    gint              index_stop;  /* atomic; tells the indexer to give up */
+    GMutex            lock;     /* guards db and stmts */
 } ClipiumDb;
 
 ClipiumDb *clipium_db_open     (const char *path);
+
+/* Operations still queued are dropped: flush first to keep them */
 void       clipium_db_close    (ClipiumDb *db);
 gboolean   clipium_db_init     (ClipiumDb *db);
+
+/* Wait until every queued operation is committed, for at most
+ * `timeout_usec` (0: no limit). FALSE if some were still pending. */
+gboolean   clipium_db_flush    (ClipiumDb *db, gint64 timeout_usec);
+
+/* Transactions the writer has committed and the operations in them */
+void       clipium_db_writer_stats(ClipiumDb *db, guint64 *batches, guint64 *ops);
+
+/* Loaders take the live entries; archived ones stay on disk */
 gboolean   clipium_db_load_all (ClipiumDb *db, ClipiumStore *store);
+
+/* Load everything but the blobs; the store then fetches content on demand
+ * through clipium_db_load_content (see clipium_store_set_content_loader).
+ * Text blobs are then read once, newest first, on a background thread to
+ * build the full-text search index, so startup does not wait for it:
+ * until then, older entries are only found by their preview. The store
+ * must outlive the indexing, which clipium_db_close stops. */
+gboolean   clipium_db_load_metadata(ClipiumDb *db, ClipiumStore *store);
+
+/* Wait until the indexing clipium_db_load_metadata started is done */
+void       clipium_db_wait_indexed(ClipiumDb *db);
+GBytes    *clipium_db_load_content (ClipiumDb *db, guint64 id);
 void       clipium_db_save     (ClipiumDb *db, const ClipiumEntry *entry);
-void       clipium_db_save_async(ClipiumDb *db, const ClipiumEntry *entry);
+void       clipium_db_save_async(ClipiumDb *db, ClipiumEntry *entry);
+
+/* Live or archived; FALSE if there was no such row */
 gboolean   clipium_db_delete   (ClipiumDb *db, guint64 id);
+
+/* Queue the deletion of rows, live or archived, without waiting; for rows
+ * the store no longer has, such as archive hits */
+void       clipium_db_delete_async(ClipiumDb *db, const guint64 *ids, guint n_ids);
 gboolean   clipium_db_clear    (ClipiumDb *db);
 gboolean   clipium_db_update_pin(ClipiumDb *db, guint64 id, gboolean pinned);
 
+/* Archive tier: entries the store evicts keep their row, marked archived,
+ * and their text goes into a full-text index, so history outlives the
+ * store's cap. clipium_db_persist archives them and applies retention. */
+
+/* Archived text entries holding every word of `query` that has three or
+ * more characters, ignoring case. Appends up to `limit` metadata-only
+ * ClipiumEntry* references to `results`, newest first; see
+ * ClipiumArchiveSearch. */
+void       clipium_db_search_archive(ClipiumDb  *db,
+                                     const char *query,
+                                     guint       limit,
+                                     GArray     *results);
+
+/* An archived entry, metadata-only, or NULL */
+ClipiumEntry *clipium_db_get_archived(ClipiumDb *db, guint64 id);
+
+/* Queue the store's journaled changes (clipium_store_take_changes) as
+ * writes, in order: adds are saved, bumps, uses and pins update their row,
+ * evictions archive it, deletes and expiries remove it. Evictions are
+ * followed by a trim of the archive to the history size. Safe to call from
+ * any thread: concurrent calls queue their changes in journal order.
+ * Returns how many changes there were. */
+guint      clipium_db_persist  (ClipiumDb *db, ClipiumStore *store);
+
+/* Rows the database keeps, live and archived together, 0 for no limit.
+ * The archive gives up its oldest rows to stay within it; live ones are
+ * never dropped. */
+void       clipium_db_set_history(ClipiumDb *db, guint max_rows);
+
+/* Apply retention now: archive all but the newest `keep_live` live rows,
+ * pinned ones kept and counted (0 to leave them be), then trim the archive
+ * to the history size. Returns the rows archived or deleted. */
+guint      clipium_db_compact  (ClipiumDb *db, guint keep_live);
+
 G_END_DECLS
@@ -1,5 +1,6 @@
 #include "clipium-entry-row.h"
 #include "clipium-config.h"
+#include <string.h>
 
 struct _ClipiumEntryRow {
     GtkListBoxRow parent;
@@ -112,3 +113,43 @@ clipium_entry_row_get_preview(ClipiumEntryRow *row)
 {
     return row->preview;
 }
+
+/* Matched runs in bold accent, widened to whole UTF-8 characters */
+void
+clipium_entry_row_highlight(ClipiumEntryRow *row, const GArray *positions)
+{
+    if (!positions || positions->len == 0 || !row->preview) {
+        gtk_label_set_attributes(row->preview_label, NULL);
+        return;
+    }
+
+    gsize len = strlen(row->preview);
+    PangoAttrList *attrs = pango_attr_list_new();
+    guint i = 0;
+    while (i < positions->len) {
+        guint start = g_array_index(positions, guint, i);
+        guint end = start + 1;
+        for (i++; i < positions->len && g_array_index(positions, guint, i) <= end; i++)
+            end = g_array_index(positions, guint, i) + 1;
+        if (start >= len)
+            break;
+
+        while (start > 0 && (row->preview[start] & 0xC0) == 0x80)
+            start--;
+        while (end < len && (row->preview[end] & 0xC0) == 0x80)
+            end++;
+
+        PangoAttribute *weight = pango_attr_weight_new(PANGO_WEIGHT_BOLD);
+        weight->start_index = start;
+        weight->end_index = MIN(end, len);
+        pango_attr_list_insert(attrs, weight);
+
+        PangoAttribute *color = pango_attr_foreground_new(0x3500, 0x8400, 0xe400);
+        color->start_index = start;
+        color->end_index = MIN(end, len);
+        pango_attr_list_insert(attrs, color);
+    }
+
+    gtk_label_set_attributes(row->preview_label, attrs);
+    pango_attr_list_unref(attrs);
+}
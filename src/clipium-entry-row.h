@@ -12,4 +12,9 @@ ClipiumEntryRow *clipium_entry_row_new    (const ClipiumEntry *entry);
 guint64          clipium_entry_row_get_id (ClipiumEntryRow *row);
 const char      *clipium_entry_row_get_preview(ClipiumEntryRow *row);
 
+/* Emphasise the preview bytes at `positions` (guint, ascending), as
+ * returned by clipium_fuzzy_score; NULL or empty clears it */
+void             clipium_entry_row_highlight  (ClipiumEntryRow *row,
+                                               const GArray    *positions);
+
 G_END_DECLS
@@ -0,0 +1,450 @@
+#include "clipium-evict.h"
+#include <string.h>
+
+#define NODE_NONE G_MAXUINT
+
+/* List ids. FIFO, LRU and LFU keep everything on LIST_MAIN; ARC splits
+ * resident entries into T1 (seen once) and T2 (seen again). */
+enum { LIST_NONE, LIST_MAIN, LIST_T2, N_LISTS };
+#define LIST_T1 LIST_MAIN
+
+typedef struct {
+    guint head;   /* most recent / most valuable */
+    guint tail;   /* next victim */
+    guint len;
+} EvictList;
+
+typedef struct {
+    guint   prev;
+    guint   next;
+    guint   list;   /* LIST_*, LIST_NONE while untracked */
+    guint   freq;   /* LFU use count */
+    gint64  stamp;  /* last use, orders entries within a list or LFU run */
+} EvictNode;
+
+struct _ClipiumEvictPolicy {
+    ClipiumEvictKind  kind;
+    guint             capacity;
+    GArray           *nodes;           /* EvictNode[], indexed by store slot */
+    EvictList         lists[N_LISTS];
+
+    /* LFU: LIST_MAIN is ordered by frequency (highest at head), most recent
+     * first within a frequency. run_fronts maps a frequency to the most
+     * recent node with it, which makes a use O(1). */
+    GHashTable       *run_fronts;
+
+    /* ARC: target size of T1 and the ghost lists of recently evicted keys */
+    guint             target_t1;
+    GQueue            ghosts_b1;       /* ClipiumHash* keys, most recent at head */
+    GQueue            ghosts_b2;
+    GHashTable       *ghost_b1_index;  /* key → GList* link in ghosts_b1 */
+    GHashTable       *ghost_b2_index;
+};
+
+#define NODE(policy, slot) (&g_array_index((policy)->nodes, EvictNode, (slot)))
+
+/* --- Intrusive list helpers --- */
+
+static EvictNode *
+node_get(ClipiumEvictPolicy *policy, guint slot)
+{
+    if (slot >= policy->nodes->len)
+        g_array_set_size(policy->nodes, slot + 1);
+    return NODE(policy, slot);
+}
+
+static void
+list_unlink(ClipiumEvictPolicy *policy, guint slot)
+{
+    EvictNode *n = NODE(policy, slot);
+    EvictList *l = &policy->lists[n->list];
+    if (n->prev != NODE_NONE) NODE(policy, n->prev)->next = n->next;
+    else l->head = n->next;
+    if (n->next != NODE_NONE) NODE(policy, n->next)->prev = n->prev;
+    else l->tail = n->prev;
+    l->len--;
+    n->prev = n->next = NODE_NONE;
+    n->list = LIST_NONE;
+}
+
+/* Link `slot` into `list` just before `before` (NODE_NONE = at the tail) */
+static void
+list_insert_before(ClipiumEvictPolicy *policy, guint list, guint slot, guint before)
+{
+    EvictList *l = &policy->lists[list];
+    EvictNode *n = NODE(policy, slot);
+    guint after = (before != NODE_NONE) ? NODE(policy, before)->prev : l->tail;
+
+    n->list = list;
+    n->prev = after;
+    n->next = before;
+    if (after != NODE_NONE) NODE(policy, after)->next = slot;
+    else l->head = slot;
+    if (before != NODE_NONE) NODE(policy, before)->prev = slot;
+    else l->tail = slot;
+    l->len++;
+}
+
+static void
+list_push_front(ClipiumEvictPolicy *policy, guint list, guint slot)
+{
+    list_insert_before(policy, list, slot, policy->lists[list].head);
+}
+
+/* --- FIFO / LRU --- */
+
+/* Keep a list sorted by stamp. Fresh entries go straight to the head;
+ * older stamps (unpin, bulk load) are placed by walking from the tail, which
+ * is O(1) for rows loaded newest-first. */
+static void
+stamp_list_insert(ClipiumEvictPolicy *policy, guint list, guint slot, gint64 stamp)
+{
+    EvictList *l = &policy->lists[list];
+    NODE(policy, slot)->stamp = stamp;
+
+    if (l->head == NODE_NONE || stamp >= NODE(policy, l->head)->stamp) {
+        list_push_front(policy, list, slot);
+        return;
+    }
+
+    guint before = NODE_NONE;
+    for (guint at = l->tail; at != NODE_NONE && NODE(policy, at)->stamp < stamp;
+         at = NODE(policy, at)->prev)
+        before = at;
+    list_insert_before(policy, list, slot, before);
+}
+
+/* --- LFU --- */
+
+static gboolean
+lfu_run_front(ClipiumEvictPolicy *policy, guint freq, guint *slot)
+{
+    gpointer value;
+    if (!g_hash_table_lookup_extended(policy->run_fronts, GUINT_TO_POINTER(freq), NULL, &value))
+        return FALSE;
+    *slot = GPOINTER_TO_UINT(value);
+    return TRUE;
+}
+
+static void
+lfu_set_run_front(ClipiumEvictPolicy *policy, guint freq, guint slot)
+{
+    g_hash_table_insert(policy->run_fronts, GUINT_TO_POINTER(freq), GUINT_TO_POINTER(slot));
+}
+
+/* If `slot` fronts its run, hand the role to the next node of the same
+ * frequency, or drop the run */
+static void
+lfu_leave_run(ClipiumEvictPolicy *policy, guint slot)
+{
+    EvictNode *n = NODE(policy, slot);
+    guint front;
+    if (!lfu_run_front(policy, n->freq, &front) || front != slot)
+        return;
+    if (n->next != NODE_NONE && NODE(policy, n->next)->freq == n->freq)
+        lfu_set_run_front(policy, n->freq, n->next);
+    else
+        g_hash_table_remove(policy->run_fronts, GUINT_TO_POINTER(n->freq));
+}
+
+static void
+lfu_insert(ClipiumEvictPolicy *policy, guint slot, guint freq, gint64 stamp)
+{
+    EvictList *l = &policy->lists[LIST_MAIN];
+    guint front, before = NODE_NONE;
+
+    if (lfu_run_front(policy, freq, &front) && stamp >= NODE(policy, front)->stamp) {
+        before = front;
+    } else {
+        /* Walk from the tail past lower counts and older uses of this count.
+         * Rows loaded newest-first land at the tail, so this is normally O(1). */
+        for (guint at = l->tail; at != NODE_NONE; at = NODE(policy, at)->prev) {
+            EvictNode *a = NODE(policy, at);
+            if (a->freq > freq || (a->freq == freq && a->stamp >= stamp))
+                break;
+            before = at;
+        }
+    }
+
+    EvictNode *n = NODE(policy, slot);
+    n->freq = freq;
+    n->stamp = stamp;
+    gboolean had_run = lfu_run_front(policy, freq, &front);
+    list_insert_before(policy, LIST_MAIN, slot, before);
+    if (!had_run || front == before)
+        lfu_set_run_front(policy, freq, slot);
+}
+
+static void
+lfu_touch(ClipiumEvictPolicy *policy, guint slot, gint64 stamp)
+{
+    EvictNode *n = NODE(policy, slot);
+    guint freq = n->freq;
+    guint front;
+    gboolean was_front = lfu_run_front(policy, freq, &front) && front == slot;
+
+    lfu_leave_run(policy, slot);
+
+    guint before;
+    if (lfu_run_front(policy, freq + 1, &before)) {
+        list_unlink(policy, slot);
+        list_insert_before(policy, LIST_MAIN, slot, before);
+    } else if (!was_front) {
+        /* No run for freq + 1: everything ahead of run `freq` counts at least
+         * freq + 2, so the node belongs right in front of that run */
+        lfu_run_front(policy, freq, &before);
+        list_unlink(policy, slot);
+        list_insert_before(policy, LIST_MAIN, slot, before);
+    }
+
+    NODE(policy, slot)->freq = freq + 1;
+    NODE(policy, slot)->stamp = stamp;
+    lfu_set_run_front(policy, freq + 1, slot);
+}
+
+/* --- ARC --- */
+
+static void
+arc_ghost_forget(GQueue *ghosts, GHashTable *index, const ClipiumHash *key)
+{
+    GList *link = g_hash_table_lookup(index, key);
+    if (!link)
+        return;
+    g_hash_table_remove(index, key);
+    g_free(link->data);
+    g_queue_delete_link(ghosts, link);
+}
+
+static void
+arc_ghost_add(ClipiumEvictPolicy *policy, gboolean from_t2, const ClipiumHash *key)
+{
+    arc_ghost_forget(&policy->ghosts_b1, policy->ghost_b1_index, key);
+    arc_ghost_forget(&policy->ghosts_b2, policy->ghost_b2_index, key);
+
+    GQueue *ghosts = from_t2 ? &policy->ghosts_b2 : &policy->ghosts_b1;
+    GHashTable *index = from_t2 ? policy->ghost_b2_index : policy->ghost_b1_index;
+
+    ClipiumHash *copy = g_memdup2(key, sizeof(*key));
+    g_queue_push_head(ghosts, copy);
+    g_hash_table_insert(index, copy, ghosts->head);
+
+    while (ghosts->length > MAX(policy->capacity, 1)) {
+        ClipiumHash *old = g_queue_pop_tail(ghosts);
+        g_hash_table_remove(index, old);
+        g_free(old);
+    }
+}
+
+static void
+arc_insert(ClipiumEvictPolicy *policy, guint slot, const ClipiumHash *key,
+           gint64 stamp, guint hits)
+{
+    guint b1 = policy->ghosts_b1.length;
+    guint b2 = policy->ghosts_b2.length;
+    guint list = hits > 0 ? LIST_T2 : LIST_T1;
+
+    if (key && g_hash_table_contains(policy->ghost_b1_index, key)) {
+        /* Evicted from T1 too early: give recency more room */
+        guint delta = MAX(b2 / MAX(b1, 1), 1);
+        policy->target_t1 = MIN(policy->capacity, policy->target_t1 + delta);
+        arc_ghost_forget(&policy->ghosts_b1, policy->ghost_b1_index, key);
+        list = LIST_T2;
+    } else if (key && g_hash_table_contains(policy->ghost_b2_index, key)) {
+        /* Evicted from T2 too early: give frequency more room */
+        guint delta = MAX(b1 / MAX(b2, 1), 1);
+        policy->target_t1 = policy->target_t1 > delta ? policy->target_t1 - delta : 0;
+        arc_ghost_forget(&policy->ghosts_b2, policy->ghost_b2_index, key);
+        list = LIST_T2;
+    }
+
+    stamp_list_insert(policy, list, slot, stamp);
+}
+
+/* ARC's REPLACE: evict from T1 while it is over its target, else from T2 */
+static guint
+arc_preferred_list(ClipiumEvictPolicy *policy)
+{
+    guint t1 = policy->lists[LIST_T1].len;
+    if (t1 > 0 && (t1 > policy->target_t1 || policy->lists[LIST_T2].len == 0))
+        return LIST_T1;
+    return LIST_T2;
+}
+
+/* --- Public API --- */
+
+ClipiumEvictPolicy *
+clipium_evict_policy_new(ClipiumEvictKind kind, guint capacity)
+{
+    ClipiumEvictPolicy *policy = g_new0(ClipiumEvictPolicy, 1);
+    policy->kind = kind;
+    policy->capacity = capacity;
+    policy->nodes = g_array_new(FALSE, TRUE, sizeof(EvictNode));
+    policy->run_fronts = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_queue_init(&policy->ghosts_b1);
+    g_queue_init(&policy->ghosts_b2);
+    policy->ghost_b1_index = g_hash_table_new(clipium_hash_hash, clipium_hash_equal);
+    policy->ghost_b2_index = g_hash_table_new(clipium_hash_hash, clipium_hash_equal);
+    clipium_evict_policy_clear(policy);
+    return policy;
+}
+
+void
+clipium_evict_policy_free(ClipiumEvictPolicy *policy)
+{
+    if (!policy) return;
+    clipium_evict_policy_clear(policy);
+    g_array_free(policy->nodes, TRUE);
+    g_hash_table_destroy(policy->run_fronts);
+    g_hash_table_destroy(policy->ghost_b1_index);
+    g_hash_table_destroy(policy->ghost_b2_index);
+    g_free(policy);
+}
+
+ClipiumEvictKind
+clipium_evict_policy_kind(ClipiumEvictPolicy *policy)
+{
+    return policy->kind;
+}
+
+void
+clipium_evict_policy_clear(ClipiumEvictPolicy *policy)
+{
+    g_array_set_size(policy->nodes, 0);
+    for (guint i = 0; i < N_LISTS; i++)
+        policy->lists[i] = (EvictList){ NODE_NONE, NODE_NONE, 0 };
+    g_hash_table_remove_all(policy->run_fronts);
+    g_hash_table_remove_all(policy->ghost_b1_index);
+    g_hash_table_remove_all(policy->ghost_b2_index);
+    g_queue_clear_full(&policy->ghosts_b1, g_free);
+    g_queue_clear_full(&policy->ghosts_b2, g_free);
+    policy->target_t1 = 0;
+}
+
+void
+clipium_evict_policy_insert(ClipiumEvictPolicy *policy,
+                            guint               slot,
+                            const ClipiumHash  *key,
+                            gint64              stamp,
+                            guint               hits)
+{
+    EvictNode *n = node_get(policy, slot);
+    g_return_if_fail(n->list == LIST_NONE);
+    n->prev = n->next = NODE_NONE;
+
+    switch (policy->kind) {
+    case CLIPIUM_EVICT_FIFO:
+    case CLIPIUM_EVICT_LRU:
+        stamp_list_insert(policy, LIST_MAIN, slot, stamp);
+        break;
+    case CLIPIUM_EVICT_LFU:
+        lfu_insert(policy, slot, hits + 1, stamp);
+        break;
+    case CLIPIUM_EVICT_ARC:
+        arc_insert(policy, slot, key, stamp, hits);
+        break;
+    }
+}
+
+void
+clipium_evict_policy_touch(ClipiumEvictPolicy *policy,
+                           guint               slot,
+                           gint64              stamp,
+                           gboolean            copied)
+{
+    if (slot >= policy->nodes->len || NODE(policy, slot)->list == LIST_NONE)
+        return;
+
+    switch (policy->kind) {
+    case CLIPIUM_EVICT_FIFO:
+        if (!copied)
+            break;
+        /* fall through */
+    case CLIPIUM_EVICT_LRU:
+        list_unlink(policy, slot);
+        NODE(policy, slot)->stamp = stamp;
+        list_push_front(policy, LIST_MAIN, slot);
+        break;
+    case CLIPIUM_EVICT_LFU:
+        lfu_touch(policy, slot, stamp);
+        break;
+    case CLIPIUM_EVICT_ARC:
+        list_unlink(policy, slot);
+        NODE(policy, slot)->stamp = stamp;
+        list_push_front(policy, LIST_T2, slot);
+        break;
+    }
+}
+
+void
+clipium_evict_policy_remove(ClipiumEvictPolicy *policy,
+                            guint               slot,
+                            const ClipiumHash  *key,
+                            gboolean            evicted)
+{
+    if (slot >= policy->nodes->len || NODE(policy, slot)->list == LIST_NONE)
+        return;
+
+    guint list = NODE(policy, slot)->list;
+    if (policy->kind == CLIPIUM_EVICT_LFU)
+        lfu_leave_run(policy, slot);
+    list_unlink(policy, slot);
+
+    if (policy->kind == CLIPIUM_EVICT_ARC && evicted && key)
+        arc_ghost_add(policy, list == LIST_T2, key);
+}
+
+guint
+clipium_evict_policy_first(ClipiumEvictPolicy *policy)
+{
+    if (policy->kind != CLIPIUM_EVICT_ARC)
+        return policy->lists[LIST_MAIN].tail;
+
+    guint pref = arc_preferred_list(policy);
+    guint other = pref == LIST_T1 ? LIST_T2 : LIST_T1;
+    return policy->lists[pref].tail != NODE_NONE ? policy->lists[pref].tail
+                                                  : policy->lists[other].tail;
+}
+
+guint
+clipium_evict_policy_next(ClipiumEvictPolicy *policy, guint slot)
+{
+    EvictNode *n = NODE(policy, slot);
+    if (n->prev != NODE_NONE)
+        return n->prev;
+    if (policy->kind != CLIPIUM_EVICT_ARC)
+        return NODE_NONE;
+
+    /* End of the preferred ARC list: continue with the other one */
+    guint pref = arc_preferred_list(policy);
+    if (n->list == pref && policy->lists[pref].tail != NODE_NONE)
+        return policy->lists[pref == LIST_T1 ? LIST_T2 : LIST_T1].tail;
+    return NODE_NONE;
+}
+
+static const char *const evict_kind_names[] = {
+    [CLIPIUM_EVICT_FIFO] = "fifo",
+    [CLIPIUM_EVICT_LRU]  = "lru",
+    [CLIPIUM_EVICT_LFU]  = "lfu",
+    [CLIPIUM_EVICT_ARC]  = "arc",
+};
+
+const char *
+clipium_evict_kind_to_string(ClipiumEvictKind kind)
+{
+    g_return_val_if_fail(kind < G_N_ELEMENTS(evict_kind_names), "unknown");
+    return evict_kind_names[kind];
+}
+
+gboolean
+clipium_evict_kind_from_string(const char *name, ClipiumEvictKind *kind)
+{
+    if (!name)
+        return FALSE;
+    for (guint i = 0; i < G_N_ELEMENTS(evict_kind_names); i++) {
+        if (g_ascii_strcasecmp(name, evict_kind_names[i]) == 0) {
+            *kind = (ClipiumEvictKind)i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
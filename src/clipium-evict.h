@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glib.h>
+#include "clipium-hash.h"
+
+G_BEGIN_DECLS
+
+/* Eviction policies decide which unpinned entry the store drops next.
+ * They track store slot indices only; pinned entries are never inserted. */
+typedef enum {
+    CLIPIUM_EVICT_FIFO,  /* oldest copy first (copy or re-copy refreshes) */
+    CLIPIUM_EVICT_LRU,   /* least recently copied, pasted or fetched */
+    CLIPIUM_EVICT_LFU,   /* least frequently used, oldest first within a count */
+    CLIPIUM_EVICT_ARC,   /* adaptive replacement cache (recency vs frequency) */
+} ClipiumEvictKind;
+
+typedef struct _ClipiumEvictPolicy ClipiumEvictPolicy;
+
+ClipiumEvictPolicy *clipium_evict_policy_new    (ClipiumEvictKind kind, guint capacity);
+void                clipium_evict_policy_free   (ClipiumEvictPolicy *policy);
+ClipiumEvictKind    clipium_evict_policy_kind   (ClipiumEvictPolicy *policy);
+void                clipium_evict_policy_clear  (ClipiumEvictPolicy *policy);
+
+/* Start tracking a slot. `key` identifies the content across evictions (ARC
+ * ghost lists); `stamp` is the last use time and `hits` the access count,
+ * so an entry that is unpinned or reloaded keeps its standing. */
+void                clipium_evict_policy_insert (ClipiumEvictPolicy *policy,
+                                                 guint               slot,
+                                                 const ClipiumHash  *key,
+                                                 gint64              stamp,
+                                                 guint               hits);
+
+/* Record a use. `copied` is TRUE for a re-copy (dedup bump), FALSE for a
+ * paste or fetch; FIFO only reacts to copies. */
+void                clipium_evict_policy_touch  (ClipiumEvictPolicy *policy,
+                                                 guint               slot,
+                                                 gint64              stamp,
+                                                 gboolean            copied);
+
+/* Stop tracking a slot; `evicted` lets ARC remember the key as a ghost */
+void                clipium_evict_policy_remove (ClipiumEvictPolicy *policy,
+                                                 guint               slot,
+                                                 const ClipiumHash  *key,
+                                                 gboolean            evicted);
+
+/* Walk candidates from the best victim onwards; G_MAXUINT ends the walk.
+ * The order is only valid until the next policy mutation. */
+guint               clipium_evict_policy_first  (ClipiumEvictPolicy *policy);
+guint               clipium_evict_policy_next   (ClipiumEvictPolicy *policy, guint slot);
+
+const char         *clipium_evict_kind_to_string  (ClipiumEvictKind kind);
+gboolean            clipium_evict_kind_from_string(const char *name, ClipiumEvictKind *kind);
+
+G_END_DECLS
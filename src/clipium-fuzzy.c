@@ -1,22 +1,118 @@
 #include "clipium-fuzzy.h"
 #include <string.h>
 #include <ctype.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+guint64
+clipium_fuzzy_char_mask(const char *text, gsize len)
+{
+    guint64 mask = 0;
+    for (gsize i = 0; i < len; i++)
+        mask |= G_GUINT64_CONSTANT(1) << (tolower((unsigned char)text[i]) & 63);
+    return mask;
+}
+
+/* --- Search keys --- */
+
+static inline void
+fold_append(GString *key, GArray *offsets, const char *bytes, gsize n, guint offset)
+{
+    g_string_append_len(key, bytes, (gssize)n);
+    for (gsize i = 0; offsets && i < n; i++)
+        g_array_append_val(offsets, offset);
+}
+
+char *
+clipium_fuzzy_fold(const char *text, gsize len, GArray *offsets)
+{
+    GString *key = g_string_sized_new(len);
+    const char *p = text, *end = text + len;
+
+    while (p < end) {
+        guint offset = (guint)(p - text);
+        if ((guchar)*p < 0x80) {
+            fold_append(key, offsets, p++, 1, offset);
+            continue;
+        }
+
+        gunichar ch = g_utf8_get_char_validated(p, end - p);
+        if (ch == (gunichar)-1 || ch == (gunichar)-2) {
+            fold_append(key, offsets, p++, 1, offset);  /* not UTF-8: keep the byte */
+            continue;
+        }
+        p = g_utf8_next_char(p);
+
+        gunichar decomposed[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+        gsize n = g_unichar_fully_decompose(ch, TRUE, decomposed, G_N_ELEMENTS(decomposed));
+        for (gsize i = 0; i < n; i++) {
+            char buf[6];
+            if (g_unichar_ismark(decomposed[i]))
+                continue;
+            if (decomposed[i] < 0x80) {
+                buf[0] = (char)decomposed[i];
+                fold_append(key, offsets, buf, 1, offset);
+                continue;
+            }
+            gint buf_len = g_unichar_to_utf8(decomposed[i], buf);
+            g_autofree char *folded = g_utf8_casefold(buf, buf_len);
+            fold_append(key, offsets, folded, strlen(folded), offset);
+        }
+    }
+    return g_string_free(key, FALSE);
+}
+
+/* --- Matching --- */
+
+/* First position in s[0..len) holding c in either case, or NULL. The
+ * matcher cannot score anything before it, so it starts there. */
+static const char *
+find_first_folded(const char *s, gsize len, char c)
+{
+    char lower = (char)tolower((unsigned char)c);
+    char upper = (char)toupper((unsigned char)c);
+    if (lower == upper)
+        return memchr(s, c, len);
+
+    gsize i = 0;
+#ifdef __SSE2__
+    /* Compare 16 bytes against both cases at once */
+    const __m128i vl = _mm_set1_epi8(lower);
+    const __m128i vu = _mm_set1_epi8(upper);
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        int hits = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, vl),
+                                                  _mm_cmpeq_epi8(chunk, vu)));
+        if (hits)
+            return s + i + __builtin_ctz((unsigned)hits);
+    }
+#endif
+    for (; i < len; i++) {
+        if (s[i] == lower || s[i] == upper)
+            return s + i;
+    }
+    return NULL;
+}
 
 int
-clipium_fuzzy_match(const char *query, const char *target)
+clipium_fuzzy_match_len(const char *query, const char *target, gsize target_len)
 {
     if (!query || !*query)
         return 0;
-    if (!target || !*target)
+    if (!target || target_len == 0)
         return -1;
 
     const char *q = query;
-    const char *t = target;
+    const char *end = target + target_len;
+    const char *t = find_first_folded(target, target_len, *q);
+    if (!t)
+        return -1;
+
     int score = 0;
     int consecutive = 0;
-    gboolean first_char_bonus = TRUE;
 
-    while (*q && *t) {
+    while (*q && t < end) {
         char qc = (char)tolower((unsigned char)*q);
         char tc = (char)tolower((unsigned char)*t);
 
@@ -27,7 +123,7 @@ clipium_fuzzy_match(const char *query, const char *target)
                 score += consecutive * 2;
             consecutive++;
             /* Bonus for matching at start */
-            if (first_char_bonus && t == target)
+            if (t == target)
                 score += 10;
             /* Bonus for matching after separator */
             if (t > target) {
@@ -39,7 +135,6 @@ clipium_fuzzy_match(const char *query, const char *target)
         } else {
             consecutive = 0;
         }
-        first_char_bonus = FALSE;
         t++;
     }
 
@@ -49,3 +144,321 @@ clipium_fuzzy_match(const char *query, const char *target)
 
     return score;
 }
+
+int
+clipium_fuzzy_match(const char *query, const char *target)
+{
+    if (!query || !*query)
+        return 0;
+    if (!target)
+        return -1;
+    return clipium_fuzzy_match_len(query, target, strlen(target));
+}
+
+/* --- Optimal alignment (fzf v2) --- */
+
+#define SCORE_MATCH              16
+#define SCORE_GAP_START          (-3)
+#define SCORE_GAP_EXTENSION      (-1)
+#define BONUS_BOUNDARY           (SCORE_MATCH / 2)
+#define BONUS_BOUNDARY_WHITE     (BONUS_BOUNDARY + 2)
+#define BONUS_BOUNDARY_DELIMITER (BONUS_BOUNDARY + 1)
+#define BONUS_NON_WORD           (SCORE_MATCH / 2)
+#define BONUS_CAMEL123           (BONUS_BOUNDARY + SCORE_GAP_EXTENSION)
+#define BONUS_CONSECUTIVE        (-(SCORE_GAP_START + SCORE_GAP_EXTENSION))
+#define BONUS_FIRST_CHAR_MULTIPLIER 2
+
+/* Score matrix bounds: beyond these the greedy path takes over */
+#define FUZZY_MAX_QUERY 64
+#define FUZZY_MAX_CELLS 16384
+
+/* Word characters sort after the separators, so `cls > CHAR_NON_WORD`
+ * tests for one; non-ASCII bytes count as letters */
+typedef enum {
+    CHAR_WHITE,
+    CHAR_NON_WORD,
+    CHAR_DELIMITER,
+    CHAR_LOWER,
+    CHAR_UPPER,
+    CHAR_NUMBER,
+} CharClass;
+
+/* Per-thread scratch space, so scoring never allocates */
+typedef struct {
+    gint16 h[FUZZY_MAX_CELLS];   /* best score ending at (row, col) */
+    gint16 c[FUZZY_MAX_CELLS];   /* length of the consecutive run there */
+    gint16 b[FUZZY_MAX_CELLS];   /* bonus of each column */
+    gsize  f[FUZZY_MAX_QUERY];   /* first possible column of each row */
+} FuzzySlab;
+
+static GPrivate fuzzy_slab = G_PRIVATE_INIT(g_free);
+
+static inline guchar
+fold(char c)
+{
+    return (guchar)g_ascii_tolower(c);
+}
+
+static inline CharClass
+char_class(char ch)
+{
+    guchar c = (guchar)ch;
+    if (c >= 'a' && c <= 'z') return CHAR_LOWER;
+    if (c >= 'A' && c <= 'Z') return CHAR_UPPER;
+    if (c >= '0' && c <= '9') return CHAR_NUMBER;
+    if (c >= 0x80) return CHAR_LOWER;
+    if (c == ' ' || (c >= '\t' && c <= '\r')) return CHAR_WHITE;
+    if (c == '/' || c == ',' || c == ':' || c == ';' || c == '|') return CHAR_DELIMITER;
+    return CHAR_NON_WORD;
+}
+
+static inline gint16
+bonus_for(CharClass prev, CharClass cls)
+{
+    if (cls > CHAR_NON_WORD) {
+        if (prev == CHAR_WHITE) return BONUS_BOUNDARY_WHITE;
+        if (prev == CHAR_DELIMITER) return BONUS_BOUNDARY_DELIMITER;
+        if (prev == CHAR_NON_WORD) return BONUS_BOUNDARY;
+    }
+    if ((prev == CHAR_LOWER && cls == CHAR_UPPER) ||
+        (prev != CHAR_NUMBER && cls == CHAR_NUMBER))
+        return BONUS_CAMEL123;
+    if (cls == CHAR_NON_WORD || cls == CHAR_DELIMITER) return BONUS_NON_WORD;
+    if (cls == CHAR_WHITE) return BONUS_BOUNDARY_WHITE;
+    return 0;
+}
+
+int
+clipium_fuzzy_run_score(gsize query_len)
+{
+    if (query_len == 0)
+        return 0;
+    return (int)MIN(query_len * SCORE_MATCH + (query_len - 1) * BONUS_CONSECUTIVE,
+                    (gsize)G_MAXINT / 2);
+}
+
+/* Score the greedy alignment of target[sidx..eidx) the way the matrix
+ * would, appending positions if asked */
+static int
+fuzzy_window_score(const char *query, const char *target, gsize sidx, gsize eidx,
+                   GArray *positions)
+{
+    int score = 0;
+    int consecutive = 0;
+    gint16 first_bonus = 0;
+    gboolean in_gap = FALSE;
+    gsize pidx = 0;
+    CharClass prev = sidx > 0 ? char_class(target[sidx - 1]) : CHAR_WHITE;
+
+    for (gsize i = sidx; i < eidx; i++) {
+        CharClass cls = char_class(target[i]);
+        if (query[pidx] && fold(target[i]) == fold(query[pidx])) {
+            if (positions) {
+                guint pos = (guint)i;
+                g_array_append_val(positions, pos);
+            }
+            gint16 bonus = bonus_for(prev, cls);
+            if (consecutive == 0) {
+                first_bonus = bonus;
+            } else {
+                /* A boundary inside a run starts a new chunk */
+                if (bonus >= BONUS_BOUNDARY && bonus > first_bonus)
+                    first_bonus = bonus;
+                bonus = MAX(MAX(bonus, first_bonus), BONUS_CONSECUTIVE);
+            }
+            score += SCORE_MATCH + (pidx == 0 ? bonus * BONUS_FIRST_CHAR_MULTIPLIER : bonus);
+            in_gap = FALSE;
+            consecutive++;
+            pidx++;
+        } else {
+            score += in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            in_gap = TRUE;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+        prev = cls;
+    }
+    /* Long gaps can outweigh the matches; it is still a match */
+    return MAX(score, 0);
+}
+
+/* Greedy fast path: the first window that contains the query, narrowed
+ * from its end backwards, then scored as one alignment */
+static int
+fuzzy_greedy(const char *query, gsize m, const char *target, gsize n, GArray *positions)
+{
+    gsize pidx = 0, eidx = 0;
+    for (gsize i = 0; i < n; i++) {
+        if (fold(target[i]) == fold(query[pidx]) && ++pidx == m) {
+            eidx = i + 1;
+            break;
+        }
+    }
+    if (pidx < m)
+        return -1;
+
+    gsize sidx = eidx;
+    for (gsize i = eidx; i > 0 && pidx > 0; i--) {
+        if (fold(target[i - 1]) == fold(query[pidx - 1])) {
+            pidx--;
+            sidx = i - 1;
+        }
+    }
+    return fuzzy_window_score(query, target, sidx, eidx, positions);
+}
+
+int
+clipium_fuzzy_score(const char *query, const char *target, gsize target_len, GArray *positions)
+{
+    if (!query || !*query)
+        return 0;
+    if (!target || target_len == 0)
+        return -1;
+
+    gsize m = strlen(query);
+    if (m > target_len)
+        return -1;
+    if (m > FUZZY_MAX_QUERY)
+        return fuzzy_greedy(query, m, target, target_len, positions);
+
+    FuzzySlab *slab = g_private_get(&fuzzy_slab);
+    if (!slab) {
+        slab = g_new(FuzzySlab, 1);
+        g_private_set(&fuzzy_slab, slab);
+    }
+
+    /* Phase 1: first column each query byte can match at, and the last
+     * occurrence of the final byte; nothing outside that window scores */
+    const char *first = find_first_folded(target, target_len, query[0]);
+    if (!first)
+        return -1;
+    gsize min_idx = (gsize)(first - target);
+    gsize last_idx = min_idx;
+    gsize pidx = 0;
+    guchar pchar = fold(query[0]);
+    for (gsize i = min_idx; i < target_len; i++) {
+        if (fold(target[i]) != pchar)
+            continue;
+        if (pidx < m) {
+            slab->f[pidx++] = i;
+            pchar = fold(query[MIN(pidx, m - 1)]);
+        }
+        last_idx = i;
+    }
+    if (pidx < m)
+        return -1;
+
+    gsize width = last_idx - min_idx + 1;
+    if (m * width > FUZZY_MAX_CELLS)
+        return fuzzy_greedy(query, m, target, target_len, positions);
+
+    gint16 *H = slab->h, *C = slab->c, *B = slab->b;
+    const gsize *F = slab->f;
+    memset(C, 0, m * width * sizeof(gint16));
+
+    /* Phase 2: column bonuses and the first row */
+    gint16 max_score = 0;
+    gsize max_pos = min_idx;
+    gint16 prev_h = 0;
+    gboolean in_gap = FALSE;
+    CharClass prev = min_idx > 0 ? char_class(target[min_idx - 1]) : CHAR_WHITE;
+    guchar q0 = fold(query[0]);
+    for (gsize off = 0; off < width; off++) {
+        char ch = target[min_idx + off];
+        CharClass cls = char_class(ch);
+        B[off] = bonus_for(prev, cls);
+        prev = cls;
+
+        if (fold(ch) == q0) {
+            H[off] = (gint16)(SCORE_MATCH + B[off] * BONUS_FIRST_CHAR_MULTIPLIER);
+            C[off] = 1;
+            if (m == 1 && H[off] > max_score) {
+                max_score = H[off];
+                max_pos = min_idx + off;
+            }
+            in_gap = FALSE;
+        } else {
+            H[off] = (gint16)MAX(prev_h + (in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START), 0);
+            in_gap = TRUE;
+        }
+        prev_h = H[off];
+    }
+
+    /* Phase 3: the remaining rows, from each row's first possible column */
+    for (gsize row = 1; row < m; row++) {
+        gint16 *h_row = H + row * width, *h_up = H + (row - 1) * width;
+        gint16 *c_row = C + row * width, *c_up = C + (row - 1) * width;
+        guchar qc = fold(query[row]);
+        gsize f = F[row] - min_idx;
+
+        h_row[f - 1] = 0;
+        in_gap = FALSE;
+        for (gsize off = f; off < width; off++) {
+            gint16 s1 = 0, consecutive = 0;
+            gint16 s2 = (gint16)(h_row[off - 1] + (in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START));
+
+            if (fold(target[min_idx + off]) == qc) {
+                s1 = (gint16)(h_up[off - 1] + SCORE_MATCH);
+                gint16 b = B[off];
+                consecutive = (gint16)(c_up[off - 1] + 1);
+                if (consecutive > 1) {
+                    gint16 fb = B[off - (gsize)consecutive + 1];
+                    /* A boundary inside a run starts a new chunk */
+                    if (b >= BONUS_BOUNDARY && b > fb)
+                        consecutive = 1;
+                    else
+                        b = MAX(b, MAX(BONUS_CONSECUTIVE, fb));
+                }
+                if (s1 + b < s2) {
+                    s1 = (gint16)(s1 + B[off]);
+                    consecutive = 0;
+                } else {
+                    s1 = (gint16)(s1 + b);
+                }
+            }
+
+            c_row[off] = consecutive;
+            in_gap = s1 < s2;
+            gint16 score = MAX(MAX(s1, s2), 0);
+            if (row == m - 1 && score > max_score) {
+                max_score = score;
+                max_pos = min_idx + off;
+            }
+            h_row[off] = score;
+        }
+    }
+
+    if (!positions)
+        return max_score;
+
+    /* Phase 4: walk back from the best cell, preferring to stay on a
+     * consecutive run when a match and a gap score the same */
+    guint start = positions->len;
+    gsize i = m - 1, j = max_pos;
+    gboolean prefer_match = TRUE;
+    for (;;) {
+        gsize row = i, j0 = j - min_idx;
+        gint16 s = H[row * width + j0];
+        gint16 s1 = (row > 0 && j >= F[row]) ? H[(row - 1) * width + j0 - 1] : 0;
+        gint16 s2 = j > F[row] ? H[row * width + j0 - 1] : 0;
+
+        if (s > s1 && (s > s2 || (s == s2 && prefer_match))) {
+            guint pos = (guint)j;
+            g_array_append_val(positions, pos);
+            if (i == 0)
+                break;
+            i--;
+        }
+        prefer_match = C[row * width + j0] > 1 ||
+                       (row + 1 < m && j0 + 1 < width && C[(row + 1) * width + j0 + 1] > 0);
+        j--;
+    }
+
+    /* Collected back to front */
+    for (guint a = start, z = positions->len - 1; a < z; a++, z--) {
+        guint tmp = g_array_index(positions, guint, a);
+        g_array_index(positions, guint, a) = g_array_index(positions, guint, z);
+        g_array_index(positions, guint, z) = tmp;
+    }
+    return max_score;
+}
@@ -6,6 +6,50 @@ G_BEGIN_DECLS
 
 /* Returns a score >= 0 if query fuzzy-matches target, -1 if no match.
  * Higher score = better match. */
-int clipium_fuzzy_match(const char *query, const char *target);
+int     clipium_fuzzy_match     (const char *query, const char *target);
+
+/* Same, for a target of known length (need not be NUL-terminated) */
+int     clipium_fuzzy_match_len (const char *query, const char *target, gsize target_len);
+
+/* Optimal alignment in the style of fzf's v2 algorithm: Smith-Waterman
+ * over query × target with gap penalties, bonuses for matches at word
+ * boundaries, camelCase humps and digits, and for consecutive runs.
+ * ASCII case-insensitive. Returns -1 if the query is not a subsequence of
+ * the target, otherwise the score; when `positions` is non-NULL the
+ * matched byte offsets (guint, ascending) are appended to it. Long targets
+ * and queries, whose score matrix would not fit the per-thread slab, are
+ * scored greedily over the shortest matching window instead. */
+int     clipium_fuzzy_score     (const char *query,
+                                 const char *target,
+                                 gsize       target_len,
+                                 GArray     *positions);
+
+/* Score of a query matched as one contiguous run inside a word, on the
+ * clipium_fuzzy_score scale, for hits found without aligning */
+int     clipium_fuzzy_run_score (gsize query_len);
+
+/* Search key of `text`: NFKD-decomposed, combining marks dropped and
+ * non-ASCII characters case-folded, so "Straße" keys as "Strasse" and
+ * "École" as "Ecole". ASCII passes through as is: the matcher folds its
+ * case itself and needs it for camelCase bonuses. When `offsets` is
+ * non-NULL, the byte offset in `text` (guint) of the character each key
+ * byte came from is appended to it, to map matched positions back. */
+char   *clipium_fuzzy_fold      (const char *text, gsize len, GArray *offsets);
+
+/* Whether `text` has anything clipium_fuzzy_fold would change */
+static inline gboolean
+clipium_fuzzy_needs_fold(const char *text, gsize len)
+{
+    for (gsize i = 0; i < len; i++) {
+        if ((guchar)text[i] >= 0x80)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* One bit per folded character (ASCII case-insensitive, bytes hashed into
+ * 64 bits). A target can only match a query if its mask has every bit of
+ * the query's: (query_mask & ~target_mask) != 0 rules it out. */
+guint64 clipium_fuzzy_char_mask (const char *text, gsize len);
 
 G_END_DECLS
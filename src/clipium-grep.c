@@ -0,0 +1,185 @@
+#include "clipium-grep.h"
+#include <string.h>
+
+gboolean
+clipium_search_mode_from_string(const char *name, ClipiumSearchMode *mode)
+{
+    if (g_str_equal(name, "fuzzy"))
+        *mode = CLIPIUM_SEARCH_FUZZY;
+    else if (g_str_equal(name, "literal"))
+        *mode = CLIPIUM_SEARCH_LITERAL;
+    else if (g_str_equal(name, "regex"))
+        *mode = CLIPIUM_SEARCH_REGEX;
+    else
+        return FALSE;
+    return TRUE;
+}
+
+char *
+clipium_search_mode_split(const char *input, ClipiumSearchMode *mode)
+{
+    const char *pattern = NULL;
+    gsize len = 0;
+    if (g_str_has_prefix(input, "re:")) {
+        *mode = CLIPIUM_SEARCH_REGEX;
+        pattern = input + 3;
+        len = strlen(pattern);
+    } else if (input[0] == '"') {
+        *mode = CLIPIUM_SEARCH_LITERAL;
+        pattern = input + 1;
+        len = strlen(pattern);
+        if (len > 0 && pattern[len - 1] == '"')
+            len--;
+    }
+
+    /* A bare prefix is a pattern still being typed: list as usual */
+    if (!pattern || len == 0) {
+        *mode = CLIPIUM_SEARCH_FUZZY;
+        return g_strdup(pattern ? "" : input);
+    }
+    return g_strndup(pattern, len);
+}
+
+/* --- Literal scan --- */
+
+/* Rough frequency class of a byte in clipboard text, lower is rarer */
+static guint
+byte_rank(guchar c)
+{
+    if (c == ' ' || g_ascii_islower(c))
+        return 3;
+    if (c >= 0x80 || g_ascii_isalnum(c) || g_ascii_isspace(c))
+        return 2;
+    return 1;  /* punctuation and control bytes */
+}
+
+gboolean
+clipium_grep_literal_find(const char *haystack, gsize haystack_len,
+                          const char *needle,   gsize needle_len)
+{
+    if (needle_len == 0)
+        return TRUE;
+    if (needle_len > haystack_len)
+        return FALSE;
+
+    /* Search for whichever end of the needle is rarer; `anchor` is its
+     * offset in the needle */
+    gsize last = needle_len - 1;
+    gsize anchor = byte_rank((guchar)needle[last]) < byte_rank((guchar)needle[0]) ? last : 0;
+    guchar c = (guchar)needle[anchor];
+    const char *p = haystack + anchor;
+    const char *end = haystack + haystack_len - (last - anchor);
+
+    while (p < end) {
+        const char *hit = memchr(p, c, (gsize)(end - p));
+        if (!hit)
+            return FALSE;
+        const char *start = hit - anchor;
+        if (start[0] == needle[0] && start[last] == needle[last] &&
+            memcmp(start, needle, needle_len) == 0)
+            return TRUE;
+        p = hit + 1;
+    }
+    return FALSE;
+}
+
+/* --- Regex cache --- */
+
+typedef struct {
+    char   *pattern;
+    GRegex *regex;
+} CachedRegex;
+
+struct _ClipiumRegexCache {
+    GHashTable *by_pattern;  /* pattern → GList* in lru */
+    GQueue      lru;         /* CachedRegex*, most recent first */
+    guint       max_patterns;
+    guint64     hits;
+    GMutex      lock;
+};
+
+static void
+cached_regex_free(CachedRegex *cr)
+{
+    g_free(cr->pattern);
+    g_regex_unref(cr->regex);
+    g_free(cr);
+}
+
+ClipiumRegexCache *
+clipium_regex_cache_new(guint max_patterns)
+{
+    ClipiumRegexCache *cache = g_new0(ClipiumRegexCache, 1);
+    cache->by_pattern = g_hash_table_new(g_str_hash, g_str_equal);
+    g_queue_init(&cache->lru);
+    cache->max_patterns = MAX(max_patterns, 1);
+    g_mutex_init(&cache->lock);
+    return cache;
+}
+
+void
+clipium_regex_cache_free(ClipiumRegexCache *cache)
+{
+    if (!cache) return;
+    g_queue_clear_full(&cache->lru, (GDestroyNotify)cached_regex_free);
+    g_hash_table_destroy(cache->by_pattern);
+    g_mutex_clear(&cache->lock);
+    g_free(cache);
+}
+
+GRegex *
+clipium_regex_cache_get(ClipiumRegexCache *cache, const char *pattern, GError **error)
+{
+    g_mutex_lock(&cache->lock);
+    GList *link = g_hash_table_lookup(cache->by_pattern, pattern);
+    if (link) {
+        g_queue_unlink(&cache->lru, link);
+        g_queue_push_head_link(&cache->lru, link);
+        cache->hits++;
+        GRegex *regex = g_regex_ref(((CachedRegex *)link->data)->regex);
+        g_mutex_unlock(&cache->lock);
+        return regex;
+    }
+    g_mutex_unlock(&cache->lock);
+
+    /* Compile without the lock; if another thread raced us to the same
+     * pattern, keep its copy */
+    GRegex *regex = g_regex_new(pattern, G_REGEX_MULTILINE, G_REGEX_MATCH_DEFAULT, error);
+    if (!regex)
+        return NULL;
+
+    g_mutex_lock(&cache->lock);
+    if (!g_hash_table_contains(cache->by_pattern, pattern)) {
+        CachedRegex *cr = g_new(CachedRegex, 1);
+        cr->pattern = g_strdup(pattern);
+        cr->regex = g_regex_ref(regex);
+        g_queue_push_head(&cache->lru, cr);
+        g_hash_table_insert(cache->by_pattern, cr->pattern, cache->lru.head);
+        while (cache->lru.length > cache->max_patterns) {
+            CachedRegex *old = g_queue_pop_tail(&cache->lru);
+            g_hash_table_remove(cache->by_pattern, old->pattern);
+            cached_regex_free(old);
+        }
+    }
+    g_mutex_unlock(&cache->lock);
+    return regex;
+}
+
+guint64
+clipium_regex_cache_hits(ClipiumRegexCache *cache)
+{
+    g_mutex_lock(&cache->lock);
+    guint64 hits = cache->hits;
+    g_mutex_unlock(&cache->lock);
+    return hits;
+}
+
+/* GRegex matches UTF-8, and PCRE is not told to re-check it, so anything
+ * else is turned away up front */
+gboolean
+clipium_regex_find(GRegex *regex, const char *text, gsize len)
+{
+    if (len > G_MAXSSIZE || !g_utf8_validate(text, (gssize)len, NULL))
+        return FALSE;
+    return g_regex_match_full(regex, text, (gssize)len, 0, G_REGEX_MATCH_DEFAULT, NULL, NULL);
+}
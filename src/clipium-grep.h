@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* How a query is matched. Fuzzy is the default; the exact modes look for
+ * the pattern anywhere in the full content of text entries. */
+typedef enum {
+    CLIPIUM_SEARCH_FUZZY,
+    CLIPIUM_SEARCH_LITERAL,   /* case-sensitive substring */
+    CLIPIUM_SEARCH_REGEX,     /* GRegex (PCRE) syntax, multi-line */
+} ClipiumSearchMode;
+
+/* "fuzzy", "literal" or "regex"; FALSE if `name` is none of those */
+gboolean     clipium_search_mode_from_string(const char *name, ClipiumSearchMode *mode);
+
+/* Split a typed query into its mode and pattern: "re:PATTERN" is a regex
+ * and "\"TEXT\"" a literal (the closing quote may be left off while
+ * typing); anything else is fuzzy and comes back unchanged */
+char        *clipium_search_mode_split      (const char *input, ClipiumSearchMode *mode);
+
+/* Whether `needle` occurs in `haystack`. The scan runs on memchr, which
+ * libc vectorizes, for the rarer of the needle's first and last bytes, and
+ * only compares the whole needle where both line up. */
+gboolean     clipium_grep_literal_find      (const char *haystack, gsize haystack_len,
+                                             const char *needle,   gsize needle_len);
+
+/* Compiled regexes, most recently used kept, so typing a pattern again or
+ * repeating a search compiles nothing. Safe to use from any thread. */
+typedef struct _ClipiumRegexCache ClipiumRegexCache;
+
+ClipiumRegexCache *clipium_regex_cache_new (guint max_patterns);
+void               clipium_regex_cache_free(ClipiumRegexCache *cache);
+
+/* A new reference to the compiled `pattern`, or NULL with `error` set if it
+ * does not compile (failures are not cached) */
+GRegex            *clipium_regex_cache_get (ClipiumRegexCache *cache,
+                                            const char        *pattern,
+                                            GError           **error);
+guint64            clipium_regex_cache_hits(ClipiumRegexCache *cache);
+
+/* Whether `regex` matches somewhere in `text`, which need not be
+ * NUL-terminated. Text that is not valid UTF-8 never matches. */
+gboolean           clipium_regex_find      (GRegex *regex, const char *text, gsize len);
+
+G_END_DECLS
@@ -0,0 +1,164 @@
+#include "clipium-hash.h"
+#include <string.h>
+
+/* MurmurHash3 x64_128 (public domain, Austin Appleby), seed 0, restructured
+ * to accept input in pieces. Blocks are read little-endian so the result is
+ * the same on every host, which matters because it is persisted. */
+
+#define C1 G_GUINT64_CONSTANT(0x87c37b91114253d5)
+#define C2 G_GUINT64_CONSTANT(0x4cf5ad432745937f)
+
+static inline guint64
+rotl64(guint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline guint64
+fmix64(guint64 k)
+{
+    k ^= k >> 33;
+    k *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+    k ^= k >> 33;
+    k *= G_GUINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+    k ^= k >> 33;
+    return k;
+}
+
+static inline guint64
+load64_le(const guint8 *p)
+{
+    guint64 v;
+    memcpy(&v, p, sizeof(v));
+    return GUINT64_FROM_LE(v);
+}
+
+static inline void
+mix_block(ClipiumHasher *hasher, const guint8 *block)
+{
+    guint64 k1 = load64_le(block);
+    guint64 k2 = load64_le(block + 8);
+    guint64 h1 = hasher->h1, h2 = hasher->h2;
+
+    k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+
+    hasher->h1 = h1;
+    hasher->h2 = h2;
+}
+
+void
+clipium_hasher_init(ClipiumHasher *hasher)
+{
+    memset(hasher, 0, sizeof(*hasher));
+}
+
+void
+clipium_hasher_update(ClipiumHasher *hasher, const void *data, gsize len)
+{
+    const guint8 *p = data;
+    hasher->total += len;
+
+    /* Complete a block left over from the previous call */
+    if (hasher->tail_len > 0) {
+        gsize need = 16 - hasher->tail_len;
+        gsize take = MIN(need, len);
+        memcpy(hasher->tail + hasher->tail_len, p, take);
+        hasher->tail_len += take;
+        p += take;
+        len -= take;
+        if (hasher->tail_len < 16)
+            return;
+        mix_block(hasher, hasher->tail);
+        hasher->tail_len = 0;
+    }
+
+    for (; len >= 16; p += 16, len -= 16)
+        mix_block(hasher, p);
+
+    memcpy(hasher->tail, p, len);
+    hasher->tail_len = len;
+}
+
+void
+clipium_hasher_finish(ClipiumHasher *hasher, ClipiumHash *hash)
+{
+    const guint8 *tail = hasher->tail;
+    guint64 h1 = hasher->h1, h2 = hasher->h2;
+    guint64 k1 = 0, k2 = 0;
+
+    switch (hasher->tail_len) {
+    case 15: k2 ^= (guint64)tail[14] << 48; /* fall through */
+    case 14: k2 ^= (guint64)tail[13] << 40; /* fall through */
+    case 13: k2 ^= (guint64)tail[12] << 32; /* fall through */
+    case 12: k2 ^= (guint64)tail[11] << 24; /* fall through */
+    case 11: k2 ^= (guint64)tail[10] << 16; /* fall through */
+    case 10: k2 ^= (guint64)tail[9] << 8;   /* fall through */
+    case 9:  k2 ^= (guint64)tail[8];
+             k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+             /* fall through */
+    case 8:  k1 ^= (guint64)tail[7] << 56;  /* fall through */
+    case 7:  k1 ^= (guint64)tail[6] << 48;  /* fall through */
+    case 6:  k1 ^= (guint64)tail[5] << 40;  /* fall through */
+    case 5:  k1 ^= (guint64)tail[4] << 32;  /* fall through */
+    case 4:  k1 ^= (guint64)tail[3] << 24;  /* fall through */
+    case 3:  k1 ^= (guint64)tail[2] << 16;  /* fall through */
+    case 2:  k1 ^= (guint64)tail[1] << 8;   /* fall through */
+    case 1:  k1 ^= (guint64)tail[0];
+             k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+             break;
+    default: break;
+    }
+
+    h1 ^= (guint64)hasher->total;
+    h2 ^= (guint64)hasher->total;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    h1 = GUINT64_TO_LE(h1);
+    h2 = GUINT64_TO_LE(h2);
+    memcpy(hash->bytes, &h1, 8);
+    memcpy(hash->bytes + 8, &h2, 8);
+}
+
+void
+clipium_hash_data(const void *data, gsize len, ClipiumHash *hash)
+{
+    ClipiumHasher hasher;
+    clipium_hasher_init(&hasher);
+    clipium_hasher_update(&hasher, data, len);
+    clipium_hasher_finish(&hasher, hash);
+}
+
+guint
+clipium_hash_hash(gconstpointer key)
+{
+    /* The bytes are already well mixed: any four of them will do */
+    guint h;
+    memcpy(&h, ((const ClipiumHash *)key)->bytes, sizeof(h));
+    return h;
+}
+
+gboolean
+clipium_hash_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, CLIPIUM_HASH_LEN) == 0;
+}
+
+void
+clipium_hash_to_hex(const ClipiumHash *hash, char *hex)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (guint i = 0; i < CLIPIUM_HASH_LEN; i++) {
+        hex[i * 2]     = digits[hash->bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[hash->bytes[i] & 0xf];
+    }
+    hex[CLIPIUM_HASH_HEX_LEN] = '\0';
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* 128-bit content hash used for deduplication. Non-cryptographic
+ * (MurmurHash3 x64_128), stored as 16 raw bytes in memory and in the DB. */
+#define CLIPIUM_HASH_LEN     16
+#define CLIPIUM_HASH_HEX_LEN (CLIPIUM_HASH_LEN * 2)
+
+typedef struct {
+    guint8 bytes[CLIPIUM_HASH_LEN];
+} ClipiumHash;
+
+/* Streaming state, so content can be hashed as it is decoded */
+typedef struct {
+    guint64 h1;
+    guint64 h2;
+    guint8  tail[16];
+    gsize   tail_len;
+    gsize   total;
+} ClipiumHasher;
+
+void     clipium_hasher_init   (ClipiumHasher *hasher);
+void     clipium_hasher_update (ClipiumHasher *hasher, const void *data, gsize len);
+void     clipium_hasher_finish (ClipiumHasher *hasher, ClipiumHash *hash);
+
+void     clipium_hash_data     (const void *data, gsize len, ClipiumHash *hash);
+
+/* GHashTable callbacks for ClipiumHash* keys */
+guint    clipium_hash_hash     (gconstpointer key);
+gboolean clipium_hash_equal    (gconstpointer a, gconstpointer b);
+
+/* Lowercase hex, for IPC and logs. `hex` must hold CLIPIUM_HASH_HEX_LEN + 1. */
+void     clipium_hash_to_hex   (const ClipiumHash *hash, char *hex);
+
+G_END_DECLS
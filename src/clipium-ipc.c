@@ -77,6 +77,48 @@ json_get_string(const char *json, const char *key)
     return NULL;
 }
 
+/* Decode a base64 string value straight out of the message and hash it in
+ * the same pass, one cache-sized chunk at a time, instead of copying the
+ * string, decoding it and hashing the result separately. Characters outside
+ * the base64 alphabet (such as a JSON "\/" escape) are skipped by the
+ * decoder. */
+#define IPC_DECODE_CHUNK (64 * 1024)
+
+static guchar *
+json_get_base64_hashed(const char *json, const char *key, gsize *out_len, ClipiumHash *hash)
+{
+    g_autofree char *pattern = g_strdup_printf("\"%s\"", key);
+    const char *pos = strstr(json, pattern);
+    if (!pos) return NULL;
+
+    pos += strlen(pattern);
+    while (*pos && (*pos == ' ' || *pos == ':' || *pos == '\t')) pos++;
+    if (*pos != '"') return NULL;
+    pos++;
+
+    const char *end = strchr(pos, '"');
+    if (!end) return NULL;
+
+    gsize b64_len = (gsize)(end - pos);
+    guchar *out = g_malloc(b64_len / 4 * 3 + 3);
+    gsize written = 0;
+    gint state = 0;
+    guint save = 0;
+    ClipiumHasher hasher;
+    clipium_hasher_init(&hasher);
+
+    for (gsize off = 0; off < b64_len; off += IPC_DECODE_CHUNK) {
+        gsize n = MIN(IPC_DECODE_CHUNK, b64_len - off);
+        gsize w = g_base64_decode_step(pos + off, n, out + written, &state, &save);
+        clipium_hasher_update(&hasher, out + written, w);
+        written += w;
+    }
+
+    clipium_hasher_finish(&hasher, hash);
+    *out_len = written;
+    return out;
+}
+
 static gint64
 json_get_int(const char *json, const char *key, gint64 default_val)
 {
@@ -115,61 +157,121 @@ format_time_ago(gint64 timestamp)
 
 /* --- Entry to JSON --- */
 
+/* Without `with_content` the entry is described only, and the client
+ * fetches the content with "get" if it wants it */
 static char *
-entry_to_json(const ClipiumEntry *e)
+entry_to_json(ClipiumStore *store, const ClipiumEntry *e, gboolean with_content)
 {
     g_autofree char *preview_escaped = json_escape_string(e->preview);
     g_autofree char *mime_escaped = json_escape_string(e->mime_type);
-    g_autofree char *hash_escaped = json_escape_string(e->hash);
+    char hash_hex[CLIPIUM_HASH_HEX_LEN + 1];
+    clipium_hash_to_hex(&e->hash, hash_hex);
+    g_autofree char *hash_escaped = json_escape_string(hash_hex);
     g_autofree char *time_ago = format_time_ago(e->timestamp);
     g_autofree char *time_escaped = json_escape_string(time_ago);
 
-    /* Base64-encode content */
-    gsize content_len;
-    const guchar *content_data = g_bytes_get_data(e->content, &content_len);
-    g_autofree char *content_b64 = g_base64_encode(content_data, content_len);
-    g_autofree char *content_escaped = json_escape_string(content_b64);
+    /* Base64-encode content, reading it from the database if not resident */
+    g_autofree char *content_field = NULL;
+    if (with_content) {
+        g_autoptr(GBytes) content = clipium_store_get_content(store, e);
+        g_autofree char *content_escaped = NULL;
+        if (content) {
+            gsize content_len;
+            const guchar *content_data = g_bytes_get_data(content, &content_len);
+            g_autofree char *content_b64 = g_base64_encode(content_data, content_len);
+            content_escaped = json_escape_string(content_b64);
+        } else {
+            content_escaped = g_strdup("null");
+        }
+        content_field = g_strdup_printf(",\"content\":%s", content_escaped);
+    }
 
     return g_strdup_printf(
         "{\"id\":%" G_GUINT64_FORMAT ",\"preview\":%s,\"mime\":%s,\"hash\":%s,"
         "\"timestamp\":%" G_GINT64_FORMAT ",\"pinned\":%s,\"size\":%" G_GSIZE_FORMAT ","
-        "\"time_ago\":%s,\"content\":%s}",
+        "\"time_ago\":%s%s}",
         e->id, preview_escaped, mime_escaped, hash_escaped,
         e->timestamp, e->pinned ? "true" : "false", e->size,
-        time_escaped, content_escaped);
+        time_escaped, content_field ? content_field : "");
 }
 
 /* --- Command handler --- */
 
+static gboolean send_response(GOutputStream *out, const char *json);
+
+/* A search response. "complete" is false for interim results and for a
+ * final one whose time budget ran out before every entry was searched.
+ * Interim results are replaced within milliseconds, so only the final one
+ * carries the content. */
+static char *
+search_response_json(ClipiumStore *store, GArray *entries, ClipiumSearchStage stage)
+{
+    GString *json = g_string_new("{\"ok\":true,\"count\":");
+    g_string_append_printf(json, "%u,\"entries\":[", entries->len);
+
+    for (guint i = 0; i < entries->len; i++) {
+        if (i > 0) g_string_append_c(json, ',');
+        ClipiumEntry *e = g_array_index(entries, ClipiumEntry *, i);
+        g_autofree char *ej = entry_to_json(store, e, stage != CLIPIUM_SEARCH_INTERIM);
+        g_string_append(json, ej);
+    }
+
+    g_string_append_printf(json, "],\"complete\":%s}",
+                           stage == CLIPIUM_SEARCH_COMPLETE ? "true" : "false");
+    return g_string_free(json, FALSE);
+}
+
+typedef struct {
+    ClipiumIpc    *ipc;
+    GOutputStream *out;          /* where interim results go, NULL to drop them */
+    GCancellable  *cancellable;  /* stops the search if the client goes away */
+    char          *final;        /* the response to return */
+} SearchReply;
+
+static void
+on_search_result(GArray *entries, ClipiumSearchStage stage, gpointer user_data)
+{
+    SearchReply *reply = user_data;
+    if (stage == CLIPIUM_SEARCH_INTERIM) {
+        if (reply->out) {
+            g_autofree char *json = search_response_json(reply->ipc->store, entries, stage);
+            if (!send_response(reply->out, json))
+                g_cancellable_cancel(reply->cancellable);
+        }
+    } else {
+        reply->final = search_response_json(reply->ipc->store, entries, stage);
+    }
+    g_array_free(entries, TRUE);
+}
+
 static char *
-handle_command(ClipiumIpc *ipc, const char *json_str)
+handle_command(ClipiumIpc *ipc, const char *json_str, GOutputStream *out)
 {
     g_autofree char *cmd = json_get_string(json_str, "cmd");
     if (!cmd)
         return g_strdup("{\"ok\":false,\"error\":\"missing cmd\"}");
 
     if (g_str_equal(cmd, "ingest")) {
-        g_autofree char *content_b64 = json_get_string(json_str, "content");
         g_autofree char *mime = json_get_string(json_str, "mime");
+        ClipiumHash hash;
+        gsize decoded_len = 0;
+        guchar *decoded = json_get_base64_hashed(json_str, "content", &decoded_len, &hash);
 
-        if (!content_b64 || !mime)
+        if (!decoded || !mime) {
+            g_free(decoded);
             return g_strdup("{\"ok\":false,\"error\":\"missing content or mime\"}");
-
-        gsize decoded_len;
-        guchar *decoded = g_base64_decode(content_b64, &decoded_len);
-        if (!decoded || decoded_len == 0) {
+        }
+        if (decoded_len == 0) {
             g_free(decoded);
             return g_strdup("{\"ok\":false,\"error\":\"empty content\"}");
         }
 
         GBytes *content = g_bytes_new_take(decoded, decoded_len);
-        guint64 new_id = clipium_store_add(ipc->store, content, mime);
+        guint64 new_id = clipium_store_add_hashed(ipc->store, content, mime, &hash);
 
-        if (new_id > 0 && ipc->db) {
-            ClipiumEntry *entry = clipium_store_get(ipc->store, new_id);
-            if (entry)
-                clipium_db_save_async(ipc->db, entry);
-        }
+        /* The new entry or the bump, and whatever it pushed out */
+        if (ipc->db)
+            clipium_db_persist(ipc->db, ipc->store);
 
         g_bytes_unref(content);
         return g_strdup_printf("{\"ok\":true,\"id\":%" G_GUINT64_FORMAT "}", new_id);
@@ -186,7 +288,7 @@ handle_command(ClipiumIpc *ipc, const char *json_str)
         for (guint i = 0; i < entries->len; i++) {
             if (i > 0) g_string_append_c(json, ',');
             ClipiumEntry *e = g_array_index(entries, ClipiumEntry *, i);
-            g_autofree char *ej = entry_to_json(e);
+            g_autofree char *ej = entry_to_json(ipc->store, e, TRUE);
             g_string_append(json, ej);
         }
 
@@ -202,20 +304,52 @@ handle_command(ClipiumIpc *ipc, const char *json_str)
         if (!query)
             return g_strdup("{\"ok\":false,\"error\":\"missing query\"}");
 
-        GArray *entries = clipium_store_search(ipc->store, query, (guint)limit);
-        GString *json = g_string_new("{\"ok\":true,\"count\":");
-        g_string_append_printf(json, "%u,\"entries\":[", entries->len);
-
-        for (guint i = 0; i < entries->len; i++) {
-            if (i > 0) g_string_append_c(json, ',');
-            ClipiumEntry *e = g_array_index(entries, ClipiumEntry *, i);
-            g_autofree char *ej = entry_to_json(e);
-            g_string_append(json, ej);
+        /* Without a mode the query may pick one itself ("re:…", "\"…\"") */
+        g_autofree char *mode_name = json_get_string(json_str, "mode");
+        g_autofree char *pattern = NULL;
+        ClipiumSearchMode mode;
+        if (!mode_name)
+            pattern = clipium_search_mode_split(query, &mode);
+        else if (clipium_search_mode_from_string(mode_name, &mode))
+            pattern = g_strdup(query);
+        else
+            return g_strdup("{\"ok\":false,\"error\":\"unknown mode\"}");
+
+        /* "stream" sends the interim results ahead of the final one */
+        SearchReply reply = {
+            .ipc = ipc,
+            .out = json_get_int(json_str, "stream", 0) ? out : NULL,
+            .cancellable = g_cancellable_new(),
+        };
+        gint64 budget = json_get_int(json_str, "budget_ms", 0) * 1000;
+        g_autoptr(GError) error = NULL;
+        gboolean ok = clipium_store_search_progressive(ipc->store, pattern, mode, (guint)limit,
+                                                       budget, reply.cancellable,
+                                                       on_search_result, &reply, &error);
+        g_object_unref(reply.cancellable);
+        if (!ok) {
+            g_autofree char *message = json_escape_string(error->message);
+            return g_strdup_printf("{\"ok\":false,\"error\":%s}", message);
         }
+        return reply.final ? reply.final : g_strdup("{\"ok\":false,\"error\":\"cancelled\"}");
+    }
 
-        g_string_append(json, "]}");
-        g_array_free(entries, TRUE);
-        return g_string_free(json, FALSE);
+    if (g_str_equal(cmd, "get")) {
+        gint64 id = json_get_int(json_str, "id", -1);
+        if (id < 0)
+            return g_strdup("{\"ok\":false,\"error\":\"missing id\"}");
+
+        g_autoptr(ClipiumEntry) entry = clipium_store_get(ipc->store, (guint64)id);
+        if (!entry && ipc->db)
+            entry = clipium_db_get_archived(ipc->db, (guint64)id);
+        if (!entry)
+            return g_strdup("{\"ok\":false,\"error\":\"not found\"}");
+
+        /* A fetch is a use, same as a paste from the popup */
+        if (clipium_store_touch(ipc->store, (guint64)id) && ipc->db)
+            clipium_db_persist(ipc->db, ipc->store);
+        g_autofree char *ej = entry_to_json(ipc->store, entry, TRUE);
+        return g_strdup_printf("{\"ok\":true,\"entry\":%s}", ej);
     }
 
     if (g_str_equal(cmd, "delete")) {
@@ -223,9 +357,12 @@ handle_command(ClipiumIpc *ipc, const char *json_str)
         if (id < 0)
             return g_strdup("{\"ok\":false,\"error\":\"missing id\"}");
 
+        /* Not in the store, it may still be in the archive */
         gboolean ok = clipium_store_delete(ipc->store, (guint64)id);
         if (ok && ipc->db)
-            clipium_db_delete(ipc->db, (guint64)id);
+            clipium_db_persist(ipc->db, ipc->store);
+        else if (ipc->db)
+            ok = clipium_db_delete(ipc->db, (guint64)id);
 
         return g_strdup_printf("{\"ok\":%s}", ok ? "true" : "false");
     }
@@ -233,7 +370,7 @@ handle_command(ClipiumIpc *ipc, const char *json_str)
     if (g_str_equal(cmd, "clear")) {
         clipium_store_clear(ipc->store);
         if (ipc->db)
-            clipium_db_clear(ipc->db);
+            clipium_db_persist(ipc->db, ipc->store);
         return g_strdup("{\"ok\":true}");
     }
 
@@ -245,9 +382,28 @@ handle_command(ClipiumIpc *ipc, const char *json_str)
 
     if (g_str_equal(cmd, "status")) {
         guint count = clipium_store_count(ipc->store);
+        gsize bytes = clipium_store_bytes(ipc->store);
+        ClipiumContentStats cs;
+        clipium_store_content_stats(ipc->store, &cs);
+        guint64 lookups = cs.cache_hits + cs.cache_misses;
         return g_strdup_printf(
-            "{\"ok\":true,\"entries\":%u,\"max_entries\":%u,\"version\":\"%s\"}",
-            count, CLIPIUM_MAX_ENTRIES, CLIPIUM_VERSION);
+            "{\"ok\":true,\"entries\":%u,\"max_entries\":%u,"
+            "\"bytes\":%" G_GSIZE_FORMAT ",\"max_bytes\":%" G_GSIZE_FORMAT ","
+            "\"index_bytes\":%" G_GSIZE_FORMAT ","
+            "\"content_cache\":{\"bytes\":%" G_GSIZE_FORMAT ",\"hits\":%" G_GUINT64_FORMAT
+            ",\"misses\":%" G_GUINT64_FORMAT ",\"hit_rate\":%.3f},"
+            "\"compression\":{\"entries\":%u,\"bytes_saved\":%" G_GSIZE_FORMAT
+            ",\"compress_us\":%" G_GINT64_FORMAT ",\"decompressions\":%" G_GUINT64_FORMAT
+            ",\"decompress_us\":%" G_GINT64_FORMAT "},"
+            "\"evict_policy\":\"%s\",\"version\":\"%s\"}",
+            count, CLIPIUM_MAX_ENTRIES, bytes, clipium_store_get_max_bytes(ipc->store),
+            clipium_store_index_bytes(ipc->store),
+            cs.cache_bytes, cs.cache_hits, cs.cache_misses,
+            lookups ? (double)cs.cache_hits / (double)lookups : 0.0,
+            cs.compressed_entries, cs.compressed_saved, cs.compress_usec,
+            cs.decompressions, cs.decompress_usec,
+            clipium_evict_kind_to_string(clipium_store_get_evict_policy(ipc->store)),
+            CLIPIUM_VERSION);
     }
 
     if (g_str_equal(cmd, "pin")) {
@@ -258,7 +414,7 @@ handle_command(ClipiumIpc *ipc, const char *json_str)
 
         gboolean ok = clipium_store_pin(ipc->store, (guint64)id, (gboolean)pinned);
         if (ok && ipc->db)
-            clipium_db_update_pin(ipc->db, (guint64)id, (gboolean)pinned);
+            clipium_db_persist(ipc->db, ipc->store);
 
         return g_strdup_printf("{\"ok\":%s}", ok ? "true" : "false");
     }
@@ -335,7 +491,7 @@ on_incoming(GSocketService    *service,
     }
     buf[msg_len] = '\0';
 
-    g_autofree char *response = handle_command(ipc, buf);
+    g_autofree char *response = handle_command(ipc, buf, out);
     g_free(buf);
 
     send_response(out, response);
@@ -399,8 +555,8 @@ clipium_ipc_server_stop(ClipiumIpc *ipc)
 
 /* --- Client --- */
 
-char *
-clipium_ipc_send_command(const char *socket_path, const char *json_cmd)
+static GSocketConnection *
+client_send(const char *socket_path, const char *json_cmd)
 {
     GError *err = NULL;
 
@@ -418,7 +574,6 @@ clipium_ipc_send_command(const char *socket_path, const char *json_cmd)
     }
 
     GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(conn));
-    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(conn));
 
     /* Send length-prefixed message */
     gsize len = strlen(json_cmd);
@@ -431,32 +586,66 @@ clipium_ipc_send_command(const char *socket_path, const char *json_cmd)
 
     g_output_stream_write_all(out, hdr, 4, NULL, NULL, NULL);
     g_output_stream_write_all(out, json_cmd, len, NULL, NULL, NULL);
+    return conn;
+}
+
+/* The next length-prefixed response, or NULL at the end of the stream */
+static char *
+client_read_response(GSocketConnection *conn)
+{
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(conn));
 
-    /* Read response */
     guchar resp_hdr[4];
     gsize bytes_read;
-    if (!g_input_stream_read_all(in, resp_hdr, 4, &bytes_read, NULL, NULL) || bytes_read != 4) {
-        g_object_unref(conn);
+    if (!g_input_stream_read_all(in, resp_hdr, 4, &bytes_read, NULL, NULL) || bytes_read != 4)
         return NULL;
-    }
 
     guint32 resp_len = ((guint32)resp_hdr[0] << 24) | ((guint32)resp_hdr[1] << 16) |
                        ((guint32)resp_hdr[2] << 8)  | (guint32)resp_hdr[3];
 
-    if (resp_len > CLIPIUM_IPC_MAX_MSG) {
-        g_object_unref(conn);
+    if (resp_len > CLIPIUM_IPC_MAX_MSG)
         return NULL;
-    }
 
     char *resp = g_malloc(resp_len + 1);
     if (!g_input_stream_read_all(in, resp, resp_len, &bytes_read, NULL, NULL) ||
         bytes_read != resp_len) {
         g_free(resp);
-        g_object_unref(conn);
         return NULL;
     }
     resp[resp_len] = '\0';
+    return resp;
+}
+
+char *
+clipium_ipc_send_command(const char *socket_path, const char *json_cmd)
+{
+    GSocketConnection *conn = client_send(socket_path, json_cmd);
+    if (!conn)
+        return NULL;
 
+    char *resp = client_read_response(conn);
     g_object_unref(conn);
     return resp;
 }
+
+gboolean
+clipium_ipc_send_command_stream(const char             *socket_path,
+                                const char             *json_cmd,
+                                ClipiumIpcResponseFunc  func,
+                                gpointer                user_data)
+{
+    GSocketConnection *conn = client_send(socket_path, json_cmd);
+    if (!conn)
+        return FALSE;
+
+    /* The daemon closes the connection after the last response */
+    gboolean any = FALSE;
+    char *resp;
+    while ((resp = client_read_response(conn))) {
+        func(resp, user_data);
+        g_free(resp);
+        any = TRUE;
+    }
+    g_object_unref(conn);
+    return any;
+}
@@ -22,4 +22,13 @@ void        clipium_ipc_server_stop   (ClipiumIpc *ipc);
 /* Client helpers (used by CLI modes) */
 char       *clipium_ipc_send_command  (const char *socket_path, const char *json_cmd);
 
+/* For commands that answer with several responses (a streamed search):
+ * calls `func` with each as it arrives. FALSE if none came. */
+typedef void (*ClipiumIpcResponseFunc)(const char *json, gpointer user_data);
+
+gboolean    clipium_ipc_send_command_stream(const char             *socket_path,
+                                            const char             *json_cmd,
+                                            ClipiumIpcResponseFunc  func,
+                                            gpointer                user_data);
+
 G_END_DECLS
@@ -0,0 +1,191 @@
+#include "clipium-query.h"
+#include <string.h>
+
+gboolean
+clipium_parse_duration(const char *text, gint64 *usec)
+{
+    if (g_str_equal(text, "never")) {
+        *usec = 0;
+        return TRUE;
+    }
+
+    char *end;
+    guint64 n = g_ascii_strtoull(text, &end, 10);
+    if (end == text || n > G_MAXINT32)
+        return FALSE;
+
+    gint64 unit;
+    switch (*end) {
+    case '\0':
+    case 's': unit = 1; break;
+    case 'm': unit = 60; break;
+    case 'h': unit = 60 * 60; break;
+    case 'd': unit = 24 * 60 * 60; break;
+    case 'w': unit = 7 * 24 * 60 * 60; break;
+    default:  return FALSE;
+    }
+    if (*end && end[1])
+        return FALSE;
+
+    *usec = (gint64)n * unit * G_USEC_PER_SEC;
+    return TRUE;
+}
+
+/* "512", "4k", "1M", "2G", optionally followed by "B" or "iB" */
+static gboolean
+parse_size(const char *text, gint64 *bytes)
+{
+    char *end;
+    guint64 n = g_ascii_strtoull(text, &end, 10);
+    if (end == text || n > G_MAXINT32)
+        return FALSE;
+
+    gint64 unit = 1;
+    switch (g_ascii_toupper(*end)) {
+    case 'K': unit = 1024; end++; break;
+    case 'M': unit = 1024 * 1024; end++; break;
+    case 'G': unit = 1024 * 1024 * 1024; end++; break;
+    default:  break;
+    }
+    if (unit > 1 && *end == 'i')
+        end++;
+    if (*end == 'B' || *end == 'b')
+        end++;
+    if (*end)
+        return FALSE;
+
+    *bytes = (gint64)n * unit;
+    return TRUE;
+}
+
+static gboolean
+parse_bool(const char *text, gint *value)
+{
+    if (g_ascii_strcasecmp(text, "yes") == 0 || g_ascii_strcasecmp(text, "true") == 0 ||
+        g_str_equal(text, "1")) {
+        *value = 1;
+        return TRUE;
+    }
+    if (g_ascii_strcasecmp(text, "no") == 0 || g_ascii_strcasecmp(text, "false") == 0 ||
+        g_str_equal(text, "0")) {
+        *value = 0;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Apply `token` to `query` if it is a well-formed filter */
+static gboolean
+parse_filter(ClipiumQuery *query, const char *token, gint64 now)
+{
+    if (g_str_has_prefix(token, "mime:") && token[5]) {
+        g_autofree char *mime = g_ascii_strdown(token + 5, -1);
+        if (g_str_has_suffix(mime, "/*"))
+            mime[strlen(mime) - 2] = '\0';
+        g_free(query->mime);
+        query->mime = g_steal_pointer(&mime);
+        return TRUE;
+    }
+    if (g_str_has_prefix(token, "pinned:"))
+        return parse_bool(token + 7, &query->pinned);
+    if (g_str_has_prefix(token, "since:")) {
+        gint64 usec;
+        if (!clipium_parse_duration(token + 6, &usec) || usec == 0)
+            return FALSE;
+        query->since = now - usec;
+        return TRUE;
+    }
+    if (g_str_has_prefix(token, "size") && (token[4] == '<' || token[4] == '>')) {
+        gboolean inclusive = token[5] == '=';
+        gint64 bytes;
+        if (!parse_size(token + (inclusive ? 6 : 5), &bytes))
+            return FALSE;
+        if (token[4] == '>')
+            query->size_min = inclusive ? bytes : bytes + 1;
+        else if (bytes > 0 || inclusive)
+            query->size_max = inclusive ? bytes : bytes - 1;
+        else
+            return FALSE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+ClipiumQuery *
+clipium_query_parse(const char *input, gint64 now)
+{
+    ClipiumQuery *query = g_new0(ClipiumQuery, 1);
+    query->pinned = -1;
+    query->size_min = -1;
+    query->size_max = -1;
+
+    g_auto(GStrv) tokens = g_strsplit_set(input ? input : "", " \t\n", -1);
+    GString *text = g_string_new(NULL);
+    gboolean filtered = FALSE;
+    for (guint i = 0; tokens[i]; i++) {
+        if (!*tokens[i])
+            continue;
+        if (parse_filter(query, tokens[i], now)) {
+            filtered = TRUE;
+            continue;
+        }
+        if (text->len)
+            g_string_append_c(text, ' ');
+        g_string_append(text, tokens[i]);
+    }
+
+    /* Without filters the text is the input exactly, spacing included */
+    if (filtered) {
+        query->text = g_string_free(text, FALSE);
+    } else {
+        g_string_free(text, TRUE);
+        query->text = g_strdup(input ? input : "");
+    }
+    return query;
+}
+
+void
+clipium_query_free(ClipiumQuery *query)
+{
+    if (!query) return;
+    g_free(query->text);
+    g_free(query->mime);
+    g_free(query);
+}
+
+gboolean
+clipium_query_has_filters(const ClipiumQuery *query)
+{
+    return query->mime || query->pinned >= 0 || query->since > 0 ||
+           query->size_min >= 0 || query->size_max >= 0;
+}
+
+gboolean
+clipium_mime_matches(const char *pattern, const char *mime_type)
+{
+    gsize len = strlen(pattern);
+    if (g_ascii_strncasecmp(pattern, mime_type, len) != 0)
+        return FALSE;
+    char next = mime_type[len];
+    return next == '\0' || next == ';' || (next == '/' && !strchr(pattern, '/'));
+}
+
+gboolean
+clipium_query_accepts(const ClipiumQuery *query,
+                      const char         *mime_type,
+                      gboolean            pinned,
+                      gint64              timestamp,
+                      gsize               size)
+{
+    if (query->mime && !clipium_mime_matches(query->mime, mime_type))
+        return FALSE;
+    if (query->pinned >= 0 && query->pinned != (pinned ? 1 : 0))
+        return FALSE;
+    if (query->since > 0 && timestamp < query->since)
+        return FALSE;
+    if (query->size_min >= 0 && (gint64)size < query->size_min)
+        return FALSE;
+    if (query->size_max >= 0 && (gint64)size > query->size_max)
+        return FALSE;
+    return TRUE;
+}
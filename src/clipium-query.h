@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A search query split into its free text and structured filters:
+ *
+ *   mime:image          type/subtype, or just the type
+ *   pinned:yes          yes/no (also true/false, 1/0)
+ *   since:2h            copied within the last s/m/h/d/w
+ *   size>1M  size<=4k   content size, with k/M/G suffixes (1024-based)
+ *
+ * Everything else, including filter-like words that do not parse (which
+ * is what a half-typed filter looks like), is free text. */
+typedef struct {
+    char    *text;      /* free text, "" if none */
+    char    *mime;      /* NULL = any */
+    gint     pinned;    /* -1 = any, 0 or 1 */
+    gint64   since;     /* absolute µs, 0 = any */
+    gint64   size_min;  /* bytes, inclusive; -1 = any */
+    gint64   size_max;
+} ClipiumQuery;
+
+/* Parse `input` with relative times taken from `now` (µs) */
+ClipiumQuery *clipium_query_parse      (const char *input, gint64 now);
+void          clipium_query_free       (ClipiumQuery *query);
+gboolean      clipium_query_has_filters(const ClipiumQuery *query);
+
+/* Whether an entry's attributes pass every filter (not the text) */
+gboolean      clipium_query_accepts    (const ClipiumQuery *query,
+                                        const char         *mime_type,
+                                        gboolean            pinned,
+                                        gint64              timestamp,
+                                        gsize               size);
+
+/* "image" matches "image/png"; "text/plain" matches "text/plain;charset=…" */
+gboolean      clipium_mime_matches     (const char *pattern, const char *mime_type);
+
+/* "30s", "5m", "2h", "1d", "1w" (bare numbers are seconds) or "never"
+ * (0) as µs. Returns FALSE if malformed. */
+gboolean      clipium_parse_duration   (const char *text, gint64 *usec);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(ClipiumQuery, clipium_query_free)
+
+G_END_DECLS
@@ -1,28 +1,69 @@
 #include "clipium-store.h"
 #include "clipium-fuzzy.h"
+#include "clipium-query.h"
 #include "clipium-config.h"
+#include <math.h>
 #include <string.h>
 
+#define SLOT_NONE G_MAXUINT
+
+/* A slot keeps its index for the lifetime of the entry. `prev`/`next` link
+ * all entries newest-first; free slots are chained through `next`. Access
+ * statistics live here rather than in the entry, so recording a paste does
+ * not have to install a new copy. */
+typedef struct {
+    ClipiumEntry *entry;
+    guint         prev;
+    guint         next;
+    guint         hits;       /* copies, pastes and fetches */
+    gint64        last_used;  /* time of the last of those */
+    double        frecency;   /* see ClipiumUsage; keys by_frecency */
+    guint         snapshot_row; /* row in the last snapshot built */
+    gboolean      incompressible; /* compression was tried and did not pay */
+    gboolean      in_use;
+} ClipiumSlot;
+
 /* Wrapper for g_array_set_clear_func (GDestroyNotify expects gpointer) */
 static void
-entry_clear_notify(gpointer data)
+slot_clear_notify(gpointer data)
+{
+    g_clear_pointer(&((ClipiumSlot *)data)->entry, clipium_entry_unref);
+}
+
+typedef struct {
+    guint64  id;
+    GBytes  *content;
+} CachedContent;
+
+typedef struct {
+    GPatternSpec *pattern;   /* on the mime type */
+    gboolean      pinned;
+    gint64        ttl_usec;  /* 0 = never expires */
+} TtlRule;
+
+static void
+ttl_rule_free(gpointer data)
 {
-    clipium_entry_clear((ClipiumEntry *)data);
+    TtlRule *rule = data;
+    g_pattern_spec_free(rule->pattern);
+    g_free(rule);
+}
+
+/* g_array_set_clear_func receives a pointer to the element */
+static void
+entry_ptr_clear_notify(gpointer data)
+{
+    g_clear_pointer((ClipiumEntry **)data, clipium_entry_unref);
 }
 
 /* --- Helpers --- */
 
-char *
-clipium_entry_compute_hash(GBytes *content)
+void
+clipium_entry_compute_hash(GBytes *content, ClipiumHash *hash)
 {
     gsize len;
     const guchar *data = g_bytes_get_data(content, &len);
-    GChecksum *cs = g_checksum_new(G_CHECKSUM_SHA256);
-    g_return_val_if_fail(cs != NULL, NULL);
-    g_checksum_update(cs, data, (gssize)len);
-    char *hash = g_strdup(g_checksum_get_string(cs));
-    g_checksum_free(cs);
-    return hash;
+    clipium_hash_data(data, len, hash);
 }
 
 char *
@@ -71,28 +112,693 @@ clipium_entry_make_preview(GBytes *content, const char *mime_type)
     return g_string_free(preview, FALSE);
 }
 
+/* --- Entry lifecycle --- */
+
+static ClipiumEntry *
+entry_alloc(guint64            id,
+            GBytes            *content,
+            const char        *mime_type,
+            const char        *preview,
+            const ClipiumHash *hash,
+            gint64             timestamp,
+            gboolean           pinned,
+            gsize              size)
+{
+    ClipiumEntry *entry = g_new0(ClipiumEntry, 1);
+    g_atomic_ref_count_init(&entry->ref_count);
+    entry->id        = id;
+    entry->content   = content ? g_bytes_ref(content) : NULL;
+    entry->mime_type = g_intern_string(mime_type);
+    entry->preview   = g_strdup(preview);
+    entry->hash      = *hash;
+    entry->timestamp = timestamp;
+    entry->pinned    = pinned;
+    entry->size      = size;
+    return entry;
+}
+
+static void
+entry_set_search_key(ClipiumEntry *entry, const char *key)
+{
+    entry->search_key = key;
+    entry->char_mask = key ? clipium_fuzzy_char_mask(key, strlen(key)) : 0;
+}
+
+ClipiumEntry *
+clipium_entry_new(guint64            id,
+                  GBytes            *content,
+                  const char        *mime_type,
+                  const char        *preview,
+                  const ClipiumHash *hash,
+                  gint64             timestamp,
+                  gboolean           pinned,
+                  gsize              size)
+{
+    ClipiumEntry *entry = entry_alloc(id, content, mime_type, preview, hash,
+                                      timestamp, pinned, size);
+
+    /* Folded once here, so searches compare bytes; ASCII previews (most
+     * of them) are their own key */
+    const char *p = entry->preview;
+    if (p && clipium_fuzzy_needs_fold(p, strlen(p)))
+        entry_set_search_key(entry, clipium_fuzzy_fold(p, strlen(p), NULL));
+    else
+        entry_set_search_key(entry, p);
+    return entry;
+}
+
+/* The copy is private to the caller until it is installed in the store, so
+ * this is the one place where entry fields may be modified. */
+ClipiumEntry *
+clipium_entry_copy(const ClipiumEntry *entry)
+{
+    ClipiumEntry *copy = entry_alloc(entry->id, entry->content, entry->mime_type,
+                                     entry->preview, &entry->hash, entry->timestamp,
+                                     entry->pinned, entry->size);
+    entry_set_search_key(copy, entry->search_key == entry->preview
+                               ? copy->preview : g_strdup(entry->search_key));
+    copy->compressed = entry->compressed ? g_bytes_ref(entry->compressed) : NULL;
+    return copy;
+}
+
+ClipiumEntry *
+clipium_entry_ref(ClipiumEntry *entry)
+{
+    g_return_val_if_fail(entry != NULL, NULL);
+    g_atomic_ref_count_inc(&entry->ref_count);
+    return entry;
+}
+
 void
-clipium_entry_clear(ClipiumEntry *entry)
+clipium_entry_unref(ClipiumEntry *entry)
 {
+    g_return_if_fail(entry != NULL);
+    if (!g_atomic_ref_count_dec(&entry->ref_count))
+        return;
     g_clear_pointer(&entry->content, g_bytes_unref);
-    g_clear_pointer(&entry->mime_type, g_free);
-    g_clear_pointer(&entry->preview, g_free);
-    g_clear_pointer(&entry->hash, g_free);
+    g_clear_pointer(&entry->compressed, g_bytes_unref);
+    if (entry->search_key != entry->preview)
+        g_free((char *)entry->search_key);
+    g_free(entry->preview);
+    g_free(entry);
+}
+
+/* --- Snapshots --- */
+
+/* The frecency column is the one a published snapshot lets change: a use
+ * rewrites its row in place rather than republishing, so it is kept as
+ * float bits that fit an atomic int */
+static inline double
+snapshot_frecency(const ClipiumSnapshot *snapshot, guint i)
+{
+    gint bits = g_atomic_int_get(&snapshot->frecency[i]);
+    float f;
+    memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+static inline void
+snapshot_set_frecency(ClipiumSnapshot *snapshot, guint i, double frecency)
+{
+    float f = (float)frecency;
+    gint bits;
+    memcpy(&bits, &f, sizeof bits);
+    g_atomic_int_set(&snapshot->frecency[i], bits);
+}
+
+ClipiumSnapshot *
+clipium_snapshot_ref(ClipiumSnapshot *snapshot)
+{
+    g_return_val_if_fail(snapshot != NULL, NULL);
+    g_atomic_ref_count_inc(&snapshot->ref_count);
+    return snapshot;
+}
+
+void
+clipium_snapshot_unref(ClipiumSnapshot *snapshot)
+{
+    g_return_if_fail(snapshot != NULL);
+    if (!g_atomic_ref_count_dec(&snapshot->ref_count))
+        return;
+    g_ptr_array_unref(snapshot->entries);
+    g_free(snapshot->timestamps);
+    g_free(snapshot->sizes);
+    g_free(snapshot->key_offsets);
+    g_free(snapshot->mime_ids);
+    g_free(snapshot->char_masks);
+    g_free(snapshot->pinned);
+    g_free(snapshot->frecency);
+    g_free(snapshot->key_arena);
+    g_free(snapshot);
+}
+
+/* --- Frecency --- */
+
+/* ln 2 per half-life, per µs */
+#define FRECENCY_RATE (G_LN2 / ((double)CLIPIUM_FRECENCY_HALF_LIFE_S * G_USEC_PER_SEC))
+
+double
+clipium_frecency_add(double frecency, gint64 time)
+{
+    double x = (double)time * FRECENCY_RATE;
+    if (frecency == 0)
+        return x;
+
+    /* log(e^a + e^b), factored so neither term overflows */
+    double hi = MAX(frecency, x), lo = MIN(frecency, x);
+    return hi + log1p(exp(lo - hi));
+}
+
+double
+clipium_frecency_value(double frecency, gint64 now)
+{
+    return frecency == 0 ? 0.0 : exp(frecency - (double)now * FRECENCY_RATE);
+}
+
+/* What a frecency adds to a match score; `origin` is `now` scaled by
+ * FRECENCY_RATE, worked out once per search. Logarithmic, so a handful of
+ * recent uses lifts a match a few places but cannot outrank a much
+ * better one. */
+static inline int
+frecency_bonus(double frecency, double origin)
+{
+    if (frecency == 0)
+        return 0;
+    return (int)(CLIPIUM_FRECENCY_WEIGHT * log1p(exp(frecency - origin)) + 0.5);
+}
+
+/* --- zlib helpers --- */
+
+/* Entries that are worth a compression attempt; images and archives are
+ * already compressed */
+static gboolean
+mime_is_compressible(const char *mime_type)
+{
+    return g_str_has_prefix(mime_type, "text/") ||
+           strstr(mime_type, "json") || strstr(mime_type, "xml") ||
+           strstr(mime_type, "javascript");
+}
+
+/* Run a whole buffer through a GIO zlib converter */
+static GBytes *
+zlib_convert(GConverter *converter, GBytes *input, gsize size_hint)
+{
+    gsize in_len;
+    const guint8 *in = g_bytes_get_data(input, &in_len);
+    GByteArray *out = g_byte_array_sized_new((guint)MAX(size_hint, 64));
+    g_byte_array_set_size(out, (guint)MAX(size_hint, 64));
+    gsize in_pos = 0, out_pos = 0;
+
+    for (;;) {
+        if (out_pos == out->len)
+            g_byte_array_set_size(out, out->len * 2);
+
+        gsize bytes_read = 0, bytes_written = 0;
+        GError *err = NULL;
+        GConverterResult res = g_converter_convert(converter, in + in_pos, in_len - in_pos,
+                                                   out->data + out_pos, out->len - out_pos,
+                                                   G_CONVERTER_INPUT_AT_END,
+                                                   &bytes_read, &bytes_written, &err);
+        if (res == G_CONVERTER_ERROR) {
+            if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+                g_error_free(err);
+                g_byte_array_set_size(out, out->len * 2);
+                continue;
+            }
+            g_warning("zlib conversion failed: %s", err->message);
+            g_error_free(err);
+            g_byte_array_free(out, TRUE);
+            return NULL;
+        }
+
+        in_pos += bytes_read;
+        out_pos += bytes_written;
+        if (res == G_CONVERTER_FINISHED)
+            break;
+    }
+
+    g_byte_array_set_size(out, (guint)out_pos);
+    return g_byte_array_free_to_bytes(out);
+}
+
+/* Decompress or load content that is not resident. Call without the
+ * store lock or content_lock held. */
+static GBytes *
+content_fetch(ClipiumStore *store, const ClipiumEntry *entry)
+{
+    if (entry->compressed) {
+        gint64 start = g_get_monotonic_time();
+        GConverter *zd = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+        GBytes *content = zlib_convert(zd, entry->compressed, entry->size);
+        g_object_unref(zd);
+
+        g_mutex_lock(&store->content_lock);
+        store->decompressions++;
+        store->decompress_usec += g_get_monotonic_time() - start;
+        g_mutex_unlock(&store->content_lock);
+        return content;
+    }
+
+    g_mutex_lock(&store->content_lock);
+    ClipiumContentLoader loader = store->content_loader;
+    gpointer loader_data = store->content_loader_data;
+    g_mutex_unlock(&store->content_lock);
+    return loader ? loader(entry->id, loader_data) : NULL;
+}
+
+/* The content of any entry for a scan: resident or already cached content
+ * is shared, anything else is read for this caller alone. The cache, its
+ * order and its hit statistics are left as they were, so one search over
+ * everything does not push out what pastes keep using. */
+static GBytes *
+store_read_content(ClipiumStore *store, const ClipiumEntry *entry)
+{
+    if (entry->content)
+        return g_bytes_ref(entry->content);
+
+    g_mutex_lock(&store->content_lock);
+    GList *link = g_hash_table_lookup(store->content_cache, GSIZE_TO_POINTER((gsize)entry->id));
+    GBytes *content = link ? g_bytes_ref(((CachedContent *)link->data)->content) : NULL;
+    g_mutex_unlock(&store->content_lock);
+    return content ? content : content_fetch(store, entry);
+}
+
+/* Trigrams of a text entry for the full-text index, or NULL if the entry
+ * is not text. Runs outside the store lock. */
+static GArray *
+entry_extract_trigrams(GBytes *content, const char *mime_type)
+{
+    if (!content || !g_str_has_prefix(mime_type, "text/"))
+        return NULL;
+    gsize len;
+    const char *data = g_bytes_get_data(content, &len);
+    return clipium_trigrams_extract(data, MIN(len, CLIPIUM_INDEX_MAX_BYTES));
+}
+
+/* Words for the typo index, from the same text the trigrams come from */
+static GPtrArray *
+entry_extract_words(GBytes *content, const char *mime_type)
+{
+    if (!content || !g_str_has_prefix(mime_type, "text/"))
+        return NULL;
+    gsize len;
+    const char *data = g_bytes_get_data(content, &len);
+    return clipium_typo_words_extract(data, MIN(len, CLIPIUM_INDEX_MAX_BYTES));
+}
+
+/* --- TTL rules --- */
+
+/* Returns a GPtrArray of TtlRule, or NULL if the spec is malformed */
+static GPtrArray *
+ttl_rules_parse(const char *spec)
+{
+    GPtrArray *rules = g_ptr_array_new_with_free_func(ttl_rule_free);
+    g_auto(GStrv) items = g_strsplit(spec, ",", -1);
+
+    for (guint i = 0; items[i]; i++) {
+        char *item = g_strstrip(items[i]);
+        if (!*item)
+            continue;
+
+        gboolean pinned = g_str_has_prefix(item, "pinned:");
+        if (pinned)
+            item += strlen("pinned:");
+
+        char *eq = strchr(item, '=');
+        gint64 ttl;
+        if (!eq || eq == item || !clipium_parse_duration(g_strstrip(eq + 1), &ttl)) {
+            g_ptr_array_unref(rules);
+            return NULL;
+        }
+        *eq = '\0';
+
+        TtlRule *rule = g_new(TtlRule, 1);
+        rule->pattern = g_pattern_spec_new(g_strstrip(item));
+        rule->pinned = pinned;
+        rule->ttl_usec = ttl;
+        g_ptr_array_add(rules, rule);
+    }
+
+    return rules;
 }
 
-/* --- Rebuild index helpers --- */
+/* --- Content cache (caller holds store->content_lock) --- */
 
 static void
-store_rebuild_indices(ClipiumStore *store)
+content_cache_unlink(ClipiumStore *store, GList *link)
 {
-    g_hash_table_remove_all(store->by_hash);
-    g_hash_table_remove_all(store->by_id);
+    CachedContent *cc = link->data;
+    g_hash_table_remove(store->content_cache, GSIZE_TO_POINTER((gsize)cc->id));
+    store->content_cache_bytes -= g_bytes_get_size(cc->content);
+    g_queue_delete_link(&store->content_lru, link);
+    g_bytes_unref(cc->content);
+    g_free(cc);
+}
+
+static void
+content_cache_trim(ClipiumStore *store)
+{
+    while (store->content_cache_bytes > store->content_cache_max && store->content_lru.tail)
+        content_cache_unlink(store, store->content_lru.tail);
+}
+
+static void
+content_cache_drop(ClipiumStore *store, guint64 id)
+{
+    g_mutex_lock(&store->content_lock);
+    GList *link = g_hash_table_lookup(store->content_cache, GSIZE_TO_POINTER((gsize)id));
+    if (link)
+        content_cache_unlink(store, link);
+    g_mutex_unlock(&store->content_lock);
+}
+
+static void
+content_cache_drop_all(ClipiumStore *store)
+{
+    g_mutex_lock(&store->content_lock);
+    while (store->content_lru.head)
+        content_cache_unlink(store, store->content_lru.head);
+    g_mutex_unlock(&store->content_lock);
+}
+
+/* --- Slot and list helpers (caller holds store->lock) --- */
+
+#define SLOT(store, i) (&g_array_index((store)->slots, ClipiumSlot, (i)))
+
+/* Bytes an entry keeps in memory; metadata-only entries count as none */
+static inline gsize
+entry_resident_bytes(const ClipiumEntry *e)
+{
+    if (e->content)
+        return e->size;
+    return e->compressed ? g_bytes_get_size(e->compressed) : 0;
+}
 
-    for (guint i = 0; i < store->entries->len; i++) {
-        ClipiumEntry *e = &g_array_index(store->entries, ClipiumEntry, i);
-        g_hash_table_insert(store->by_hash, e->hash, GUINT_TO_POINTER(i));
-        g_hash_table_insert(store->by_id, GSIZE_TO_POINTER((gsize)e->id), GUINT_TO_POINTER(i));
+/* Every mutation bumps the generation so the next reader republishes */
+static inline void
+store_changed(ClipiumStore *store)
+{
+    g_atomic_int_inc(&store->generation);
+}
+
+/* Orders by_frecency: most frecent first, then newest, with the slot
+ * keeping duplicates of a bulk load apart until bulk_end drops them */
+static gint
+frecency_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    ClipiumStore *store = user_data;
+    guint x = GPOINTER_TO_UINT(a), y = GPOINTER_TO_UINT(b);
+    const ClipiumSlot *sx = SLOT(store, x), *sy = SLOT(store, y);
+    if (sx->frecency != sy->frecency)
+        return (sy->frecency > sx->frecency) - (sy->frecency < sx->frecency);
+    if (sx->entry->id != sy->entry->id)
+        return (sy->entry->id > sx->entry->id) - (sy->entry->id < sx->entry->id);
+    return (x > y) - (x < y);
+}
+
+static inline void
+store_index_frecency(ClipiumStore *store, guint idx)
+{
+    g_tree_insert(store->by_frecency, GUINT_TO_POINTER(idx), GUINT_TO_POINTER(idx));
+}
+
+/* Count a copy, paste or fetch at `now`. The slot leaves by_frecency while
+ * its key changes. */
+static void
+slot_record_use(ClipiumStore *store, guint idx, gint64 now)
+{
+    ClipiumSlot *slot = SLOT(store, idx);
+    g_tree_remove(store->by_frecency, GUINT_TO_POINTER(idx));
+    slot->hits++;
+    slot->last_used = now;
+    slot->frecency = clipium_frecency_add(slot->frecency, now);
+    store_index_frecency(store, idx);
+}
+
+static guint
+slot_alloc(ClipiumStore *store)
+{
+    guint idx;
+    if (store->free_head != SLOT_NONE) {
+        idx = store->free_head;
+        store->free_head = SLOT(store, idx)->next;
+    } else {
+        idx = store->slots->len;
+        g_array_set_size(store->slots, idx + 1);
+    }
+
+    ClipiumSlot *slot = SLOT(store, idx);
+    slot->prev = slot->next = SLOT_NONE;
+    slot->hits = 0;
+    slot->incompressible = FALSE;
+    slot->in_use = TRUE;
+    return idx;
+}
+
+static void
+slot_release(ClipiumStore *store, guint idx)
+{
+    ClipiumSlot *slot = SLOT(store, idx);
+    g_tree_remove(store->by_frecency, GUINT_TO_POINTER(idx));
+    clipium_wheel_cancel(store->expiry, idx);
+    clipium_trigram_index_remove(store->text_index, idx);
+    clipium_typo_index_remove(store->typo_index, idx);
+    clipium_attr_index_remove(store->attrs, idx);
+    g_clear_pointer(&slot->entry, clipium_entry_unref);
+    slot->in_use = FALSE;
+    slot->prev = SLOT_NONE;
+    slot->next = store->free_head;
+    store->free_head = idx;
+}
+
+static inline void
+store_index_attrs(ClipiumStore *store, guint idx)
+{
+    const ClipiumEntry *e = SLOT(store, idx)->entry;
+    clipium_attr_index_insert(store->attrs, idx, e->mime_type, e->pinned, e->timestamp);
+}
+
+/* Swap in a modified copy. The hash key must be replaced too, since it
+ * points into the old entry which may outlive or predecease the slot. */
+static void
+slot_replace_entry(ClipiumStore *store, guint idx, ClipiumEntry *entry)
+{
+    ClipiumSlot *slot = SLOT(store, idx);
+    g_hash_table_replace(store->by_hash, &entry->hash, GUINT_TO_POINTER(idx));
+    clipium_entry_unref(slot->entry);
+    slot->entry = entry;
+    store_index_attrs(store, idx);
+}
+
+/* TTL of an entry under the current rules, 0 if it never expires */
+static gint64
+store_entry_ttl(ClipiumStore *store, const ClipiumEntry *e)
+{
+    for (guint i = 0; i < store->ttl_rules->len; i++) {
+        TtlRule *rule = g_ptr_array_index(store->ttl_rules, i);
+        if (rule->pinned == e->pinned && g_pattern_spec_match_string(rule->pattern, e->mime_type))
+            return rule->ttl_usec;
+    }
+    return 0;
+}
+
+/* (Re)arm an entry's expiry, counted from its last copy */
+static void
+store_schedule_expiry(ClipiumStore *store, guint idx)
+{
+    const ClipiumEntry *e = SLOT(store, idx)->entry;
+    gint64 ttl = store_entry_ttl(store, e);
+    if (ttl > 0)
+        clipium_wheel_schedule(store->expiry, idx, e->timestamp + ttl);
+    else
+        clipium_wheel_cancel(store->expiry, idx);
+}
+
+static void
+recency_unlink(ClipiumStore *store, guint idx)
+{
+    ClipiumSlot *slot = SLOT(store, idx);
+    if (slot->prev != SLOT_NONE) SLOT(store, slot->prev)->next = slot->next;
+    else store->head = slot->next;
+    if (slot->next != SLOT_NONE) SLOT(store, slot->next)->prev = slot->prev;
+    else store->tail = slot->prev;
+    slot->prev = slot->next = SLOT_NONE;
+}
+
+static void
+recency_push_front(ClipiumStore *store, guint idx)
+{
+    ClipiumSlot *slot = SLOT(store, idx);
+    slot->prev = SLOT_NONE;
+    slot->next = store->head;
+    if (store->head != SLOT_NONE) SLOT(store, store->head)->prev = idx;
+    else store->tail = idx;
+    store->head = idx;
+}
+
+static void
+recency_push_back(ClipiumStore *store, guint idx)
+{
+    ClipiumSlot *slot = SLOT(store, idx);
+    slot->next = SLOT_NONE;
+    slot->prev = store->tail;
+    if (store->tail != SLOT_NONE) SLOT(store, store->tail)->next = idx;
+    else store->head = idx;
+    store->tail = idx;
+}
+
+/* --- Change journal --- */
+
+static GArray *
+journal_new(void)
+{
+    GArray *journal = g_array_new(FALSE, TRUE, sizeof(ClipiumStoreChange));
+    g_array_set_clear_func(journal, (GDestroyNotify)clipium_store_change_clear);
+    return journal;
+}
+
+/* Record a change to the entry in `idx` as it is now. Caller holds lock. */
+static void
+store_journal(ClipiumStore *store, ClipiumChangeKind kind, guint idx)
+{
+    if (!store->journal)
+        return;
+
+    const ClipiumSlot *slot = SLOT(store, idx);
+    ClipiumStoreChange change = {
+        .kind      = kind,
+        .id        = slot->entry->id,
+        .entry     = kind == CLIPIUM_CHANGE_ADDED ? clipium_entry_ref(slot->entry) : NULL,
+        .timestamp = slot->entry->timestamp,
+        .pinned    = slot->entry->pinned,
+        .usage     = { slot->hits, slot->last_used, slot->frecency },
+    };
+    g_array_append_val(store->journal, change);
+}
+
+void
+clipium_store_change_clear(ClipiumStoreChange *change)
+{
+    g_clear_pointer(&change->entry, clipium_entry_unref);
+}
+
+/* Unlink an entry from every list and index and free its slot. `evicted`
+ * tells the policy the store chose to drop it, as opposed to a delete. */
+static void
+store_remove_slot(ClipiumStore *store, guint idx, gboolean evicted)
+{
+    store_journal(store, evicted ? CLIPIUM_CHANGE_EVICTED : CLIPIUM_CHANGE_REMOVED, idx);
+    ClipiumEntry *e = SLOT(store, idx)->entry;
+    if (!e->pinned)
+        clipium_evict_policy_remove(store->policy, idx, &e->hash, evicted);
+    g_hash_table_remove(store->by_hash, &e->hash);
+    g_hash_table_remove(store->by_id, GSIZE_TO_POINTER((gsize)e->id));
+    if (!e->content)
+        content_cache_drop(store, e->id);
+    if (e->compressed) {
+        store->compressed_count--;
+        store->compressed_saved -= e->size - g_bytes_get_size(e->compressed);
+    }
+    recency_unlink(store, idx);
+    store->total_bytes -= entry_resident_bytes(e);
+    slot_release(store, idx);
+    store->count--;
+    store_changed(store);
+}
+
+static gboolean
+store_lookup_id(ClipiumStore *store, guint64 id, guint *idx)
+{
+    gpointer idx_ptr;
+    if (!g_hash_table_lookup_extended(store->by_id, GSIZE_TO_POINTER((gsize)id), NULL, &idx_ptr))
+        return FALSE;
+    *idx = GPOINTER_TO_UINT(idx_ptr);
+    return TRUE;
+}
+
+static void
+store_reset_lists(ClipiumStore *store)
+{
+    store->head = store->tail = SLOT_NONE;
+    store->free_head = SLOT_NONE;
+    store->count = 0;
+    store->total_bytes = 0;
+    store->compressed_count = 0;
+    store->compressed_saved = 0;
+}
+
+/* Pick the entry to evict. Over the count cap alone, that is simply the
+ * policy's first candidate. Over the byte budget, weigh its first
+ * CLIPIUM_EVICT_WINDOW candidates by resident size × time since last use so
+ * one large stale image goes before many small snippets; metadata-only
+ * entries would free nothing, but still count toward the window so the
+ * scan stays bounded. If none of those frees anything, fall back to the
+ * first candidate while over the count cap: pinned entries alone can
+ * exceed the budget. `keep` (the entry just added) is never chosen. */
+static guint
+store_pick_victim(ClipiumStore *store, guint keep, gint64 now)
+{
+    gboolean over_bytes = store->max_bytes > 0 && store->total_bytes > store->max_bytes;
+    guint first = SLOT_NONE;
+    guint victim = SLOT_NONE;
+    double best = -1.0;
+    guint scanned = 0;
+
+    for (guint i = clipium_evict_policy_first(store->policy); i != SLOT_NONE;
+         i = clipium_evict_policy_next(store->policy, i)) {
+        if (i == keep)
+            continue;
+        if (!over_bytes)
+            return i;
+        if (first == SLOT_NONE)
+            first = i;
+
+        ClipiumSlot *slot = SLOT(store, i);
+        gsize resident = entry_resident_bytes(slot->entry);
+        double age = (double)MAX(now - slot->last_used, 0) + 1.0;
+        double score = (double)resident * age;
+        if (resident > 0 && score > best) {
+            best = score;
+            victim = i;
+        }
+        if (++scanned >= CLIPIUM_EVICT_WINDOW)
+            break;
     }
+
+    if (victim == SLOT_NONE && store->count > store->max_entries)
+        return first;
+    return victim;
+}
+
+/* Snapshot rows whose preview matched `query`. Any query that has `query`
+ * as a subsequence can only match a subset of them, as long as the rows
+ * still refer to the same snapshot. */
+struct _ClipiumSearchState {
+    char   *key;         /* the folded query, see search_key_refines */
+    gint    generation;
+    GArray *rows;        /* guint, ascending */
+};
+
+static void
+search_state_free(ClipiumSearchState *state)
+{
+    g_free(state->key);
+    g_array_unref(state->rows);
+    g_free(state);
+}
+
+/* A cached search result */
+typedef struct {
+    char      *key;      /* "limit:mode:query" */
+    GPtrArray *entries;  /* ClipiumEntry* refs, in result order */
+} CachedSearch;
+
+static void
+cached_search_free(CachedSearch *cs)
+{
+    g_free(cs->key);
+    g_ptr_array_unref(cs->entries);
+    g_free(cs);
 }
 
 /* --- Public API --- */
@@ -101,13 +807,36 @@ ClipiumStore *
 clipium_store_new(guint max_entries)
 {
     ClipiumStore *store = g_new0(ClipiumStore, 1);
-    store->entries = g_array_new(FALSE, TRUE, sizeof(ClipiumEntry));
-    g_array_set_clear_func(store->entries, entry_clear_notify);
-    store->by_hash = g_hash_table_new(g_str_hash, g_str_equal);
+    store->slots = g_array_new(FALSE, TRUE, sizeof(ClipiumSlot));
+    g_array_set_clear_func(store->slots, slot_clear_notify);
+    store->by_hash = g_hash_table_new(clipium_hash_hash, clipium_hash_equal);
     store->by_id = g_hash_table_new(g_direct_hash, g_direct_equal);
+    store_reset_lists(store);
     store->next_id = 1;
     store->max_entries = max_entries;
+    store->policy = clipium_evict_policy_new(CLIPIUM_EVICT_LRU, max_entries);
+    store->text_index = clipium_trigram_index_new();
+    store->typo_index = clipium_typo_index_new();
+    store->attrs = clipium_attr_index_new();
+    store->by_frecency = g_tree_new_full(frecency_compare, store, NULL, NULL);
+    store->ttl_rules = g_ptr_array_new_with_free_func(ttl_rule_free);
+    store->expiry = clipium_wheel_new(g_get_real_time(), CLIPIUM_TTL_TICK_USEC);
+    store->content_cache = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_queue_init(&store->content_lru);
+    store->content_cache_max = CLIPIUM_CONTENT_CACHE_BYTES;
     g_mutex_init(&store->lock);
+    g_mutex_init(&store->snapshot_lock);
+    g_mutex_init(&store->content_lock);
+    g_mutex_init(&store->search_lock);
+    store->search_parallel_min = CLIPIUM_SEARCH_PARALLEL_MIN;
+    store->search_cache = g_hash_table_new(g_str_hash, g_str_equal);
+    g_queue_init(&store->search_lru);
+    store->search_cache_generation = -1;
+    store->regex_cache = clipium_regex_cache_new(CLIPIUM_REGEX_CACHE_SIZE);
+    store->grep_budget = CLIPIUM_GREP_BUDGET_MS * 1000;
+    store->search_slice = CLIPIUM_SEARCH_SLICE;
+    store->search_first_usec = CLIPIUM_SEARCH_FIRST_MS * 1000;
+    store->search_refine_usec = CLIPIUM_SEARCH_REFINE_MS * 1000;
     return store;
 }
 
@@ -115,10 +844,32 @@ void
 clipium_store_free(ClipiumStore *store)
 {
     if (!store) return;
-    /* Caller must ensure no other threads access the store */
+    /* Caller must ensure no other threads access the store. Entries and
+     * snapshots still referenced elsewhere stay valid. */
     g_hash_table_destroy(store->by_hash);
     g_hash_table_destroy(store->by_id);
-    g_array_free(store->entries, TRUE);
+    g_array_free(store->slots, TRUE);
+    clipium_evict_policy_free(store->policy);
+    clipium_wheel_free(store->expiry);
+    clipium_trigram_index_free(store->text_index);
+    clipium_typo_index_free(store->typo_index);
+    clipium_attr_index_free(store->attrs);
+    g_tree_destroy(store->by_frecency);
+    g_ptr_array_unref(store->ttl_rules);
+    content_cache_drop_all(store);
+    g_hash_table_destroy(store->content_cache);
+    g_clear_pointer(&store->snapshot, clipium_snapshot_unref);
+    if (store->search_pool)
+        g_thread_pool_free(store->search_pool, FALSE, TRUE);
+    g_clear_pointer(&store->last_search, search_state_free);
+    g_queue_clear_full(&store->search_lru, (GDestroyNotify)cached_search_free);
+    g_hash_table_destroy(store->search_cache);
+    clipium_regex_cache_free(store->regex_cache);
+    if (store->journal)
+        g_array_unref(store->journal);
+    g_mutex_clear(&store->search_lock);
+    g_mutex_clear(&store->content_lock);
+    g_mutex_clear(&store->snapshot_lock);
     g_mutex_clear(&store->lock);
     g_free(store);
 }
@@ -128,11 +879,28 @@ clipium_store_add(ClipiumStore *store, GBytes *content, const char *mime_type)
 {
     g_return_val_if_fail(store && content && mime_type, 0);
 
+    ClipiumHash hash;
+    clipium_entry_compute_hash(content, &hash);
+    return clipium_store_add_hashed(store, content, mime_type, &hash);
+}
+
+guint64
+clipium_store_add_hashed(ClipiumStore      *store,
+                         GBytes            *content,
+                         const char        *mime_type,
+                         const ClipiumHash *hash)
+{
+    g_return_val_if_fail(store && content && mime_type && hash, 0);
+
     gsize size = g_bytes_get_size(content);
     if (size == 0)
         return 0;
 
-    g_autofree char *hash = clipium_entry_compute_hash(content);
+    /* Everything expensive happens before taking the lock */
+    g_autofree char *preview = clipium_entry_make_preview(content, mime_type);
+    g_autoptr(GArray) trigrams = entry_extract_trigrams(content, mime_type);
+    g_autoptr(GPtrArray) words = entry_extract_words(content, mime_type);
+    gint64 now = g_get_real_time();
 
     g_mutex_lock(&store->lock);
 
@@ -140,193 +908,1436 @@ clipium_store_add(ClipiumStore *store, GBytes *content, const char *mime_type)
     gpointer idx_ptr;
     if (g_hash_table_lookup_extended(store->by_hash, hash, NULL, &idx_ptr)) {
         guint idx = GPOINTER_TO_UINT(idx_ptr);
-        if (idx < store->entries->len) {
-            ClipiumEntry existing = g_array_index(store->entries, ClipiumEntry, idx);
-            /* Update timestamp */
-            existing.timestamp = g_get_real_time();
-            /* Zero out the slot so clear func doesn't free our data */
-            ClipiumEntry *slot = &g_array_index(store->entries, ClipiumEntry, idx);
-            memset(slot, 0, sizeof(ClipiumEntry));
-            g_array_remove_index(store->entries, idx);
-            /* Prepend */
-            g_array_prepend_val(store->entries, existing);
-            store_rebuild_indices(store);
-        }
+        ClipiumEntry *bumped = clipium_entry_copy(SLOT(store, idx)->entry);
+        bumped->timestamp = now;
+        slot_replace_entry(store, idx, bumped);
+
+        slot_record_use(store, idx, now);
+        recency_unlink(store, idx);
+        recency_push_front(store, idx);
+        if (!bumped->pinned)
+            clipium_evict_policy_touch(store->policy, idx, now, TRUE);
+        store_schedule_expiry(store, idx);
+        store_journal(store, CLIPIUM_CHANGE_BUMPED, idx);
+        /* A metadata-only entry may not have been indexed yet */
+        if (trigrams && !clipium_trigram_index_has(store->text_index, idx))
+            clipium_trigram_index_insert(store->text_index, idx, g_steal_pointer(&trigrams));
+        if (words && !clipium_typo_index_has(store->typo_index, idx))
+            clipium_typo_index_insert(store->typo_index, idx, g_steal_pointer(&words));
+        store_changed(store);
         g_mutex_unlock(&store->lock);
         return 0;
     }
 
     /* Create new entry */
-    ClipiumEntry entry = {
-        .id        = store->next_id++,
-        .content   = g_bytes_ref(content),
-        .mime_type = g_strdup(mime_type),
-        .preview   = clipium_entry_make_preview(content, mime_type),
-        .hash      = g_strdup(hash),
-        .timestamp = g_get_real_time(),
-        .pinned    = FALSE,
-        .size      = size,
-    };
-
-    guint64 new_id = entry.id;
+    guint64 new_id = store->next_id++;
+    guint idx = slot_alloc(store);
+    ClipiumEntry *entry = clipium_entry_new(new_id, content, mime_type, preview,
+                                            hash, now, FALSE, size);
+    SLOT(store, idx)->entry = entry;
+    SLOT(store, idx)->last_used = now;
+    SLOT(store, idx)->frecency = clipium_frecency_add(0, now);
+    store_index_attrs(store, idx);
+    store_index_frecency(store, idx);
 
     /* Prepend (newest first) */
-    g_array_prepend_val(store->entries, entry);
-
-    /* Evict oldest non-pinned if over capacity */
-    while (store->entries->len > store->max_entries) {
-        gboolean found = FALSE;
-        for (int i = (int)store->entries->len - 1; i >= 0; i--) {
-            ClipiumEntry *e = &g_array_index(store->entries, ClipiumEntry, (guint)i);
-            if (!e->pinned) {
-                g_array_remove_index(store->entries, (guint)i);
-                found = TRUE;
-                break;
-            }
-        }
-        if (!found) break;
+    recency_push_front(store, idx);
+    clipium_evict_policy_insert(store->policy, idx, &entry->hash, now, 0);
+    store_schedule_expiry(store, idx);
+    if (trigrams)
+        clipium_trigram_index_insert(store->text_index, idx, g_steal_pointer(&trigrams));
+    if (words)
+        clipium_typo_index_insert(store->typo_index, idx, g_steal_pointer(&words));
+    g_hash_table_insert(store->by_hash, &entry->hash, GUINT_TO_POINTER(idx));
+    g_hash_table_insert(store->by_id, GSIZE_TO_POINTER((gsize)new_id), GUINT_TO_POINTER(idx));
+    store->count++;
+    store->total_bytes += size;
+    store_journal(store, CLIPIUM_CHANGE_ADDED, idx);
+    store_changed(store);
+
+    /* Evict unpinned entries while over the count cap or the byte budget */
+    while (store->count > store->max_entries ||
+           (store->max_bytes > 0 && store->total_bytes > store->max_bytes)) {
+        guint victim = store_pick_victim(store, idx, now);
+        if (victim == SLOT_NONE)
+            break;
+        store_remove_slot(store, victim, TRUE);
     }
 
-    store_rebuild_indices(store);
     g_mutex_unlock(&store->lock);
 
     return new_id;
 }
 
 void
-clipium_store_load_entry(ClipiumStore *store,
-                         guint64       id,
-                         GBytes       *content,
-                         const char   *mime_type,
-                         const char   *hash,
-                         const char   *preview,
-                         gint64        timestamp,
-                         gboolean      pinned,
-                         gsize         size)
-{
-    g_mutex_lock(&store->lock);
-
-    ClipiumEntry entry = {
-        .id        = id,
-        .content   = g_bytes_ref(content),
-        .mime_type = g_strdup(mime_type),
-        .preview   = g_strdup(preview),
-        .hash      = g_strdup(hash),
-        .timestamp = timestamp,
-        .pinned    = pinned,
-        .size      = size,
-    };
+clipium_store_bulk_begin(ClipiumStore *store, guint size_hint)
+{
+    g_mutex_lock(&store->lock);
+    store->bulk_base = store->slots->len;
+
+    /* Grow once up front; shrinking a GArray keeps its allocation */
+    g_array_set_size(store->slots, store->bulk_base + size_hint);
+    g_array_set_size(store->slots, store->bulk_base);
+}
+
+void
+clipium_store_bulk_append(ClipiumStore       *store,
+                          guint64             id,
+                          GBytes             *content,
+                          const char         *mime_type,
+                          const ClipiumHash  *hash,
+                          const char         *preview,
+                          gint64              timestamp,
+                          gboolean            pinned,
+                          gsize               size,
+                          const ClipiumUsage *usage)
+{
+    /* Always append so the new rows form one contiguous run from bulk_base */
+    guint idx = store->slots->len;
+    g_array_set_size(store->slots, idx + 1);
 
-    g_array_append_val(store->entries, entry);
+    ClipiumSlot *slot = SLOT(store, idx);
+    slot->prev = slot->next = SLOT_NONE;
+    slot->hits = usage ? usage->hits : 0;
+    slot->last_used = usage && usage->last_used ? usage->last_used : timestamp;
+    slot->frecency = usage && usage->frecency != 0 ? usage->frecency
+                                                    : clipium_frecency_add(0, timestamp);
+    slot->incompressible = FALSE;
+    slot->in_use = TRUE;
+    slot->entry = clipium_entry_new(id, content, mime_type, preview, hash,
+                                    timestamp, pinned, size);
+    store_index_attrs(store, idx);
+    store_index_frecency(store, idx);
+
+    /* Rows arrive newest-first, so each one goes to the back */
+    recency_push_back(store, idx);
+    if (!pinned)
+        clipium_evict_policy_insert(store->policy, idx, &slot->entry->hash,
+                                    slot->last_used, slot->hits);
+    store_schedule_expiry(store, idx);
+    GArray *trigrams = entry_extract_trigrams(content, mime_type);
+    if (trigrams)
+        clipium_trigram_index_insert(store->text_index, idx, trigrams);
+    GPtrArray *words = entry_extract_words(content, mime_type);
+    if (words)
+        clipium_typo_index_insert(store->typo_index, idx, words);
+    store->count++;
+    store->total_bytes += entry_resident_bytes(slot->entry);
 
     if (id >= store->next_id)
         store->next_id = id + 1;
-
-    store_rebuild_indices(store);
-    g_mutex_unlock(&store->lock);
 }
 
-/* NOTE: Returns pointer into internal array. Safe only when called from the
- * main thread (all store mutations are serialized on the main thread).
- * Do NOT hold this pointer across any call that may modify the store. */
-ClipiumEntry *
-clipium_store_get(ClipiumStore *store, guint64 id)
+void
+clipium_store_bulk_end(ClipiumStore *store)
 {
-    g_mutex_lock(&store->lock);
-    gpointer idx_ptr;
-    if (g_hash_table_lookup_extended(store->by_id, GSIZE_TO_POINTER((gsize)id), NULL, &idx_ptr)) {
-        guint idx = GPOINTER_TO_UINT(idx_ptr);
-        if (idx < store->entries->len) {
-            ClipiumEntry *e = &g_array_index(store->entries, ClipiumEntry, idx);
-            g_mutex_unlock(&store->lock);
-            return e;
+    for (guint idx = store->bulk_base; idx < store->slots->len; idx++) {
+        ClipiumSlot *slot = SLOT(store, idx);
+
+        /* Keep the newest copy if the same content or id shows up twice */
+        if (g_hash_table_contains(store->by_hash, &slot->entry->hash) ||
+            g_hash_table_contains(store->by_id, GSIZE_TO_POINTER((gsize)slot->entry->id))) {
+            if (!slot->entry->pinned)
+                clipium_evict_policy_remove(store->policy, idx, NULL, FALSE);
+            recency_unlink(store, idx);
+            store->total_bytes -= entry_resident_bytes(slot->entry);
+            slot_release(store, idx);
+            store->count--;
+            continue;
         }
+
+        g_hash_table_insert(store->by_hash, &slot->entry->hash, GUINT_TO_POINTER(idx));
+        g_hash_table_insert(store->by_id, GSIZE_TO_POINTER((gsize)slot->entry->id), GUINT_TO_POINTER(idx));
     }
+
+    store_changed(store);
     g_mutex_unlock(&store->lock);
-    return NULL;
 }
 
-GArray *
-clipium_store_list(ClipiumStore *store, guint limit, guint offset)
+void
+clipium_store_load_entry(ClipiumStore      *store,
+                         guint64            id,
+                         GBytes            *content,
+                         const char        *mime_type,
+                         const ClipiumHash *hash,
+                         const char        *preview,
+                         gint64             timestamp,
+                         gboolean           pinned,
+                         gsize              size)
+{
+    clipium_store_bulk_begin(store, 1);
+    clipium_store_bulk_append(store, id, content, mime_type, hash, preview,
+                              timestamp, pinned, size, NULL);
+    clipium_store_bulk_end(store);
+}
+
+ClipiumEntry *
+clipium_store_get(ClipiumStore *store, guint64 id)
 {
     g_mutex_lock(&store->lock);
+    guint idx;
+    ClipiumEntry *e = store_lookup_id(store, id, &idx)
+        ? clipium_entry_ref(SLOT(store, idx)->entry) : NULL;
+    g_mutex_unlock(&store->lock);
+    return e;
+}
 
-    GArray *result = g_array_new(FALSE, FALSE, sizeof(ClipiumEntry *));
-    guint count = 0;
+/* Fill the parallel metadata arrays from the entry refs. Entries are
+ * immutable, so this runs after store->lock has been released. */
+static void
+snapshot_build_columns(ClipiumSnapshot *snap)
+{
+    guint n = snap->entries->len;
+    snap->len = n;
+    snap->timestamps = g_new(gint64, n);
+    snap->sizes = g_new(gsize, n);
+    snap->key_offsets = g_new(guint32, n);
+    snap->mime_ids = g_new(GQuark, n);
+    snap->char_masks = g_new(guint64, n);
+    snap->pinned = g_new(guint8, n);
 
-    for (guint i = offset; i < store->entries->len && count < limit; i++, count++) {
-        ClipiumEntry *e = &g_array_index(store->entries, ClipiumEntry, i);
-        g_array_append_val(result, e);
+    gsize arena_len = 0;
+    for (guint i = 0; i < n; i++)
+        arena_len += strlen(((ClipiumEntry *)g_ptr_array_index(snap->entries, i))->search_key) + 1;
+    snap->key_arena = g_malloc(MAX(arena_len, 1));
+    snap->key_arena_len = arena_len;
+
+    /* Mime types are interned, so consecutive entries of the same type
+     * (the common case) skip the quark table lookup */
+    const char *last_mime = NULL;
+    GQuark last_quark = 0;
+    gsize pos = 0;
+    for (guint i = 0; i < n; i++) {
+        const ClipiumEntry *e = g_ptr_array_index(snap->entries, i);
+        snap->timestamps[i] = e->timestamp;
+        snap->sizes[i] = e->size;
+        snap->pinned[i] = e->pinned ? 1 : 0;
+        snap->char_masks[i] = e->char_mask;
+        if (e->mime_type != last_mime) {
+            last_mime = e->mime_type;
+            last_quark = g_quark_from_string(last_mime);
+        }
+        snap->mime_ids[i] = last_quark;
+
+        gsize len = strlen(e->search_key) + 1;
+        memcpy(snap->key_arena + pos, e->search_key, len);
+        snap->key_offsets[i] = (guint32)pos;
+        pos += len;
     }
+}
+
+/* Returns the current snapshot, publishing a fresh one if the store changed
+ * since the last one was built. The rebuild only copies entry pointers, and
+ * it happens at most once per burst of changes, not once per mutation. */
+ClipiumSnapshot *
+clipium_store_snapshot(ClipiumStore *store)
+{
+    g_mutex_lock(&store->snapshot_lock);
+    ClipiumSnapshot *current = store->snapshot;
+    if (current && current->generation == g_atomic_int_get(&store->generation)) {
+        clipium_snapshot_ref(current);
+        g_mutex_unlock(&store->snapshot_lock);
+        return current;
+    }
+    g_mutex_unlock(&store->snapshot_lock);
+
+    ClipiumSnapshot *snap = g_new0(ClipiumSnapshot, 1);
+    g_atomic_ref_count_init(&snap->ref_count);
+
+    g_mutex_lock(&store->lock);
+    snap->generation = g_atomic_int_get(&store->generation);
+    guint uses = store->uses;
+    snap->entries = g_ptr_array_new_full(store->count, (GDestroyNotify)clipium_entry_unref);
+    snap->frecency = g_new(gint, MAX(store->count, 1));
+    for (guint i = store->head; i != SLOT_NONE; i = SLOT(store, i)->next) {
+        SLOT(store, i)->snapshot_row = snap->entries->len;
+        snapshot_set_frecency(snap, snap->entries->len, SLOT(store, i)->frecency);
+        g_ptr_array_add(snap->entries, clipium_entry_ref(SLOT(store, i)->entry));
+    }
+    g_mutex_unlock(&store->lock);
 
+    snapshot_build_columns(snap);
+
+    /* Publish unless a concurrent reader already published this generation.
+     * Uses that came in while the columns were built went to the snapshot
+     * this one replaces, so pick them up first. */
+    g_mutex_lock(&store->lock);
+    if (store->uses != uses && snap->generation == g_atomic_int_get(&store->generation)) {
+        for (guint i = store->head; i != SLOT_NONE; i = SLOT(store, i)->next)
+            snapshot_set_frecency(snap, SLOT(store, i)->snapshot_row, SLOT(store, i)->frecency);
+    }
+    g_mutex_lock(&store->snapshot_lock);
+    current = store->snapshot;
+    if (!current || current->generation != snap->generation) {
+        store->snapshot = clipium_snapshot_ref(snap);
+        g_mutex_unlock(&store->snapshot_lock);
+        g_mutex_unlock(&store->lock);
+        if (current)
+            clipium_snapshot_unref(current);
+        return snap;
+    }
+    clipium_snapshot_ref(current);
+    g_mutex_unlock(&store->snapshot_lock);
     g_mutex_unlock(&store->lock);
+    clipium_snapshot_unref(snap);
+    return current;
+}
+
+static GArray *
+entry_result_array_new(guint reserve)
+{
+    GArray *result = g_array_sized_new(FALSE, FALSE, sizeof(ClipiumEntry *), reserve);
+    g_array_set_clear_func(result, entry_ptr_clear_notify);
     return result;
 }
 
 GArray *
-clipium_store_search(ClipiumStore *store, const char *query, guint limit)
+clipium_store_list(ClipiumStore *store, guint limit, guint offset)
+{
+    g_autoptr(ClipiumSnapshot) snap = clipium_store_snapshot(store);
+    GArray *result = entry_result_array_new(MIN(limit, snap->len));
+
+    for (guint i = offset; i < snap->len && result->len < limit; i++) {
+        ClipiumEntry *e = clipium_entry_ref(g_ptr_array_index(snap->entries, i));
+        g_array_append_val(result, e);
+    }
+
+    return result;
+}
+
+/* by_frecency keeps its order as uses come in, so this only walks the
+ * first `limit` nodes */
+GArray *
+clipium_store_list_frecent(ClipiumStore *store, guint limit)
+{
+    g_mutex_lock(&store->lock);
+    GArray *result = entry_result_array_new(MIN(limit, store->count));
+    for (GTreeNode *node = g_tree_node_first(store->by_frecency); node && result->len < limit;
+         node = g_tree_node_next(node)) {
+        ClipiumEntry *e = clipium_entry_ref(SLOT(store, GPOINTER_TO_UINT(g_tree_node_key(node)))->entry);
+        g_array_append_val(result, e);
+    }
+    g_mutex_unlock(&store->lock);
+    return result;
+}
+
+typedef struct {
+    ClipiumEntry *entry;
+    int           score;
+} SearchMatch;
+
+/* Whether every match of `key` is also a match of `previous`. Both are
+ * query keys as previews are matched on, folded by clipium_fuzzy_fold (so
+ * "straße" refines "stras"); that leaves ASCII case to the matcher, which
+ * ignores it, and so does this. */
+static gboolean
+search_key_refines(const char *previous, const char *key)
+{
+    for (; *key && *previous; key++) {
+        if (g_ascii_tolower(*key) == g_ascii_tolower(*previous))
+            previous++;
+    }
+    return *previous == '\0';
+}
+
+/* The rows a refinement of the last scan has to look at, or NULL if the
+ * last scan was for another snapshot or an unrelated query key */
+static GArray *
+search_state_rows(ClipiumStore *store, const ClipiumSnapshot *snap, const char *key)
+{
+    GArray *rows = NULL;
+    g_mutex_lock(&store->search_lock);
+    ClipiumSearchState *state = store->last_search;
+    if (state && state->generation == snap->generation &&
+        search_key_refines(state->key, key))
+        rows = g_array_ref(state->rows);
+    g_mutex_unlock(&store->search_lock);
+    return rows;
+}
+
+static void
+search_state_save(ClipiumStore *store, const ClipiumSnapshot *snap, const char *key, GArray *rows)
+{
+    ClipiumSearchState *state = g_new(ClipiumSearchState, 1);
+    state->key = g_strdup(key);
+    state->generation = snap->generation;
+    state->rows = g_array_ref(rows);
+
+    g_mutex_lock(&store->search_lock);
+    ClipiumSearchState *old = g_steal_pointer(&store->last_search);
+    store->last_search = state;
+    g_mutex_unlock(&store->search_lock);
+    if (old)
+        search_state_free(old);
+}
+
+/* Best score first, then most recent */
+static gint
+search_match_compare(gconstpointer a, gconstpointer b)
+{
+    const SearchMatch *x = a, *y = b;
+    if (x->score != y->score)
+        return y->score - x->score;
+    if (x->entry->timestamp != y->entry->timestamp)
+        return (y->entry->timestamp > x->entry->timestamp) - (y->entry->timestamp < x->entry->timestamp);
+    return (y->entry->id > x->entry->id) - (y->entry->id < x->entry->id);
+}
+
+/* Bounded selection of the best `limit` matches: a heap with the worst
+ * kept match at the root, so each candidate costs O(log limit) and the
+ * rest are rejected with one comparison */
+typedef struct {
+    GArray *heap;   /* SearchMatch */
+    guint   limit;
+} SearchTopK;
+
+static void
+search_topk_init(SearchTopK *topk, guint limit)
+{
+    topk->heap = g_array_sized_new(FALSE, FALSE, sizeof(SearchMatch), MIN(limit, 1024));
+    topk->limit = limit;
+}
+
+#define HEAP(topk, i) (&g_array_index((topk)->heap, SearchMatch, (i)))
+
+static void
+search_topk_push(SearchTopK *topk, const SearchMatch *m)
+{
+    if (topk->limit == 0)
+        return;
+
+    guint i;
+    if (topk->heap->len < topk->limit) {
+        /* Sift up from the new leaf while the parent ranks above it */
+        g_array_set_size(topk->heap, topk->heap->len + 1);
+        for (i = topk->heap->len - 1; i > 0; i = (i - 1) / 2) {
+            if (search_match_compare(HEAP(topk, (i - 1) / 2), m) >= 0)
+                break;
+            *HEAP(topk, i) = *HEAP(topk, (i - 1) / 2);
+        }
+    } else {
+        if (search_match_compare(m, HEAP(topk, 0)) >= 0)
+            return;  /* no better than the worst kept */
+
+        /* Sift down from the root, towards the worse child */
+        guint len = topk->heap->len;
+        for (i = 0;;) {
+            guint child = 2 * i + 1;
+            if (child >= len)
+                break;
+            if (child + 1 < len && search_match_compare(HEAP(topk, child + 1), HEAP(topk, child)) > 0)
+                child++;
+            if (search_match_compare(HEAP(topk, child), m) <= 0)
+                break;
+            *HEAP(topk, i) = *HEAP(topk, child);
+            i = child;
+        }
+    }
+    *HEAP(topk, i) = *m;
+}
+
+/* Whether `m` would be kept if pushed now */
+static gboolean
+search_topk_admits(const SearchTopK *topk, const SearchMatch *m)
+{
+    return topk->heap->len < topk->limit || search_match_compare(m, HEAP(topk, 0)) < 0;
+}
+
+#undef HEAP
+
+/* The kept matches, best first; the selection is consumed */
+static GArray *
+search_topk_finish(SearchTopK *topk)
+{
+    g_array_sort(topk->heap, search_match_compare);
+    return g_steal_pointer(&topk->heap);
+}
+
+/* The kept matches so far as a search result, leaving the selection be */
+static GArray *
+search_topk_peek(const SearchTopK *topk)
+{
+    g_autoptr(GArray) sorted = g_array_copy(topk->heap);
+    g_array_sort(sorted, search_match_compare);
+    GArray *result = entry_result_array_new(sorted->len);
+    for (guint i = 0; i < sorted->len; i++) {
+        ClipiumEntry *e = clipium_entry_ref(g_array_index(sorted, SearchMatch, i).entry);
+        g_array_append_val(result, e);
+    }
+    return result;
+}
+
+/* A job for the search pool. Each kind of job starts with one of these,
+ * so the pool runs them all. */
+typedef struct SearchTask {
+    void               (*run)(struct SearchTask *task);
+    struct SearchBatch  *batch;
+} SearchTask;
+
+typedef struct SearchBatch {
+    GMutex lock;
+    GCond  done;
+    guint  pending;
+} SearchBatch;
+
+/* One slice of a preview scan. Chunks only read the snapshot, so any
+ * number can run at once; each keeps its own best `limit` matches and
+ * every matching row (for the narrowing state). */
+typedef struct {
+    SearchTask             task;
+    const ClipiumSnapshot *snap;
+    const char            *query;
+    guint64                query_mask;
+    double                 origin;    /* for frecency_bonus */
+    const GArray          *previous;  /* rows to look at, or NULL for all */
+    guint                  start;     /* range into previous, or the rows */
+    guint                  end;
+    SearchTopK             best;
+    GArray                *matches;   /* SearchMatch, best first, once run */
+    GArray                *rows;      /* guint, ascending */
+} SearchChunk;
+
+static void
+search_chunk_run(SearchTask *task)
+{
+    SearchChunk *chunk = (SearchChunk *)task;
+    const ClipiumSnapshot *snap = chunk->snap;
+    for (guint r = chunk->start; r < chunk->end; r++) {
+        guint i = chunk->previous ? g_array_index(chunk->previous, guint, r) : r;
+        if (chunk->query_mask & ~snap->char_masks[i])
+            continue;
+        int score = clipium_fuzzy_score(chunk->query, clipium_snapshot_key(snap, i),
+                                        clipium_snapshot_key_len(snap, i), NULL);
+        if (score < 0)
+            continue;
+        g_array_append_val(chunk->rows, i);
+        SearchMatch m = { .entry = g_ptr_array_index(snap->entries, i),
+                          .score = score + frecency_bonus(snapshot_frecency(snap, i), chunk->origin) };
+        search_topk_push(&chunk->best, &m);
+    }
+
+    /* Only the chunk's own top `limit` can make the merged top `limit` */
+    chunk->matches = search_topk_finish(&chunk->best);
+}
+
+static void
+search_task_worker(gpointer data, gpointer user_data)
+{
+    SearchTask *task = data;
+    task->run(task);
+
+    SearchBatch *batch = task->batch;
+    g_mutex_lock(&batch->lock);
+    if (--batch->pending == 0)
+        g_cond_signal(&batch->done);
+    g_mutex_unlock(&batch->lock);
+}
+
+static GThreadPool *
+store_search_pool(ClipiumStore *store)
+{
+    g_mutex_lock(&store->search_lock);
+    if (!store->search_pool)
+        store->search_pool = g_thread_pool_new(search_task_worker, NULL,
+                                               (gint)MAX(g_get_num_processors(), 1),
+                                               FALSE, NULL);
+    GThreadPool *pool = store->search_pool;
+    g_mutex_unlock(&store->search_lock);
+    return pool;
+}
+
+/* Run `n_tasks` tasks laid out `stride` bytes apart: the calling thread
+ * takes the first itself and the pool the rest. Returns once all are done. */
+static void
+search_batch_run(ClipiumStore *store, gpointer tasks, gsize stride, guint n_tasks)
+{
+    SearchBatch batch = { .pending = n_tasks - 1 };
+    g_mutex_init(&batch.lock);
+    g_cond_init(&batch.done);
+
+#define TASK(i) ((SearchTask *)((char *)tasks + (i) * stride))
+    for (guint i = 0; i < n_tasks; i++)
+        TASK(i)->batch = &batch;
+    if (n_tasks > 1) {
+        GThreadPool *pool = store_search_pool(store);
+        for (guint i = 1; i < n_tasks; i++)
+            g_thread_pool_push(pool, TASK(i), NULL);
+    }
+    TASK(0)->run(TASK(0));
+#undef TASK
+
+    g_mutex_lock(&batch.lock);
+    while (batch.pending > 0)
+        g_cond_wait(&batch.done, &batch.lock);
+    g_mutex_unlock(&batch.lock);
+    g_cond_clear(&batch.done);
+    g_mutex_clear(&batch.lock);
+}
+
+/* Score `n_rows` rows from `first` on, in chunks on the worker pool when
+ * there are enough of them. Appends each chunk's best matches to `matches`
+ * and every matching row to `rows`, both in row order. */
+static void
+store_scan_previews(ClipiumStore *store, const ClipiumSnapshot *snap, const char *query,
+                    guint64 query_mask, double origin, const GArray *previous, guint first,
+                    guint n_rows, guint limit, GArray *matches, GArray *rows)
+{
+    guint n_chunks = 1;
+    if (n_rows >= store->search_parallel_min)
+        n_chunks = (n_rows + CLIPIUM_SEARCH_CHUNK - 1) / CLIPIUM_SEARCH_CHUNK;
+
+    SearchChunk *chunks = g_new0(SearchChunk, n_chunks);
+    for (guint c = 0; c < n_chunks; c++) {
+        SearchChunk *chunk = &chunks[c];
+        chunk->task.run = search_chunk_run;
+        chunk->snap = snap;
+        chunk->query = query;
+        chunk->query_mask = query_mask;
+        chunk->origin = origin;
+        chunk->previous = previous;
+        chunk->start = first + (n_chunks == 1 ? 0 : c * CLIPIUM_SEARCH_CHUNK);
+        chunk->end = first + (n_chunks == 1 ? n_rows : MIN(n_rows, (c + 1) * CLIPIUM_SEARCH_CHUNK));
+        search_topk_init(&chunk->best, limit);
+        chunk->rows = g_array_new(FALSE, FALSE, sizeof(guint));
+    }
+    search_batch_run(store, chunks, sizeof(SearchChunk), n_chunks);
+
+    for (guint c = 0; c < n_chunks; c++) {
+        g_array_append_vals(matches, chunks[c].matches->data, chunks[c].matches->len);
+        g_array_append_vals(rows, chunks[c].rows->data, chunks[c].rows->len);
+        g_array_unref(chunks[c].matches);
+        g_array_unref(chunks[c].rows);
+    }
+    g_free(chunks);
+}
+
+/* --- Search result cache --- */
+
+/* Caller holds search_lock. Results only hold for one generation, so a
+ * newer one empties the cache. */
+static void
+search_cache_sync(ClipiumStore *store, gint generation)
 {
+    if (store->search_cache_generation == generation)
+        return;
+    g_hash_table_remove_all(store->search_cache);
+    g_queue_clear_full(&store->search_lru, (GDestroyNotify)cached_search_free);
+    store->search_cache_generation = generation;
+}
+
+static GArray *
+search_cache_lookup(ClipiumStore *store, const ClipiumSnapshot *snap, const char *key)
+{
+    GArray *result = NULL;
+    g_mutex_lock(&store->search_lock);
+    search_cache_sync(store, snap->generation);
+    GList *link = g_hash_table_lookup(store->search_cache, key);
+    if (link) {
+        g_queue_unlink(&store->search_lru, link);
+        g_queue_push_head_link(&store->search_lru, link);
+
+        CachedSearch *cs = link->data;
+        result = entry_result_array_new(cs->entries->len);
+        for (guint i = 0; i < cs->entries->len; i++) {
+            ClipiumEntry *e = clipium_entry_ref(g_ptr_array_index(cs->entries, i));
+            g_array_append_val(result, e);
+        }
+        store->search_cache_hits++;
+    }
+    g_mutex_unlock(&store->search_lock);
+    return result;
+}
+
+/* Remember `result` for `key` (taking ownership of the key), unless the
+ * store moved on while it was computed */
+static void
+search_cache_insert(ClipiumStore *store, const ClipiumSnapshot *snap, char *key, GArray *result)
+{
+    CachedSearch *cs = g_new(CachedSearch, 1);
+    cs->key = key;
+    cs->entries = g_ptr_array_new_full(result->len, (GDestroyNotify)clipium_entry_unref);
+    for (guint i = 0; i < result->len; i++)
+        g_ptr_array_add(cs->entries, clipium_entry_ref(g_array_index(result, ClipiumEntry *, i)));
+
+    g_mutex_lock(&store->search_lock);
+    if (store->search_cache_generation != snap->generation ||
+        g_hash_table_contains(store->search_cache, key)) {
+        g_mutex_unlock(&store->search_lock);
+        cached_search_free(cs);
+        return;
+    }
+    g_queue_push_head(&store->search_lru, cs);
+    g_hash_table_insert(store->search_cache, cs->key, store->search_lru.head);
+    while (store->search_lru.length > CLIPIUM_SEARCH_CACHE_SIZE) {
+        CachedSearch *old = g_queue_pop_tail(&store->search_lru);
+        g_hash_table_remove(store->search_cache, old->key);
+        cached_search_free(old);
+    }
+    g_mutex_unlock(&store->search_lock);
+}
+
+/* Entries whose indexed text has every trigram of the query, and their
+ * frecency (double) in `frecency`. Returns FALSE if the query is too short
+ * for the index. */
+static gboolean
+store_index_candidates(ClipiumStore *store, const char *query, GPtrArray *candidates,
+                       GArray *frecency)
+{
+    g_autoptr(GArray) slots = g_array_new(FALSE, FALSE, sizeof(guint));
+
     g_mutex_lock(&store->lock);
+    gboolean indexed = clipium_trigram_index_query(store->text_index, query, slots);
+    for (guint i = 0; i < slots->len; i++) {
+        ClipiumSlot *slot = SLOT(store, g_array_index(slots, guint, i));
+        g_ptr_array_add(candidates, clipium_entry_ref(slot->entry));
+        g_array_append_val(frecency, slot->frecency);
+    }
+    g_mutex_unlock(&store->lock);
 
-    /* Collect matches with scores */
-    typedef struct { ClipiumEntry *entry; int score; } Match;
-    GArray *matches = g_array_new(FALSE, FALSE, sizeof(Match));
+    return indexed;
+}
 
-    for (guint i = 0; i < store->entries->len; i++) {
-        ClipiumEntry *e = &g_array_index(store->entries, ClipiumEntry, i);
-        int score = clipium_fuzzy_match(query, e->preview);
-        if (score >= 0) {
-            Match m = { .entry = e, .score = score };
-            g_array_append_val(matches, m);
+/* A typo-tolerant match, see store_search_typos */
+typedef struct {
+    ClipiumEntry *entry;
+    guint         distance;
+    double        frecency;
+} TypoMatch;
+
+/* Fewest edits first, then most frecent, then newest */
+static gint
+typo_match_compare(gconstpointer a, gconstpointer b)
+{
+    const TypoMatch *x = a, *y = b;
+    if (x->distance != y->distance)
+        return (x->distance > y->distance) - (x->distance < y->distance);
+    if (x->frecency != y->frecency)
+        return (y->frecency > x->frecency) - (y->frecency < x->frecency);
+    return (y->entry->id > x->entry->id) - (y->entry->id < x->entry->id);
+}
+
+/* Append to `result` up to `limit` entries it does not already hold whose
+ * words are within the typo allowance of every word of `query`. They go
+ * after everything already there, so any exact match ranks above them. */
+static void
+store_search_typos(ClipiumStore *store, const char *query, guint limit, GArray *result)
+{
+    g_autoptr(GHashTable) taken = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < result->len; i++)
+        g_hash_table_add(taken, g_array_index(result, ClipiumEntry *, i));
+    g_autoptr(GArray) hits = g_array_new(FALSE, FALSE, sizeof(ClipiumTypoHit));
+    g_autoptr(GArray) typos = g_array_new(FALSE, FALSE, sizeof(TypoMatch));
+
+    g_mutex_lock(&store->lock);
+    if (store->typo_edits > 0 &&
+        clipium_typo_index_query(store->typo_index, query, store->typo_edits, hits)) {
+        for (guint i = 0; i < hits->len; i++) {
+            const ClipiumTypoHit *hit = &g_array_index(hits, ClipiumTypoHit, i);
+            ClipiumSlot *slot = SLOT(store, hit->slot);
+            if (g_hash_table_contains(taken, slot->entry))
+                continue;
+            TypoMatch m = { clipium_entry_ref(slot->entry), hit->distance, slot->frecency };
+            g_array_append_val(typos, m);
         }
     }
+    g_mutex_unlock(&store->lock);
+
+    g_array_sort(typos, typo_match_compare);
+    for (guint i = 0; i < typos->len; i++) {
+        ClipiumEntry *e = g_array_index(typos, TypoMatch, i).entry;
+        if (i < limit)
+            g_array_append_val(result, e);
+        else
+            clipium_entry_unref(e);
+    }
+}
 
-    /* Sort by score descending (insertion sort, fine for small N) */
-    for (guint i = 1; i < matches->len; i++) {
-        Match key = g_array_index(matches, Match, i);
-        int j = (int)i - 1;
-        while (j >= 0 && g_array_index(matches, Match, (guint)j).score < key.score) {
-            g_array_index(matches, Match, (guint)(j + 1)) = g_array_index(matches, Match, (guint)j);
-            j--;
+/* Append up to `limit` matches from the archive tier; TRUE if it had any */
+static gboolean
+store_search_archive(ClipiumStore *store, const char *query, guint limit, GArray *result)
+{
+    g_mutex_lock(&store->lock);
+    ClipiumArchiveSearch search = store->archive_search;
+    gpointer search_data = store->archive_data;
+    g_mutex_unlock(&store->lock);
+    if (!search || !*query)
+        return FALSE;
+
+    guint before = result->len;
+    search(query, limit, result, search_data);
+    return result->len > before;
+}
+
+/* Whether the indexed text of `e` really holds `query`: the trigram index
+ * only says it has all of the query's trigrams, in any order. Content that
+ * is not resident is read without caching it. */
+static gboolean
+store_text_contains(ClipiumStore *store, const ClipiumEntry *e, const char *query, gsize query_len)
+{
+    g_autoptr(GBytes) content = store_read_content(store, e);
+    if (!content)
+        return FALSE;
+    gsize len;
+    const char *data = g_bytes_get_data(content, &len);
+    return clipium_trigram_contains(data, MIN(len, CLIPIUM_INDEX_MAX_BYTES), query, query_len);
+}
+
+/* Confirm full-text hits whose preview did not match. `pending` holds
+ * them scored as if confirmed; they are taken best first, and once `top`
+ * is full the rest could not place, so their content is never read. Of
+ * those that could, at most CLIPIUM_SEARCH_CONFIRM_MAX whose content is
+ * not resident are read, until `deadline` (monotonic µs). Confirmed ones
+ * go into `top`, and their ids into `seen` if given. Returns FALSE if a
+ * hit that could have placed was left unconfirmed. */
+static gboolean
+store_confirm_hits(ClipiumStore *store,
+                   GArray       *pending,
+                   const char   *query,
+                   gsize         query_len,
+                   gint64        deadline,
+                   SearchTopK   *top,
+                   GHashTable   *seen)
+{
+    g_array_sort(pending, search_match_compare);
+    guint reads = 0;
+    for (guint i = 0; i < pending->len; i++) {
+        SearchMatch *m = &g_array_index(pending, SearchMatch, i);
+        if (!search_topk_admits(top, m))
+            return TRUE;
+        if (!m->entry->content) {
+            if (reads == CLIPIUM_SEARCH_CONFIRM_MAX || g_get_monotonic_time() >= deadline)
+                return FALSE;
+            reads++;
         }
-        g_array_index(matches, Match, (guint)(j + 1)) = key;
+        if (!store_text_contains(store, m->entry, query, query_len))
+            continue;
+        search_topk_push(top, m);
+        if (seen)
+            g_hash_table_add(seen, GSIZE_TO_POINTER((gsize)m->entry->id));
+    }
+    return TRUE;
+}
+
+/* Structured queries start from the most selective secondary index and
+ * check the remaining filters against each candidate entry. Relative
+ * times make these results age, so they are not cached. */
+static GArray *
+store_search_filtered(ClipiumStore       *store,
+                      const ClipiumQuery *query,
+                      guint               limit,
+                      gint64              now,
+                      ClipiumSearchStats *stats)
+{
+    g_autoptr(GArray) slots = g_array_new(FALSE, FALSE, sizeof(guint));
+    g_autoptr(GArray) frecency = g_array_new(FALSE, FALSE, sizeof(double));
+    g_autoptr(GArray) text_slots = g_array_new(FALSE, FALSE, sizeof(guint));
+    g_autoptr(GHashTable) text_hits = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_autoptr(GPtrArray) candidates =
+        g_ptr_array_new_with_free_func((GDestroyNotify)clipium_entry_unref);
+    gsize text_len = strlen(query->text);
+
+    g_mutex_lock(&store->lock);
+    guint n_pinned = query->pinned == 1 ? clipium_attr_index_count_pinned(store->attrs) : G_MAXUINT;
+    guint n_mime = query->mime ? clipium_attr_index_count_mime(store->attrs, query->mime) : G_MAXUINT;
+    guint best = MIN(n_pinned, n_mime);
+    guint n_since = query->since > 0
+                    ? clipium_attr_index_count_since(store->attrs, query->since, best)
+                    : G_MAXUINT;
+
+    if (n_since < best)
+        clipium_attr_index_since(store->attrs, query->since, slots);
+    else if (n_pinned <= n_mime && n_pinned != G_MAXUINT)
+        clipium_attr_index_pinned(store->attrs, slots);
+    else if (n_mime != G_MAXUINT)
+        clipium_attr_index_mime(store->attrs, query->mime, slots);
+    else {
+        /* Only pinned:no or size bounds, which no index narrows */
+        for (guint i = store->head; i != SLOT_NONE; i = SLOT(store, i)->next)
+            g_array_append_val(slots, i);
     }
 
-    GArray *result = g_array_new(FALSE, FALSE, sizeof(ClipiumEntry *));
-    guint count = 0;
-    for (guint i = 0; i < matches->len && count < limit; i++, count++) {
-        Match *m = &g_array_index(matches, Match, i);
-        g_array_append_val(result, m->entry);
+    for (guint i = 0; i < slots->len; i++) {
+        ClipiumSlot *slot = SLOT(store, g_array_index(slots, guint, i));
+        ClipiumEntry *e = slot->entry;
+        if (clipium_query_accepts(query, e->mime_type, e->pinned, e->timestamp, e->size)) {
+            g_ptr_array_add(candidates, clipium_entry_ref(e));
+            g_array_append_val(frecency, slot->frecency);
+        }
     }
 
-    g_array_free(matches, TRUE);
+    gboolean indexed = text_len > 0 &&
+                       clipium_trigram_index_query(store->text_index, query->text, text_slots);
+    for (guint i = 0; i < text_slots->len; i++)
+        g_hash_table_add(text_hits, SLOT(store, g_array_index(text_slots, guint, i))->entry);
     g_mutex_unlock(&store->lock);
+
+    g_autofree char *folded = clipium_fuzzy_needs_fold(query->text, text_len)
+                              ? clipium_fuzzy_fold(query->text, text_len, NULL) : NULL;
+    const char *key = folded ? folded : query->text;
+    guint64 query_mask = clipium_fuzzy_char_mask(key, strlen(key));
+    double origin = (double)now * FRECENCY_RATE;
+
+    /* With no text only frecency tells candidates apart. Hits further
+     * into the text are confirmed after the preview matches are in. */
+    SearchTopK top;
+    search_topk_init(&top, limit);
+    g_autoptr(GArray) pending = g_array_new(FALSE, FALSE, sizeof(SearchMatch));
+    for (guint i = 0; i < candidates->len; i++) {
+        ClipiumEntry *e = g_ptr_array_index(candidates, i);
+        int bonus = frecency_bonus(g_array_index(frecency, double, i), origin);
+        int score = 0;
+        if (text_len > 0) {
+            score = ((query_mask & ~e->char_mask) || !e->search_key)
+                    ? -1 : clipium_fuzzy_score(key, e->search_key, strlen(e->search_key), NULL);
+            if (score < 0) {
+                if (indexed && g_hash_table_contains(text_hits, e)) {
+                    SearchMatch m = { .entry = e, .score = clipium_fuzzy_run_score(text_len) + bonus };
+                    g_array_append_val(pending, m);
+                }
+                continue;
+            }
+        }
+        SearchMatch m = { .entry = e, .score = score + bonus };
+        search_topk_push(&top, &m);
+    }
+    stats->partial = !store_confirm_hits(store, pending, query->text, text_len, G_MAXINT64,
+                                         &top, NULL);
+
+    g_autoptr(GArray) matches = search_topk_finish(&top);
+    GArray *result = entry_result_array_new(matches->len);
+    for (guint i = 0; i < matches->len; i++) {
+        ClipiumEntry *e = clipium_entry_ref(g_array_index(matches, SearchMatch, i).entry);
+        g_array_append_val(result, e);
+    }
     return result;
 }
 
+/* --- Exact search --- */
+
+/* One slice of a literal or regex search over full content: the first
+ * `limit` matching text entries among its rows, in row order. It gives up
+ * at the deadline, so one huge entry cannot hold a search up for long. */
+typedef struct {
+    SearchTask             task;
+    ClipiumStore          *store;
+    const ClipiumSnapshot *snap;
+    const char            *pattern;
+    gsize                  pattern_len;
+    GRegex                *regex;     /* NULL for a literal */
+    gint64                 deadline;  /* monotonic µs */
+    guint                  start;
+    guint                  end;
+    guint                  limit;
+    GArray                *rows;      /* guint, ascending */
+    gboolean               timed_out;
+} GrepChunk;
+
+static void
+grep_chunk_run(SearchTask *task)
+{
+    GrepChunk *chunk = (GrepChunk *)task;
+    const ClipiumSnapshot *snap = chunk->snap;
+    for (guint i = chunk->start; i < chunk->end && chunk->rows->len < chunk->limit; i++) {
+        if (g_get_monotonic_time() > chunk->deadline) {
+            chunk->timed_out = TRUE;
+            break;
+        }
+        if (!g_str_has_prefix(g_quark_to_string(snap->mime_ids[i]), "text/") ||
+            (!chunk->regex && snap->sizes[i] < chunk->pattern_len))
+            continue;
+
+        /* Compressed and metadata-only entries are read around the content
+         * cache: a scan over everything would only flush it */
+        ClipiumEntry *e = g_ptr_array_index(snap->entries, i);
+        GBytes *content = store_read_content(chunk->store, e);
+        if (!content)
+            continue;
+        gsize len;
+        const char *data = g_bytes_get_data(content, &len);
+        gboolean found;
+        if (chunk->regex) {
+            /* The deadline is only checked between entries, so bound what
+             * one match may take: cap the text, cut at a character */
+            gsize cap = MIN(len, CLIPIUM_GREP_REGEX_MAX_BYTES);
+            while (cap > 0 && cap < len && ((guchar)data[cap] & 0xC0) == 0x80)
+                cap--;
+            found = clipium_regex_find(chunk->regex, data, cap);
+        } else {
+            found = clipium_grep_literal_find(data, len, chunk->pattern, chunk->pattern_len);
+        }
+        g_bytes_unref(content);
+        if (found)
+            g_array_append_val(chunk->rows, i);
+    }
+}
+
+/* Text entries whose content holds `pattern`, newest first, searched for
+ * at most `budget` µs (0 = no limit). Results that ran out of time are
+ * partial and are not cached. */
+static GArray *
+store_search_exact(ClipiumStore       *store,
+                   const char         *pattern,
+                   ClipiumSearchMode   mode,
+                   guint               limit,
+                   gint64              budget,
+                   ClipiumSearchStats *stats,
+                   GError            **error)
+{
+    g_autoptr(GRegex) regex = NULL;
+    if (mode == CLIPIUM_SEARCH_REGEX) {
+        regex = clipium_regex_cache_get(store->regex_cache, pattern, error);
+        if (!regex)
+            return NULL;
+    }
+
+    *stats = (ClipiumSearchStats){ 0 };
+    g_autoptr(ClipiumSnapshot) snap = clipium_store_snapshot(store);
+    g_autofree char *cache_key = g_strdup_printf("%u:%d:%s", limit, mode, pattern);
+    GArray *cached = search_cache_lookup(store, snap, cache_key);
+    if (cached)
+        return cached;
+
+    gint64 deadline = budget > 0 ? g_get_monotonic_time() + budget : G_MAXINT64;
+    guint n_chunks = MAX((snap->len + CLIPIUM_GREP_CHUNK - 1) / CLIPIUM_GREP_CHUNK, 1);
+    GrepChunk *chunks = g_new0(GrepChunk, n_chunks);
+    for (guint c = 0; c < n_chunks; c++) {
+        GrepChunk *chunk = &chunks[c];
+        chunk->task.run = grep_chunk_run;
+        chunk->store = store;
+        chunk->snap = snap;
+        chunk->pattern = pattern;
+        chunk->pattern_len = strlen(pattern);
+        chunk->regex = regex;
+        chunk->deadline = deadline;
+        chunk->start = c * CLIPIUM_GREP_CHUNK;
+        chunk->end = MIN(snap->len, (c + 1) * CLIPIUM_GREP_CHUNK);
+        chunk->limit = limit;
+        chunk->rows = g_array_new(FALSE, FALSE, sizeof(guint));
+    }
+    search_batch_run(store, chunks, sizeof(GrepChunk), n_chunks);
+
+    /* Chunks cover the snapshot in order, so the first `limit` rows over
+     * all of them are the newest matches */
+    GArray *result = entry_result_array_new(limit);
+    gboolean partial = FALSE;
+    for (guint c = 0; c < n_chunks; c++) {
+        GrepChunk *chunk = &chunks[c];
+        for (guint i = 0; i < chunk->rows->len && result->len < limit; i++) {
+            guint row = g_array_index(chunk->rows, guint, i);
+            ClipiumEntry *e = clipium_entry_ref(g_ptr_array_index(snap->entries, row));
+            g_array_append_val(result, e);
+        }
+        /* A chunk that timed out only matters if it was still needed */
+        if (chunk->timed_out && result->len < limit)
+            partial = TRUE;
+        g_array_unref(chunk->rows);
+    }
+    g_free(chunks);
+
+    stats->scanned = snap->len;
+    stats->partial = partial;
+    if (!partial)
+        search_cache_insert(store, snap, g_steal_pointer(&cache_key), result);
+    return result;
+}
+
+/* How a progressive search reports back, see
+ * clipium_store_search_progressive */
+typedef struct {
+    ClipiumSearchCallback  callback;
+    gpointer               user_data;
+    GCancellable          *cancellable;
+    gint64                 next_emit;  /* monotonic µs of the next interim result */
+    gint64                 deadline;   /* stop scanning here */
+} SearchProgress;
+
+/* Without `progress` this runs to the end. With it, the preview scan goes
+ * slice by slice, newest rows first, handing out the best matches so far
+ * between slices and stopping at the deadline; returns NULL if cancelled.
+ * stats->partial tells whether the result misses rows. */
+static GArray *
+store_search_fuzzy(ClipiumStore       *store,
+                   const char         *query,
+                   guint               limit,
+                   SearchProgress     *progress,
+                   ClipiumSearchStats *stats)
+{
+    *stats = (ClipiumSearchStats){ 0 };
+    gint64 now = g_get_real_time();
+    g_autoptr(ClipiumQuery) parsed = clipium_query_parse(query, now);
+    if (clipium_query_has_filters(parsed))
+        return store_search_filtered(store, parsed, limit, now, stats);
+
+    g_autoptr(ClipiumSnapshot) snap = clipium_store_snapshot(store);
+    g_autofree char *cache_key = g_strdup_printf("%u:%d:%s", limit, CLIPIUM_SEARCH_FUZZY, query);
+    GArray *cached = search_cache_lookup(store, snap, cache_key);
+    if (cached)
+        return cached;
+
+    g_autoptr(GPtrArray) candidates =
+        g_ptr_array_new_with_free_func((GDestroyNotify)clipium_entry_unref);
+    g_autoptr(GArray) frecency = g_array_new(FALSE, FALSE, sizeof(double));
+    g_autoptr(GHashTable) seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+    SearchTopK best;
+    search_topk_init(&best, limit);
+    gsize query_len = strlen(query);
+    double origin = (double)now * FRECENCY_RATE;
+
+    /* Previews are matched on their search keys, so fold the query the
+     * same way; the index holds the raw text and takes the raw query */
+    g_autofree char *folded = clipium_fuzzy_needs_fold(query, query_len)
+                              ? clipium_fuzzy_fold(query, query_len, NULL) : NULL;
+    const char *key = folded ? folded : query;
+    guint64 query_mask = clipium_fuzzy_char_mask(key, strlen(key));
+
+    /* Full-text hits from the index. A candidate whose preview does not
+     * match may be a match further into its text: once the preview
+     * matches are in, confirm the ones that could still place and score
+     * them as a contiguous run inside a word. */
+    gboolean indexed = store_index_candidates(store, query, candidates, frecency);
+    g_autoptr(GArray) pending = g_array_new(FALSE, FALSE, sizeof(SearchMatch));
+    for (guint i = 0; i < candidates->len; i++) {
+        ClipiumEntry *e = g_ptr_array_index(candidates, i);
+        int score = ((query_mask & ~e->char_mask) || !e->search_key)
+                    ? -1 : clipium_fuzzy_score(key, e->search_key, strlen(e->search_key), NULL);
+        SearchMatch m = { .entry = e,
+                          .score = (score < 0 ? clipium_fuzzy_run_score(query_len) : score) +
+                                   frecency_bonus(g_array_index(frecency, double, i), origin) };
+        if (score < 0) {
+            g_array_append_val(pending, m);
+            continue;
+        }
+        search_topk_push(&best, &m);
+        g_hash_table_add(seen, GSIZE_TO_POINTER((gsize)e->id));
+    }
+    gboolean confirmed = store_confirm_hits(store, pending, query, query_len,
+                                            progress ? progress->deadline : G_MAXINT64,
+                                            &best, seen);
+
+    /* Fuzzy-match previews over the arena when the index cannot answer the
+     * query or found fewer than asked for. One AND against each entry's
+     * character mask rejects most of them before the matcher runs. */
+    gboolean complete = TRUE;
+    if (!indexed || g_hash_table_size(seen) < limit) {
+        /* Refining the last query only re-scores what it matched */
+        g_autoptr(GArray) previous = search_state_rows(store, snap, key);
+        guint n_rows = previous ? previous->len : snap->len;
+        guint slice = progress ? MAX(store->search_slice, 1) : n_rows;
+        g_autoptr(GArray) rows = g_array_new(FALSE, FALSE, sizeof(guint));
+        g_autoptr(GArray) scanned = g_array_new(FALSE, FALSE, sizeof(SearchMatch));
+
+        guint done = 0;
+        while (done < n_rows) {
+            guint n = MIN(slice, n_rows - done);
+            store_scan_previews(store, snap, key, query_mask, origin, previous, done, n, limit,
+                                scanned, rows);
+            for (guint i = 0; i < scanned->len; i++) {
+                SearchMatch *m = &g_array_index(scanned, SearchMatch, i);
+                if (!g_hash_table_contains(seen, GSIZE_TO_POINTER((gsize)m->entry->id)))
+                    search_topk_push(&best, m);
+            }
+            g_array_set_size(scanned, 0);
+            done += n;
+            if (!progress || done == n_rows)
+                continue;
+
+            if (g_cancellable_is_cancelled(progress->cancellable)) {
+                g_array_unref(best.heap);
+                return NULL;
+            }
+            gint64 mono = g_get_monotonic_time();
+            if (mono >= progress->deadline)
+                break;
+            if (mono >= progress->next_emit) {
+                progress->callback(search_topk_peek(&best), CLIPIUM_SEARCH_INTERIM,
+                                   progress->user_data);
+                progress->next_emit = mono + store->search_refine_usec;
+            }
+        }
+
+        /* A scan cut short cannot seed narrowing: its rows are not all
+         * the matches */
+        stats->scanned = done;
+        complete = done == n_rows;
+        if (complete)
+            search_state_save(store, snap, key, rows);
+    }
+
+    g_autoptr(GArray) matches = search_topk_finish(&best);
+    GArray *result = entry_result_array_new(matches->len);
+    for (guint i = 0; i < matches->len; i++) {
+        ClipiumEntry *e = clipium_entry_ref(g_array_index(matches, SearchMatch, i).entry);
+        g_array_append_val(result, e);
+    }
+    stats->partial = !complete || !confirmed;
+    if (stats->partial)
+        return result;
+    if (result->len < limit)
+        store_search_typos(store, query, limit - result->len, result);
+
+    /* The archive changes without the store knowing, so results that
+     * reach into it are not cached */
+    if (result->len < limit && store_search_archive(store, query, limit - result->len, result))
+        return result;
+    search_cache_insert(store, snap, g_steal_pointer(&cache_key), result);
+    return result;
+}
+
+GArray *
+clipium_store_search_mode(ClipiumStore       *store,
+                          const char         *pattern,
+                          ClipiumSearchMode   mode,
+                          guint               limit,
+                          ClipiumSearchStats *stats,
+                          GError            **error)
+{
+    ClipiumSearchStats local;
+    if (!stats)
+        stats = &local;
+    if (mode == CLIPIUM_SEARCH_FUZZY)
+        return store_search_fuzzy(store, pattern, limit, NULL, stats);
+    return store_search_exact(store, pattern, mode, limit, store->grep_budget, stats, error);
+}
+
 gboolean
-clipium_store_delete(ClipiumStore *store, guint64 id)
+clipium_store_search_progressive(ClipiumStore         *store,
+                                 const char           *pattern,
+                                 ClipiumSearchMode     mode,
+                                 guint                 limit,
+                                 gint64                budget,
+                                 GCancellable         *cancellable,
+                                 ClipiumSearchCallback callback,
+                                 gpointer              user_data,
+                                 GError              **error)
+{
+    gint64 start = g_get_monotonic_time();
+    GArray *result;
+    ClipiumSearchStats stats;
+
+    if (mode == CLIPIUM_SEARCH_FUZZY) {
+        SearchProgress progress = {
+            .callback = callback,
+            .user_data = user_data,
+            .cancellable = cancellable,
+            .next_emit = start + store->search_first_usec,
+            .deadline = budget > 0 ? start + budget : G_MAXINT64,
+        };
+        result = store_search_fuzzy(store, pattern, limit, &progress, &stats);
+        if (!result)
+            return TRUE;
+    } else {
+        /* Content scans already stop at a deadline; the tighter one wins */
+        gint64 exact_budget = store->grep_budget;
+        if (budget > 0 && (exact_budget == 0 || budget < exact_budget))
+            exact_budget = budget;
+        result = store_search_exact(store, pattern, mode, limit, exact_budget, &stats, error);
+        if (!result)
+            return FALSE;
+    }
+
+    if (g_cancellable_is_cancelled(cancellable))
+        g_array_free(result, TRUE);
+    else
+        callback(result, stats.partial ? CLIPIUM_SEARCH_TIMED_OUT : CLIPIUM_SEARCH_COMPLETE, user_data);
+    return TRUE;
+}
+
+GArray *
+clipium_store_search(ClipiumStore *store, const char *query, guint limit)
+{
+    ClipiumSearchMode mode;
+    g_autofree char *pattern = clipium_search_mode_split(query, &mode);
+    GArray *result = clipium_store_search_mode(store, pattern, mode, limit, NULL, NULL);
+
+    /* A pattern that is still being typed may not compile yet */
+    return result ? result : entry_result_array_new(0);
+}
+
+/* The bytes of the first literal or regex match in the preview */
+static gboolean
+match_exact_positions(ClipiumStore      *store,
+                      const char        *pattern,
+                      ClipiumSearchMode  mode,
+                      const char        *preview,
+                      GArray            *positions)
+{
+    gint start, end;
+    if (mode == CLIPIUM_SEARCH_LITERAL) {
+        const char *hit = strstr(preview, pattern);
+        if (!hit)
+            return FALSE;
+        start = (gint)(hit - preview);
+        end = start + (gint)strlen(pattern);
+    } else {
+        g_autoptr(GRegex) regex = clipium_regex_cache_get(store->regex_cache, pattern, NULL);
+        g_autoptr(GMatchInfo) info = NULL;
+        if (!regex || !g_regex_match(regex, preview, G_REGEX_MATCH_DEFAULT, &info) ||
+            !g_match_info_fetch_pos(info, 0, &start, &end) || end <= start)
+            return FALSE;
+    }
+    for (guint i = (guint)start; i < (guint)end; i++)
+        g_array_append_val(positions, i);
+    return TRUE;
+}
+
+/* Align the query with the entry's search key and map the matched key
+ * bytes back to preview offsets */
+gboolean
+clipium_store_match_positions(ClipiumStore       *store,
+                              const char         *query,
+                              const ClipiumEntry *e,
+                              GArray             *positions)
+{
+    if (!e->preview)
+        return FALSE;
+
+    ClipiumSearchMode mode;
+    g_autofree char *pattern = clipium_search_mode_split(query, &mode);
+    if (mode != CLIPIUM_SEARCH_FUZZY)
+        return match_exact_positions(store, pattern, mode, e->preview, positions);
+
+    /* Only the free text is highlighted, not the filters */
+    g_autoptr(ClipiumQuery) parsed = clipium_query_parse(query, 0);
+    query = parsed->text;
+    if (!*query)
+        return FALSE;
+
+    gsize query_len = strlen(query);
+    g_autofree char *folded_query = clipium_fuzzy_needs_fold(query, query_len)
+                                    ? clipium_fuzzy_fold(query, query_len, NULL) : NULL;
+    const char *q = folded_query ? folded_query : query;
+
+    if (e->search_key == e->preview)
+        return clipium_fuzzy_score(q, e->preview, strlen(e->preview), positions) >= 0;
+
+    g_autoptr(GArray) offsets = g_array_new(FALSE, FALSE, sizeof(guint));
+    g_autofree char *key = clipium_fuzzy_fold(e->preview, strlen(e->preview), offsets);
+    g_autoptr(GArray) key_positions = g_array_new(FALSE, FALSE, sizeof(guint));
+    if (clipium_fuzzy_score(q, key, strlen(key), key_positions) < 0)
+        return FALSE;
+
+    /* Several key bytes can come from one character ("ß" keys as "ss") */
+    for (guint i = 0; i < key_positions->len; i++) {
+        guint offset = g_array_index(offsets, guint, g_array_index(key_positions, guint, i));
+        if (positions->len == 0 || g_array_index(positions, guint, positions->len - 1) != offset)
+            g_array_append_val(positions, offset);
+    }
+    return TRUE;
+}
+
+void
+clipium_store_set_typo_edits(ClipiumStore *store, guint max_edits)
 {
     g_mutex_lock(&store->lock);
-    gpointer idx_ptr;
-    if (g_hash_table_lookup_extended(store->by_id, GSIZE_TO_POINTER((gsize)id), NULL, &idx_ptr)) {
-        guint idx = GPOINTER_TO_UINT(idx_ptr);
-        g_array_remove_index(store->entries, idx);
-        store_rebuild_indices(store);
-        g_mutex_unlock(&store->lock);
-        return TRUE;
+    store->typo_edits = MIN(max_edits, 2);
+    store_changed(store);  /* cached results were found without it */
+    g_mutex_unlock(&store->lock);
+}
+
+void
+clipium_store_set_archive(ClipiumStore         *store,
+                          ClipiumArchiveSearch  search,
+                          gpointer              user_data)
+{
+    g_mutex_lock(&store->lock);
+    store->archive_search = search;
+    store->archive_data = user_data;
+    store_changed(store);  /* cached results were found without it */
+    g_mutex_unlock(&store->lock);
+}
+
+void
+clipium_store_set_journal(ClipiumStore *store, gboolean enabled)
+{
+    g_mutex_lock(&store->lock);
+    if (!enabled)
+        g_clear_pointer(&store->journal, g_array_unref);
+    else if (!store->journal)
+        store->journal = journal_new();
+    g_mutex_unlock(&store->lock);
+}
+
+GArray *
+clipium_store_take_changes(ClipiumStore *store)
+{
+    GArray *changes = journal_new();
+    g_mutex_lock(&store->lock);
+    if (store->journal && store->journal->len > 0) {
+        GArray *taken = store->journal;
+        store->journal = changes;
+        changes = taken;
     }
     g_mutex_unlock(&store->lock);
-    return FALSE;
+    return changes;
+}
+
+void
+clipium_store_reserve_ids(ClipiumStore *store, guint64 max_id)
+{
+    g_mutex_lock(&store->lock);
+    if (max_id >= store->next_id)
+        store->next_id = max_id + 1;
+    g_mutex_unlock(&store->lock);
+}
+
+gboolean
+clipium_store_index_content(ClipiumStore *store, guint64 id, GBytes *content)
+{
+    g_return_val_if_fail(store && content, FALSE);
+
+    /* Extract before locking; only text entries take the result */
+    gsize len;
+    const char *data = g_bytes_get_data(content, &len);
+    g_autoptr(GArray) trigrams = clipium_trigrams_extract(data, MIN(len, CLIPIUM_INDEX_MAX_BYTES));
+    g_autoptr(GPtrArray) words = clipium_typo_words_extract(data, MIN(len, CLIPIUM_INDEX_MAX_BYTES));
+
+    g_mutex_lock(&store->lock);
+    guint idx;
+    gboolean found = store_lookup_id(store, id, &idx) &&
+                     g_str_has_prefix(SLOT(store, idx)->entry->mime_type, "text/");
+    if (found) {
+        clipium_trigram_index_insert(store->text_index, idx, g_steal_pointer(&trigrams));
+        clipium_typo_index_insert(store->typo_index, idx, g_steal_pointer(&words));
+        store_changed(store);  /* search results may differ now */
+    }
+    g_mutex_unlock(&store->lock);
+    return found;
+}
+
+gboolean
+clipium_store_delete(ClipiumStore *store, guint64 id)
+{
+    g_mutex_lock(&store->lock);
+    guint idx;
+    gboolean found = store_lookup_id(store, id, &idx);
+    if (found)
+        store_remove_slot(store, idx, FALSE);
+    g_mutex_unlock(&store->lock);
+    return found;
 }
 
 void
 clipium_store_clear(ClipiumStore *store)
 {
     g_mutex_lock(&store->lock);
-    g_array_set_size(store->entries, 0);
     g_hash_table_remove_all(store->by_hash);
     g_hash_table_remove_all(store->by_id);
+    g_tree_remove_all(store->by_frecency);
+    g_array_set_size(store->slots, 0);
+    clipium_evict_policy_clear(store->policy);
+    clipium_wheel_clear(store->expiry);
+    clipium_trigram_index_clear(store->text_index);
+    clipium_typo_index_clear(store->typo_index);
+    clipium_attr_index_clear(store->attrs);
+    content_cache_drop_all(store);
+    if (store->journal) {
+        /* Whatever was pending concerned entries that are gone now */
+        g_array_set_size(store->journal, 0);
+        ClipiumStoreChange change = { .kind = CLIPIUM_CHANGE_CLEARED };
+        g_array_append_val(store->journal, change);
+    }
+    store_reset_lists(store);
+    store_changed(store);
     g_mutex_unlock(&store->lock);
 }
 
@@ -334,23 +2345,321 @@ gboolean
 clipium_store_pin(ClipiumStore *store, guint64 id, gboolean pinned)
 {
     g_mutex_lock(&store->lock);
-    gpointer idx_ptr;
-    if (g_hash_table_lookup_extended(store->by_id, GSIZE_TO_POINTER((gsize)id), NULL, &idx_ptr)) {
-        guint idx = GPOINTER_TO_UINT(idx_ptr);
-        ClipiumEntry *e = &g_array_index(store->entries, ClipiumEntry, idx);
-        e->pinned = pinned;
+    guint idx;
+    if (!store_lookup_id(store, id, &idx)) {
         g_mutex_unlock(&store->lock);
-        return TRUE;
+        return FALSE;
     }
+
+    ClipiumSlot *slot = SLOT(store, idx);
+    if (pinned && !slot->entry->pinned) {
+        clipium_evict_policy_remove(store->policy, idx, &slot->entry->hash, FALSE);
+    } else if (!pinned && slot->entry->pinned) {
+        /* Re-enter the policy with the statistics gathered while pinned */
+        clipium_evict_policy_insert(store->policy, idx, &slot->entry->hash,
+                                    slot->last_used, slot->hits);
+    }
+
+    if (slot->entry->pinned != pinned) {
+        ClipiumEntry *copy = clipium_entry_copy(slot->entry);
+        copy->pinned = pinned;
+        slot_replace_entry(store, idx, copy);
+        store_schedule_expiry(store, idx);
+        store_journal(store, CLIPIUM_CHANGE_PINNED, idx);
+        store_changed(store);
+    }
+
     g_mutex_unlock(&store->lock);
-    return FALSE;
+    return TRUE;
 }
 
 guint
 clipium_store_count(ClipiumStore *store)
 {
     g_mutex_lock(&store->lock);
-    guint count = store->entries->len;
+    guint count = store->count;
     g_mutex_unlock(&store->lock);
     return count;
 }
+
+gsize
+clipium_store_bytes(ClipiumStore *store)
+{
+    g_mutex_lock(&store->lock);
+    gsize bytes = store->total_bytes;
+    g_mutex_unlock(&store->lock);
+    return bytes;
+}
+
+gsize
+clipium_store_index_bytes(ClipiumStore *store)
+{
+    g_mutex_lock(&store->lock);
+    gsize bytes = clipium_trigram_index_bytes(store->text_index) +
+                  clipium_typo_index_bytes(store->typo_index);
+    g_mutex_unlock(&store->lock);
+    return bytes;
+}
+
+void
+clipium_store_set_max_bytes(ClipiumStore *store, gsize max_bytes)
+{
+    g_mutex_lock(&store->lock);
+    store->max_bytes = max_bytes;
+    g_mutex_unlock(&store->lock);
+}
+
+gsize
+clipium_store_get_max_bytes(ClipiumStore *store)
+{
+    g_mutex_lock(&store->lock);
+    gsize max_bytes = store->max_bytes;
+    g_mutex_unlock(&store->lock);
+    return max_bytes;
+}
+
+void
+clipium_store_set_evict_policy(ClipiumStore *store, ClipiumEvictKind kind)
+{
+    g_mutex_lock(&store->lock);
+    clipium_evict_policy_free(store->policy);
+    store->policy = clipium_evict_policy_new(kind, store->max_entries);
+
+    /* Oldest first, so recency-ordered policies mostly push to the front */
+    for (guint i = store->tail; i != SLOT_NONE; i = SLOT(store, i)->prev) {
+        ClipiumSlot *slot = SLOT(store, i);
+        if (!slot->entry->pinned)
+            clipium_evict_policy_insert(store->policy, i, &slot->entry->hash,
+                                        slot->last_used, slot->hits);
+    }
+    g_mutex_unlock(&store->lock);
+}
+
+ClipiumEvictKind
+clipium_store_get_evict_policy(ClipiumStore *store)
+{
+    g_mutex_lock(&store->lock);
+    ClipiumEvictKind kind = clipium_evict_policy_kind(store->policy);
+    g_mutex_unlock(&store->lock);
+    return kind;
+}
+
+gboolean
+clipium_store_set_ttl_rules(ClipiumStore *store, const char *spec)
+{
+    g_return_val_if_fail(store && spec, FALSE);
+
+    GPtrArray *rules = ttl_rules_parse(spec);
+    if (!rules)
+        return FALSE;
+
+    g_mutex_lock(&store->lock);
+    g_ptr_array_unref(store->ttl_rules);
+    store->ttl_rules = rules;
+    for (guint i = store->head; i != SLOT_NONE; i = SLOT(store, i)->next)
+        store_schedule_expiry(store, i);
+    g_mutex_unlock(&store->lock);
+    return TRUE;
+}
+
+guint
+clipium_store_expire(ClipiumStore *store, gint64 now)
+{
+    g_autoptr(GArray) fired = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    g_mutex_lock(&store->lock);
+    clipium_wheel_advance(store->expiry, now, fired);
+    for (guint i = 0; i < fired->len; i++)
+        store_remove_slot(store, g_array_index(fired, guint, i), FALSE);
+    g_mutex_unlock(&store->lock);
+
+    return fired->len;
+}
+
+gboolean
+clipium_store_touch(ClipiumStore *store, guint64 id)
+{
+    gint64 now = g_get_real_time();
+
+    g_mutex_lock(&store->lock);
+    guint idx;
+    gboolean found = store_lookup_id(store, id, &idx);
+    if (found) {
+        /* The entry and the order are unchanged, so this leaves the
+         * generation alone: only the frecency row of the published
+         * snapshot is rewritten, and cached results keep their old ranking
+         * until the next real change */
+        slot_record_use(store, idx, now);
+        if (!SLOT(store, idx)->entry->pinned)
+            clipium_evict_policy_touch(store->policy, idx, now, FALSE);
+        store_journal(store, CLIPIUM_CHANGE_USED, idx);
+        store->uses++;
+
+        g_mutex_lock(&store->snapshot_lock);
+        ClipiumSnapshot *snap = store->snapshot;
+        if (snap && snap->generation == g_atomic_int_get(&store->generation))
+            snapshot_set_frecency(snap, SLOT(store, idx)->snapshot_row, SLOT(store, idx)->frecency);
+        g_mutex_unlock(&store->snapshot_lock);
+    }
+    g_mutex_unlock(&store->lock);
+    return found;
+}
+
+gboolean
+clipium_store_get_usage(ClipiumStore *store, guint64 id, ClipiumUsage *usage)
+{
+    g_mutex_lock(&store->lock);
+    guint idx;
+    gboolean found = store_lookup_id(store, id, &idx);
+    if (found && usage) {
+        const ClipiumSlot *slot = SLOT(store, idx);
+        usage->hits = slot->hits;
+        usage->last_used = slot->last_used;
+        usage->frecency = slot->frecency;
+    }
+    g_mutex_unlock(&store->lock);
+    return found;
+}
+
+void
+clipium_store_set_content_loader(ClipiumStore         *store,
+                                 ClipiumContentLoader  loader,
+                                 gpointer              user_data)
+{
+    g_mutex_lock(&store->content_lock);
+    store->content_loader = loader;
+    store->content_loader_data = user_data;
+    g_mutex_unlock(&store->content_lock);
+}
+
+void
+clipium_store_set_content_cache_size(ClipiumStore *store, gsize max_bytes)
+{
+    g_mutex_lock(&store->content_lock);
+    store->content_cache_max = max_bytes;
+    content_cache_trim(store);
+    g_mutex_unlock(&store->content_lock);
+}
+
+GBytes *
+clipium_store_get_content(ClipiumStore *store, const ClipiumEntry *entry)
+{
+    g_return_val_if_fail(store && entry, NULL);
+
+    if (entry->content)
+        return g_bytes_ref(entry->content);
+
+    gpointer key = GSIZE_TO_POINTER((gsize)entry->id);
+    g_mutex_lock(&store->content_lock);
+    GList *link = g_hash_table_lookup(store->content_cache, key);
+    if (link) {
+        g_queue_unlink(&store->content_lru, link);
+        g_queue_push_head_link(&store->content_lru, link);
+        store->content_hits++;
+        GBytes *content = g_bytes_ref(((CachedContent *)link->data)->content);
+        g_mutex_unlock(&store->content_lock);
+        return content;
+    }
+    store->content_misses++;
+    g_mutex_unlock(&store->content_lock);
+
+    GBytes *content = content_fetch(store, entry);
+    if (!content)
+        return NULL;
+
+    /* Only cache content for entries that are still in the store, or a
+     * concurrent delete would leave it behind */
+    g_mutex_lock(&store->lock);
+    g_mutex_lock(&store->content_lock);
+    gsize len = g_bytes_get_size(content);
+    if (g_hash_table_contains(store->by_id, key) &&
+        !g_hash_table_contains(store->content_cache, key) &&
+        len <= store->content_cache_max) {
+        CachedContent *cc = g_new(CachedContent, 1);
+        cc->id = entry->id;
+        cc->content = g_bytes_ref(content);
+        g_queue_push_head(&store->content_lru, cc);
+        g_hash_table_insert(store->content_cache, key, store->content_lru.head);
+        store->content_cache_bytes += len;
+        content_cache_trim(store);
+    }
+    g_mutex_unlock(&store->content_lock);
+    g_mutex_unlock(&store->lock);
+
+    return content;
+}
+
+void
+clipium_store_content_stats(ClipiumStore *store, ClipiumContentStats *stats)
+{
+    g_mutex_lock(&store->lock);
+    stats->compressed_entries = store->compressed_count;
+    stats->compressed_saved = store->compressed_saved;
+    stats->compress_usec = store->compress_usec;
+
+    g_mutex_lock(&store->content_lock);
+    stats->cache_bytes = store->content_cache_bytes;
+    stats->cache_hits = store->content_hits;
+    stats->cache_misses = store->content_misses;
+    stats->decompressions = store->decompressions;
+    stats->decompress_usec = store->decompress_usec;
+    g_mutex_unlock(&store->content_lock);
+    g_mutex_unlock(&store->lock);
+}
+
+guint
+clipium_store_compress_cold(ClipiumStore *store, gsize min_size, gint64 idle_usec)
+{
+    gint64 now = g_get_real_time();
+    g_autoptr(GPtrArray) candidates =
+        g_ptr_array_new_with_free_func((GDestroyNotify)clipium_entry_unref);
+
+    g_mutex_lock(&store->lock);
+    for (guint i = store->head; i != SLOT_NONE; i = SLOT(store, i)->next) {
+        ClipiumSlot *slot = SLOT(store, i);
+        ClipiumEntry *e = slot->entry;
+        if (e->content && e->size >= min_size && !slot->incompressible &&
+            now - slot->last_used >= idle_usec && mime_is_compressible(e->mime_type))
+            g_ptr_array_add(candidates, clipium_entry_ref(e));
+    }
+    g_mutex_unlock(&store->lock);
+
+    guint compressed = 0;
+    for (guint i = 0; i < candidates->len; i++) {
+        ClipiumEntry *e = g_ptr_array_index(candidates, i);
+
+        gint64 start = g_get_monotonic_time();
+        GConverter *zc = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, -1));
+        g_autoptr(GBytes) z = zlib_convert(zc, e->content, e->size / 4);
+        g_object_unref(zc);
+        gint64 elapsed = g_get_monotonic_time() - start;
+
+        g_mutex_lock(&store->lock);
+        store->compress_usec += elapsed;
+
+        /* Install only if the slot still holds the entry we compressed: a
+         * bump, pin or delete in the meantime wins */
+        guint idx;
+        if (store_lookup_id(store, e->id, &idx) && SLOT(store, idx)->entry == e) {
+            gsize zlen = z ? g_bytes_get_size(z) : e->size;
+            if (zlen <= e->size - e->size / 4) {
+                ClipiumEntry *copy = clipium_entry_copy(e);
+                g_clear_pointer(&copy->content, g_bytes_unref);
+                copy->compressed = g_steal_pointer(&z);
+                slot_replace_entry(store, idx, copy);
+
+                store->total_bytes -= e->size - zlen;
+                store->compressed_count++;
+                store->compressed_saved += e->size - zlen;
+                store_changed(store);
+                compressed++;
+            } else {
+                /* Saves less than a quarter: not worth the decompression */
+                SLOT(store, idx)->incompressible = TRUE;
+            }
+        }
+        g_mutex_unlock(&store->lock);
+    }
+
+    return compressed;
+}
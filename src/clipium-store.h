@@ -2,27 +2,219 @@
 
 #include <glib.h>
 #include <gio/gio.h>
+#include "clipium-evict.h"
+#include "clipium-hash.h"
+#include "clipium-wheel.h"
+#include "clipium-trigram.h"
+#include "clipium-typo.h"
+#include "clipium-grep.h"
+#include "clipium-attrs.h"
 
 G_BEGIN_DECLS
 
+/* Entries are refcounted and immutable once they are in the store: pinning
+ * or bumping installs a modified copy, so a reader holding a reference never
+ * sees a field change or the memory go away under it. `content` is NULL for
+ * metadata-only and compressed entries; use clipium_store_get_content to
+ * read it. */
 typedef struct {
-    guint64    id;
-    GBytes    *content;
-    char      *mime_type;
-    char      *preview;
-    char      *hash;
-    gint64     timestamp;
-    gboolean   pinned;
-    gsize      size;
+    guint64          id;
+    GBytes          *content;    /* NULL when not resident */
+    GBytes          *compressed; /* zlib stream of a cold entry, or NULL */
+    const char      *mime_type;  /* interned (g_intern_string) */
+    char            *preview;
+    const char      *search_key; /* clipium_fuzzy_fold of the preview; may be `preview` */
+    guint64          char_mask;  /* clipium_fuzzy_char_mask of the search key */
+    ClipiumHash      hash;
+    gint64           timestamp;
+    gboolean         pinned;
+    gsize            size;
+    gatomicrefcount  ref_count;
 } ClipiumEntry;
 
+/* Immutable, refcounted view of the store ordering. Readers take one with
+ * clipium_store_snapshot() and walk it without holding store->lock; the
+ * store publishes a new one (RCU-style) the first time it is read after a
+ * change. A use is not a change: it only rewrites the frecency column.
+ *
+ * The fields scans look at are also laid out as parallel arrays indexed
+ * like `entries`, with every search key packed into one arena, so a search
+ * walks linear memory instead of dereferencing each entry. */
 typedef struct {
-    GArray     *entries;    /* ClipiumEntry[], newest-first */
-    GHashTable *by_hash;   /* char* hash → guint index */
-    GHashTable *by_id;     /* guint64 id → guint index */
+    gatomicrefcount  ref_count;
+    gint             generation;
+    guint            len;
+    GPtrArray       *entries;         /* ClipiumEntry* refs, newest-first */
+    gint64          *timestamps;
+    gsize           *sizes;
+    guint32         *key_offsets;     /* into key_arena, NUL-terminated */
+    GQuark          *mime_ids;        /* g_quark_to_string gives the mime type */
+    guint64         *char_masks;      /* search prefilter, see ClipiumEntry */
+    guint8          *pinned;
+    gint            *frecency;        /* ClipiumUsage.frecency as float bits,
+                                       * rewritten in place on use */
+    char            *key_arena;
+    gsize            key_arena_len;
+} ClipiumSnapshot;
+
+static inline const char *
+clipium_snapshot_key(const ClipiumSnapshot *snapshot, guint i)
+{
+    return snapshot->key_arena + snapshot->key_offsets[i];
+}
+
+/* Keys are packed back to back, so the length falls out of the offsets */
+static inline gsize
+clipium_snapshot_key_len(const ClipiumSnapshot *snapshot, guint i)
+{
+    gsize next = i + 1 < snapshot->len ? snapshot->key_offsets[i + 1]
+                                       : snapshot->key_arena_len;
+    return next - snapshot->key_offsets[i] - 1;
+}
+
+typedef struct _ClipiumSearchState ClipiumSearchState;
+
+/* Fetches the content of a metadata-only entry, e.g. from the database.
+ * Called without any store lock held; returns a new reference or NULL. */
+typedef GBytes *(*ClipiumContentLoader)(guint64 id, gpointer user_data);
+
+/* Searches the archive evicted entries went to, e.g. the database's.
+ * Appends up to `limit` matches of `query` to `results` as ClipiumEntry*
+ * references, best first; they are metadata-only and read their content
+ * through the content loader. Called without any store lock held. */
+typedef void (*ClipiumArchiveSearch)(const char *query,
+                                     guint       limit,
+                                     GArray     *results,
+                                     gpointer    user_data);
+
+typedef struct {
+    gsize    cache_bytes;        /* content cache (lazy and decompressed) */
+    guint64  cache_hits;
+    guint64  cache_misses;
+    guint    compressed_entries;
+    gsize    compressed_saved;   /* raw minus compressed bytes */
+    gint64   compress_usec;
+    guint64  decompressions;
+    gint64   decompress_usec;
+} ClipiumContentStats;
+
+/* Access statistics of an entry. Frecency is Σ 2^(-(now - t) / half-life)
+ * over every copy, paste and fetch t; it is kept as the log of
+ * Σ 2^(t / half-life), which never needs decaying and orders entries the
+ * same way at any `now` (see clipium_frecency_add). 0 = nothing recorded. */
+typedef struct {
+    guint   hits;       /* copies, pastes and fetches */
+    gint64  last_used;  /* time of the last of those */
+    double  frecency;
+} ClipiumUsage;
+
+/* A change to the store, as recorded for whoever mirrors it, e.g. the
+ * database (see clipium_store_set_journal). The fields are those of the
+ * entry right after the change. */
+typedef enum {
+    CLIPIUM_CHANGE_ADDED,    /* a new entry */
+    CLIPIUM_CHANGE_BUMPED,   /* copied again: new timestamp, one more use */
+    CLIPIUM_CHANGE_USED,     /* pasted or fetched */
+    CLIPIUM_CHANGE_PINNED,   /* pinned or unpinned */
+    CLIPIUM_CHANGE_EVICTED,  /* dropped to stay within the caps */
+    CLIPIUM_CHANGE_REMOVED,  /* deleted or expired */
+    CLIPIUM_CHANGE_CLEARED,  /* every entry removed; `id` is 0 */
+} ClipiumChangeKind;
+
+typedef struct {
+    ClipiumChangeKind  kind;
+    guint64            id;
+    ClipiumEntry      *entry;      /* ADDED: a reference to the entry */
+    gint64             timestamp;
+    gboolean           pinned;
+    ClipiumUsage       usage;
+} ClipiumStoreChange;
+
+void           clipium_store_change_clear (ClipiumStoreChange *change);
+
+/* Add a use at `time` (µs) to a frecency */
+double         clipium_frecency_add       (double frecency, gint64 time);
+
+/* The decayed sum a frecency stands for at `now` */
+double         clipium_frecency_value     (double frecency, gint64 now);
+
+/* Entries live in stable slots; recency is an intrusive doubly-linked list
+ * threaded through the slots, so add/bump/delete/evict never shift memory
+ * and the indexes are updated in place. The eviction policy orders the
+ * unpinned slots by their access statistics. */
+typedef struct {
+    GArray     *slots;      /* ClipiumSlot[], stable indices, freed slots reused */
+    GHashTable *by_hash;    /* ClipiumHash* (in the entry) → guint slot */
+    GHashTable *by_id;      /* guint64 id → guint slot */
+    guint       head;       /* newest entry */
+    guint       tail;       /* oldest entry */
+    ClipiumEvictPolicy *policy; /* orders unpinned slots for eviction */
+    guint       free_head;  /* chain of unused slots */
+    guint       count;
+    guint       bulk_base;  /* first slot of an in-progress bulk load */
     guint64     next_id;
     guint       max_entries;
+    gsize       total_bytes; /* resident content, compressed size if compressed */
+    gsize       max_bytes;   /* content budget, 0 = unlimited */
     GMutex      lock;
+
+    guint       compressed_count; /* entries currently compressed */
+    gsize       compressed_saved; /* bytes those save over their raw size */
+    gint64      compress_usec;    /* total time spent compressing */
+
+    ClipiumTrigramIndex *text_index; /* full text of text entries, by slot */
+    ClipiumTypoIndex    *typo_index; /* words of text entries, by slot */
+    guint                typo_edits; /* per query word; 0 = exact search only */
+    ClipiumAttrIndex    *attrs;      /* mime type, pinned and timestamp, by slot */
+    GTree               *by_frecency; /* slots, most frecent first */
+
+    GPtrArray    *ttl_rules;  /* TtlRule*, first match wins */
+    ClipiumWheel *expiry;     /* slots with a TTL, by deadline */
+
+    gint             generation;     /* bumped on every change, atomic */
+    guint            uses;           /* bumped by clipium_store_touch, which
+                                      * leaves the generation alone */
+    ClipiumSnapshot *snapshot;       /* last published snapshot */
+    GMutex           snapshot_lock;  /* guards only the snapshot pointer swap */
+
+    /* Preview matches of the last full scan, so a refined query only
+     * re-scores those; see clipium_store_search */
+    ClipiumSearchState *last_search;
+    GMutex              search_lock;    /* guards the search state, cache and pool */
+    GThreadPool        *search_pool;    /* scores chunks of large scans */
+    guint               search_parallel_min; /* rows before a scan is split */
+    guint               search_slice;   /* rows a progressive scan takes at a time */
+    gint64              search_first_usec;  /* progressive: first interim result after */
+    gint64              search_refine_usec; /* and then the next ones every */
+    gint64              grep_budget;    /* µs a literal or regex search may take, 0 = no limit */
+    ClipiumRegexCache  *regex_cache;    /* patterns of regex searches */
+
+    /* Archive tier, see clipium_store_set_archive; guarded by lock */
+    ClipiumArchiveSearch archive_search;
+    gpointer             archive_data;
+
+    /* ClipiumStoreChange not yet taken, or NULL when not journaling;
+     * guarded by lock */
+    GArray              *journal;
+
+    /* LRU of recent results by limit and query, for one generation */
+    GHashTable         *search_cache;   /* "limit:query" → GList* in search_lru */
+    GQueue              search_lru;     /* CachedSearch*, most recent first */
+    gint                search_cache_generation;
+    guint64             search_cache_hits;
+
+    /* Bounded LRU of content loaded for metadata-only entries */
+    ClipiumContentLoader content_loader;
+    gpointer             content_loader_data;
+    GHashTable          *content_cache;       /* guint64 id → GList* in content_lru */
+    GQueue               content_lru;         /* CachedContent*, most recent first */
+    gsize                content_cache_bytes;
+    gsize                content_cache_max;
+    guint64              content_hits;
+    guint64              content_misses;
+    guint64              decompressions;
+    gint64               decompress_usec;
+    GMutex               content_lock;        /* guards the cache; nests inside lock */
 } ClipiumStore;
 
 ClipiumStore  *clipium_store_new          (guint max_entries);
@@ -33,27 +225,241 @@ guint64        clipium_store_add          (ClipiumStore *store,
                                            GBytes       *content,
                                            const char   *mime_type);
 
-/* Load an entry from DB (with pre-computed fields) */
-void           clipium_store_load_entry   (ClipiumStore *store,
-                                           guint64       id,
-                                           GBytes       *content,
-                                           const char   *mime_type,
-                                           const char   *hash,
-                                           const char   *preview,
-                                           gint64        timestamp,
-                                           gboolean      pinned,
-                                           gsize         size);
+/* Same, with the content hash already computed (e.g. while decoding) */
+guint64        clipium_store_add_hashed   (ClipiumStore      *store,
+                                           GBytes            *content,
+                                           const char        *mime_type,
+                                           const ClipiumHash *hash);
+
+/* Load an entry from DB (with pre-computed fields); content may be NULL */
+void           clipium_store_load_entry   (ClipiumStore      *store,
+                                           guint64            id,
+                                           GBytes            *content,
+                                           const char        *mime_type,
+                                           const ClipiumHash *hash,
+                                           const char        *preview,
+                                           gint64             timestamp,
+                                           gboolean           pinned,
+                                           gsize              size);
 
+/* Bulk load: begin takes the lock and reserves room for size_hint rows,
+ * append links rows oldest-last without touching the indexes, and end
+ * builds by_hash/by_id once and releases the lock. Rows must arrive
+ * newest-first, as clipium_db_load_all produces them. `usage` may be NULL
+ * for rows that were never used, and a zero frecency is derived from the
+ * timestamp. */
+void           clipium_store_bulk_begin   (ClipiumStore *store, guint size_hint);
+void           clipium_store_bulk_append  (ClipiumStore       *store,
+                                           guint64             id,
+                                           GBytes             *content,
+                                           const char         *mime_type,
+                                           const ClipiumHash  *hash,
+                                           const char         *preview,
+                                           gint64              timestamp,
+                                           gboolean            pinned,
+                                           gsize               size,
+                                           const ClipiumUsage *usage);
+void           clipium_store_bulk_end     (ClipiumStore *store);
+
+/* Returns a new reference (release with clipium_entry_unref), or NULL */
 ClipiumEntry  *clipium_store_get          (ClipiumStore *store, guint64 id);
+
+/* Both return a GArray of ClipiumEntry* references; g_array_free drops them.
+ * Search finds queries of three or more bytes anywhere in the full text of
+ * text entries through the trigram index, and fuzzy-matches previews
+ * when the index finds fewer than `limit`. Index hits that only the
+ * content can confirm are read best first, only while they could still
+ * place, and at most CLIPIUM_SEARCH_CONFIRM_MAX of them from outside
+ * memory; a search that wanted more is partial. Typing further into a query
+ * only re-scores the previews the last one matched, until the store
+ * changes, and repeating a recent search returns its cached result.
+ * Structured filters in the query (see ClipiumQuery) are answered from
+ * the secondary indexes in `attrs`. Matches gain a bonus that grows with
+ * their frecency (CLIPIUM_FRECENCY_WEIGHT). With typo tolerance on, text
+ * entries whose words are within a few edits of the query's come after all
+ * of those, fewest edits first; matches from the archive tier (see
+ * clipium_store_set_archive) come last. A query in the literal or regex
+ * syntax of clipium_search_mode_split is searched as with
+ * clipium_store_search_mode, and finds nothing while it does not compile. */
 GArray        *clipium_store_list         (ClipiumStore *store, guint limit, guint offset);
 GArray        *clipium_store_search       (ClipiumStore *store, const char *query, guint limit);
+
+/* What one search did */
+typedef struct {
+    guint    scanned;  /* previews scored, or entries a content scan covered;
+                        * 0 when the result came from the cache */
+    gboolean partial;  /* it ran out of time before searching every entry */
+} ClipiumSearchStats;
+
+/* Search `pattern` in the given mode. The literal and regex modes scan the
+ * full content of text entries, newest first, in parallel chunks that stop
+ * after `grep_budget`; stats->partial then tells that entries were left
+ * unsearched. A regex only sees the first CLIPIUM_GREP_REGEX_MAX_BYTES of
+ * each entry. Content that is not resident is read without going through
+ * the content cache. `stats` may be NULL. Returns NULL with `error` set if
+ * a regex does not compile. */
+GArray        *clipium_store_search_mode  (ClipiumStore       *store,
+                                           const char         *pattern,
+                                           ClipiumSearchMode   mode,
+                                           guint               limit,
+                                           ClipiumSearchStats *stats,
+                                           GError            **error);
+
+/* Where a progressive search stands when it reports a result */
+typedef enum {
+    CLIPIUM_SEARCH_INTERIM,    /* the best so far; more is coming */
+    CLIPIUM_SEARCH_TIMED_OUT,  /* final, but the budget ran out first */
+    CLIPIUM_SEARCH_COMPLETE,   /* final, every entry was searched */
+} ClipiumSearchStage;
+
+/* Receives a result of clipium_store_search_progressive (ClipiumEntry*
+ * references, best first), which it then owns */
+typedef void (*ClipiumSearchCallback)(GArray             *results,
+                                      ClipiumSearchStage  stage,
+                                      gpointer            user_data);
+
+/* Search `pattern` as clipium_store_search_mode does, reporting as it
+ * goes: the preview scan takes the newest entries first, hands the best
+ * matches so far to `callback` after search_first_usec and then every
+ * search_refine_usec, and stops once `budget` µs (0 = no limit) have
+ * passed. The final call has the result to keep; a result cut short by the
+ * budget is not cached. Literal and regex searches only make the final
+ * call. Runs `callback` on the calling thread and returns after the final
+ * call, or without making it once `cancellable` is cancelled. Returns
+ * FALSE with `error` set, and no call, if a regex does not compile. */
+gboolean       clipium_store_search_progressive(ClipiumStore         *store,
+                                                const char           *pattern,
+                                                ClipiumSearchMode     mode,
+                                                guint                 limit,
+                                                gint64                budget,
+                                                GCancellable         *cancellable,
+                                                ClipiumSearchCallback callback,
+                                                gpointer              user_data,
+                                                GError              **error);
+
+/* The preview bytes `query` (as passed to clipium_store_search) matches in
+ * `entry`, ascending, for highlighting: the fuzzy alignment of the free
+ * text with the search key, mapped back to the preview, or the first
+ * literal or regex match. Appends to `positions`; FALSE if the preview
+ * does not match, as when the hit is further into the content. */
+gboolean       clipium_store_match_positions(ClipiumStore       *store,
+                                             const char         *query,
+                                             const ClipiumEntry *entry,
+                                             GArray             *positions);
+
+/* The `limit` most frecent entries, most frecent first. Copies count as
+ * uses, so with no pastes or fetches this is the recency order. */
+GArray        *clipium_store_list_frecent (ClipiumStore *store, guint limit);
+
+/* Typo-tolerant search (see ClipiumTypoIndex): the most edits allowed per
+ * query word, at most 2, or 0 to turn it off */
+void           clipium_store_set_typo_edits(ClipiumStore *store, guint max_edits);
+
+/* Keep evicted entries searchable in an archive: fuzzy searches that find
+ * fewer than `limit` in the store append the archive's matches after their
+ * own. The journal tells the archive which entries were evicted. NULL turns
+ * the archive off. */
+void           clipium_store_set_archive  (ClipiumStore         *store,
+                                           ClipiumArchiveSearch  search,
+                                           gpointer              user_data);
+
+/* Record every change made from now on, adds, bumps, uses, pins,
+ * evictions, deletes, expiries and clears alike, so a mirror of the store
+ * can replay them. Loading entries is not a change. Turning the journal
+ * off drops what was not taken. */
+void           clipium_store_set_journal  (ClipiumStore *store, gboolean enabled);
+
+/* The changes (ClipiumStoreChange) recorded since the last call, oldest
+ * first; the array frees them. Empty if there were none. A clear drops the
+ * changes before it. */
+GArray        *clipium_store_take_changes (ClipiumStore *store);
+
+/* IDs up to `max_id` are taken elsewhere (e.g. by archived rows): new
+ * entries get higher ones */
+void           clipium_store_reserve_ids  (ClipiumStore *store, guint64 max_id);
+
+/* Index the text of an entry that was loaded without content, so search
+ * covers it without keeping the content resident */
+gboolean       clipium_store_index_content(ClipiumStore *store, guint64 id, GBytes *content);
 gboolean       clipium_store_delete       (ClipiumStore *store, guint64 id);
 void           clipium_store_clear        (ClipiumStore *store);
 gboolean       clipium_store_pin          (ClipiumStore *store, guint64 id, gboolean pinned);
 guint          clipium_store_count        (ClipiumStore *store);
+gsize          clipium_store_bytes        (ClipiumStore *store);
+
+/* Memory the full-text and typo indexes take. It is not part of the byte
+ * budget; what bounds it is that only the first CLIPIUM_INDEX_MAX_BYTES of
+ * each text entry are indexed. */
+gsize          clipium_store_index_bytes  (ClipiumStore *store);
+
+/* Cap total content size; eviction then prefers large, old, unpinned entries.
+ * 0 disables the byte budget. Takes effect on the next add. */
+void           clipium_store_set_max_bytes(ClipiumStore *store, gsize max_bytes);
+gsize          clipium_store_get_max_bytes(ClipiumStore *store);
+
+/* Switch the eviction policy; current entries keep their access statistics */
+void             clipium_store_set_evict_policy(ClipiumStore *store, ClipiumEvictKind kind);
+ClipiumEvictKind clipium_store_get_evict_policy(ClipiumStore *store);
+
+/* Time-to-live rules, comma-separated "[pinned:]MIME_GLOB=DURATION" where a
+ * duration is a number with an s, m, h, d or w suffix, or "never". The
+ * first rule matching an entry's mime type and pin state decides how long
+ * after its last copy it expires; pinned entries only match rules with the
+ * "pinned:" prefix, and unmatched entries never expire. Returns FALSE and
+ * keeps the current rules if the spec does not parse. */
+gboolean       clipium_store_set_ttl_rules(ClipiumStore *store, const char *spec);
+
+/* Remove the entries whose TTL ran out by `now`. Returns how many were
+ * removed; the journal tells the database (see clipium_db_persist). */
+guint          clipium_store_expire       (ClipiumStore *store, gint64 now);
+
+/* Record a use of an entry (paste, IPC fetch). Re-copies count on their own.
+ * A use keeps the generation, so cached search results stay valid and keep
+ * the ranking they were found with until the next change. */
+gboolean       clipium_store_touch        (ClipiumStore *store, guint64 id);
 
-void           clipium_entry_clear        (ClipiumEntry *entry);
+/* Access statistics of an entry, e.g. to persist them after a touch */
+gboolean       clipium_store_get_usage    (ClipiumStore *store,
+                                           guint64       id,
+                                           ClipiumUsage *usage);
+
+/* Metadata-only entries (loaded without content) read through a loader and
+ * a content cache bounded to max_bytes (0 disables caching) */
+void           clipium_store_set_content_loader    (ClipiumStore         *store,
+                                                    ClipiumContentLoader  loader,
+                                                    gpointer              user_data);
+void           clipium_store_set_content_cache_size(ClipiumStore *store, gsize max_bytes);
+
+/* Returns a new reference to the entry's content, loading and caching it if
+ * the entry is metadata-only. NULL if it cannot be loaded. */
+GBytes        *clipium_store_get_content  (ClipiumStore *store, const ClipiumEntry *entry);
+void           clipium_store_content_stats(ClipiumStore *store, ClipiumContentStats *stats);
+
+/* Compress entries of at least min_size that have not been used for
+ * idle_usec, keeping the zlib stream only if it saves enough. Runs the
+ * compression without holding the store lock; returns how many were
+ * compressed. */
+guint          clipium_store_compress_cold(ClipiumStore *store, gsize min_size, gint64 idle_usec);
+
+ClipiumSnapshot *clipium_store_snapshot   (ClipiumStore *store);
+ClipiumSnapshot *clipium_snapshot_ref     (ClipiumSnapshot *snapshot);
+void             clipium_snapshot_unref   (ClipiumSnapshot *snapshot);
+
+ClipiumEntry  *clipium_entry_new          (guint64            id,
+                                           GBytes            *content,
+                                           const char        *mime_type,
+                                           const char        *preview,
+                                           const ClipiumHash *hash,
+                                           gint64             timestamp,
+                                           gboolean           pinned,
+                                           gsize              size);
+ClipiumEntry  *clipium_entry_copy         (const ClipiumEntry *entry);
+ClipiumEntry  *clipium_entry_ref          (ClipiumEntry *entry);
+void           clipium_entry_unref        (ClipiumEntry *entry);
 char          *clipium_entry_make_preview (GBytes *content, const char *mime_type);
-char          *clipium_entry_compute_hash (GBytes *content);
+void           clipium_entry_compute_hash (GBytes *content, ClipiumHash *hash);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(ClipiumEntry, clipium_entry_unref)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(ClipiumSnapshot, clipium_snapshot_unref)
 
 G_END_DECLS
@@ -0,0 +1,225 @@
+#include "clipium-trigram.h"
+#include <string.h>
+
+struct _ClipiumTrigramIndex {
+    GHashTable *postings;  /* guint32 trigram → GArray* of guint slots, sorted */
+    GPtrArray  *by_slot;   /* GArray* of the slot's trigrams, or NULL */
+    gsize       bytes;     /* see clipium_trigram_index_bytes */
+};
+
+/* What one indexed trigram of a slot costs: its entry in the slot's set
+ * and in the trigram's posting */
+#define TRIGRAM_REF_BYTES (sizeof(guint32) + sizeof(guint))
+
+/* by_slot has holes for unindexed slots */
+static void
+trigram_set_free(gpointer data)
+{
+    if (data)
+        g_array_unref(data);
+}
+
+static inline guint32
+trigram_at(const guchar *p)
+{
+    return ((guint32)clipium_trigram_fold(p[0]) << 16) |
+           ((guint32)clipium_trigram_fold(p[1]) << 8) |
+           (guint32)clipium_trigram_fold(p[2]);
+}
+
+static gint
+compare_u32(gconstpointer a, gconstpointer b)
+{
+    guint32 x = *(const guint32 *)a, y = *(const guint32 *)b;
+    return (x > y) - (x < y);
+}
+
+/* Index of the first element >= value in a sorted guint array */
+static guint
+lower_bound(GArray *array, guint value)
+{
+    guint lo = 0, hi = array->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(array, guint, mid) < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static gboolean
+sorted_contains(GArray *array, guint value)
+{
+    guint i = lower_bound(array, value);
+    return i < array->len && g_array_index(array, guint, i) == value;
+}
+
+static gint
+compare_posting_len(gconstpointer a, gconstpointer b)
+{
+    guint x = (*(GArray *const *)a)->len, y = (*(GArray *const *)b)->len;
+    return (x > y) - (x < y);
+}
+
+/* --- Public API --- */
+
+ClipiumTrigramIndex *
+clipium_trigram_index_new(void)
+{
+    ClipiumTrigramIndex *index = g_new0(ClipiumTrigramIndex, 1);
+    index->postings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                            (GDestroyNotify)g_array_unref);
+    index->by_slot = g_ptr_array_new_with_free_func(trigram_set_free);
+    return index;
+}
+
+void
+clipium_trigram_index_free(ClipiumTrigramIndex *index)
+{
+    if (!index) return;
+    g_hash_table_destroy(index->postings);
+    g_ptr_array_unref(index->by_slot);
+    g_free(index);
+}
+
+void
+clipium_trigram_index_clear(ClipiumTrigramIndex *index)
+{
+    g_hash_table_remove_all(index->postings);
+    g_ptr_array_set_size(index->by_slot, 0);
+    index->bytes = 0;
+}
+
+GArray *
+clipium_trigrams_extract(const char *text, gsize len)
+{
+    GArray *trigrams = g_array_sized_new(FALSE, FALSE, sizeof(guint32),
+                                         len >= 3 ? (guint)(len - 2) : 0);
+    const guchar *p = (const guchar *)text;
+    for (gsize i = 0; i + 3 <= len; i++) {
+        guint32 t = trigram_at(p + i);
+        g_array_append_val(trigrams, t);
+    }
+    if (trigrams->len == 0)
+        return trigrams;
+
+    g_array_sort(trigrams, compare_u32);
+    guint out = 1;
+    for (guint i = 1; i < trigrams->len; i++) {
+        guint32 t = g_array_index(trigrams, guint32, i);
+        if (t != g_array_index(trigrams, guint32, out - 1))
+            g_array_index(trigrams, guint32, out++) = t;
+    }
+    g_array_set_size(trigrams, out);
+    return trigrams;
+}
+
+void
+clipium_trigram_index_insert(ClipiumTrigramIndex *index, guint slot, GArray *trigrams)
+{
+    clipium_trigram_index_remove(index, slot);
+
+    for (guint i = 0; i < trigrams->len; i++) {
+        gpointer key = GUINT_TO_POINTER(g_array_index(trigrams, guint32, i));
+        GArray *posting = g_hash_table_lookup(index->postings, key);
+        if (!posting) {
+            posting = g_array_new(FALSE, FALSE, sizeof(guint));
+            g_hash_table_insert(index->postings, key, posting);
+        }
+        g_array_insert_val(posting, lower_bound(posting, slot), slot);
+    }
+    index->bytes += trigrams->len * TRIGRAM_REF_BYTES;
+
+    if (slot >= index->by_slot->len)
+        g_ptr_array_set_size(index->by_slot, slot + 1);
+    g_ptr_array_index(index->by_slot, slot) = trigrams;
+}
+
+void
+clipium_trigram_index_remove(ClipiumTrigramIndex *index, guint slot)
+{
+    if (!clipium_trigram_index_has(index, slot))
+        return;
+
+    GArray *trigrams = g_ptr_array_index(index->by_slot, slot);
+    for (guint i = 0; i < trigrams->len; i++) {
+        gpointer key = GUINT_TO_POINTER(g_array_index(trigrams, guint32, i));
+        GArray *posting = g_hash_table_lookup(index->postings, key);
+        g_array_remove_index(posting, lower_bound(posting, slot));
+        if (posting->len == 0)
+            g_hash_table_remove(index->postings, key);
+    }
+
+    index->bytes -= trigrams->len * TRIGRAM_REF_BYTES;
+    g_array_unref(trigrams);
+    g_ptr_array_index(index->by_slot, slot) = NULL;
+}
+
+gsize
+clipium_trigram_index_bytes(ClipiumTrigramIndex *index)
+{
+    return index->bytes;
+}
+
+gboolean
+clipium_trigram_index_has(ClipiumTrigramIndex *index, guint slot)
+{
+    return slot < index->by_slot->len && g_ptr_array_index(index->by_slot, slot) != NULL;
+}
+
+gboolean
+clipium_trigram_index_query(ClipiumTrigramIndex *index, const char *query, GArray *slots)
+{
+    gsize len = strlen(query);
+    if (len < CLIPIUM_TRIGRAM_MIN_QUERY)
+        return FALSE;
+
+    g_autoptr(GArray) trigrams = clipium_trigrams_extract(query, len);
+    g_autoptr(GPtrArray) postings = g_ptr_array_sized_new(trigrams->len);
+    for (guint i = 0; i < trigrams->len; i++) {
+        GArray *posting = g_hash_table_lookup(index->postings,
+                                              GUINT_TO_POINTER(g_array_index(trigrams, guint32, i)));
+        if (!posting)
+            return TRUE;  /* some trigram occurs nowhere */
+        g_ptr_array_add(postings, posting);
+    }
+
+    /* Walk the shortest list and probe the others, rarest first */
+    g_ptr_array_sort(postings, compare_posting_len);
+    GArray *shortest = g_ptr_array_index(postings, 0);
+    for (guint i = 0; i < shortest->len; i++) {
+        guint slot = g_array_index(shortest, guint, i);
+        gboolean all = TRUE;
+        for (guint j = 1; j < postings->len && all; j++)
+            all = sorted_contains(g_ptr_array_index(postings, j), slot);
+        if (all)
+            g_array_append_val(slots, slot);
+    }
+    return TRUE;
+}
+
+gboolean
+clipium_trigram_contains(const char *haystack, gsize haystack_len,
+                         const char *needle, gsize needle_len)
+{
+    if (needle_len == 0)
+        return TRUE;
+    if (needle_len > haystack_len)
+        return FALSE;
+
+    const guchar *h = (const guchar *)haystack;
+    const guchar *n = (const guchar *)needle;
+    guchar first = clipium_trigram_fold(n[0]);
+    for (gsize i = 0; i + needle_len <= haystack_len; i++) {
+        if (clipium_trigram_fold(h[i]) != first)
+            continue;
+        gsize j = 1;
+        while (j < needle_len && clipium_trigram_fold(h[i + j]) == clipium_trigram_fold(n[j]))
+            j++;
+        if (j == needle_len)
+            return TRUE;
+    }
+    return FALSE;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Inverted index from byte trigrams to store slots, used to find entries
+ * whose full text contains a query without scanning them all. Text is
+ * folded (ASCII case, and \n \r \t as spaces, like the preview) before
+ * trigrams are taken. Posting lists are sorted slot arrays; each slot also
+ * keeps its own trigram set so removal only touches its postings. */
+typedef struct _ClipiumTrigramIndex ClipiumTrigramIndex;
+
+#define CLIPIUM_TRIGRAM_MIN_QUERY 3
+
+static inline guchar
+clipium_trigram_fold(guchar c)
+{
+    if (c == '\n' || c == '\r' || c == '\t')
+        return ' ';
+    return (guchar)g_ascii_tolower(c);
+}
+
+ClipiumTrigramIndex *clipium_trigram_index_new   (void);
+void                 clipium_trigram_index_free  (ClipiumTrigramIndex *index);
+void                 clipium_trigram_index_clear (ClipiumTrigramIndex *index);
+
+/* Sorted, distinct trigrams of the folded text (guint32 each). This is the
+ * expensive part of indexing, so it runs before any lock is taken. */
+GArray              *clipium_trigrams_extract    (const char *text, gsize len);
+
+/* Index `slot` under `trigrams` (from clipium_trigrams_extract), replacing
+ * whatever it had. Takes ownership of the array. */
+void                 clipium_trigram_index_insert(ClipiumTrigramIndex *index,
+                                                  guint                slot,
+                                                  GArray              *trigrams);
+void                 clipium_trigram_index_remove(ClipiumTrigramIndex *index, guint slot);
+gboolean             clipium_trigram_index_has   (ClipiumTrigramIndex *index, guint slot);
+
+/* Memory the indexed trigrams take, in their sets and postings; the
+ * tables holding those are not counted */
+gsize                clipium_trigram_index_bytes (ClipiumTrigramIndex *index);
+
+/* Append to `slots` every indexed slot whose text has all the trigrams of
+ * `query`, in ascending order. These are candidates: confirm them with
+ * clipium_trigram_contains when the text is at hand. Returns FALSE if the
+ * query is shorter than CLIPIUM_TRIGRAM_MIN_QUERY and cannot use the index. */
+gboolean             clipium_trigram_index_query (ClipiumTrigramIndex *index,
+                                                  const char          *query,
+                                                  GArray              *slots);
+
+/* Whether `haystack` contains `needle`, comparing folded bytes */
+gboolean             clipium_trigram_contains    (const char *haystack,
+                                                  gsize       haystack_len,
+                                                  const char *needle,
+                                                  gsize       needle_len);
+
+G_END_DECLS
@@ -0,0 +1,375 @@
+#include "clipium-typo.h"
+#include <string.h>
+
+/* A distinct word: its postings and its place in the BK-tree */
+typedef struct TypoWord TypoWord;
+
+typedef struct {
+    guint     distance;  /* from the parent */
+    TypoWord *word;
+} TypoChild;
+
+struct TypoWord {
+    char   *text;
+    guint   len;
+    GArray *slots;     /* guint, sorted; empty once no text uses the word */
+    GArray *children;  /* TypoChild, or NULL */
+};
+
+struct _ClipiumTypoIndex {
+    GHashTable *words;    /* text → TypoWord*, owning both */
+    TypoWord   *root;
+    GPtrArray  *by_slot;  /* GPtrArray* of the slot's TypoWord*, or NULL */
+    guint       live;     /* words some slot still uses */
+    gsize       bytes;    /* see clipium_typo_index_bytes */
+};
+
+/* A word with its place in the tree, and one slot's use of a word: its
+ * entry in the slot's set and in the word's slots */
+#define TYPO_WORD_BYTES(len) (sizeof(TypoWord) + sizeof(TypoChild) + (len) + 1)
+#define TYPO_REF_BYTES       (sizeof(gpointer) + sizeof(guint))
+
+/* Rebuild once unused words outnumber used ones, past this many */
+#define TYPO_REBUILD_MIN 1024
+
+static void
+typo_word_free(gpointer data)
+{
+    TypoWord *word = data;
+    g_free(word->text);
+    g_array_unref(word->slots);
+    if (word->children)
+        g_array_unref(word->children);
+    g_free(word);
+}
+
+/* by_slot has holes for unindexed slots */
+static void
+word_set_free(gpointer data)
+{
+    if (data)
+        g_ptr_array_unref(data);
+}
+
+static inline gboolean
+typo_word_byte(guchar c)
+{
+    return c >= 0x80 || g_ascii_isalnum(c);
+}
+
+/* Index of the first element >= value in a sorted guint array */
+static guint
+lower_bound(GArray *array, guint value)
+{
+    guint lo = 0, hi = array->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(array, guint, mid) < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void
+tree_insert(ClipiumTypoIndex *index, TypoWord *word)
+{
+    if (!index->root) {
+        index->root = word;
+        return;
+    }
+
+    TypoWord *node = index->root;
+    for (;;) {
+        guint d = clipium_typo_distance(word->text, word->len, node->text, node->len);
+        TypoWord *next = NULL;
+        for (guint i = 0; node->children && i < node->children->len; i++) {
+            TypoChild *child = &g_array_index(node->children, TypoChild, i);
+            if (child->distance == d) {
+                next = child->word;
+                break;
+            }
+        }
+        if (!next) {
+            if (!node->children)
+                node->children = g_array_new(FALSE, FALSE, sizeof(TypoChild));
+            TypoChild child = { .distance = d, .word = word };
+            g_array_append_val(node->children, child);
+            return;
+        }
+        node = next;
+    }
+}
+
+/* Drop the words nothing uses and rebuild the tree from the rest */
+static void
+typo_index_compact(ClipiumTypoIndex *index)
+{
+    index->root = NULL;
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, index->words);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        TypoWord *word = value;
+        if (word->slots->len == 0) {
+            index->bytes -= TYPO_WORD_BYTES(word->len);
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+        g_clear_pointer(&word->children, g_array_unref);
+    }
+
+    g_hash_table_iter_init(&iter, index->words);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        tree_insert(index, value);
+}
+
+/* Slots that have a word within `max_edits` of `text`, each with its
+ * smallest distance (+1, so that 0 stays "absent") */
+static GHashTable *
+typo_index_lookup(ClipiumTypoIndex *index, const char *text, guint len, guint max_edits)
+{
+    GHashTable *found = g_hash_table_new(g_direct_hash, g_direct_equal);
+    if (!index->root)
+        return found;
+
+    g_autoptr(GPtrArray) stack = g_ptr_array_new();
+    g_ptr_array_add(stack, index->root);
+    while (stack->len > 0) {
+        TypoWord *node = g_ptr_array_steal_index_fast(stack, stack->len - 1);
+        guint d = clipium_typo_distance(text, len, node->text, node->len);
+
+        if (d <= max_edits) {
+            for (guint i = 0; i < node->slots->len; i++) {
+                gpointer slot = GUINT_TO_POINTER(g_array_index(node->slots, guint, i));
+                guint known = GPOINTER_TO_UINT(g_hash_table_lookup(found, slot));
+                if (!known || d + 1 < known)
+                    g_hash_table_insert(found, slot, GUINT_TO_POINTER(d + 1));
+            }
+        }
+
+        /* By the triangle inequality, only these subtrees can hold words
+         * within max_edits of the query */
+        for (guint i = 0; node->children && i < node->children->len; i++) {
+            TypoChild *child = &g_array_index(node->children, TypoChild, i);
+            if (child->distance + max_edits >= d && child->distance <= d + max_edits)
+                g_ptr_array_add(stack, child->word);
+        }
+    }
+    return found;
+}
+
+/* --- Public API --- */
+
+ClipiumTypoIndex *
+clipium_typo_index_new(void)
+{
+    ClipiumTypoIndex *index = g_new0(ClipiumTypoIndex, 1);
+    index->words = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, typo_word_free);
+    index->by_slot = g_ptr_array_new_with_free_func(word_set_free);
+    return index;
+}
+
+void
+clipium_typo_index_free(ClipiumTypoIndex *index)
+{
+    if (!index) return;
+    g_ptr_array_unref(index->by_slot);
+    g_hash_table_destroy(index->words);
+    g_free(index);
+}
+
+void
+clipium_typo_index_clear(ClipiumTypoIndex *index)
+{
+    g_ptr_array_set_size(index->by_slot, 0);
+    g_hash_table_remove_all(index->words);
+    index->root = NULL;
+    index->live = 0;
+    index->bytes = 0;
+}
+
+GPtrArray *
+clipium_typo_words_extract(const char *text, gsize len)
+{
+    GPtrArray *words = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GHashTable) seen = g_hash_table_new(g_str_hash, g_str_equal);
+    const guchar *p = (const guchar *)text;
+
+    for (gsize i = 0; i < len;) {
+        if (!typo_word_byte(p[i])) {
+            i++;
+            continue;
+        }
+        gsize start = i;
+        while (i < len && typo_word_byte(p[i]))
+            i++;
+        gsize word_len = i - start;
+        if (word_len < CLIPIUM_TYPO_MIN_WORD || word_len > CLIPIUM_TYPO_MAX_WORD)
+            continue;
+
+        char *word = g_ascii_strdown(text + start, (gssize)word_len);
+        if (g_hash_table_contains(seen, word)) {
+            g_free(word);
+            continue;
+        }
+        g_hash_table_add(seen, word);
+        g_ptr_array_add(words, word);
+    }
+    return words;
+}
+
+void
+clipium_typo_index_insert(ClipiumTypoIndex *index, guint slot, GPtrArray *words)
+{
+    clipium_typo_index_remove(index, slot);
+
+    GPtrArray *set = g_ptr_array_sized_new(words->len);
+    for (guint i = 0; i < words->len; i++) {
+        char *text = g_ptr_array_index(words, i);
+        TypoWord *word = g_hash_table_lookup(index->words, text);
+        if (!word) {
+            word = g_new0(TypoWord, 1);
+            word->text = g_strdup(text);
+            word->len = (guint)strlen(text);
+            word->slots = g_array_new(FALSE, FALSE, sizeof(guint));
+            g_hash_table_insert(index->words, word->text, word);
+            tree_insert(index, word);
+            index->bytes += TYPO_WORD_BYTES(word->len);
+        }
+        if (word->slots->len == 0)
+            index->live++;
+        g_array_insert_val(word->slots, lower_bound(word->slots, slot), slot);
+        g_ptr_array_add(set, word);
+    }
+    g_ptr_array_unref(words);
+    index->bytes += set->len * TYPO_REF_BYTES;
+
+    if (slot >= index->by_slot->len)
+        g_ptr_array_set_size(index->by_slot, slot + 1);
+    g_ptr_array_index(index->by_slot, slot) = set;
+}
+
+void
+clipium_typo_index_remove(ClipiumTypoIndex *index, guint slot)
+{
+    if (!clipium_typo_index_has(index, slot))
+        return;
+
+    GPtrArray *set = g_ptr_array_index(index->by_slot, slot);
+    for (guint i = 0; i < set->len; i++) {
+        TypoWord *word = g_ptr_array_index(set, i);
+        g_array_remove_index(word->slots, lower_bound(word->slots, slot));
+        if (word->slots->len == 0)
+            index->live--;
+    }
+    index->bytes -= set->len * TYPO_REF_BYTES;
+    g_ptr_array_unref(set);
+    g_ptr_array_index(index->by_slot, slot) = NULL;
+
+    guint total = g_hash_table_size(index->words);
+    if (total >= TYPO_REBUILD_MIN && index->live < total / 2)
+        typo_index_compact(index);
+}
+
+gboolean
+clipium_typo_index_has(ClipiumTypoIndex *index, guint slot)
+{
+    return slot < index->by_slot->len && g_ptr_array_index(index->by_slot, slot) != NULL;
+}
+
+gsize
+clipium_typo_index_bytes(ClipiumTypoIndex *index)
+{
+    return index->bytes;
+}
+
+gboolean
+clipium_typo_index_query(ClipiumTypoIndex *index, const char *query, guint max_edits,
+                         GArray *hits)
+{
+    g_autoptr(GPtrArray) words = clipium_typo_words_extract(query, strlen(query));
+    if (words->len == 0)
+        return FALSE;
+
+    /* Slot → summed distance + 1, narrowed word by word */
+    g_autoptr(GHashTable) matched = NULL;
+    for (guint w = 0; w < words->len; w++) {
+        const char *text = g_ptr_array_index(words, w);
+        guint len = (guint)strlen(text);
+        GHashTable *found = typo_index_lookup(index, text, len,
+                                              MIN(max_edits, len <= 4 ? 1u : 2u));
+        if (!matched) {
+            matched = found;
+            continue;
+        }
+
+        GHashTableIter iter;
+        gpointer slot, dist;
+        g_hash_table_iter_init(&iter, matched);
+        while (g_hash_table_iter_next(&iter, &slot, &dist)) {
+            guint d = GPOINTER_TO_UINT(g_hash_table_lookup(found, slot));
+            if (d)
+                g_hash_table_iter_replace(&iter, GUINT_TO_POINTER(GPOINTER_TO_UINT(dist) + d - 1));
+            else
+                g_hash_table_iter_remove(&iter);
+        }
+        g_hash_table_destroy(found);
+        if (g_hash_table_size(matched) == 0)
+            break;
+    }
+
+    GHashTableIter iter;
+    gpointer slot, dist;
+    g_hash_table_iter_init(&iter, matched);
+    while (g_hash_table_iter_next(&iter, &slot, &dist)) {
+        ClipiumTypoHit hit = { .slot = GPOINTER_TO_UINT(slot), .distance = GPOINTER_TO_UINT(dist) - 1 };
+        g_array_append_val(hits, hit);
+    }
+    return TRUE;
+}
+
+/* Lowrance-Wagner: unlike the restricted (optimal string alignment)
+ * variant this satisfies the triangle inequality the tree relies on.
+ * `last_row[c]` is the last row whose byte of `a` was c. */
+guint
+clipium_typo_distance(const char *a, gsize a_len, const char *b, gsize b_len)
+{
+    g_return_val_if_fail(a_len <= CLIPIUM_TYPO_MAX_WORD && b_len <= CLIPIUM_TYPO_MAX_WORD,
+                         (guint)MAX(a_len, b_len));
+
+    enum { N = CLIPIUM_TYPO_MAX_WORD + 2 };
+    guint d[N][N];
+    guint last_row[256] = { 0 };
+    guint inf = (guint)(a_len + b_len);
+    const guchar *x = (const guchar *)a, *y = (const guchar *)b;
+
+    d[0][0] = inf;
+    for (gsize i = 0; i <= a_len; i++) {
+        d[i + 1][0] = inf;
+        d[i + 1][1] = (guint)i;
+    }
+    for (gsize j = 0; j <= b_len; j++) {
+        d[0][j + 1] = inf;
+        d[1][j + 1] = (guint)j;
+    }
+
+    for (gsize i = 1; i <= a_len; i++) {
+        guint last_col = 0;  /* last column in this row where the bytes matched */
+        for (gsize j = 1; j <= b_len; j++) {
+            guint i1 = last_row[y[j - 1]], j1 = last_col;
+            guint cost = x[i - 1] == y[j - 1] ? 0 : 1;
+            if (cost == 0)
+                last_col = (guint)j;
+
+            guint best = d[i][j] + cost;                           /* substitute */
+            best = MIN(best, d[i + 1][j] + 1);                     /* insert */
+            best = MIN(best, d[i][j + 1] + 1);                     /* delete */
+            best = MIN(best, d[i1][j1] + (guint)(i - i1 - 1) + 1 + (guint)(j - j1 - 1)); /* transpose */
+            d[i + 1][j + 1] = best;
+        }
+        last_row[x[i - 1]] = (guint)i;
+    }
+    return d[a_len + 1][b_len + 1];
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Words of indexed text, by store slot, in a BK-tree under
+ * Damerau-Levenshtein distance (insertions, deletions, substitutions and
+ * transpositions of adjacent bytes each cost 1). That distance is a metric,
+ * so a lookup only descends into the children whose distance to their
+ * parent is within `max_edits` of the query word's, and finds every indexed
+ * word that close without comparing against the rest of the vocabulary.
+ *
+ * Words are runs of ASCII letters and digits and non-ASCII bytes, lowercased
+ * (ASCII only), of CLIPIUM_TYPO_MIN_WORD to CLIPIUM_TYPO_MAX_WORD bytes.
+ * Words no text uses any more stay in the tree until enough of them pile up
+ * to rebuild it. */
+typedef struct _ClipiumTypoIndex ClipiumTypoIndex;
+
+#define CLIPIUM_TYPO_MIN_WORD 3
+#define CLIPIUM_TYPO_MAX_WORD 32
+
+typedef struct {
+    guint slot;
+    guint distance;  /* summed over the query words */
+} ClipiumTypoHit;
+
+ClipiumTypoIndex *clipium_typo_index_new   (void);
+void              clipium_typo_index_free  (ClipiumTypoIndex *index);
+void              clipium_typo_index_clear (ClipiumTypoIndex *index);
+
+/* Distinct words of `text` (char*, owned by the array). Like trigram
+ * extraction, this runs before any lock is taken. */
+GPtrArray        *clipium_typo_words_extract(const char *text, gsize len);
+
+/* Index `slot` under `words` (from clipium_typo_words_extract), replacing
+ * whatever it had. Takes ownership of the array. */
+void              clipium_typo_index_insert(ClipiumTypoIndex *index,
+                                            guint             slot,
+                                            GPtrArray        *words);
+void              clipium_typo_index_remove(ClipiumTypoIndex *index, guint slot);
+gboolean          clipium_typo_index_has   (ClipiumTypoIndex *index, guint slot);
+
+/* Memory the words and their uses take, not counting the tables */
+gsize             clipium_typo_index_bytes (ClipiumTypoIndex *index);
+
+/* Append to `hits` every slot that has, for each word of `query`, a word
+ * within the edits that word allows: 1 up to 4 bytes, 2 beyond, and never
+ * more than `max_edits`. Hits come in no particular order. Returns FALSE if
+ * the query has no words long enough to look up. */
+gboolean          clipium_typo_index_query (ClipiumTypoIndex *index,
+                                            const char       *query,
+                                            guint             max_edits,
+                                            GArray           *hits);
+
+/* Damerau-Levenshtein distance between two byte strings of at most
+ * CLIPIUM_TYPO_MAX_WORD bytes */
+guint             clipium_typo_distance    (const char *a, gsize a_len,
+                                            const char *b, gsize b_len);
+
+G_END_DECLS
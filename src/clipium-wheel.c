@@ -0,0 +1,202 @@
+#include "clipium-wheel.h"
+
+#define NODE_NONE    G_MAXUINT
+#define WHEEL_BITS   6
+#define WHEEL_SIZE   (1u << WHEEL_BITS)  /* buckets per level */
+#define WHEEL_MASK   ((guint64)WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 5                   /* 2^30 ticks, 34 years of seconds */
+#define WHEEL_SPAN   ((guint64)1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+typedef struct {
+    guint64  expires;  /* tick the slot fires at */
+    guint    prev;
+    guint    next;
+    guint8   level;
+    guint8   bucket;
+    gboolean scheduled;
+} WheelNode;
+
+/* Level 0 holds the next 64 ticks one per bucket; each level above covers
+ * 64 times the span of the one below. When a level's index wraps, the
+ * matching bucket of the next level is cascaded down into finer buckets. */
+struct _ClipiumWheel {
+    gint64   start;
+    gint64   tick_usec;
+    guint64  current;                             /* last tick processed */
+    GArray  *nodes;                               /* WheelNode[], indexed by store slot */
+    guint    buckets[WHEEL_LEVELS][WHEEL_SIZE];   /* list heads */
+    guint    level_count[WHEEL_LEVELS];
+    guint    count;
+};
+
+#define NODE(wheel, slot) (&g_array_index((wheel)->nodes, WheelNode, (slot)))
+
+/* --- Bucket helpers --- */
+
+static void
+bucket_link(ClipiumWheel *wheel, guint slot)
+{
+    WheelNode *n = NODE(wheel, slot);
+    guint64 delta = n->expires - wheel->current;
+    guint level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (guint64)1 << (WHEEL_BITS * (level + 1)))
+        level++;
+
+    guint bucket = (guint)((n->expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    guint *head = &wheel->buckets[level][bucket];
+    n->level = (guint8)level;
+    n->bucket = (guint8)bucket;
+    n->prev = NODE_NONE;
+    n->next = *head;
+    if (*head != NODE_NONE)
+        NODE(wheel, *head)->prev = slot;
+    *head = slot;
+    wheel->level_count[level]++;
+}
+
+static void
+bucket_unlink(ClipiumWheel *wheel, guint slot)
+{
+    WheelNode *n = NODE(wheel, slot);
+    if (n->prev != NODE_NONE) NODE(wheel, n->prev)->next = n->next;
+    else wheel->buckets[n->level][n->bucket] = n->next;
+    if (n->next != NODE_NONE) NODE(wheel, n->next)->prev = n->prev;
+    wheel->level_count[n->level]--;
+    n->prev = n->next = NODE_NONE;
+}
+
+/* Re-place every slot of a coarse bucket relative to the current tick */
+static void
+bucket_cascade(ClipiumWheel *wheel, guint level, guint bucket)
+{
+    guint slot = wheel->buckets[level][bucket];
+    wheel->buckets[level][bucket] = NODE_NONE;
+    while (slot != NODE_NONE) {
+        guint next = NODE(wheel, slot)->next;
+        wheel->level_count[level]--;
+        bucket_link(wheel, slot);
+        slot = next;
+    }
+}
+
+/* Process one tick: cascade wherever a level wrapped, then fire the level 0
+ * bucket for the new tick */
+static void
+wheel_step(ClipiumWheel *wheel, GArray *fired)
+{
+    wheel->current++;
+    for (guint level = 1; level < WHEEL_LEVELS; level++) {
+        if ((wheel->current >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK)
+            break;
+        bucket_cascade(wheel, level,
+                       (guint)((wheel->current >> (WHEEL_BITS * level)) & WHEEL_MASK));
+    }
+
+    guint bucket = (guint)(wheel->current & WHEEL_MASK);
+    while (wheel->buckets[0][bucket] != NODE_NONE) {
+        guint slot = wheel->buckets[0][bucket];
+        bucket_unlink(wheel, slot);
+        NODE(wheel, slot)->scheduled = FALSE;
+        wheel->count--;
+        g_array_append_val(fired, slot);
+    }
+}
+
+/* --- Public API --- */
+
+ClipiumWheel *
+clipium_wheel_new(gint64 start, gint64 tick_usec)
+{
+    g_return_val_if_fail(tick_usec > 0, NULL);
+
+    ClipiumWheel *wheel = g_new0(ClipiumWheel, 1);
+    wheel->start = start;
+    wheel->tick_usec = tick_usec;
+    wheel->nodes = g_array_new(FALSE, TRUE, sizeof(WheelNode));
+    clipium_wheel_clear(wheel);
+    return wheel;
+}
+
+void
+clipium_wheel_free(ClipiumWheel *wheel)
+{
+    if (!wheel) return;
+    g_array_free(wheel->nodes, TRUE);
+    g_free(wheel);
+}
+
+void
+clipium_wheel_clear(ClipiumWheel *wheel)
+{
+    g_array_set_size(wheel->nodes, 0);
+    for (guint level = 0; level < WHEEL_LEVELS; level++) {
+        for (guint b = 0; b < WHEEL_SIZE; b++)
+            wheel->buckets[level][b] = NODE_NONE;
+        wheel->level_count[level] = 0;
+    }
+    wheel->count = 0;
+}
+
+guint
+clipium_wheel_count(ClipiumWheel *wheel)
+{
+    return wheel->count;
+}
+
+void
+clipium_wheel_schedule(ClipiumWheel *wheel, guint slot, gint64 deadline)
+{
+    if (slot >= wheel->nodes->len)
+        g_array_set_size(wheel->nodes, slot + 1);
+
+    WheelNode *n = NODE(wheel, slot);
+    if (n->scheduled) {
+        bucket_unlink(wheel, slot);
+        wheel->count--;
+    }
+
+    /* Round up so a slot never fires before its deadline */
+    guint64 expires = 0;
+    if (deadline > wheel->start)
+        expires = (guint64)((deadline - wheel->start + wheel->tick_usec - 1) / wheel->tick_usec);
+    expires = CLAMP(expires, wheel->current + 1, wheel->current + WHEEL_SPAN - 1);
+
+    n->expires = expires;
+    n->scheduled = TRUE;
+    bucket_link(wheel, slot);
+    wheel->count++;
+}
+
+void
+clipium_wheel_cancel(ClipiumWheel *wheel, guint slot)
+{
+    if (slot >= wheel->nodes->len || !NODE(wheel, slot)->scheduled)
+        return;
+    bucket_unlink(wheel, slot);
+    NODE(wheel, slot)->scheduled = FALSE;
+    wheel->count--;
+}
+
+guint
+clipium_wheel_advance(ClipiumWheel *wheel, gint64 now, GArray *fired)
+{
+    guint before = fired->len;
+    guint64 target = now > wheel->start ? (guint64)((now - wheel->start) / wheel->tick_usec) : 0;
+
+    while (wheel->current < target) {
+        if (wheel->count == 0) {
+            wheel->current = target;
+            break;
+        }
+        /* With level 0 empty nothing can fire before the next cascade, so
+         * skip straight to the tick before it */
+        if (wheel->level_count[0] == 0) {
+            wheel->current = MIN(target, wheel->current | WHEEL_MASK);
+            if (wheel->current == target)
+                break;
+        }
+        wheel_step(wheel, fired);
+    }
+
+    return fired->len - before;
+}
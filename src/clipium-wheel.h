@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Hierarchical timer wheel over store slot indices. Scheduling and
+ * cancelling are O(1); advancing only visits the buckets that come due,
+ * plus one cascade from a coarser level every 64 ticks, so expiring
+ * entries never needs a scan of the whole store. */
+typedef struct _ClipiumWheel ClipiumWheel;
+
+/* `start` is the time (µs) of tick 0; `tick_usec` the resolution */
+ClipiumWheel *clipium_wheel_new     (gint64 start, gint64 tick_usec);
+void          clipium_wheel_free    (ClipiumWheel *wheel);
+void          clipium_wheel_clear   (ClipiumWheel *wheel);
+guint         clipium_wheel_count   (ClipiumWheel *wheel);
+
+/* Fire `slot` at the first tick at or after `deadline`; a deadline that
+ * has already passed fires at the next tick. Rescheduling a slot moves
+ * it. */
+void          clipium_wheel_schedule(ClipiumWheel *wheel, guint slot, gint64 deadline);
+void          clipium_wheel_cancel  (ClipiumWheel *wheel, guint slot);
+
+/* Run the wheel up to `now`, appending the slots that came due (guint) to
+ * `fired`. Fired slots are no longer scheduled. Returns how many fired. */
+guint         clipium_wheel_advance (ClipiumWheel *wheel, gint64 now, GArray *fired);
+
+G_END_DECLS
@@ -20,6 +20,7 @@ struct _ClipiumWindow {
     GtkLabel       *empty_label;
 
     GtkCssProvider *css_provider;
+    GCancellable   *search_cancellable;  /* the search filling the list, if any */
 };
 
 G_DEFINE_TYPE(ClipiumWindow, clipium_window, GTK_TYPE_WINDOW)
@@ -83,12 +84,25 @@ do_paste_after_delay(gpointer user_data)
 static void
 do_select_entry(ClipiumWindow *self, guint64 entry_id)
 {
-    ClipiumEntry *entry = clipium_store_get(self->store, entry_id);
+    g_autoptr(ClipiumEntry) entry = clipium_store_get(self->store, entry_id);
+    if (!entry && self->db)
+        entry = clipium_db_get_archived(self->db, entry_id);
     if (!entry) return;
 
+    /* A paste is a use; keep the count and frecency across restarts */
+    if (clipium_store_touch(self->store, entry_id) && self->db)
+        clipium_db_persist(self->db, self->store);
+
+    /* Metadata-only entries read their content from the database here */
+    g_autoptr(GBytes) content = clipium_store_get_content(self->store, entry);
+    if (!content) {
+        g_warning("Content of entry %" G_GUINT64_FORMAT " is unavailable", entry_id);
+        return;
+    }
+
     /* Copy to clipboard via wl-copy */
     gsize content_len;
-    const char *content_data = g_bytes_get_data(entry->content, &content_len);
+    const char *content_data = g_bytes_get_data(content, &content_len);
 
     GError *err = NULL;
     GSubprocess *proc = g_subprocess_new(
@@ -155,11 +169,23 @@ on_key_pressed(GtkEventControllerKey *controller,
         GtkListBoxRow *row = gtk_list_box_get_selected_row(self->listbox);
         if (row && CLIPIUM_IS_ENTRY_ROW(row)) {
             guint64 id = clipium_entry_row_get_id(CLIPIUM_ENTRY_ROW(row));
-            clipium_store_delete(self->store, id);
-            if (self->db)
-                clipium_db_delete(self->db, id);
-            const char *text = gtk_editable_get_text(GTK_EDITABLE(self->search_entry));
-            populate_listbox(self, (text && *text) ? text : NULL);
+            if (clipium_store_delete(self->store, id)) {
+                if (self->db)
+                    clipium_db_persist(self->db, self->store);
+                const char *text = gtk_editable_get_text(GTK_EDITABLE(self->search_entry));
+                populate_listbox(self, (text && *text) ? text : NULL);
+            } else if (self->db) {
+                /* An archive hit: the writer drops its row, so take it out
+                 * of the list here rather than search again before then */
+                int idx = gtk_list_box_row_get_index(row);
+                clipium_db_delete_async(self->db, &id, 1);
+                gtk_list_box_remove(self->listbox, GTK_WIDGET(row));
+                GtkListBoxRow *next = gtk_list_box_get_row_at_index(self->listbox, idx);
+                if (!next && idx > 0)
+                    next = gtk_list_box_get_row_at_index(self->listbox, idx - 1);
+                if (next)
+                    gtk_list_box_select_row(self->listbox, next);
+            }
         }
         return TRUE;
     }
@@ -225,20 +251,27 @@ on_overlay_click(GtkGestureClick *gesture,
 
 /* --- Populate listbox --- */
 
+/* Fill the list with `entries` (consumed) for `search_query`, or the
+ * history if NULL, highlighting each row at its `positions` (a GArray of
+ * preview offsets or NULL per entry, from the search thread). Only a final
+ * result says there are no matches. */
 static void
-populate_listbox(ClipiumWindow *self, const char *search_query)
+show_entries(ClipiumWindow *self,
+             const char    *search_query,
+             GArray        *entries,
+             GPtrArray     *positions,
+             gboolean       final)
 {
+    if (entries->len == 0 && !final) {
+        g_array_free(entries, TRUE);
+        return;
+    }
+
     /* Remove all existing rows */
     GtkWidget *child;
     while ((child = gtk_widget_get_first_child(GTK_WIDGET(self->listbox))))
         gtk_list_box_remove(self->listbox, child);
 
-    GArray *entries;
-    if (search_query)
-        entries = clipium_store_search(self->store, search_query, 50);
-    else
-        entries = clipium_store_list(self->store, 50, 0);
-
     if (entries->len == 0) {
         gtk_widget_set_visible(GTK_WIDGET(self->scrolled), FALSE);
         gtk_widget_set_visible(GTK_WIDGET(self->empty_label), TRUE);
@@ -253,6 +286,9 @@ populate_listbox(ClipiumWindow *self, const char *search_query)
         for (guint i = 0; i < entries->len; i++) {
             ClipiumEntry *e = g_array_index(entries, ClipiumEntry *, i);
             ClipiumEntryRow *row = clipium_entry_row_new(e);
+            GArray *row_positions = positions ? g_ptr_array_index(positions, i) : NULL;
+            if (row_positions)
+                clipium_entry_row_highlight(row, row_positions);
             gtk_list_box_append(self->listbox, GTK_WIDGET(row));
         }
 
@@ -265,6 +301,148 @@ populate_listbox(ClipiumWindow *self, const char *search_query)
     g_array_free(entries, TRUE);
 }
 
+/* --- Progressive search --- */
+
+/* Searches run off the main loop and post each result back to it: the
+ * best matches among the newest entries show up first and are replaced as
+ * the scan goes on. A newer query cancels the search, and results that
+ * were already on their way are dropped. */
+typedef struct {
+    ClipiumWindow   *self;
+    char            *query;
+    GCancellable    *cancellable;
+    GHashTable      *positions;  /* ClipiumEntry* → GArray or NULL, search thread only */
+    gatomicrefcount  ref_count;  /* the task's and each pending update's */
+} SearchJob;
+
+typedef struct {
+    SearchJob          *job;
+    GArray             *entries;
+    GPtrArray          *positions;  /* see show_entries */
+    ClipiumSearchStage  stage;
+} SearchUpdate;
+
+/* Entries whose preview has no match keep NULL */
+static void
+positions_free(gpointer data)
+{
+    if (data)
+        g_array_unref(data);
+}
+
+static SearchJob *
+search_job_ref(SearchJob *job)
+{
+    g_atomic_ref_count_inc(&job->ref_count);
+    return job;
+}
+
+static void
+search_job_unref(gpointer data)
+{
+    SearchJob *job = data;
+    if (!g_atomic_ref_count_dec(&job->ref_count))
+        return;
+    g_object_unref(job->self);
+    g_object_unref(job->cancellable);
+    g_hash_table_unref(job->positions);
+    g_free(job->query);
+    g_free(job);
+}
+
+static gboolean
+search_update_apply(gpointer user_data)
+{
+    SearchUpdate *update = user_data;
+    SearchJob *job = update->job;
+    if (!g_cancellable_is_cancelled(job->cancellable))
+        show_entries(job->self, job->query, g_steal_pointer(&update->entries),
+                     update->positions, update->stage != CLIPIUM_SEARCH_INTERIM);
+    if (update->entries)
+        g_array_free(update->entries, TRUE);
+    g_ptr_array_unref(update->positions);
+    search_job_unref(job);
+    g_free(update);
+    return G_SOURCE_REMOVE;
+}
+
+/* On the search thread. Each entry is aligned with the query once per
+ * search, however many updates it shows up in; a hit further into the
+ * content leaves the preview plain. */
+static void
+on_search_result(GArray *entries, ClipiumSearchStage stage, gpointer user_data)
+{
+    SearchJob *job = user_data;
+    SearchUpdate *update = g_new(SearchUpdate, 1);
+    update->job = search_job_ref(job);
+    update->entries = entries;
+    update->positions = g_ptr_array_new_full(entries->len, positions_free);
+    update->stage = stage;
+
+    for (guint i = 0; i < entries->len; i++) {
+        ClipiumEntry *e = g_array_index(entries, ClipiumEntry *, i);
+        GArray *positions;
+        if (!g_hash_table_lookup_extended(job->positions, e, NULL, (gpointer *)&positions)) {
+            positions = g_array_new(FALSE, FALSE, sizeof(guint));
+            if (!clipium_store_match_positions(job->self->store, job->query, e, positions))
+                g_clear_pointer(&positions, g_array_unref);
+            g_hash_table_insert(job->positions, clipium_entry_ref(e), positions);
+        }
+        g_ptr_array_add(update->positions, positions ? g_array_ref(positions) : NULL);
+    }
+    g_idle_add(search_update_apply, update);
+}
+
+static void
+search_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+    SearchJob *job = task_data;
+    ClipiumSearchMode mode;
+    g_autofree char *pattern = clipium_search_mode_split(job->query, &mode);
+
+    /* A regex that is still being typed finds nothing yet */
+    if (!clipium_store_search_progressive(job->self->store, pattern, mode, 50,
+                                          CLIPIUM_SEARCH_BUDGET_MS * 1000, cancellable,
+                                          on_search_result, job, NULL))
+        on_search_result(g_array_new(FALSE, FALSE, sizeof(ClipiumEntry *)),
+                         CLIPIUM_SEARCH_COMPLETE, job);
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+cancel_search(ClipiumWindow *self)
+{
+    if (self->search_cancellable) {
+        g_cancellable_cancel(self->search_cancellable);
+        g_clear_object(&self->search_cancellable);
+    }
+}
+
+static void
+populate_listbox(ClipiumWindow *self, const char *search_query)
+{
+    cancel_search(self);
+    if (!search_query) {
+        show_entries(self, NULL, clipium_store_list_frecent(self->store, 50), NULL, TRUE);
+        return;
+    }
+
+    self->search_cancellable = g_cancellable_new();
+    SearchJob *job = g_new(SearchJob, 1);
+    job->self = g_object_ref(self);
+    job->query = g_strdup(search_query);
+    job->cancellable = g_object_ref(self->search_cancellable);
+    job->positions = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                           (GDestroyNotify)clipium_entry_unref,
+                                           positions_free);
+    g_atomic_ref_count_init(&job->ref_count);
+
+    GTask *task = g_task_new(self, job->cancellable, NULL, NULL);
+    g_task_set_task_data(task, job, search_job_unref);
+    g_task_run_in_thread(task, search_thread);
+    g_object_unref(task);
+}
+
 static void
 select_current_row(ClipiumWindow *self)
 {
@@ -281,6 +459,7 @@ static void
 clipium_window_finalize(GObject *obj)
 {
     ClipiumWindow *self = CLIPIUM_WINDOW(obj);
+    g_clear_object(&self->search_cancellable);
     if (self->css_provider) {
         gtk_style_context_remove_provider_for_display(
             gdk_display_get_default(),
@@ -356,7 +535,7 @@ clipium_window_new(GtkApplication *app, ClipiumStore *store, ClipiumDb *db, Clip
     /* Search entry */
     self->search_entry = GTK_SEARCH_ENTRY(gtk_search_entry_new());
     gtk_widget_add_css_class(GTK_WIDGET(self->search_entry), "clipium-search");
-    g_object_set(self->search_entry, "placeholder-text", "Search clipboard...", NULL);
+    g_object_set(self->search_entry, "placeholder-text", "Search clipboard... (\"exact\", re:regex)", NULL);
     g_signal_connect(self->search_entry, "search-changed", G_CALLBACK(on_search_changed), self);
 
     /* Scrolled window + listbox */
@@ -427,6 +606,7 @@ clipium_window_show_popup(ClipiumWindow *self)
 void
 clipium_window_hide_popup(ClipiumWindow *self)
 {
+    cancel_search(self);
     gtk_widget_set_visible(GTK_WIDGET(self), FALSE);
 }
 
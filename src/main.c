@@ -173,6 +173,25 @@ do_cli_command(const char *json_cmd)
     return 0;
 }
 
+static void
+print_response(const char *json, gpointer user_data)
+{
+    printf("%s\n", json);
+    fflush(stdout);
+}
+
+/* One response per line, as the daemon sends them */
+static int
+do_cli_command_stream(const char *json_cmd)
+{
+    g_autofree char *sock = clipium_socket_path();
+    if (!clipium_ipc_send_command_stream(sock, json_cmd, print_response, NULL)) {
+        g_printerr("clipium: daemon not running (socket: %s)\n", sock);
+        return 1;
+    }
+    return 0;
+}
+
 static int
 do_show(void)
 {
@@ -193,23 +212,56 @@ do_list(int argc, char **argv)
 static int
 do_search(int argc, char **argv)
 {
-    if (argc < 3) {
-        g_printerr("Usage: clipium search <query>\n");
+    const char *mode = NULL;
+    gboolean stream = FALSE;
+    int first = 2;
+    for (; first < argc; first++) {
+        if (g_str_equal(argv[first], "--literal"))
+            mode = "literal";
+        else if (g_str_equal(argv[first], "--regex"))
+            mode = "regex";
+        else if (g_str_equal(argv[first], "--stream"))
+            stream = TRUE;
+        else
+            break;
+    }
+
+    if (argc <= first) {
+        g_printerr("Usage: clipium search [--literal | --regex] [--stream] <query>\n");
         return 1;
     }
 
+    /* Separate arguments form one query, so filters need no quoting:
+     * clipium search mime:image since:1d */
+    g_autofree char *query = g_strjoinv(" ", argv + first);
+
     /* Escape the query for JSON */
     GString *escaped = g_string_new(NULL);
-    for (const char *p = argv[2]; *p; p++) {
+    for (const char *p = query; *p; p++) {
         if (*p == '"' || *p == '\\')
             g_string_append_c(escaped, '\\');
         g_string_append_c(escaped, *p);
     }
 
+    g_autofree char *mode_field = mode ? g_strdup_printf(",\"mode\":\"%s\"", mode) : g_strdup("");
     g_autofree char *cmd = g_strdup_printf(
-        "{\"cmd\":\"search\",\"query\":\"%s\"}", escaped->str);
+        "{\"cmd\":\"search\",\"query\":\"%s\"%s%s}", escaped->str, mode_field,
+        stream ? ",\"stream\":true" : "");
     g_string_free(escaped, TRUE);
 
+    return stream ? do_cli_command_stream(cmd) : do_cli_command(cmd);
+}
+
+static int
+do_get(int argc, char **argv)
+{
+    if (argc < 3) {
+        g_printerr("Usage: clipium get <id>\n");
+        return 1;
+    }
+
+    long id = atol(argv[2]);
+    g_autofree char *cmd = g_strdup_printf("{\"cmd\":\"get\",\"id\":%ld}", id);
     return do_cli_command(cmd);
 }
 
@@ -250,7 +302,15 @@ print_usage(void)
         "  clipium                Start daemon (or activate existing)\n"
         "  clipium show           Show clipboard popup\n"
         "  clipium list [N]       List last N entries (default 50)\n"
-        "  clipium search <q>     Fuzzy search entries\n"
+        "  clipium search <q>     Fuzzy search entries; filter with mime:image,\n"
+        "                         pinned:yes, since:2h, size>1M\n"
+        "  clipium search --literal <text>\n"
+        "  clipium search --regex <re>\n"
+        "                         Exact or regex search of full text content\n"
+        "  clipium search --stream <q>\n"
+        "                         Print interim results as they are found\n"
+        "                         (content only in the last one)\n"
+        "  clipium get <id>       Fetch entry by ID\n"
         "  clipium delete <id>    Delete entry by ID\n"
         "  clipium clear          Clear all entries\n"
         "  clipium status         Show daemon status\n"
@@ -283,6 +343,8 @@ main(int argc, char **argv)
             return do_list(argc, argv);
         if (g_str_equal(argv[1], "search"))
             return do_search(argc, argv);
+        if (g_str_equal(argv[1], "get"))
+            return do_get(argc, argv);
         if (g_str_equal(argv[1], "delete"))
             return do_delete(argc, argv);
         if (g_str_equal(argv[1], "clear"))
@@ -7,10 +7,33 @@
 #include "clipium-store.h"
 #include "clipium-fuzzy.h"
 #include "clipium-db.h"
+#include "clipium-wheel.h"
+#include "clipium-trigram.h"
 #include "clipium-config.h"
+#include "clipium-query.h"
+#include "clipium-attrs.h"
+#include "clipium-typo.h"
+#include "clipium-grep.h"
+#include "clipium-ipc.h"
 
 /* ======== Store Tests ======== */
 
+/* Hash of a string, for entries and rows built by hand */
+static ClipiumHash
+test_hash(const char *text)
+{
+    ClipiumHash hash;
+    clipium_hash_data(text, strlen(text), &hash);
+    return hash;
+}
+
+static gboolean
+store_has(ClipiumStore *store, guint64 id)
+{
+    g_autoptr(ClipiumEntry) entry = clipium_store_get(store, id);
+    return entry != NULL;
+}
+
 static void
 test_store_new_free(void)
 {
@@ -30,7 +53,7 @@ test_store_add_single(void)
     g_assert_cmpuint(id, >, 0);
     g_assert_cmpuint(clipium_store_count(store), ==, 1);
 
-    ClipiumEntry *entry = clipium_store_get(store, id);
+    g_autoptr(ClipiumEntry) entry = clipium_store_get(store, id);
     g_assert_nonnull(entry);
     g_assert_cmpstr(entry->mime_type, ==, "text/plain");
     g_assert_cmpstr(entry->preview, ==, "hello world");
@@ -119,8 +142,7 @@ test_store_eviction(void)
     g_assert_cmpuint(clipium_store_count(store), ==, 3);
 
     /* id1 should be gone */
-    ClipiumEntry *evicted = clipium_store_get(store, id1);
-    g_assert_null(evicted);
+    g_assert_false(store_has(store, id1));
 
     g_bytes_unref(c1);
     g_bytes_unref(c2);
@@ -149,8 +171,136 @@ test_store_eviction_pinned(void)
     clipium_store_add(store, c4, "text/plain");
     g_assert_cmpuint(clipium_store_count(store), ==, 3);
 
-    g_assert_nonnull(clipium_store_get(store, id1)); /* pinned, still there */
-    g_assert_null(clipium_store_get(store, id2));    /* evicted */
+    g_assert_true(store_has(store, id1));  /* pinned, still there */
+    g_assert_false(store_has(store, id2)); /* evicted */
+
+    g_bytes_unref(c1);
+    g_bytes_unref(c2);
+    g_bytes_unref(c3);
+    g_bytes_unref(c4);
+    clipium_store_free(store);
+}
+
+static void
+test_store_eviction_bytes(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    clipium_store_set_max_bytes(store, 100);
+    g_assert_cmpuint(clipium_store_get_max_bytes(store), ==, 100);
+
+    char big[60], pinned_big[40];
+    memset(big, 'b', sizeof(big));
+    memset(pinned_big, 'p', sizeof(pinned_big));
+    GBytes *cp = g_bytes_new(pinned_big, sizeof(pinned_big));
+    GBytes *cb = g_bytes_new(big, sizeof(big));
+    GBytes *c1 = g_bytes_new_static("small-1", 7);
+    GBytes *c2 = g_bytes_new_static("small-2", 7);
+    GBytes *c3 = g_bytes_new_static("small-3", 7);
+
+    guint64 idp = clipium_store_add(store, cp, "text/plain");
+    clipium_store_pin(store, idp, TRUE);
+    guint64 idb = clipium_store_add(store, cb, "text/plain");
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 40 + 60);
+
+    /* 107 bytes > 100: one entry has to go */
+    guint64 id1 = clipium_store_add(store, c1, "text/plain");
+    g_assert_cmpuint(clipium_store_count(store), ==, 2);
+
+    /* The large unpinned entry went, not the pinned one or the new snippet */
+    g_assert_true(store_has(store, idp));
+    g_assert_false(store_has(store, idb));
+    g_assert_true(store_has(store, id1));
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 40 + 7);
+
+    clipium_store_add(store, c2, "text/plain");
+    clipium_store_add(store, c3, "text/plain");
+    g_assert_cmpuint(clipium_store_count(store), ==, 4);
+    g_assert_cmpuint(clipium_store_bytes(store), <=, 100);
+
+    clipium_store_delete(store, id1);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 40 + 7 + 7);
+    clipium_store_clear(store);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 0);
+
+    g_bytes_unref(cp);
+    g_bytes_unref(cb);
+    g_bytes_unref(c1);
+    g_bytes_unref(c2);
+    g_bytes_unref(c3);
+    clipium_store_free(store);
+}
+
+/* A pinned entry alone over the byte budget, with metadata-only entries
+ * (lazy mode) as the only other candidates: the count cap still holds */
+static void
+test_store_eviction_bytes_pinned_lazy(void)
+{
+    ClipiumStore *store = clipium_store_new(5);
+    clipium_store_set_max_bytes(store, 100);
+
+    ClipiumHash hashes[4];
+    clipium_store_bulk_begin(store, G_N_ELEMENTS(hashes));
+    for (guint i = 0; i < G_N_ELEMENTS(hashes); i++) {
+        g_autofree char *name = g_strdup_printf("lazy %u", i);
+        hashes[i] = test_hash(name);
+        clipium_store_bulk_append(store, 10 - i, NULL, "text/plain", &hashes[i], name,
+                                  100 - i, FALSE, 1000, NULL);
+    }
+    clipium_store_bulk_end(store);
+
+    char screenshot[200];
+    memset(screenshot, 's', sizeof(screenshot));
+    g_autoptr(GBytes) big = g_bytes_new(screenshot, sizeof(screenshot));
+    guint64 pinned = clipium_store_add(store, big, "image/png");
+    clipium_store_pin(store, pinned, TRUE);
+
+    guint64 last = 0;
+    for (guint i = 0; i < 20; i++) {
+        g_autofree char *text = g_strdup_printf("snippet %u", i);
+        g_autoptr(GBytes) content = g_bytes_new(text, strlen(text));
+        last = clipium_store_add(store, content, "text/plain");
+        g_assert_cmpuint(clipium_store_count(store), <=, 5);
+    }
+    g_assert_true(store_has(store, pinned));
+    g_assert_true(store_has(store, last));
+    g_assert_cmpuint(clipium_store_count(store), ==, 5);
+    clipium_store_free(store);
+}
+
+static void
+test_store_eviction_unpinned_order(void)
+{
+    ClipiumStore *store = clipium_store_new(3);
+    GBytes *c1 = g_bytes_new_static("aaa", 3);
+    GBytes *c2 = g_bytes_new_static("bbb", 3);
+    GBytes *c3 = g_bytes_new_static("ccc", 3);
+    GBytes *c4 = g_bytes_new_static("ddd", 3);
+
+    guint64 id1 = clipium_store_add(store, c1, "text/plain");
+    guint64 id2 = clipium_store_add(store, c2, "text/plain");
+    guint64 id3 = clipium_store_add(store, c3, "text/plain");
+
+    /* Pin then unpin the oldest: it must go back to being the next victim */
+    clipium_store_pin(store, id1, TRUE);
+    clipium_store_pin(store, id1, FALSE);
+
+    /* Delete frees a slot that the next add reuses */
+    clipium_store_delete(store, id2);
+    guint64 id4 = clipium_store_add(store, c4, "text/plain");
+    g_assert_cmpuint(clipium_store_count(store), ==, 3);
+
+    clipium_store_add(store, c2, "text/plain");
+    g_assert_cmpuint(clipium_store_count(store), ==, 3);
+    g_assert_false(store_has(store, id1));
+    g_assert_true(store_has(store, id3));
+    g_assert_true(store_has(store, id4));
+
+    GArray *list = clipium_store_list(store, 10, 0);
+    g_assert_cmpuint(list->len, ==, 3);
+    g_assert_cmpstr(g_array_index(list, ClipiumEntry *, 0)->preview, ==, "bbb");
+    g_assert_cmpstr(g_array_index(list, ClipiumEntry *, 1)->preview, ==, "ddd");
+    g_assert_cmpstr(g_array_index(list, ClipiumEntry *, 2)->preview, ==, "ccc");
+    g_array_free(list, TRUE);
 
     g_bytes_unref(c1);
     g_bytes_unref(c2);
@@ -159,6 +309,323 @@ test_store_eviction_pinned(void)
     clipium_store_free(store);
 }
 
+/* A 3-entry store holding "aaa", "bbb", "ccc" (oldest first) */
+static ClipiumStore *
+policy_store_new(ClipiumEvictKind kind, guint64 ids[3])
+{
+    static const char *const texts[] = { "aaa", "bbb", "ccc" };
+    ClipiumStore *store = clipium_store_new(3);
+    clipium_store_set_evict_policy(store, kind);
+    for (guint i = 0; i < 3; i++) {
+        g_autoptr(GBytes) c = g_bytes_new_static(texts[i], 3);
+        ids[i] = clipium_store_add(store, c, "text/plain");
+    }
+    return store;
+}
+
+static guint64
+store_add_text(ClipiumStore *store, const char *text)
+{
+    g_autoptr(GBytes) c = g_bytes_new_static(text, strlen(text));
+    return clipium_store_add(store, c, "text/plain");
+}
+
+static void
+test_store_eviction_fifo(void)
+{
+    guint64 ids[3];
+    ClipiumStore *store = policy_store_new(CLIPIUM_EVICT_FIFO, ids);
+
+    /* Pastes do not count under FIFO: the oldest copy still goes */
+    clipium_store_touch(store, ids[0]);
+    guint64 idd = store_add_text(store, "ddd");
+    g_assert_false(store_has(store, ids[0]));
+
+    /* A re-copy does refresh its position */
+    g_assert_cmpuint(store_add_text(store, "bbb"), ==, 0);
+    store_add_text(store, "eee");
+    g_assert_true(store_has(store, ids[1]));
+    g_assert_false(store_has(store, ids[2]));
+    g_assert_true(store_has(store, idd));
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_eviction_lru(void)
+{
+    guint64 ids[3];
+    ClipiumStore *store = policy_store_new(CLIPIUM_EVICT_LRU, ids);
+
+    /* Pasting the oldest entry keeps it; the least recently used goes */
+    clipium_store_touch(store, ids[0]);
+    guint64 idd = store_add_text(store, "ddd");
+    g_assert_cmpuint(clipium_store_count(store), ==, 3);
+    g_assert_true(store_has(store, ids[0]));
+    g_assert_false(store_has(store, ids[1]));
+    g_assert_true(store_has(store, ids[2]));
+    g_assert_true(store_has(store, idd));
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_eviction_lfu(void)
+{
+    guint64 ids[3];
+    ClipiumStore *store = policy_store_new(CLIPIUM_EVICT_LRU, ids);
+
+    /* Gather statistics first, then switch: the new policy inherits them */
+    clipium_store_touch(store, ids[0]);
+    clipium_store_touch(store, ids[0]);
+    clipium_store_touch(store, ids[1]);
+    clipium_store_set_evict_policy(store, CLIPIUM_EVICT_LFU);
+    g_assert_cmpint(clipium_store_get_evict_policy(store), ==, CLIPIUM_EVICT_LFU);
+
+    /* "ccc" was never used after being copied */
+    guint64 idd = store_add_text(store, "ddd");
+    g_assert_false(store_has(store, ids[2]));
+
+    /* Between two one-off copies the older one goes, never the new one */
+    guint64 ide = store_add_text(store, "eee");
+    g_assert_false(store_has(store, idd));
+    g_assert_true(store_has(store, ids[0]));
+    g_assert_true(store_has(store, ids[1]));
+    g_assert_true(store_has(store, ide));
+
+    /* Once used, the new entry outranks "bbb" (one use, older) */
+    clipium_store_touch(store, ide);
+    clipium_store_touch(store, ide);
+    store_add_text(store, "fff");
+    g_assert_false(store_has(store, ids[1]));
+    g_assert_true(store_has(store, ids[0]));
+    g_assert_true(store_has(store, ide));
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_eviction_arc(void)
+{
+    guint64 ids[3];
+    ClipiumStore *store = policy_store_new(CLIPIUM_EVICT_ARC, ids);
+
+    /* A burst of one-off copies must not flush an entry that was reused,
+     * even though it is the least recently used one */
+    clipium_store_touch(store, ids[0]);
+    guint64 idd = store_add_text(store, "ddd");
+    guint64 ide = store_add_text(store, "eee");
+    g_assert_true(store_has(store, ids[0]));
+    g_assert_false(store_has(store, ids[1]));
+    g_assert_false(store_has(store, ids[2]));
+
+    /* Re-copying a recently evicted entry is a ghost hit: it comes back as
+     * frequently used and the one-off copies make room */
+    guint64 idb = store_add_text(store, "bbb");
+    g_assert_cmpuint(idb, !=, 0);
+    g_assert_cmpuint(clipium_store_count(store), ==, 3);
+    g_assert_true(store_has(store, ids[0]));
+    g_assert_true(store_has(store, idb));
+    g_assert_false(store_has(store, idd));
+    g_assert_true(store_has(store, ide));
+
+    store_add_text(store, "fff");
+    g_assert_true(store_has(store, ids[0]));
+    g_assert_true(store_has(store, idb));
+    g_assert_false(store_has(store, ide));
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_access_stats(void)
+{
+    ClipiumStore *store = clipium_store_new(10);
+    guint64 id = store_add_text(store, "hello");
+    ClipiumUsage usage = { .hits = 99 };
+
+    g_assert_true(clipium_store_get_usage(store, id, &usage));
+    g_assert_cmpuint(usage.hits, ==, 0);
+    g_assert_cmpint(usage.last_used, >, 0);
+    gint64 added = usage.last_used;
+    double copied = usage.frecency;
+
+    /* Pastes/fetches and re-copies both count */
+    g_assert_true(clipium_store_touch(store, id));
+    store_add_text(store, "hello");
+    g_assert_true(clipium_store_get_usage(store, id, &usage));
+    g_assert_cmpuint(usage.hits, ==, 2);
+    g_assert_cmpint(usage.last_used, >=, added);
+    g_assert_cmpfloat(usage.frecency, >, copied);
+
+    /* Statistics survive pinning and policy changes */
+    clipium_store_pin(store, id, TRUE);
+    g_assert_true(clipium_store_touch(store, id));
+    clipium_store_pin(store, id, FALSE);
+    clipium_store_set_evict_policy(store, CLIPIUM_EVICT_ARC);
+    g_assert_true(clipium_store_get_usage(store, id, &usage));
+    g_assert_cmpuint(usage.hits, ==, 3);
+
+    g_assert_false(clipium_store_touch(store, 12345));
+    g_assert_false(clipium_store_get_usage(store, 12345, NULL));
+
+    ClipiumEvictKind kind;
+    g_assert_true(clipium_evict_kind_from_string("LFU", &kind));
+    g_assert_cmpint(kind, ==, CLIPIUM_EVICT_LFU);
+    g_assert_cmpstr(clipium_evict_kind_to_string(CLIPIUM_EVICT_ARC), ==, "arc");
+    g_assert_false(clipium_evict_kind_from_string("mru", &kind));
+
+    clipium_store_free(store);
+}
+
+/* Loader for /store/lazy-content: serves "content-<id>" and counts calls */
+static GBytes *
+test_content_loader(guint64 id, gpointer user_data)
+{
+    guint *calls = user_data;
+    (*calls)++;
+    g_autofree char *text = g_strdup_printf("content-%" G_GUINT64_FORMAT, id);
+    gsize len = strlen(text);
+    return g_bytes_new_take(g_steal_pointer(&text), len);
+}
+
+static void
+test_store_lazy_content(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    guint calls = 0;
+    clipium_store_set_content_loader(store, test_content_loader, &calls);
+    clipium_store_set_content_cache_size(store, 20);
+
+    /* Metadata-only rows, as clipium_db_load_metadata produces them */
+    ClipiumHash h1 = test_hash("h1"), h2 = test_hash("h2"), h3 = test_hash("h3");
+    clipium_store_bulk_begin(store, 3);
+    clipium_store_bulk_append(store, 3, NULL, "text/plain", &h3, "three", 30, FALSE, 9, NULL);
+    clipium_store_bulk_append(store, 2, NULL, "text/plain", &h2, "two", 20, FALSE, 9, NULL);
+    clipium_store_bulk_append(store, 1, NULL, "text/plain", &h1, "one", 10, FALSE, 9, NULL);
+    clipium_store_bulk_end(store);
+    g_assert_cmpuint(clipium_store_count(store), ==, 3);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 0);
+
+    g_autoptr(ClipiumEntry) e1 = clipium_store_get(store, 1);
+    g_assert_null(e1->content);
+    g_autoptr(GBytes) c1 = clipium_store_get_content(store, e1);
+    g_assert_nonnull(c1);
+    g_assert_cmpmem(g_bytes_get_data(c1, NULL), g_bytes_get_size(c1), "content-1", 9);
+    g_assert_cmpuint(calls, ==, 1);
+
+    /* Second read is served from the cache */
+    g_autoptr(GBytes) c1_again = clipium_store_get_content(store, e1);
+    g_assert_cmpuint(calls, ==, 1);
+
+    /* The 20-byte cache holds two 9-byte blobs: a third pushes out the LRU one */
+    g_autoptr(ClipiumEntry) e2 = clipium_store_get(store, 2);
+    g_autoptr(ClipiumEntry) e3 = clipium_store_get(store, 3);
+    g_autoptr(GBytes) c2 = clipium_store_get_content(store, e2);
+    g_autoptr(GBytes) c3 = clipium_store_get_content(store, e3);
+    ClipiumContentStats stats;
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.cache_bytes, ==, 18);
+    g_assert_cmpuint(stats.cache_hits, ==, 1);
+    g_assert_cmpuint(stats.cache_misses, ==, 3);
+
+    g_autoptr(GBytes) c1_reload = clipium_store_get_content(store, e1);
+    g_assert_cmpuint(calls, ==, 4);
+
+    /* Deleting an entry drops its cached content */
+    clipium_store_delete(store, 1);
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.cache_bytes, ==, 9);
+
+    /* Entries added at runtime keep their content inline */
+    GBytes *fresh = g_bytes_new_static("fresh", 5);
+    guint64 id = clipium_store_add(store, fresh, "text/plain");
+    g_autoptr(ClipiumEntry) e = clipium_store_get(store, id);
+    g_autoptr(GBytes) c = clipium_store_get_content(store, e);
+    g_assert_true(c == fresh);
+    g_assert_cmpuint(calls, ==, 4);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 5);
+    g_bytes_unref(fresh);
+
+    clipium_store_clear(store);
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.cache_bytes, ==, 0);
+    clipium_store_free(store);
+}
+
+static void
+test_store_compression(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+
+    /* 64 KB of repetitive log text compresses well */
+    GString *log = g_string_new(NULL);
+    for (guint i = 0; log->len < 64 * 1024; i++)
+        g_string_append_printf(log, "2024-01-01 12:00:%02u INFO request handled in %u ms\n", i % 60, i % 97);
+    gsize log_len = log->len;
+    GBytes *big = g_bytes_new_take(g_string_free(log, FALSE), log_len);
+
+    /* Random bytes do not, and a PNG is never attempted */
+    GRand *rand = g_rand_new_with_seed(42);
+    guint8 *noise = g_malloc(32 * 1024);
+    for (guint i = 0; i < 32 * 1024; i++)
+        noise[i] = (guint8)g_rand_int_range(rand, 0, 256);
+    g_rand_free(rand);
+    GBytes *random = g_bytes_new_take(noise, 32 * 1024);
+    GBytes *png = g_bytes_new_take(g_malloc0(8 * 1024), 8 * 1024);
+    GBytes *small = g_bytes_new_static("short text", 10);
+
+    guint64 id_big = clipium_store_add(store, big, "text/plain");
+    guint64 id_random = clipium_store_add(store, random, "text/plain");
+    guint64 id_png = clipium_store_add(store, png, "image/png");
+    clipium_store_add(store, small, "text/plain");
+    gsize before = clipium_store_bytes(store);
+
+    /* Nothing is idle for an hour yet */
+    g_assert_cmpuint(clipium_store_compress_cold(store, 1024, (gint64)3600 * G_USEC_PER_SEC), ==, 0);
+
+    g_assert_cmpuint(clipium_store_compress_cold(store, 1024, 0), ==, 1);
+    g_autoptr(ClipiumEntry) e = clipium_store_get(store, id_big);
+    g_assert_null(e->content);
+    g_assert_nonnull(e->compressed);
+    g_assert_cmpuint(e->size, ==, log_len);
+
+    ClipiumContentStats stats;
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.compressed_entries, ==, 1);
+    g_assert_cmpuint(stats.compressed_saved, >, log_len / 2);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, before - stats.compressed_saved);
+
+    /* The random entry is remembered as incompressible */
+    g_autoptr(ClipiumEntry) r = clipium_store_get(store, id_random);
+    g_assert_nonnull(r->content);
+    g_assert_cmpuint(clipium_store_compress_cold(store, 1024, 0), ==, 0);
+    g_autoptr(ClipiumEntry) p = clipium_store_get(store, id_png);
+    g_assert_nonnull(p->content);
+
+    /* Reads decompress once, then hit the content cache */
+    g_autoptr(GBytes) out = clipium_store_get_content(store, e);
+    g_assert_true(g_bytes_equal(out, big));
+    g_autoptr(GBytes) again = clipium_store_get_content(store, e);
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.decompressions, ==, 1);
+    g_assert_cmpuint(stats.cache_hits, ==, 1);
+
+    /* Deleting a compressed entry gives its accounting back */
+    clipium_store_delete(store, id_big);
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.compressed_entries, ==, 0);
+    g_assert_cmpuint(stats.compressed_saved, ==, 0);
+    g_assert_cmpuint(stats.cache_bytes, ==, 0);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 32 * 1024 + 8 * 1024 + 10);
+
+    g_bytes_unref(big);
+    g_bytes_unref(random);
+    g_bytes_unref(png);
+    g_bytes_unref(small);
+    clipium_store_free(store);
+}
+
 static void
 test_store_delete(void)
 {
@@ -211,13 +678,18 @@ test_store_pin(void)
 
     gboolean ok = clipium_store_pin(store, id, TRUE);
     g_assert_true(ok);
+    /* Entries are immutable: the old reference keeps its old state */
+    g_assert_false(entry->pinned);
+    clipium_entry_unref(entry);
     entry = clipium_store_get(store, id);
     g_assert_true(entry->pinned);
+    clipium_entry_unref(entry);
 
     ok = clipium_store_pin(store, id, FALSE);
     g_assert_true(ok);
     entry = clipium_store_get(store, id);
     g_assert_false(entry->pinned);
+    clipium_entry_unref(entry);
 
     /* Pin non-existent */
     ok = clipium_store_pin(store, 9999, TRUE);
@@ -283,173 +755,1784 @@ test_store_search(void)
     clipium_store_free(store);
 }
 
-static void
-test_store_dedup_bumps_to_top(void)
+/* Number of results for `query`; `stats` may be NULL */
+static guint
+search_count_stats(ClipiumStore *store, const char *query, ClipiumSearchStats *stats)
 {
-    ClipiumStore *store = clipium_store_new(100);
-    GBytes *c1 = g_bytes_new_static("aaa", 3);
-    GBytes *c2 = g_bytes_new_static("bbb", 3);
-
-    guint64 id1 = clipium_store_add(store, c1, "text/plain");
-    clipium_store_add(store, c2, "text/plain");
-    (void)id1;
-
-    /* Re-add c1 — should dedup but bump to top */
-    clipium_store_add(store, c1, "text/plain");
-
-    GArray *list = clipium_store_list(store, 10, 0);
-    g_assert_cmpuint(list->len, ==, 2);
-    /* First entry should have "aaa" preview (bumped to top) */
-    ClipiumEntry *top = g_array_index(list, ClipiumEntry *, 0);
-    g_assert_cmpstr(top->preview, ==, "aaa");
-    g_array_free(list, TRUE);
-
-    g_bytes_unref(c1);
-    g_bytes_unref(c2);
-    clipium_store_free(store);
+    ClipiumSearchMode mode;
+    g_autofree char *pattern = clipium_search_mode_split(query, &mode);
+    GArray *results = clipium_store_search_mode(store, pattern, mode, 1000, stats, NULL);
+    guint n = results ? results->len : 0;
+    if (results)
+        g_array_free(results, TRUE);
+    return n;
 }
 
-/* ======== Entry Helper Tests ======== */
-
-static void
-test_entry_compute_hash(void)
+static guint
+search_count(ClipiumStore *store, const char *query)
 {
-    GBytes *content = g_bytes_new_static("test", 4);
-    char *hash = clipium_entry_compute_hash(content);
-    g_assert_nonnull(hash);
-    /* SHA-256 hex is 64 chars */
-    g_assert_cmpuint(strlen(hash), ==, 64);
-
-    /* Same content produces same hash */
-    char *hash2 = clipium_entry_compute_hash(content);
-    g_assert_cmpstr(hash, ==, hash2);
-
-    g_free(hash);
-    g_free(hash2);
-    g_bytes_unref(content);
+    return search_count_stats(store, query, NULL);
 }
 
 static void
-test_entry_compute_hash_deterministic(void)
+test_store_search_narrowing(void)
 {
-    GBytes *c1 = g_bytes_new_static("hello", 5);
-    GBytes *c2 = g_bytes_new_static("hello", 5);
-    GBytes *c3 = g_bytes_new_static("world", 5);
-
-    char *h1 = clipium_entry_compute_hash(c1);
-    char *h2 = clipium_entry_compute_hash(c2);
-    char *h3 = clipium_entry_compute_hash(c3);
+    ClipiumStore *store = clipium_store_new(1000);
+    ClipiumSearchStats stats;
+    for (int i = 0; i < 60; i++) {
+        g_autofree char *text = g_strdup_printf(i < 40 ? "alpha %d" : "beta %d", i);
+        store_add_text(store, text);
+    }
 
-    g_assert_cmpstr(h1, ==, h2);
-    g_assert_cmpstr(h1, !=, h3);
+    g_assert_cmpuint(search_count_stats(store, "l", &stats), ==, 40);
+    g_assert_cmpuint(stats.scanned, ==, 60);
+
+    /* Typing further only re-scores the previous matches */
+    g_assert_cmpuint(search_count_stats(store, "lp", &stats), ==, 40);
+    g_assert_cmpuint(stats.scanned, ==, 40);
+    g_assert_cmpuint(search_count_stats(store, "LP1", &stats), ==, 13);
+    g_assert_cmpuint(stats.scanned, ==, 40);
+    g_assert_cmpuint(search_count_stats(store, "Lp 1", &stats), ==, 13);
+    g_assert_cmpuint(stats.scanned, ==, 13);
+
+    /* Inserting in the middle still refines; starting over does not */
+    g_assert_cmpuint(search_count_stats(store, "lph 1", &stats), ==, 13);
+    g_assert_cmpuint(stats.scanned, ==, 13);
+    g_assert_cmpuint(search_count_stats(store, "b", &stats), ==, 20);
+    g_assert_cmpuint(stats.scanned, ==, 60);
+
+    /* Adding an entry invalidates the previous matches */
+    g_assert_cmpuint(search_count(store, "e"), ==, 20);
+    store_add_text(store, "entry");
+    g_assert_cmpuint(search_count_stats(store, "en", &stats), ==, 1);
+    g_assert_cmpuint(stats.scanned, ==, 61);
+
+    /* So does removing one */
+    g_assert_cmpuint(search_count(store, "a"), ==, 60);
+    GArray *all = clipium_store_search(store, "alpha 39", 1);
+    g_assert_true(clipium_store_delete(store, g_array_index(all, ClipiumEntry *, 0)->id));
+    g_array_free(all, TRUE);
+    g_assert_cmpuint(search_count_stats(store, "a3", &stats), ==, 14);
+    g_assert_cmpuint(stats.scanned, ==, 60);
+    clipium_store_free(store);
 
-    g_free(h1);
-    g_free(h2);
-    g_free(h3);
-    g_bytes_unref(c1);
-    g_bytes_unref(c2);
-    g_bytes_unref(c3);
-}
+    /* Folded keys are compared, as previews are matched: "ßn" keys as
+     * "ssn" and refines "ss", "É" keys as "E" */
+    store = clipium_store_new(100);
+    store_add_text(store, "Hauptstraße 5");
+    store_add_text(store, "Kissen");
+    store_add_text(store, "École");
+    store_add_text(store, "stop");
+    g_assert_cmpuint(search_count_stats(store, "ss", &stats), ==, 2);
+    g_assert_cmpuint(stats.scanned, ==, 4);
+    g_assert_cmpuint(search_count_stats(store, "ßn", &stats), ==, 1);
+    g_assert_cmpuint(stats.scanned, ==, 2);
+    g_assert_cmpuint(search_count_stats(store, "o", &stats), ==, 2);
+    g_assert_cmpuint(stats.scanned, ==, 4);
+    g_assert_cmpuint(search_count_stats(store, "Éo", &stats), ==, 1);
+    g_assert_cmpuint(stats.scanned, ==, 2);
 
-static void
-test_entry_make_preview_text(void)
-{
-    GBytes *content = g_bytes_new_static("Hello\nWorld\tFoo", 15);
-    char *preview = clipium_entry_make_preview(content, "text/plain");
-    g_assert_nonnull(preview);
-    /* Newlines and tabs should be replaced with spaces */
-    g_assert_null(strchr(preview, '\n'));
-    g_assert_null(strchr(preview, '\t'));
-    g_assert_true(g_str_has_prefix(preview, "Hello"));
-    g_free(preview);
-    g_bytes_unref(content);
+    clipium_store_free(store);
 }
 
 static void
-test_entry_make_preview_binary(void)
+test_store_search_parallel(void)
 {
-    GBytes *content = g_bytes_new_static("\x89PNG\r\n\x1a\n", 8);
-    char *preview = clipium_entry_make_preview(content, "image/png");
-    g_assert_nonnull(preview);
-    /* Should show format like "[image/png 8B]" */
-    g_assert_true(g_str_has_prefix(preview, "[image/png"));
-    g_free(preview);
-    g_bytes_unref(content);
+    const guint n = 30000;
+    ClipiumStore *store = clipium_store_new(n);
+    ClipiumSearchStats stats;
+    GRand *rand = g_rand_new_with_seed(99);
+    static const char *words[] = { "config", "json", "path", "deploy", "cargo",
+                                   "build", "main", "README", "src", "test" };
+    /* Newest first, as the bulk loader expects */
+    clipium_store_bulk_begin(store, n);
+    for (guint i = n; i > 0; i--) {
+        g_autofree char *text = g_strdup_printf("%s/%s %u",
+            words[g_rand_int_range(rand, 0, G_N_ELEMENTS(words))],
+            words[g_rand_int_range(rand, 0, G_N_ELEMENTS(words))], i);
+        ClipiumHash hash = test_hash(text);
+        clipium_store_bulk_append(store, i, NULL, "text/plain", &hash, text,
+                                  (gint64)i, FALSE, strlen(text), NULL);
+    }
+    clipium_store_bulk_end(store);
+
+    static const char *queries[] = { "cj", "dpl", "rdm 1", "src/main", "zz", "tb 29" };
+    double serial_s = 0, parallel_s = 0;
+    for (guint q = 0; q < G_N_ELEMENTS(queries); q++) {
+        /* Bypass the result cache, and search for something unrelated
+         * first so each search scans everything */
+        store->search_parallel_min = G_MAXUINT;
+        store->search_cache_generation = -1;
+        g_array_free(clipium_store_search(store, "#", 1), TRUE);
+        g_test_timer_start();
+        GArray *serial = clipium_store_search(store, queries[q], 50);
+        serial_s += g_test_timer_elapsed();
+
+        store->search_parallel_min = 1000;
+        store->search_cache_generation = -1;
+        g_array_free(clipium_store_search(store, "#", 1), TRUE);
+        g_test_timer_start();
+        GArray *parallel = clipium_store_search_mode(store, queries[q], CLIPIUM_SEARCH_FUZZY,
+                                                     50, &stats, NULL);
+        parallel_s += g_test_timer_elapsed();
+        g_assert_cmpuint(stats.scanned, ==, n);
+
+        /* Per-chunk top-K merges to the same ranking */
+        g_assert_cmpuint(parallel->len, ==, serial->len);
+        for (guint i = 0; i < serial->len; i++)
+            g_assert_cmpuint(g_array_index(parallel, ClipiumEntry *, i)->id,
+                             ==, g_array_index(serial, ClipiumEntry *, i)->id);
+        g_array_free(serial, TRUE);
+        g_array_free(parallel, TRUE);
+    }
+    g_test_message("search over %u previews: serial %.2f ms, parallel %.2f ms on %u cpus",
+                   n, serial_s * 1000.0 / G_N_ELEMENTS(queries),
+                   parallel_s * 1000.0 / G_N_ELEMENTS(queries), g_get_num_processors());
+
+    /* Refining a query narrows the parallel scan too */
+    g_assert_cmpuint(search_count_stats(store, "de", &stats), >, 0);
+    guint matched = stats.scanned;
+    GArray *narrowed = clipium_store_search_mode(store, "dep", CLIPIUM_SEARCH_FUZZY, 1000000,
+                                                 &stats, NULL);
+    g_assert_cmpuint(stats.scanned, <, matched);
+    store->search_cache_generation = -1;
+    g_array_free(clipium_store_search(store, "#", 1), TRUE);
+    GArray *full = clipium_store_search_mode(store, "dep", CLIPIUM_SEARCH_FUZZY, 1000000,
+                                             &stats, NULL);
+    g_assert_cmpuint(stats.scanned, ==, n);
+    g_assert_cmpuint(narrowed->len, ==, full->len);
+    g_array_free(narrowed, TRUE);
+    g_array_free(full, TRUE);
+
+    g_rand_free(rand);
+    clipium_store_free(store);
 }
 
 static void
-test_entry_make_preview_truncates(void)
+test_store_search_top_k(void)
 {
-    /* Create a long text */
-    GString *long_text = g_string_new(NULL);
-    for (int i = 0; i < 200; i++)
-        g_string_append_c(long_text, 'A');
+    ClipiumStore *store = clipium_store_new(2000);
+    GRand *rand = g_rand_new_with_seed(5);
+    for (guint i = 0; i < 1500; i++) {
+        GString *text = g_string_new(NULL);
+        guint len = (guint)g_rand_int_range(rand, 4, 30);
+        while (text->len < len)
+            g_string_append_c(text, "abcde _/X"[g_rand_int_range(rand, 0, 9)]);
+        g_string_append_printf(text, " %u", i);
+        store_add_text(store, text->str);
+        g_string_free(text, TRUE);
+    }
 
-    GBytes *content = g_bytes_new(long_text->str, long_text->len);
-    char *preview = clipium_entry_make_preview(content, "text/plain");
-    g_assert_nonnull(preview);
-    /* Preview should be truncated to ~CLIPIUM_PREVIEW_LEN + ellipsis */
-    g_assert_true(strlen(preview) <= CLIPIUM_PREVIEW_LEN + 4);
-    g_assert_true(g_str_has_suffix(preview, "\xe2\x80\xa6")); /* UTF-8 ellipsis */
+    /* Any limit gives a prefix of the full ranking (two-byte queries rank
+     * every preview; longer ones may stop at enough index hits) */
+    static const char *queries[] = { "ab", "_c", "xe", "dd", "e/" };
+    for (guint q = 0; q < G_N_ELEMENTS(queries); q++) {
+        GArray *all = clipium_store_search(store, queries[q], G_MAXUINT);
+        g_assert_cmpuint(all->len, >, 10);
+        static const guint limits[] = { 0, 1, 7, 50 };
+        for (guint l = 0; l < G_N_ELEMENTS(limits); l++) {
+            GArray *top = clipium_store_search(store, queries[q], limits[l]);
+            g_assert_cmpuint(top->len, ==, MIN(limits[l], all->len));
+            for (guint i = 0; i < top->len; i++)
+                g_assert_true(g_array_index(top, ClipiumEntry *, i) ==
+                              g_array_index(all, ClipiumEntry *, i));
+            g_array_free(top, TRUE);
+        }
+        g_array_free(all, TRUE);
+    }
 
-    g_free(preview);
-    g_bytes_unref(content);
-    g_string_free(long_text, TRUE);
+    g_rand_free(rand);
+    clipium_store_free(store);
 }
 
 static void
-test_entry_make_preview_trailing_whitespace(void)
+test_store_search_cache(void)
 {
-    GBytes *content = g_bytes_new_static("hello   \n\n\n", 11);
-    char *preview = clipium_entry_make_preview(content, "text/plain");
-    g_assert_nonnull(preview);
-    /* Trailing whitespace should be trimmed */
-    g_assert_false(g_str_has_suffix(preview, " "));
-    g_free(preview);
-    g_bytes_unref(content);
-}
-
-/* ======== Fuzzy Match Tests ======== */
+    ClipiumStore *store = clipium_store_new(100);
+    store_add_text(store, "hello world");
+    store_add_text(store, "help me");
+
+    g_assert_cmpuint(search_count(store, "hel"), ==, 2);
+    guint64 hits = store->search_cache_hits;
+
+    /* Same query and limit: served from the cache without scoring */
+    ClipiumSearchStats stats;
+    g_assert_cmpuint(search_count_stats(store, "hel", &stats), ==, 2);
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 1);
+    g_assert_cmpuint(stats.scanned, ==, 0);
+
+    /* Another limit is another result */
+    GArray *one = clipium_store_search(store, "hel", 1);
+    g_assert_cmpuint(one->len, ==, 1);
+    g_array_free(one, TRUE);
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 1);
+
+    /* Any change to the store invalidates it */
+    store_add_text(store, "shell");
+    g_assert_cmpuint(search_count(store, "hel"), ==, 3);
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 1);
+    g_assert_cmpuint(search_count(store, "hel"), ==, 3);
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 2);
+
+    /* Bounded: the least recently used results go first */
+    for (guint i = 0; i < CLIPIUM_SEARCH_CACHE_SIZE; i++) {
+        g_autofree char *query = g_strdup_printf("q%u", i);
+        search_count(store, query);
+    }
+    g_assert_cmpuint(store->search_lru.length, ==, CLIPIUM_SEARCH_CACHE_SIZE);
+    search_count(store, "hel");
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 2);
 
-static void
-test_fuzzy_match_exact(void)
-{
-    int score = clipium_fuzzy_match("hello", "hello");
-    g_assert_cmpint(score, >, 0);
+    clipium_store_free(store);
 }
 
+/* Highlighting: the bytes of the preview a query lines up with */
 static void
-test_fuzzy_match_substring(void)
+assert_match_positions(ClipiumStore *store, guint64 id, const char *query,
+                       const guint *expected, guint n_expected)
 {
-    int score = clipium_fuzzy_match("hlo", "hello");
-    g_assert_cmpint(score, >, 0);
+    g_autoptr(ClipiumEntry) e = clipium_store_get(store, id);
+    g_autoptr(GArray) positions = g_array_new(FALSE, FALSE, sizeof(guint));
+    g_assert_cmpint(clipium_store_match_positions(store, query, e, positions), ==, n_expected > 0);
+    g_assert_cmpuint(positions->len, ==, n_expected);
+    for (guint i = 0; i < n_expected; i++)
+        g_assert_cmpuint(g_array_index(positions, guint, i), ==, expected[i]);
 }
 
 static void
-test_fuzzy_match_no_match(void)
+test_store_match_positions(void)
 {
-    int score = clipium_fuzzy_match("xyz", "hello");
-    g_assert_cmpint(score, ==, -1);
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 hello = store_add_text(store, "hello world");
+    guint64 street = store_add_text(store, "Hauptstraße 5");
+
+    static const guint world[] = { 6, 7, 8, 9, 10 };
+    assert_match_positions(store, hello, "world", world, G_N_ELEMENTS(world));
+    static const guint ll[] = { 2, 3 };
+    assert_match_positions(store, hello, "\"ll\"", ll, G_N_ELEMENTS(ll));
+    static const guint lo[] = { 2, 3, 4 };
+    assert_match_positions(store, hello, "re:l+o", lo, G_N_ELEMENTS(lo));
+    assert_match_positions(store, hello, "xyz", NULL, 0);
+    assert_match_positions(store, hello, "re:(", NULL, 0);
+
+    /* Folded keys map back to the preview: both s of "ss" are the ß */
+    static const guint strasse[] = { 5, 6, 7, 8, 9, 11 };
+    assert_match_positions(store, street, "strasse", strasse, G_N_ELEMENTS(strasse));
+
+    clipium_store_free(store);
 }
 
+/* A use only moves the frecency: the published snapshot and cached results
+ * stay, and the next scan still sees the new ranking */
 static void
-test_fuzzy_match_case_insensitive(void)
+test_store_touch_generation(void)
 {
-    int score = clipium_fuzzy_match("HELLO", "hello world");
-    g_assert_cmpint(score, >, 0);
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 older = store_add_text(store, "alpha one");
+    guint64 newer = store_add_text(store, "alpha two");
+
+    GArray *result = clipium_store_search(store, "alpha", 2);
+    g_assert_cmpuint(g_array_index(result, ClipiumEntry *, 0)->id, ==, newer);
+    g_array_free(result, TRUE);
+    g_autoptr(ClipiumSnapshot) before = clipium_store_snapshot(store);
+    gint generation = g_atomic_int_get(&store->generation);
+    guint64 hits = store->search_cache_hits;
+
+    for (guint i = 0; i < 4; i++)
+        g_assert_true(clipium_store_touch(store, older));
+    g_assert_cmpint(g_atomic_int_get(&store->generation), ==, generation);
+    g_autoptr(ClipiumSnapshot) after = clipium_store_snapshot(store);
+    g_assert_true(after == before);
+
+    /* Cached: still the ranking it was found with */
+    result = clipium_store_search(store, "alpha", 2);
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 1);
+    g_assert_cmpuint(g_array_index(result, ClipiumEntry *, 0)->id, ==, newer);
+    g_array_free(result, TRUE);
+
+    /* A fresh scan of the same snapshot ranks the used entry first */
+    result = clipium_store_search(store, "alpha", 1);
+    g_assert_cmpuint(store->search_cache_hits, ==, hits + 1);
+    g_assert_cmpuint(g_array_index(result, ClipiumEntry *, 0)->id, ==, older);
+    g_array_free(result, TRUE);
+
+    clipium_store_free(store);
 }
 
 static void
-test_fuzzy_match_empty_query(void)
+test_store_search_unicode(void)
 {
-    int score = clipium_fuzzy_match("", "hello");
-    g_assert_cmpint(score, ==, 0);
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 street = store_add_text(store, "Hauptstraße 5");
+    guint64 school = store_add_text(store, "École normale");
+    store_add_text(store, "plain text");
+
+    static const struct { const char *query; guint64 id; } cases[] = {
+        { "strasse", 0 }, { "STRASSE", 0 }, { "straße", 0 },
+        { "ecole", 1 }, { "école", 1 }, { "ÉCOLE", 1 }, { "En", 1 },
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++) {
+        GArray *results = clipium_store_search(store, cases[i].query, 10);
+        g_assert_cmpuint(results->len, ==, 1);
+        g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id,
+                         ==, cases[i].id ? school : street);
+        g_array_free(results, TRUE);
+    }
+
+    /* ASCII previews are their own key; others keep a folded copy */
+    ClipiumEntry *e = clipium_store_get(store, street);
+    g_assert_cmpstr(e->search_key, ==, "Hauptstrasse 5");
+    clipium_entry_unref(e);
+    clipium_store_pin(store, street, TRUE);
+    e = clipium_store_get(store, street);
+    g_assert_cmpstr(e->search_key, ==, "Hauptstrasse 5");
+    clipium_entry_unref(e);
+    GArray *plain = clipium_store_search(store, "plain", 1);
+    e = g_array_index(plain, ClipiumEntry *, 0);
+    g_assert_true(e->search_key == e->preview);
+    g_array_free(plain, TRUE);
+
+    clipium_store_free(store);
 }
 
 static void
-test_fuzzy_match_empty_target(void)
+test_store_search_filters(void)
 {
-    int score = clipium_fuzzy_match("hello", "");
+    ClipiumStore *store = clipium_store_new(100);
+    gint64 now = g_get_real_time();
+    guint64 note = store_add_text(store, "meeting notes");
+    g_autoptr(GBytes) png = g_bytes_new_static("\x89PNG meeting", 12);
+    guint64 image = clipium_store_add(store, png, "image/png");
+    ClipiumHash hash = test_hash("old");
+    clipium_store_load_entry(store, 500, NULL, "text/plain", &hash, "old meeting",
+                             now - 3 * G_TIME_SPAN_HOUR, FALSE, 4096);
+
+    static const struct { const char *query; guint count; } cases[] = {
+        { "mime:image", 1 },      { "mime:text meeting", 2 }, { "mime:text/plain", 2 },
+        { "since:1h", 2 },        { "since:1h meeting", 1 },  { "since:1d old", 1 },
+        { "size>1k", 1 },         { "size<=1k", 2 },          { "pinned:yes", 0 },
+        { "pinned:no mime:image", 1 }, { "mime:audio", 0 },   { "since:1h old", 0 },
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++) {
+        GArray *results = clipium_store_search(store, cases[i].query, 10);
+        g_assert_cmpuint(results->len, ==, cases[i].count);
+        g_array_free(results, TRUE);
+    }
+
+    /* The indexes follow pins, deletes and clears */
+    clipium_store_pin(store, note, TRUE);
+    GArray *results = clipium_store_search(store, "pinned:yes", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, note);
+    g_array_free(results, TRUE);
+
+    clipium_store_delete(store, image);
+    results = clipium_store_search(store, "mime:image", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    clipium_store_clear(store);
+    results = clipium_store_search(store, "since:1d", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_frecency(void)
+{
+    /* A use counts one now and halves every half-life */
+    gint64 now = g_get_real_time();
+    gint64 half_life = (gint64)CLIPIUM_FRECENCY_HALF_LIFE_S * G_USEC_PER_SEC;
+    double f = clipium_frecency_add(0, now - half_life);
+    g_assert_cmpfloat_with_epsilon(clipium_frecency_value(f, now), 0.5, 1e-6);
+    f = clipium_frecency_add(f, now);
+    g_assert_cmpfloat_with_epsilon(clipium_frecency_value(f, now), 1.5, 1e-6);
+    g_assert_cmpfloat_with_epsilon(clipium_frecency_value(f, now + half_life), 0.75, 1e-6);
+    g_assert_cmpfloat(clipium_frecency_value(0, now), ==, 0);
+
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 one = store_add_text(store, "alpha one");
+    guint64 two = store_add_text(store, "alpha two");
+
+    /* Equal matches: the newer copy wins until the older one is used (a
+     * use keeps cached results, hence another limit) */
+    GArray *results = clipium_store_search(store, "alpha", 10);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, two);
+    g_array_free(results, TRUE);
+    for (guint i = 0; i < 3; i++)
+        clipium_store_touch(store, one);
+    results = clipium_store_search(store, "alpha", 9);
+    g_assert_cmpuint(results->len, ==, 2);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, one);
+    g_array_free(results, TRUE);
+
+    /* The frecent list follows uses, copies and deletes incrementally */
+    guint64 three = store_add_text(store, "three");
+    guint64 order[] = { one, three, two };
+    results = clipium_store_list_frecent(store, 10);
+    g_assert_cmpuint(results->len, ==, 3);
+    for (guint i = 0; i < results->len; i++)
+        g_assert_cmpuint(g_array_index(results, ClipiumEntry *, i)->id, ==, order[i]);
+    g_array_free(results, TRUE);
+
+    store_add_text(store, "alpha two");
+    clipium_store_touch(store, two);
+    clipium_store_delete(store, one);
+    results = clipium_store_list_frecent(store, 1);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, two);
+    g_array_free(results, TRUE);
+
+    clipium_store_clear(store);
+    results = clipium_store_list_frecent(store, 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_search_typos(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 fox = store_add_text(store, "quick brown fox");
+    guint64 bag = store_add_text(store, "borwn paper bag");
+    store_add_text(store, "unrelated");
+
+    /* Off by default: a transposition finds nothing further */
+    GArray *results = clipium_store_search(store, "qiuck", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    clipium_store_set_typo_edits(store, 2);
+    results = clipium_store_search(store, "qiuck", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, fox);
+    g_array_free(results, TRUE);
+
+    /* Exact fuzzy matches come first, typo matches fill in after them */
+    results = clipium_store_search(store, "borwn", 10);
+    g_assert_cmpuint(results->len, ==, 2);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, bag);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 1)->id, ==, fox);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "borwn", 1);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, bag);
+    g_array_free(results, TRUE);
+
+    /* Every query word has to be close to some word of the entry */
+    results = clipium_store_search(store, "qiuck fxo", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "qiuck zebra", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    clipium_store_delete(store, fox);
+    results = clipium_store_search(store, "qiuck", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    clipium_store_free(store);
+}
+
+static void
+test_store_search_exact(void)
+{
+    ClipiumStore *store = clipium_store_new(1000);
+    GString *log = g_string_new("build log\n");
+    for (int i = 0; i < 200; i++)
+        g_string_append_printf(log, "step %d ok\n", i);
+    g_string_append(log, "error E4012 from 10.0.0.12\n");
+    GBytes *c = g_bytes_new(log->str, log->len);
+    guint64 log_id = clipium_store_add(store, c, "text/plain");
+    g_bytes_unref(c);
+    g_string_free(log, TRUE);
+    c = g_bytes_new_static("E4012 192.168.1.20", 18);
+    clipium_store_add(store, c, "image/png");
+    g_bytes_unref(c);
+    guint64 ip_id = store_add_text(store, "ssh 192.168.1.20");
+
+    /* Literals are case-sensitive and look past the preview */
+    GArray *results = clipium_store_search(store, "\"E4012\"", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, log_id);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "\"e4012\"", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    /* Regexes come back newest first */
+    const char *ip = "\\b\\d{1,3}(\\.\\d{1,3}){3}\\b";
+    ClipiumSearchStats stats;
+    results = clipium_store_search_mode(store, ip, CLIPIUM_SEARCH_REGEX, 10, &stats, NULL);
+    g_assert_cmpuint(results->len, ==, 2);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, ip_id);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 1)->id, ==, log_id);
+    g_array_free(results, TRUE);
+    g_assert_false(stats.partial);
+    g_assert_cmpuint(stats.scanned, ==, 3);
+    results = clipium_store_search_mode(store, ip, CLIPIUM_SEARCH_REGEX, 1, NULL, NULL);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, ip_id);
+    g_array_free(results, TRUE);
+    g_assert_cmpuint(clipium_regex_cache_hits(store->regex_cache), ==, 1);
+
+    results = clipium_store_search(store, "re:^error E\\d+", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+
+    /* A pattern that does not compile is an error, or no results */
+    g_autoptr(GError) error = NULL;
+    g_assert_null(clipium_store_search_mode(store, "(", CLIPIUM_SEARCH_REGEX, 10, NULL, &error));
+    g_assert_true(error && error->domain == G_REGEX_ERROR);
+    results = clipium_store_search(store, "re:(", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    /* Enough entries to split the scan; out of time, it says so */
+    for (int i = 0; i < 300; i++) {
+        g_autofree char *text = g_strdup_printf("ticket T-%d", i);
+        GBytes *t = g_bytes_new(text, strlen(text));
+        clipium_store_add(store, t, "text/plain");
+        g_bytes_unref(t);
+    }
+    store->grep_budget = 1;
+    results = clipium_store_search_mode(store, "ticket", CLIPIUM_SEARCH_LITERAL, 1000, &stats, NULL);
+    g_assert_true(stats.partial);
+    g_assert_cmpuint(results->len, <, 300);
+    g_array_free(results, TRUE);
+
+    /* Partial results are not cached */
+    store->grep_budget = 0;
+    results = clipium_store_search_mode(store, "ticket", CLIPIUM_SEARCH_LITERAL, 1000, &stats, NULL);
+    g_assert_false(stats.partial);
+    g_assert_cmpuint(stats.scanned, ==, 303);
+    g_assert_cmpuint(results->len, ==, 300);
+    g_array_free(results, TRUE);
+
+    clipium_store_free(store);
+}
+
+typedef struct {
+    guint               interim;
+    guint               final;
+    ClipiumSearchStage  stage;   /* of the final call */
+    GArray             *result;  /* of the final call */
+    GCancellable       *cancel_on_interim;
+} ProgressLog;
+
+static void
+progress_log_cb(GArray *results, ClipiumSearchStage stage, gpointer user_data)
+{
+    ProgressLog *log = user_data;
+    if (stage == CLIPIUM_SEARCH_INTERIM) {
+        g_assert_cmpuint(log->final, ==, 0);
+        log->interim++;
+        if (log->cancel_on_interim)
+            g_cancellable_cancel(log->cancel_on_interim);
+        g_array_free(results, TRUE);
+        return;
+    }
+    g_assert_cmpuint(log->final, ==, 0);
+    log->final++;
+    log->stage = stage;
+    log->result = results;
+}
+
+static void
+test_store_search_progressive(void)
+{
+    ClipiumStore *store = clipium_store_new(2000);
+    for (int i = 0; i < 1000; i++) {
+        g_autofree char *text = g_strdup_printf("entry %d", i);
+        GBytes *t = g_bytes_new(text, strlen(text));
+        clipium_store_add(store, t, "text/plain");
+        g_bytes_unref(t);
+    }
+    store->search_slice = 100;
+    store->search_first_usec = 0;
+    store->search_refine_usec = 0;
+
+    /* Best-so-far results between slices, then the same final result as a
+     * plain search; too short for the index, so every preview is scanned */
+    ProgressLog log = { 0 };
+    g_assert_true(clipium_store_search_progressive(store, "ey", CLIPIUM_SEARCH_FUZZY, 10, 0,
+                                                   NULL, progress_log_cb, &log, NULL));
+    g_assert_cmpuint(log.interim, ==, 9);
+    g_assert_cmpuint(log.final, ==, 1);
+    g_assert_cmpint(log.stage, ==, CLIPIUM_SEARCH_COMPLETE);
+    GArray *plain = clipium_store_search(store, "ey", 10);
+    g_assert_cmpuint(plain->len, ==, 10);
+    g_assert_cmpuint(log.result->len, ==, plain->len);
+    for (guint i = 0; i < plain->len; i++)
+        g_assert_true(g_array_index(plain, ClipiumEntry *, i) ==
+                      g_array_index(log.result, ClipiumEntry *, i));
+    g_array_free(plain, TRUE);
+    g_clear_pointer(&log.result, g_array_unref);
+
+    /* Out of time: a final result that says so, and is not cached */
+    log = (ProgressLog){ 0 };
+    g_assert_true(clipium_store_search_progressive(store, "ny", CLIPIUM_SEARCH_FUZZY, 5, 1,
+                                                   NULL, progress_log_cb, &log, NULL));
+    g_assert_cmpuint(log.final, ==, 1);
+    g_assert_cmpint(log.stage, ==, CLIPIUM_SEARCH_TIMED_OUT);
+    g_clear_pointer(&log.result, g_array_unref);
+    ClipiumSearchStats stats;
+    plain = clipium_store_search_mode(store, "ny", CLIPIUM_SEARCH_FUZZY, 5, &stats, NULL);
+    g_assert_false(stats.partial);
+    g_assert_cmpuint(stats.scanned, >, 0);
+    g_array_free(plain, TRUE);
+
+    /* Cancelled: no final call */
+    log = (ProgressLog){ 0 };
+    g_autoptr(GCancellable) cancellable = g_cancellable_new();
+    log.cancel_on_interim = cancellable;
+    g_assert_true(clipium_store_search_progressive(store, "e1", CLIPIUM_SEARCH_FUZZY, 10, 0,
+                                                   cancellable, progress_log_cb, &log, NULL));
+    g_assert_cmpuint(log.interim, ==, 1);
+    g_assert_cmpuint(log.final, ==, 0);
+
+    /* Exact modes only make the final call; a bad regex makes none */
+    log = (ProgressLog){ 0 };
+    g_assert_true(clipium_store_search_progressive(store, "entry 99", CLIPIUM_SEARCH_LITERAL, 20, 0,
+                                                   NULL, progress_log_cb, &log, NULL));
+    g_assert_cmpuint(log.interim, ==, 0);
+    g_assert_cmpuint(log.final, ==, 1);
+    g_assert_cmpint(log.stage, ==, CLIPIUM_SEARCH_COMPLETE);
+    g_assert_cmpuint(log.result->len, ==, 11);  /* 99 and 990-999 */
+    g_clear_pointer(&log.result, g_array_unref);
+    log = (ProgressLog){ 0 };
+    g_autoptr(GError) error = NULL;
+    g_assert_false(clipium_store_search_progressive(store, "(", CLIPIUM_SEARCH_REGEX, 10, 0,
+                                                    NULL, progress_log_cb, &log, &error));
+    g_assert_true(error && error->domain == G_REGEX_ERROR);
+    g_assert_cmpuint(log.final, ==, 0);
+
+    clipium_store_free(store);
+}
+
+/* Content "on disk" for metadata-only entries: id → GBytes* */
+static GBytes *
+table_content_loader(guint64 id, gpointer user_data)
+{
+    GBytes *content = g_hash_table_lookup(user_data, GSIZE_TO_POINTER((gsize)id));
+    return content ? g_bytes_ref(content) : NULL;
+}
+
+/* Entries whose text has every trigram of the query, but not the query
+ * itself, are not matches, whether their content is on disk or compressed */
+static void
+test_store_search_full_text_confirm(void)
+{
+    ClipiumStore *store = clipium_store_new(10);
+    g_autoptr(GHashTable) disk = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                       NULL, (GDestroyNotify)g_bytes_unref);
+    clipium_store_set_content_loader(store, table_content_loader, disk);
+
+    static const char *lazy_texts[] = { "notes\nsplit: xabcdx bcdex", "notes\nwhole: abcde" };
+    for (guint i = 0; i < G_N_ELEMENTS(lazy_texts); i++) {
+        guint64 id = 100 + i;
+        ClipiumHash hash = test_hash(lazy_texts[i]);
+        GBytes *content = g_bytes_new_static(lazy_texts[i], strlen(lazy_texts[i]));
+        clipium_store_load_entry(store, id, NULL, "text/plain", &hash, "notes",
+                                 g_get_real_time(), FALSE, g_bytes_get_size(content));
+        g_assert_true(clipium_store_index_content(store, id, content));
+        g_hash_table_insert(disk, GSIZE_TO_POINTER((gsize)id), content);
+    }
+
+    /* Past the preview, and compressible */
+    guint64 compressed[2];
+    for (guint i = 0; i < G_N_ELEMENTS(compressed); i++) {
+        GString *text = g_string_new(NULL);
+        for (guint j = 0; j < 400; j++)
+            g_string_append(text, "zz ");
+        g_string_append(text, i == 0 ? "klmnx lmnop" : "klmnop");
+        g_autoptr(GBytes) content = g_bytes_new_take(text->str, text->len);
+        g_string_free(text, FALSE);
+        compressed[i] = clipium_store_add(store, content, "text/plain");
+    }
+    g_assert_cmpuint(clipium_store_compress_cold(store, 1024, 0), ==, 2);
+
+    GArray *results = clipium_store_search(store, "abcde", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, 101);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "klmnop", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, compressed[1]);
+    g_array_free(results, TRUE);
+
+    /* The filtered path confirms the same way */
+    results = clipium_store_search(store, "mime:text abcde", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+
+    /* Confirming reads around the content cache */
+    ClipiumContentStats stats;
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.cache_bytes, ==, 0);
+    g_assert_cmpuint(stats.cache_hits + stats.cache_misses, ==, 0);
+
+    clipium_store_free(store);
+}
+
+
+typedef struct {
+    GHashTable *disk;   /* id → GBytes* */
+    guint       calls;
+} CountingLoader;
+
+static GBytes *
+counting_content_loader(guint64 id, gpointer user_data)
+{
+    CountingLoader *loader = user_data;
+    loader->calls++;
+    return table_content_loader(id, loader->disk);
+}
+
+/* Full-text hits on content that is not in memory cost a read each:
+ * only those that could still make the result are read, and only so many */
+static void
+test_store_search_confirm_reads(void)
+{
+    ClipiumStore *store = clipium_store_new(1000);
+    g_autoptr(GHashTable) disk = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                       NULL, (GDestroyNotify)g_bytes_unref);
+    CountingLoader loader = { .disk = disk };
+    clipium_store_set_content_loader(store, counting_content_loader, &loader);
+
+    gint64 now = g_get_real_time();
+    for (guint64 id = 1; id <= 400; id++) {
+        /* The first half hold the query, the rest only its trigrams */
+        g_autofree char *text = g_strdup_printf(id <= 200 ? "row %" G_GUINT64_FORMAT "\nwith a needle"
+                                                          : "row %" G_GUINT64_FORMAT "\nxabcdx bcdex",
+                                                id);
+        g_autofree char *preview = g_strdup_printf("row %" G_GUINT64_FORMAT, id);
+        ClipiumHash hash = test_hash(text);
+        GBytes *content = g_bytes_new(text, strlen(text));
+        clipium_store_load_entry(store, id, NULL, "text/plain", &hash, preview,
+                                 now - 1000000 * (gint64)id, FALSE, g_bytes_get_size(content));
+        g_assert_true(clipium_store_index_content(store, id, content));
+        g_hash_table_insert(disk, GSIZE_TO_POINTER((gsize)id), content);
+    }
+
+    /* Every hit confirms, so the best five take five reads */
+    ClipiumSearchStats stats;
+    GArray *results = clipium_store_search_mode(store, "needle", CLIPIUM_SEARCH_FUZZY, 5,
+                                                &stats, NULL);
+    g_assert_cmpuint(results->len, ==, 5);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, 1);
+    g_assert_cmpuint(loader.calls, ==, 5);
+    g_assert_false(stats.partial);
+    g_array_free(results, TRUE);
+
+    /* None confirm: reading stops at the cap, and the result says so */
+    loader.calls = 0;
+    results = clipium_store_search_mode(store, "abcde", CLIPIUM_SEARCH_FUZZY, 5, &stats, NULL);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_assert_cmpuint(loader.calls, ==, CLIPIUM_SEARCH_CONFIRM_MAX);
+    g_assert_true(stats.partial);
+    g_array_free(results, TRUE);
+
+    /* The filtered path reads the same way */
+    loader.calls = 0;
+    results = clipium_store_search(store, "mime:text needle", 5);
+    g_assert_cmpuint(results->len, ==, 5);
+    g_assert_cmpuint(loader.calls, ==, 5);
+    g_array_free(results, TRUE);
+
+    clipium_store_free(store);
+}
+/* Literal and regex scans read metadata-only content around the cache,
+ * and a regex only sees the head of a large entry */
+static void
+test_store_search_grep_lazy(void)
+{
+    ClipiumStore *store = clipium_store_new(10);
+    g_autoptr(GHashTable) disk = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                       NULL, (GDestroyNotify)g_bytes_unref);
+    clipium_store_set_content_loader(store, table_content_loader, disk);
+
+    static const char text[] = "build log\nerror E4012 in module";
+    ClipiumHash hash = test_hash(text);
+    clipium_store_load_entry(store, 100, NULL, "text/plain", &hash, "build log",
+                             g_get_real_time(), FALSE, strlen(text));
+    g_hash_table_insert(disk, GSIZE_TO_POINTER(100), g_bytes_new_static(text, strlen(text)));
+
+    GString *big = g_string_new(NULL);
+    while (big->len < CLIPIUM_GREP_REGEX_MAX_BYTES)
+        g_string_append(big, "padding ");
+    g_string_append(big, "tail W9001");
+    hash = test_hash(big->str);
+    clipium_store_load_entry(store, 101, NULL, "text/plain", &hash, "padding",
+                             g_get_real_time(), FALSE, big->len);
+    gsize big_len = big->len;
+    g_hash_table_insert(disk, GSIZE_TO_POINTER(101),
+                        g_bytes_new_take(g_string_free(big, FALSE), big_len));
+
+    GArray *results = clipium_store_search(store, "\"E4012\"", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, 100);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "re:E\\d{4}", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+
+    /* Past the cap, a literal still finds it; a regex does not */
+    results = clipium_store_search(store, "\"W9001\"", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, 101);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "re:W\\d{4}", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    ClipiumContentStats stats;
+    clipium_store_content_stats(store, &stats);
+    g_assert_cmpuint(stats.cache_bytes, ==, 0);
+    g_assert_cmpuint(stats.cache_hits + stats.cache_misses, ==, 0);
+
+    clipium_store_free(store);
+}
+
+/* The resident indexes report what they hold, and only the head of a long
+ * text goes into them */
+static void
+test_store_index_bytes(void)
+{
+    ClipiumStore *store = clipium_store_new(10);
+    g_assert_cmpuint(clipium_store_index_bytes(store), ==, 0);
+
+    guint64 short_id = store_add_text(store, "quick brown fox");
+    gsize one = clipium_store_index_bytes(store);
+    g_assert_cmpuint(one, >, 0);
+
+    /* Past the cap the text is not indexed, and costs nothing more */
+    GString *text = g_string_new(NULL);
+    for (guint i = 0; text->len < CLIPIUM_INDEX_MAX_BYTES; i++)
+        g_string_append_printf(text, "w%u ", i);
+    g_autofree char *head = g_strndup(text->str, CLIPIUM_INDEX_MAX_BYTES);
+    g_string_append(text, "zzqtail");
+    guint64 long_id = store_add_text(store, text->str);
+    gsize with_long = clipium_store_index_bytes(store);
+    GArray *results = clipium_store_search(store, "zzqtail", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+    g_assert_true(clipium_store_delete(store, long_id));
+    g_assert_cmpuint(clipium_store_index_bytes(store), ==, one);
+    store_add_text(store, head);
+    g_assert_cmpuint(clipium_store_index_bytes(store), ==, with_long);
+
+    g_assert_true(clipium_store_delete(store, short_id));
+    clipium_store_clear(store);
+    g_assert_cmpuint(clipium_store_index_bytes(store), ==, 0);
+
+    g_string_free(text, TRUE);
+    clipium_store_free(store);
+}
+
+static void
+test_store_search_full_text(void)
+{
+    ClipiumStore *store = clipium_store_new(3);
+    GString *long_text = g_string_new("first line\n");
+    for (int i = 0; i < 200; i++)
+        g_string_append_printf(long_text, "filler %d ", i);
+    g_string_append(long_text, "\nNeedle In The\nHaystack\n");
+
+    GBytes *c = g_bytes_new(long_text->str, long_text->len);
+    guint64 long_id = clipium_store_add(store, c, "text/plain");
+    g_bytes_unref(c);
+    store_add_text(store, "needle? no, a pin");
+
+    /* Far past the preview, case-folded, across the newline */
+    GArray *results = clipium_store_search(store, "needle in the", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, long_id);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "the haystack", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+
+    /* Trigrams present but not contiguous: confirmed against the content */
+    results = clipium_store_search(store, "haystack needle", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    /* A preview match outranks a hit deeper in the text */
+    results = clipium_store_search(store, "needle", 10);
+    g_assert_cmpuint(results->len, ==, 2);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 1)->id, ==, long_id);
+    g_array_free(results, TRUE);
+
+    /* Eviction drops the entry from the index */
+    store_add_text(store, "one");
+    store_add_text(store, "two");
+    results = clipium_store_search(store, "haystack", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    /* Metadata-only entries are searchable once their text is indexed */
+    ClipiumHash hash = test_hash("lazy");
+    clipium_store_load_entry(store, 900, NULL, "text/plain", &hash, "lazy",
+                             g_get_real_time(), TRUE, 40);
+    GBytes *lazy = g_bytes_new_static("lazy\nsecond line mentions marmalade", 35);
+    g_autoptr(GHashTable) disk = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_insert(disk, GSIZE_TO_POINTER(900), lazy);
+    clipium_store_set_content_loader(store, table_content_loader, disk);
+    g_assert_true(clipium_store_index_content(store, 900, lazy));
+    results = clipium_store_search(store, "marmalade", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, 900);
+    g_array_free(results, TRUE);
+
+    clipium_store_delete(store, 900);
+    results = clipium_store_search(store, "marmalade", 10);
+    g_assert_cmpuint(results->len, ==, 0);
+    g_array_free(results, TRUE);
+
+    g_bytes_unref(lazy);
+    g_string_free(long_text, TRUE);
+    clipium_store_free(store);
+}
+
+static void
+test_store_snapshot_isolation(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    GBytes *c1 = g_bytes_new_static("aaa", 3);
+    GBytes *c2 = g_bytes_new_static("bbb", 3);
+
+    guint64 id1 = clipium_store_add(store, c1, "text/plain");
+    clipium_store_add(store, c2, "text/plain");
+
+    /* Unchanged store hands out the same published snapshot */
+    ClipiumSnapshot *s1 = clipium_store_snapshot(store);
+    ClipiumSnapshot *s2 = clipium_store_snapshot(store);
+    g_assert_true(s1 == s2);
+    clipium_snapshot_unref(s2);
+
+    /* Results stay valid after the store drops the entries */
+    GArray *list = clipium_store_list(store, 10, 0);
+    clipium_store_pin(store, id1, TRUE);
+    clipium_store_clear(store);
+    g_assert_cmpuint(list->len, ==, 2);
+    g_assert_cmpstr(g_array_index(list, ClipiumEntry *, 1)->preview, ==, "aaa");
+    g_assert_false(g_array_index(list, ClipiumEntry *, 1)->pinned);
+    g_assert_cmpuint(s1->entries->len, ==, 2);
+    g_array_free(list, TRUE);
+
+    /* A change publishes a new snapshot */
+    ClipiumSnapshot *s3 = clipium_store_snapshot(store);
+    g_assert_true(s3 != s1);
+    g_assert_cmpuint(s3->entries->len, ==, 0);
+    clipium_snapshot_unref(s3);
+    clipium_snapshot_unref(s1);
+
+    g_bytes_unref(c1);
+    g_bytes_unref(c2);
+    clipium_store_free(store);
+}
+
+static void
+test_store_snapshot_columns(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 id1 = store_add_text(store, "first");
+    store_add_text(store, "second");
+    GBytes *png = g_bytes_new_static("\x89PNG", 4);
+    clipium_store_add(store, png, "image/png");
+    clipium_store_pin(store, id1, TRUE);
+
+    g_autoptr(ClipiumSnapshot) snap = clipium_store_snapshot(store);
+    g_assert_cmpuint(snap->len, ==, 3);
+    for (guint i = 0; i < snap->len; i++) {
+        ClipiumEntry *e = g_ptr_array_index(snap->entries, i);
+        g_assert_cmpstr(clipium_snapshot_key(snap, i), ==, e->search_key);
+        g_assert_cmpint(snap->timestamps[i], ==, e->timestamp);
+        g_assert_cmpuint(snap->sizes[i], ==, e->size);
+        g_assert_cmpuint(snap->pinned[i], ==, e->pinned ? 1 : 0);
+        g_assert_cmpstr(g_quark_to_string(snap->mime_ids[i]), ==, e->mime_type);
+    }
+
+    /* Text entries share one interned mime type and one quark */
+    g_assert_true(((ClipiumEntry *)g_ptr_array_index(snap->entries, 1))->mime_type ==
+                  ((ClipiumEntry *)g_ptr_array_index(snap->entries, 2))->mime_type);
+    g_assert_cmpuint(snap->mime_ids[1], ==, snap->mime_ids[2]);
+    g_assert_cmpuint(snap->mime_ids[0], !=, snap->mime_ids[1]);
+    g_assert_cmpuint(snap->pinned[2], ==, 1);
+
+    g_bytes_unref(png);
+    clipium_store_free(store);
+}
+
+static void
+test_store_ttl_rules(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    g_assert_true(clipium_store_set_ttl_rules(store, "image/*=1d, text/*=30d"));
+    g_assert_true(clipium_store_set_ttl_rules(store, "pinned:*=never,*=90m"));
+    g_assert_true(clipium_store_set_ttl_rules(store, ""));
+    g_assert_false(clipium_store_set_ttl_rules(store, "image/*"));
+    g_assert_false(clipium_store_set_ttl_rules(store, "=1d"));
+    g_assert_false(clipium_store_set_ttl_rules(store, "text/*=1y"));
+    g_assert_false(clipium_store_set_ttl_rules(store, "text/*=d"));
+
+    /* Nothing expires unless asked for: existing history stays */
+    g_assert_true(clipium_store_set_ttl_rules(store, CLIPIUM_TTL_RULES));
+    ClipiumHash hash = test_hash("last year");
+    GBytes *old = g_bytes_new_static("last year", 9);
+    gint64 now = g_get_real_time();
+    clipium_store_load_entry(store, 7, old, "text/plain", &hash, "last year",
+                             now - (gint64)365 * 24 * 3600 * G_USEC_PER_SEC, FALSE, 9);
+    g_assert_cmpuint(clipium_store_expire(store, now + CLIPIUM_TTL_TICK_USEC), ==, 0);
+    g_assert_true(store_has(store, 7));
+
+    g_bytes_unref(old);
+    clipium_store_free(store);
+}
+
+static void
+test_store_ttl_expiry(void)
+{
+    const gint64 hour = (gint64)3600 * G_USEC_PER_SEC;
+    ClipiumStore *store = clipium_store_new(100);
+    g_assert_true(clipium_store_set_ttl_rules(store,
+                  "image/*=1h,text/*=1d,pinned:text/*=1w"));
+    gint64 now = g_get_real_time();
+
+    /* Loaded two days after its last copy: already expired */
+    ClipiumHash old_hash = test_hash("old");
+    GBytes *old = g_bytes_new_static("old", 3);
+    clipium_store_load_entry(store, 500, old, "text/plain", &old_hash, "old",
+                             now - 48 * hour, FALSE, 3);
+
+    guint64 text_id = store_add_text(store, "fresh text");
+    guint64 pinned_id = store_add_text(store, "pinned text");
+    clipium_store_pin(store, pinned_id, TRUE);
+    GBytes *png = g_bytes_new_static("\x89PNG", 4);
+    guint64 image_id = clipium_store_add(store, png, "image/png");
+    GBytes *pdf = g_bytes_new_static("%PDF", 4);
+    guint64 pdf_id = clipium_store_add(store, pdf, "application/pdf");
+
+    g_assert_cmpuint(clipium_store_expire(store, now + CLIPIUM_TTL_TICK_USEC), ==, 1);
+    g_assert_false(store_has(store, 500));
+
+    g_assert_cmpuint(clipium_store_expire(store, now + 2 * hour), ==, 1);
+    g_assert_false(store_has(store, image_id));
+
+    /* Pinned entries follow their own rule */
+    g_assert_cmpuint(clipium_store_expire(store, now + 25 * hour), ==, 1);
+    g_assert_false(store_has(store, text_id));
+    g_assert_true(store_has(store, pinned_id));
+
+    g_assert_cmpuint(clipium_store_expire(store, now + 8 * 24 * hour), ==, 1);
+    g_assert_false(store_has(store, pinned_id));
+
+    /* No rule matches the PDF, so it never expires */
+    g_assert_cmpuint(clipium_store_count(store), ==, 1);
+    g_assert_true(store_has(store, pdf_id));
+
+    /* New rules apply to the entries already in the store */
+    g_assert_true(clipium_store_set_ttl_rules(store, "application/*=1h"));
+    g_assert_cmpuint(clipium_store_expire(store, now + 8 * 24 * hour + CLIPIUM_TTL_TICK_USEC),
+                     ==, 1);
+    g_assert_cmpuint(clipium_store_count(store), ==, 0);
+
+    g_bytes_unref(old);
+    g_bytes_unref(png);
+    g_bytes_unref(pdf);
+    clipium_store_free(store);
+}
+
+static gpointer
+snapshot_reader_thread(gpointer data)
+{
+    ClipiumStore *store = data;
+    for (int i = 0; i < 2000; i++) {
+        GArray *list = clipium_store_search(store, "item", 20);
+        for (guint j = 0; j < list->len; j++)
+            g_assert_true(g_str_has_prefix(g_array_index(list, ClipiumEntry *, j)->preview, "item-"));
+        g_array_free(list, TRUE);
+    }
+    return NULL;
+}
+
+static void
+test_store_concurrent_readers(void)
+{
+    ClipiumStore *store = clipium_store_new(50);
+    GThread *readers[2];
+    for (guint i = 0; i < G_N_ELEMENTS(readers); i++)
+        readers[i] = g_thread_new("reader", snapshot_reader_thread, store);
+
+    for (int i = 0; i < 2000; i++) {
+        char buf[16];
+        g_snprintf(buf, sizeof(buf), "item-%d", i % 80);
+        GBytes *c = g_bytes_new(buf, strlen(buf));
+        guint64 id = clipium_store_add(store, c, "text/plain");
+        if (id && i % 7 == 0)
+            clipium_store_delete(store, id);
+        g_bytes_unref(c);
+    }
+
+    for (guint i = 0; i < G_N_ELEMENTS(readers); i++)
+        g_thread_join(readers[i]);
+    clipium_store_free(store);
+}
+
+static void
+test_store_dedup_bumps_to_top(void)
+{
+    ClipiumStore *store = clipium_store_new(100);
+    GBytes *c1 = g_bytes_new_static("aaa", 3);
+    GBytes *c2 = g_bytes_new_static("bbb", 3);
+
+    guint64 id1 = clipium_store_add(store, c1, "text/plain");
+    clipium_store_add(store, c2, "text/plain");
+    (void)id1;
+
+    /* Re-add c1 — should dedup but bump to top */
+    clipium_store_add(store, c1, "text/plain");
+
+    GArray *list = clipium_store_list(store, 10, 0);
+    g_assert_cmpuint(list->len, ==, 2);
+    /* First entry should have "aaa" preview (bumped to top) */
+    ClipiumEntry *top = g_array_index(list, ClipiumEntry *, 0);
+    g_assert_cmpstr(top->preview, ==, "aaa");
+    g_array_free(list, TRUE);
+
+    g_bytes_unref(c1);
+    g_bytes_unref(c2);
+    clipium_store_free(store);
+}
+
+/* ======== Timer Wheel Tests ======== */
+
+static void
+test_wheel_random(void)
+{
+    const guint n_slots = 500;
+    ClipiumWheel *wheel = clipium_wheel_new(0, 1);
+    GRand *rand = g_rand_new_with_seed(42);
+    gint64 *deadlines = g_new(gint64, n_slots);  /* -1 = not scheduled */
+
+    /* Deadlines spread over every level of the wheel */
+    for (guint i = 0; i < n_slots; i++) {
+        gint64 span = (gint64)1 << g_rand_int_range(rand, 2, 24);
+        deadlines[i] = 1 + g_rand_int_range(rand, 0, (gint32)span);
+        clipium_wheel_schedule(wheel, i, deadlines[i]);
+    }
+    for (guint i = 0; i < n_slots; i += 7) {
+        clipium_wheel_cancel(wheel, i);
+        deadlines[i] = -1;
+    }
+    for (guint i = 3; i < n_slots; i += 11) {
+        deadlines[i] = 1 + g_rand_int_range(rand, 0, 1 << 20);
+        clipium_wheel_schedule(wheel, i, deadlines[i]);
+    }
+
+    g_autoptr(GArray) fired = g_array_new(FALSE, FALSE, sizeof(guint));
+    gint64 now = 0;
+    while (clipium_wheel_count(wheel) > 0) {
+        gint64 prev = now;
+        now += g_rand_int_range(rand, 1, 200000);
+        g_array_set_size(fired, 0);
+        clipium_wheel_advance(wheel, now, fired);
+
+        /* Each slot fires in the first advance that reaches its deadline */
+        for (guint j = 0; j < fired->len; j++) {
+            guint slot = g_array_index(fired, guint, j);
+            g_assert_cmpint(deadlines[slot], >, prev);
+            g_assert_cmpint(deadlines[slot], <=, now);
+            deadlines[slot] = -1;
+        }
+        for (guint i = 0; i < n_slots; i++)
+            g_assert_true(deadlines[i] == -1 || deadlines[i] > now);
+    }
+    for (guint i = 0; i < n_slots; i++)
+        g_assert_cmpint(deadlines[i], ==, -1);
+
+    g_free(deadlines);
+    g_rand_free(rand);
+    clipium_wheel_free(wheel);
+}
+
+static void
+test_wheel_past_deadline(void)
+{
+    ClipiumWheel *wheel = clipium_wheel_new(1000, 10);
+    g_autoptr(GArray) fired = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    clipium_wheel_advance(wheel, 5000, fired);
+    clipium_wheel_schedule(wheel, 3, 0);
+    clipium_wheel_schedule(wheel, 4, 4990);
+    g_assert_cmpuint(clipium_wheel_count(wheel), ==, 2);
+
+    /* Both fire on the next tick; rescheduling moves rather than adds */
+    clipium_wheel_schedule(wheel, 4, 9000);
+    g_assert_cmpuint(clipium_wheel_advance(wheel, 5010, fired), ==, 1);
+    g_assert_cmpuint(g_array_index(fired, guint, 0), ==, 3);
+    g_assert_cmpuint(clipium_wheel_advance(wheel, 8999, fired), ==, 0);
+    g_assert_cmpuint(clipium_wheel_advance(wheel, 9000, fired), ==, 1);
+    g_assert_cmpuint(clipium_wheel_count(wheel), ==, 0);
+
+    clipium_wheel_free(wheel);
+}
+
+/* ======== Trigram Index Tests ======== */
+
+static void
+test_trigram_index_random(void)
+{
+    static const char alphabet[] = "abcAB \n";
+    const guint n_texts = 60;
+    ClipiumTrigramIndex *index = clipium_trigram_index_new();
+    GRand *rand = g_rand_new_with_seed(7);
+    char **texts = g_new0(char *, n_texts);
+
+    for (guint i = 0; i < n_texts; i++) {
+        guint len = (guint)g_rand_int_range(rand, 0, 80);
+        texts[i] = g_malloc(len + 1);
+        for (guint j = 0; j < len; j++)
+            texts[i][j] = alphabet[g_rand_int_range(rand, 0, sizeof(alphabet) - 1)];
+        texts[i][len] = '\0';
+        clipium_trigram_index_insert(index, i, clipium_trigrams_extract(texts[i], len));
+    }
+    /* Remove and re-index some slots with other text */
+    for (guint i = 0; i < n_texts; i += 5)
+        clipium_trigram_index_remove(index, i);
+    for (guint i = 0; i < n_texts; i += 10) {
+        g_free(texts[i]);
+        texts[i] = g_strdup("abab cabc");
+        clipium_trigram_index_insert(index, i, clipium_trigrams_extract(texts[i], 9));
+    }
+
+    /* Every slot containing the query is a candidate, in ascending order */
+    g_autoptr(GArray) slots = g_array_new(FALSE, FALSE, sizeof(guint));
+    for (int q = 0; q < 200; q++) {
+        char query[6];
+        guint qlen = (guint)g_rand_int_range(rand, 3, 6);
+        for (guint j = 0; j < qlen; j++)
+            query[j] = alphabet[g_rand_int_range(rand, 0, sizeof(alphabet) - 1)];
+        query[qlen] = '\0';
+
+        g_array_set_size(slots, 0);
+        g_assert_true(clipium_trigram_index_query(index, query, slots));
+        for (guint j = 1; j < slots->len; j++)
+            g_assert_cmpuint(g_array_index(slots, guint, j - 1), <, g_array_index(slots, guint, j));
+
+        guint k = 0;
+        for (guint i = 0; i < n_texts; i++) {
+            gboolean indexed = clipium_trigram_index_has(index, i);
+            g_assert_cmpint(indexed, ==, i % 5 != 0 || i % 10 == 0);
+            if (indexed && clipium_trigram_contains(texts[i], strlen(texts[i]), query, qlen)) {
+                while (k < slots->len && g_array_index(slots, guint, k) < i)
+                    k++;
+                g_assert_cmpuint(k, <, slots->len);
+                g_assert_cmpuint(g_array_index(slots, guint, k), ==, i);
+            }
+        }
+    }
+
+    g_assert_false(clipium_trigram_index_query(index, "ab", slots));
+    g_assert_true(clipium_trigram_contains("Hello\tWorld", 11, "o w", 3));
+    g_assert_false(clipium_trigram_contains("Hello", 5, "hello!", 6));
+
+    for (guint i = 0; i < n_texts; i++)
+        g_free(texts[i]);
+    g_free(texts);
+    g_rand_free(rand);
+    clipium_trigram_index_free(index);
+}
+
+/* ======== Typo Index Tests ======== */
+
+static void
+test_typo_distance(void)
+{
+    static const struct { const char *a, *b; guint d; } cases[] = {
+        { "teh", "the", 1 },        { "the", "the", 0 },   { "", "abc", 3 },
+        { "kitten", "sitting", 3 }, { "quikc", "quick", 1 },
+        /* OSA would say 3: the transposed pair is edited again */
+        { "ca", "abc", 2 },
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++) {
+        const char *a = cases[i].a, *b = cases[i].b;
+        g_assert_cmpuint(clipium_typo_distance(a, strlen(a), b, strlen(b)), ==, cases[i].d);
+        g_assert_cmpuint(clipium_typo_distance(b, strlen(b), a, strlen(a)), ==, cases[i].d);
+    }
+
+    g_autoptr(GPtrArray) words = clipium_typo_words_extract("Hello, hello WORLD a1b2 to\n"
+                                                            "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 61);
+    g_assert_cmpuint(words->len, ==, 3);
+    g_assert_cmpstr(g_ptr_array_index(words, 0), ==, "hello");
+    g_assert_cmpstr(g_ptr_array_index(words, 1), ==, "world");
+    g_assert_cmpstr(g_ptr_array_index(words, 2), ==, "a1b2");
+}
+
+/* Lookups against a brute-force scan, across enough removals that the
+ * tree is rebuilt */
+static void
+test_typo_index_random(void)
+{
+    enum { SLOTS = 1500, WORDS = 3 };
+    GRand *rand = g_rand_new_with_seed(20);
+    ClipiumTypoIndex *index = clipium_typo_index_new();
+    char *text[SLOTS];
+
+    for (guint s = 0; s < SLOTS; s++) {
+        GString *t = g_string_new(NULL);
+        for (guint w = 0; w < WORDS; w++) {
+            guint len = g_rand_int_range(rand, 3, 7);
+            for (guint c = 0; c < len; c++)
+                g_string_append_c(t, "abcde"[g_rand_int_range(rand, 0, 5)]);
+            g_string_append_c(t, ' ');
+        }
+        text[s] = g_string_free(t, FALSE);
+        clipium_typo_index_insert(index, s, clipium_typo_words_extract(text[s], strlen(text[s])));
+    }
+
+    for (guint round = 0; round < 2; round++) {
+        for (guint q = 0; q < 40; q++) {
+            char query[8];
+            guint len = g_rand_int_range(rand, 3, 7);
+            for (guint c = 0; c < len; c++)
+                query[c] = "abcdef"[g_rand_int_range(rand, 0, 6)];
+            query[len] = '\0';
+            guint edits = g_rand_int_range(rand, 1, 3);
+            guint allowed = MIN(edits, len <= 4 ? 1u : 2u);
+
+            g_autoptr(GArray) hits = g_array_new(FALSE, FALSE, sizeof(ClipiumTypoHit));
+            g_assert_true(clipium_typo_index_query(index, query, edits, hits));
+            g_autoptr(GHashTable) got = g_hash_table_new(g_direct_hash, g_direct_equal);
+            for (guint i = 0; i < hits->len; i++) {
+                ClipiumTypoHit *hit = &g_array_index(hits, ClipiumTypoHit, i);
+                g_hash_table_insert(got, GUINT_TO_POINTER(hit->slot), GUINT_TO_POINTER(hit->distance + 1));
+            }
+
+            guint expected = 0;
+            for (guint s = 0; s < SLOTS; s++) {
+                if (!text[s])
+                    continue;
+                guint best = G_MAXUINT;
+                g_auto(GStrv) words = g_strsplit(text[s], " ", -1);
+                for (guint w = 0; words[w]; w++) {
+                    if (*words[w])
+                        best = MIN(best, clipium_typo_distance(query, len, words[w], strlen(words[w])));
+                }
+                if (best > allowed)
+                    continue;
+                expected++;
+                g_assert_cmpuint(GPOINTER_TO_UINT(g_hash_table_lookup(got, GUINT_TO_POINTER(s))),
+                                 ==, best + 1);
+            }
+            g_assert_cmpuint(hits->len, ==, expected);
+        }
+
+        /* Drop most slots; the vocabulary left behind forces a rebuild */
+        for (guint s = 0; s < SLOTS; s++) {
+            if (round == 0 && g_rand_int_range(rand, 0, 10) < 8) {
+                clipium_typo_index_remove(index, s);
+                g_clear_pointer(&text[s], g_free);
+            }
+        }
+    }
+
+    for (guint s = 0; s < SLOTS; s++)
+        g_free(text[s]);
+    g_rand_free(rand);
+    clipium_typo_index_free(index);
+}
+
+/* ======== Grep Tests ======== */
+
+static void
+test_grep_literal_random(void)
+{
+    GRand *rand = g_rand_new_with_seed(21);
+    const char *alphabet = "ab. ";
+
+    for (guint round = 0; round < 2000; round++) {
+        char haystack[64], needle[6];
+        guint h_len = g_rand_int_range(rand, 0, 64);
+        guint n_len = g_rand_int_range(rand, 1, 6);
+        for (guint i = 0; i < h_len; i++)
+            haystack[i] = alphabet[g_rand_int_range(rand, 0, 4)];
+        for (guint i = 0; i < n_len; i++)
+            needle[i] = alphabet[g_rand_int_range(rand, 0, 4)];
+
+        gboolean expected = FALSE;
+        for (guint i = 0; i + n_len <= h_len && !expected; i++)
+            expected = memcmp(haystack + i, needle, n_len) == 0;
+        g_assert_cmpint(clipium_grep_literal_find(haystack, h_len, needle, n_len), ==, expected);
+    }
+
+    /* Case-sensitive, and never reads past the haystack */
+    g_assert_true(clipium_grep_literal_find("code E4012.", 11, "E4012", 5));
+    g_assert_false(clipium_grep_literal_find("code e4012.", 11, "E4012", 5));
+    g_assert_false(clipium_grep_literal_find("E401", 4, "E4012", 5));
+    g_assert_true(clipium_grep_literal_find("", 0, "", 0));
+
+    g_rand_free(rand);
+}
+
+static void
+test_grep_mode_split(void)
+{
+    struct { const char *input; ClipiumSearchMode mode; const char *pattern; } cases[] = {
+        { "hello world",   CLIPIUM_SEARCH_FUZZY,   "hello world" },
+        { "re:\\d+",       CLIPIUM_SEARCH_REGEX,   "\\d+" },
+        { "\"E4012\"",     CLIPIUM_SEARCH_LITERAL, "E4012" },
+        { "\"half typed",  CLIPIUM_SEARCH_LITERAL, "half typed" },
+        { "\"say \"hi\"\"", CLIPIUM_SEARCH_LITERAL, "say \"hi\"" },
+        { "re:",           CLIPIUM_SEARCH_FUZZY,   "" },
+        { "\"",            CLIPIUM_SEARCH_FUZZY,   "" },
+        { "more:re",       CLIPIUM_SEARCH_FUZZY,   "more:re" },
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++) {
+        ClipiumSearchMode mode;
+        g_autofree char *pattern = clipium_search_mode_split(cases[i].input, &mode);
+        g_assert_cmpint(mode, ==, cases[i].mode);
+        g_assert_cmpstr(pattern, ==, cases[i].pattern);
+    }
+
+    ClipiumSearchMode mode;
+    g_assert_true(clipium_search_mode_from_string("regex", &mode));
+    g_assert_cmpint(mode, ==, CLIPIUM_SEARCH_REGEX);
+    g_assert_false(clipium_search_mode_from_string("glob", &mode));
+}
+
+static void
+test_grep_regex_cache(void)
+{
+    ClipiumRegexCache *cache = clipium_regex_cache_new(2);
+
+    GRegex *a = clipium_regex_cache_get(cache, "a+", NULL);
+    GRegex *again = clipium_regex_cache_get(cache, "a+", NULL);
+    g_assert_nonnull(a);
+    g_assert_true(a == again);
+    g_assert_cmpuint(clipium_regex_cache_hits(cache), ==, 1);
+    g_regex_unref(again);
+
+    /* The least recently used pattern goes, but references stay valid */
+    GRegex *b = clipium_regex_cache_get(cache, "b+", NULL);
+    GRegex *c = clipium_regex_cache_get(cache, "c+", NULL);
+    GRegex *a2 = clipium_regex_cache_get(cache, "a+", NULL);
+    g_assert_true(a2 != a);
+    g_assert_cmpuint(clipium_regex_cache_hits(cache), ==, 1);
+    g_assert_true(clipium_regex_find(a, "xaay", 4));
+    g_assert_false(clipium_regex_find(a, "xaay", 1));
+    g_assert_false(clipium_regex_find(a2, "a\xff", 2));
+
+    g_autoptr(GError) error = NULL;
+    g_assert_null(clipium_regex_cache_get(cache, "(unclosed", &error));
+    g_assert_true(error && error->domain == G_REGEX_ERROR);
+
+    g_regex_unref(a);
+    g_regex_unref(a2);
+    g_regex_unref(b);
+    g_regex_unref(c);
+    clipium_regex_cache_free(cache);
+}
+
+/* ======== Query Tests ======== */
+
+static void
+test_query_parse(void)
+{
+    gint64 now = 1000 * G_TIME_SPAN_DAY;
+    g_autoptr(ClipiumQuery) q = clipium_query_parse("mime:Image/* foo  pinned:yes bar since:2h "
+                                                   "size>1k size<=4MiB", now);
+    g_assert_cmpstr(q->text, ==, "foo bar");
+    g_assert_cmpstr(q->mime, ==, "image");
+    g_assert_cmpint(q->pinned, ==, 1);
+    g_assert_cmpint(q->since, ==, now - 2 * G_TIME_SPAN_HOUR);
+    g_assert_cmpint(q->size_min, ==, 1025);
+    g_assert_cmpint(q->size_max, ==, 4 * 1024 * 1024);
+    g_assert_true(clipium_query_has_filters(q));
+    g_assert_true(clipium_query_accepts(q, "image/png", TRUE, now, 2048));
+    g_assert_false(clipium_query_accepts(q, "imagery/png", TRUE, now, 2048));
+    g_assert_false(clipium_query_accepts(q, "image/png", FALSE, now, 2048));
+    g_assert_false(clipium_query_accepts(q, "image/png", TRUE, now - G_TIME_SPAN_DAY, 2048));
+    g_assert_false(clipium_query_accepts(q, "image/png", TRUE, now, 1024));
+
+    /* Half-typed filters are text; with no filters the text is verbatim */
+    g_autoptr(ClipiumQuery) partial = clipium_query_parse("  since:2 x  size>k pinned:", now);
+    g_assert_cmpstr(partial->text, ==, "x size>k pinned:");
+    g_assert_cmpint(partial->since, ==, now - 2 * G_USEC_PER_SEC);
+    g_autoptr(ClipiumQuery) plain = clipium_query_parse(" two  words ", now);
+    g_assert_cmpstr(plain->text, ==, " two  words ");
+    g_assert_false(clipium_query_has_filters(plain));
+    g_autoptr(ClipiumQuery) bad = clipium_query_parse("size<0 mime: since:never", now);
+    g_assert_false(clipium_query_has_filters(bad));
+
+    g_assert_true(clipium_mime_matches("text/plain", "text/plain;charset=utf-8"));
+    g_assert_false(clipium_mime_matches("text/plain", "text/plainish"));
+    g_assert_false(clipium_mime_matches("image/png", "image"));
+}
+
+static gint
+cmp_uint(gconstpointer a, gconstpointer b)
+{
+    guint x = *(const guint *)a, y = *(const guint *)b;
+    return (x > y) - (x < y);
+}
+
+/* Random inserts, re-inserts and removals, checked against a scan */
+static void
+test_attr_index(void)
+{
+    static const char *mimes[] = { "text/plain", "text/html", "image/png", "image/jpeg" };
+    enum { SLOTS = 64 };
+    struct { gboolean live; const char *mime; gboolean pinned; gint64 ts; } model[SLOTS] = { 0 };
+    ClipiumAttrIndex *index = clipium_attr_index_new();
+    GRand *rand = g_rand_new_with_seed(18);
+
+    for (guint round = 0; round < 2000; round++) {
+        guint slot = g_rand_int_range(rand, 0, SLOTS);
+        if (g_rand_int_range(rand, 0, 4) == 0) {
+            clipium_attr_index_remove(index, slot);
+            model[slot].live = FALSE;
+        } else {
+            model[slot].live = TRUE;
+            model[slot].mime = g_intern_static_string(mimes[g_rand_int_range(rand, 0, 4)]);
+            model[slot].pinned = g_rand_boolean(rand);
+            model[slot].ts = g_rand_int_range(rand, 0, 100);
+            clipium_attr_index_insert(index, slot, model[slot].mime,
+                                      model[slot].pinned, model[slot].ts);
+        }
+        if (round % 100 != 99)
+            continue;
+
+        static const char *patterns[] = { "text", "image/png", "audio" };
+        for (guint p = 0; p < G_N_ELEMENTS(patterns); p++) {
+            g_autoptr(GArray) got = g_array_new(FALSE, FALSE, sizeof(guint));
+            guint n = clipium_attr_index_mime(index, patterns[p], got);
+            g_assert_cmpuint(n, ==, clipium_attr_index_count_mime(index, patterns[p]));
+            g_array_sort(got, cmp_uint);
+            guint k = 0;
+            for (guint s = 0; s < SLOTS; s++) {
+                if (model[s].live && clipium_mime_matches(patterns[p], model[s].mime)) {
+                    g_assert_cmpuint(k, <, got->len);
+                    g_assert_cmpuint(g_array_index(got, guint, k++), ==, s);
+                }
+            }
+            g_assert_cmpuint(k, ==, got->len);
+        }
+
+        g_autoptr(GArray) pinned = g_array_new(FALSE, FALSE, sizeof(guint));
+        clipium_attr_index_pinned(index, pinned);
+        guint expect_pinned = 0;
+        for (guint s = 0; s < SLOTS; s++)
+            expect_pinned += model[s].live && model[s].pinned;
+        g_assert_cmpuint(pinned->len, ==, expect_pinned);
+        g_assert_cmpuint(clipium_attr_index_count_pinned(index), ==, expect_pinned);
+
+        gint64 since = g_rand_int_range(rand, 0, 100);
+        g_autoptr(GArray) recent = g_array_new(FALSE, FALSE, sizeof(guint));
+        clipium_attr_index_since(index, since, recent);
+        guint expect_recent = 0;
+        for (guint s = 0; s < SLOTS; s++)
+            expect_recent += model[s].live && model[s].ts >= since;
+        g_assert_cmpuint(recent->len, ==, expect_recent);
+        for (guint i = 0; i < recent->len; i++) {
+            guint s = g_array_index(recent, guint, i);
+            g_assert_true(model[s].live && model[s].ts >= since);
+            if (i > 0)
+                g_assert_cmpint(model[g_array_index(recent, guint, i - 1)].ts, <=, model[s].ts);
+        }
+        g_assert_cmpuint(clipium_attr_index_count_since(index, since, G_MAXUINT), ==, expect_recent);
+        g_assert_cmpuint(clipium_attr_index_count_since(index, since, 3), ==, MIN(expect_recent, 3));
+    }
+
+    clipium_attr_index_clear(index);
+    g_assert_cmpuint(clipium_attr_index_count_since(index, 0, G_MAXUINT), ==, 0);
+    g_assert_cmpuint(clipium_attr_index_count_mime(index, "text"), ==, 0);
+    g_rand_free(rand);
+    clipium_attr_index_free(index);
+}
+
+/* ======== Entry Helper Tests ======== */
+
+static void
+test_entry_compute_hash(void)
+{
+    GBytes *content = g_bytes_new_static("test", 4);
+    ClipiumHash hash, hash2;
+    clipium_entry_compute_hash(content, &hash);
+
+    /* Same content produces same hash */
+    clipium_entry_compute_hash(content, &hash2);
+    g_assert_true(clipium_hash_equal(&hash, &hash2));
+
+    char hex[CLIPIUM_HASH_HEX_LEN + 1];
+    clipium_hash_to_hex(&hash, hex);
+    g_assert_cmpuint(strlen(hex), ==, 32);
+
+    g_bytes_unref(content);
+}
+
+static void
+test_entry_compute_hash_deterministic(void)
+{
+    GBytes *c1 = g_bytes_new_static("hello", 5);
+    GBytes *c2 = g_bytes_new_static("hello", 5);
+    GBytes *c3 = g_bytes_new_static("world", 5);
+
+    ClipiumHash h1, h2, h3;
+    clipium_entry_compute_hash(c1, &h1);
+    clipium_entry_compute_hash(c2, &h2);
+    clipium_entry_compute_hash(c3, &h3);
+
+    g_assert_true(clipium_hash_equal(&h1, &h2));
+    g_assert_false(clipium_hash_equal(&h1, &h3));
+
+    g_bytes_unref(c1);
+    g_bytes_unref(c2);
+    g_bytes_unref(c3);
+}
+
+static void
+test_entry_compute_hash_streaming(void)
+{
+    static const char fox[] = "The quick brown fox jumps over the lazy dog";
+    ClipiumHash hash;
+    char hex[CLIPIUM_HASH_HEX_LEN + 1];
+
+    /* Reference MurmurHash3 x64_128 values (seed 0) */
+    clipium_hash_data(fox, strlen(fox), &hash);
+    clipium_hash_to_hex(&hash, hex);
+    g_assert_cmpstr(hex, ==, "6c1b07bc7bbc4be347939ac4a93c437a");
+    clipium_hash_data("", 0, &hash);
+    clipium_hash_to_hex(&hash, hex);
+    g_assert_cmpstr(hex, ==, "00000000000000000000000000000000");
+
+    /* Any split of the input gives the same result as one update */
+    for (gsize split = 0; split <= strlen(fox); split++) {
+        ClipiumHasher hasher;
+        ClipiumHash streamed;
+        clipium_hasher_init(&hasher);
+        clipium_hasher_update(&hasher, fox, split);
+        clipium_hasher_update(&hasher, fox + split, strlen(fox) - split);
+        clipium_hasher_finish(&hasher, &streamed);
+        clipium_hash_data(fox, strlen(fox), &hash);
+        g_assert_true(clipium_hash_equal(&streamed, &hash));
+    }
+
+    /* Byte at a time across several blocks */
+    ClipiumHasher hasher;
+    ClipiumHash streamed;
+    clipium_hasher_init(&hasher);
+    for (gsize i = 0; i < strlen(fox); i++)
+        clipium_hasher_update(&hasher, fox + i, 1);
+    clipium_hasher_finish(&hasher, &streamed);
+    g_assert_true(clipium_hash_equal(&streamed, &hash));
+}
+
+static void
+test_entry_make_preview_text(void)
+{
+    GBytes *content = g_bytes_new_static("Hello\nWorld\tFoo", 15);
+    char *preview = clipium_entry_make_preview(content, "text/plain");
+    g_assert_nonnull(preview);
+    /* Newlines and tabs should be replaced with spaces */
+    g_assert_null(strchr(preview, '\n'));
+    g_assert_null(strchr(preview, '\t'));
+    g_assert_true(g_str_has_prefix(preview, "Hello"));
+    g_free(preview);
+    g_bytes_unref(content);
+}
+
+static void
+test_entry_make_preview_binary(void)
+{
+    GBytes *content = g_bytes_new_static("\x89PNG\r\n\x1a\n", 8);
+    char *preview = clipium_entry_make_preview(content, "image/png");
+    g_assert_nonnull(preview);
+    /* Should show format like "[image/png 8B]" */
+    g_assert_true(g_str_has_prefix(preview, "[image/png"));
+    g_free(preview);
+    g_bytes_unref(content);
+}
+
+static void
+test_entry_make_preview_truncates(void)
+{
+    /* Create a long text */
+    GString *long_text = g_string_new(NULL);
+    for (int i = 0; i < 200; i++)
+        g_string_append_c(long_text, 'A');
+
+    GBytes *content = g_bytes_new(long_text->str, long_text->len);
+    char *preview = clipium_entry_make_preview(content, "text/plain");
+    g_assert_nonnull(preview);
+    /* Preview should be truncated to ~CLIPIUM_PREVIEW_LEN + ellipsis */
+    g_assert_true(strlen(preview) <= CLIPIUM_PREVIEW_LEN + 4);
+    g_assert_true(g_str_has_suffix(preview, "\xe2\x80\xa6")); /* UTF-8 ellipsis */
+
+    g_free(preview);
+    g_bytes_unref(content);
+    g_string_free(long_text, TRUE);
+}
+
+static void
+test_entry_make_preview_trailing_whitespace(void)
+{
+    GBytes *content = g_bytes_new_static("hello   \n\n\n", 11);
+    char *preview = clipium_entry_make_preview(content, "text/plain");
+    g_assert_nonnull(preview);
+    /* Trailing whitespace should be trimmed */
+    g_assert_false(g_str_has_suffix(preview, " "));
+    g_free(preview);
+    g_bytes_unref(content);
+}
+
+/* ======== Fuzzy Match Tests ======== */
+
+static void
+test_fuzzy_match_exact(void)
+{
+    int score = clipium_fuzzy_match("hello", "hello");
+    g_assert_cmpint(score, >, 0);
+}
+
+static void
+test_fuzzy_match_substring(void)
+{
+    int score = clipium_fuzzy_match("hlo", "hello");
+    g_assert_cmpint(score, >, 0);
+}
+
+static void
+test_fuzzy_match_no_match(void)
+{
+    int score = clipium_fuzzy_match("xyz", "hello");
+    g_assert_cmpint(score, ==, -1);
+}
+
+static void
+test_fuzzy_match_case_insensitive(void)
+{
+    int score = clipium_fuzzy_match("HELLO", "hello world");
+    g_assert_cmpint(score, >, 0);
+}
+
+static void
+test_fuzzy_match_empty_query(void)
+{
+    int score = clipium_fuzzy_match("", "hello");
+    g_assert_cmpint(score, ==, 0);
+}
+
+static void
+test_fuzzy_match_empty_target(void)
+{
+    int score = clipium_fuzzy_match("hello", "");
     g_assert_cmpint(score, ==, -1);
 }
 
@@ -461,22 +2544,281 @@ test_fuzzy_match_null_args(void)
 }
 
 static void
-test_fuzzy_match_scoring(void)
+test_fuzzy_match_scoring(void)
+{
+    /* Exact prefix match should score higher than scattered match */
+    int score_prefix = clipium_fuzzy_match("hel", "hello world");
+    int score_scatter = clipium_fuzzy_match("hld", "hello world");
+    g_assert_cmpint(score_prefix, >, score_scatter);
+}
+
+static void
+test_fuzzy_match_separator_bonus(void)
+{
+    /* Match after separator should score higher */
+    int score_sep = clipium_fuzzy_match("w", "hello world");
+    int score_mid = clipium_fuzzy_match("o", "hello world");
+    /* 'w' starts a word (after space), so gets separator bonus */
+    g_assert_cmpint(score_sep, >, score_mid);
+}
+
+static void
+test_fuzzy_char_mask(void)
+{
+    guint64 target = clipium_fuzzy_char_mask("Hello World", 11);
+    g_assert_cmpuint(clipium_fuzzy_char_mask("hw", 2) & ~target, ==, 0);
+    g_assert_cmpuint(clipium_fuzzy_char_mask("HELLO", 5) & ~target, ==, 0);
+    g_assert_cmpuint(clipium_fuzzy_char_mask("hz", 2) & ~target, !=, 0);
+    g_assert_cmpuint(clipium_fuzzy_char_mask("", 0), ==, 0);
+
+    /* Matching on an explicit length ignores whatever follows */
+    g_assert_cmpint(clipium_fuzzy_match_len("wor", "hello world", 8), ==, -1);
+    g_assert_cmpint(clipium_fuzzy_match_len("wo", "hello world", 8),
+                    ==, clipium_fuzzy_match("wo", "hello wo"));
+}
+
+/* The byte-by-byte matcher as it was before prefiltering, kept as the
+ * reference for equivalence and the benchmark baseline */
+static int
+reference_fuzzy_match(const char *query, const char *target)
+{
+    if (!*query)
+        return 0;
+    if (!*target)
+        return -1;
+
+    const char *q = query, *t = target;
+    int score = 0, consecutive = 0;
+    while (*q && *t) {
+        if (g_ascii_tolower(*q) == g_ascii_tolower(*t)) {
+            score += 1 + (consecutive > 0 ? consecutive * 2 : 0);
+            consecutive++;
+            if (t == target)
+                score += 10;
+            if (t > target && strchr(" /_-.", *(t - 1)))
+                score += 5;
+            q++;
+        } else {
+            consecutive = 0;
+        }
+        t++;
+    }
+    return *q ? -1 : score;
+}
+
+static void
+test_fuzzy_prefilter_benchmark(void)
+{
+    const guint n_targets = 20000;
+    const guint rounds = 5;
+    static const char *queries[] = { "xq", "zebra", "kjv", "config.json", "ab", "Hello" };
+    GRand *rand = g_rand_new_with_seed(1234);
+    char **targets = g_new(char *, n_targets);
+    gsize *lens = g_new(gsize, n_targets);
+    guint64 *masks = g_new(guint64, n_targets);
+
+    /* Preview-sized lines of mostly lowercase words */
+    for (guint i = 0; i < n_targets; i++) {
+        GString *line = g_string_new(NULL);
+        guint len = (guint)g_rand_int_range(rand, 20, 100);
+        while (line->len < len) {
+            int r = g_rand_int_range(rand, 0, 100);
+            g_string_append_c(line, r < 15 ? ' ' : r < 20 ? '.' : (char)('a' + r % 20));
+        }
+        lens[i] = line->len;
+        targets[i] = g_string_free(line, FALSE);
+        masks[i] = clipium_fuzzy_char_mask(targets[i], lens[i]);
+    }
+
+    double reference_s = 0, masked_s = 0;
+    for (guint q = 0; q < G_N_ELEMENTS(queries); q++) {
+        const char *query = queries[q];
+        guint64 query_mask = clipium_fuzzy_char_mask(query, strlen(query));
+        guint ref_hits = 0, hits = 0;
+
+        g_test_timer_start();
+        for (guint r = 0; r < rounds; r++)
+            for (guint i = 0; i < n_targets; i++)
+                ref_hits += reference_fuzzy_match(query, targets[i]) >= 0;
+        reference_s += g_test_timer_elapsed();
+
+        g_test_timer_start();
+        for (guint r = 0; r < rounds; r++)
+            for (guint i = 0; i < n_targets; i++)
+                if (!(query_mask & ~masks[i]))
+                    hits += clipium_fuzzy_match_len(query, targets[i], lens[i]) >= 0;
+        masked_s += g_test_timer_elapsed();
+
+        g_assert_cmpuint(hits, ==, ref_hits);
+        for (guint i = 0; i < n_targets; i++)
+            g_assert_cmpint(clipium_fuzzy_match_len(query, targets[i], lens[i]),
+                            ==, reference_fuzzy_match(query, targets[i]));
+    }
+
+    g_test_message("fuzzy scan of %u targets x %u queries: byte-by-byte %.2f ms, "
+                   "mask + SIMD %.2f ms (%.1fx)", n_targets,
+                   (guint)G_N_ELEMENTS(queries), reference_s * 1000.0 / rounds,
+                   masked_s * 1000.0 / rounds, reference_s / MAX(masked_s, 1e-9));
+    /* Timings are only compared when asked for: a loaded machine or a
+     * sanitizer build says nothing about the prefilter */
+    if (g_test_perf())
+        g_assert_cmpfloat(masked_s, <, reference_s * 1.5);
+
+    for (guint i = 0; i < n_targets; i++)
+        g_free(targets[i]);
+    g_free(targets);
+    g_free(lens);
+    g_free(masks);
+    g_rand_free(rand);
+}
+
+static void
+test_fuzzy_fold(void)
+{
+    static const struct { const char *text; const char *key; } cases[] = {
+        { "Straße", "Strasse" },
+        { "École", "Ecole" },
+        { "naïve café", "naive cafe" },
+        { "ΣΟΦΙΑ", "σοφια" },
+        { "ﬁle №5", "file No5" },
+        { "plain ASCII", "plain ASCII" },
+        { "", "" },
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++) {
+        g_autofree char *key = clipium_fuzzy_fold(cases[i].text, strlen(cases[i].text), NULL);
+        g_assert_cmpstr(key, ==, cases[i].key);
+        g_assert_cmpint(clipium_fuzzy_needs_fold(cases[i].text, strlen(cases[i].text)),
+                        ==, strcmp(cases[i].text, cases[i].key) != 0);
+    }
+
+    /* Every key byte maps back to the start of its source character */
+    const char *text = "aß É";
+    g_autoptr(GArray) offsets = g_array_new(FALSE, FALSE, sizeof(guint));
+    g_autofree char *key = clipium_fuzzy_fold(text, strlen(text), offsets);
+    g_assert_cmpstr(key, ==, "ass E");
+    static const guint expected[] = { 0, 1, 1, 3, 4 };
+    g_assert_cmpuint(offsets->len, ==, G_N_ELEMENTS(expected));
+    for (guint i = 0; i < offsets->len; i++)
+        g_assert_cmpuint(g_array_index(offsets, guint, i), ==, expected[i]);
+
+    /* Invalid UTF-8 passes through byte for byte */
+    g_autofree char *raw = clipium_fuzzy_fold("a\xff" "b", 3, NULL);
+    g_assert_cmpstr(raw, ==, "a\xff" "b");
+}
+
+/* Matched byte offsets as a string, for readable assertions */
+static char *
+score_positions(const char *query, const char *target, int *score)
+{
+    g_autoptr(GArray) positions = g_array_new(FALSE, FALSE, sizeof(guint));
+    *score = clipium_fuzzy_score(query, target, strlen(target), positions);
+    GString *out = g_string_new(NULL);
+    for (guint i = 0; i < positions->len; i++)
+        g_string_append_printf(out, "%s%u", i ? "," : "", g_array_index(positions, guint, i));
+    return g_string_free(out, FALSE);
+}
+
+static void
+test_fuzzy_score_optimal(void)
+{
+    int score;
+
+    /* The greedy first occurrence would take the 'c' of "src" and the 'f'
+     * of "conf"; the alignment on word starts wins */
+    g_autofree char *words = score_positions("cf", "src/conf/clip-fuzzy.c", &score);
+    g_assert_cmpstr(words, ==, "9,14");
+    g_assert_cmpint(score, >, 0);
+
+    /* A consecutive run beats a scattered match of the same letters */
+    g_autofree char *run = score_positions("abc", "a-b-c abc", &score);
+    g_assert_cmpstr(run, ==, "6,7,8");
+
+    /* camelCase humps count as word starts */
+    g_autofree char *camel = score_positions("fb", "fooBar foobar", &score);
+    g_assert_cmpstr(camel, ==, "0,3");
+
+    /* Tighter and better-placed matches score higher */
+    g_assert_cmpint(clipium_fuzzy_score("log", "login", 5, NULL),
+                    >, clipium_fuzzy_score("log", "catalog of blogs", 16, NULL));
+    g_assert_cmpint(clipium_fuzzy_score("ab", "ab", 2, NULL),
+                    >, clipium_fuzzy_score("ab", "a______b", 8, NULL));
+
+    g_assert_cmpint(clipium_fuzzy_score("", "hello", 5, NULL), ==, 0);
+    g_assert_cmpint(clipium_fuzzy_score("x", "hello", 5, NULL), ==, -1);
+    g_assert_cmpint(clipium_fuzzy_score("hello", "hell", 4, NULL), ==, -1);
+    g_assert_cmpint(clipium_fuzzy_score("h", NULL, 0, NULL), ==, -1);
+}
+
+static void
+test_fuzzy_score_positions(void)
 {
-    /* Exact prefix match should score higher than scattered match */
-    int score_prefix = clipium_fuzzy_match("hel", "hello world");
-    int score_scatter = clipium_fuzzy_match("hld", "hello world");
-    g_assert_cmpint(score_prefix, >, score_scatter);
+    GRand *rand = g_rand_new_with_seed(77);
+    static const char alphabet[] = "abcAB _-/.9";
+
+    for (guint round = 0; round < 5000; round++) {
+        char target[48], query[6];
+        guint tlen = (guint)g_rand_int_range(rand, 0, sizeof(target));
+        guint qlen = (guint)g_rand_int_range(rand, 1, sizeof(query));
+        for (guint i = 0; i < tlen; i++)
+            target[i] = alphabet[g_rand_int_range(rand, 0, sizeof(alphabet) - 1)];
+        target[tlen] = '\0';
+        for (guint i = 0; i < qlen; i++)
+            query[i] = alphabet[g_rand_int_range(rand, 0, 5)];
+        query[qlen] = '\0';
+
+        g_autoptr(GArray) positions = g_array_new(FALSE, FALSE, sizeof(guint));
+        int score = clipium_fuzzy_score(query, target, tlen, positions);
+
+        /* Matches exactly when the greedy matcher does */
+        g_assert_cmpint(score >= 0, ==, clipium_fuzzy_match_len(query, target, tlen) >= 0);
+        if (score < 0) {
+            g_assert_cmpuint(positions->len, ==, 0);
+            continue;
+        }
+
+        /* One ascending position per query byte, each on that byte */
+        g_assert_cmpuint(positions->len, ==, qlen);
+        for (guint i = 0; i < qlen; i++) {
+            guint pos = g_array_index(positions, guint, i);
+            g_assert_cmpuint(pos, <, tlen);
+            if (i > 0)
+                g_assert_cmpuint(pos, >, g_array_index(positions, guint, i - 1));
+            g_assert_cmpint(g_ascii_tolower(target[pos]), ==, g_ascii_tolower(query[i]));
+        }
+        g_assert_cmpint(clipium_fuzzy_score(query, target, tlen, NULL), ==, score);
+    }
+    g_rand_free(rand);
 }
 
 static void
-test_fuzzy_match_separator_bonus(void)
+test_fuzzy_score_long_target(void)
 {
-    /* Match after separator should score higher */
-    int score_sep = clipium_fuzzy_match("w", "hello world");
-    int score_mid = clipium_fuzzy_match("o", "hello world");
-    /* 'w' starts a word (after space), so gets separator bonus */
-    g_assert_cmpint(score_sep, >, score_mid);
+    /* Too wide for the score matrix: the greedy path still finds the
+     * tightest window and reports its positions */
+    GString *text = g_string_new("needle ");
+    while (text->len < 40000)
+        g_string_append(text, "hay ");
+    g_string_append(text, "needle");
+
+    g_autoptr(GArray) positions = g_array_new(FALSE, FALSE, sizeof(guint));
+    int score = clipium_fuzzy_score("needle", text->str, text->len, positions);
+    g_assert_cmpint(score, >, 0);
+    g_assert_cmpuint(positions->len, ==, 6);
+    for (guint i = 0; i < positions->len; i++)
+        g_assert_cmpuint(g_array_index(positions, guint, i), ==, i);
+
+    /* Spread over the whole text it is still a match */
+    g_array_set_size(positions, 0);
+    g_assert_cmpint(clipium_fuzzy_score("nn", text->str, text->len, positions), >=, 0);
+    g_assert_cmpuint(positions->len, ==, 2);
+
+    /* A query longer than the matrix allows */
+    g_autofree char *query = g_strnfill(80, 'a');
+    g_autofree char *target = g_strnfill(100, 'a');
+    g_assert_cmpint(clipium_fuzzy_score(query, target, 100, NULL), >, 0);
+    g_assert_cmpint(clipium_fuzzy_score(target, query, 80, NULL), ==, -1);
+
+    g_string_free(text, TRUE);
 }
 
 /* ======== Database Tests ======== */
@@ -516,7 +2858,7 @@ test_db_save_and_load(void)
         .content   = content,
         .mime_type = "text/plain",
         .preview   = "test content",
-        .hash      = "abc123",
+        .hash = test_hash("abc123"),
         .timestamp = g_get_real_time(),
         .pinned    = FALSE,
         .size      = 12,
@@ -530,7 +2872,7 @@ test_db_save_and_load(void)
     g_assert_true(ok);
     g_assert_cmpuint(clipium_store_count(store), ==, 1);
 
-    ClipiumEntry *loaded = clipium_store_get(store, 1);
+    g_autoptr(ClipiumEntry) loaded = clipium_store_get(store, 1);
     g_assert_nonnull(loaded);
     g_assert_cmpstr(loaded->mime_type, ==, "text/plain");
     g_assert_cmpstr(loaded->preview, ==, "test content");
@@ -552,7 +2894,7 @@ test_db_delete(void)
     GBytes *content = g_bytes_new_static("delete me", 9);
     ClipiumEntry entry = {
         .id = 42, .content = content, .mime_type = "text/plain",
-        .preview = "delete me", .hash = "hash42",
+        .preview = "delete me", .hash = test_hash("hash42"),
         .timestamp = g_get_real_time(), .pinned = FALSE, .size = 9,
     };
     clipium_db_save(db, &entry);
@@ -572,6 +2914,88 @@ test_db_delete(void)
     g_unlink(path);
 }
 
+static void
+test_db_delete_many(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+
+    GBytes *content = g_bytes_new_static("x", 1);
+    for (guint64 id = 1; id <= 5; id++) {
+        g_autofree char *text = g_strdup_printf("row %" G_GUINT64_FORMAT, id);
+        ClipiumEntry entry = {
+            .id = id, .content = content, .mime_type = "text/plain",
+            .preview = text, .hash = test_hash(text),
+            .timestamp = g_get_real_time(), .pinned = FALSE, .size = 1,
+        };
+        clipium_db_save(db, &entry);
+    }
+
+    const guint64 ids[] = { 1, 3, 5, 99 };
+    clipium_db_delete_async(db, ids, G_N_ELEMENTS(ids));
+    g_assert_true(clipium_db_flush(db, 0));
+
+    ClipiumStore *store = clipium_store_new(100);
+    clipium_db_load_all(db, store);
+    g_assert_cmpuint(clipium_store_count(store), ==, 2);
+    g_assert_true(store_has(store, 2));
+    g_assert_true(store_has(store, 4));
+
+    g_autofree char *path = g_strdup(db->path);
+    g_bytes_unref(content);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
+/* Writes queued while the writer is held up commit together, in order */
+static void
+test_db_writer(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+
+    /* Holding the connection lock stalls the writer, so the saves pile up */
+    GBytes *content = g_bytes_new_static("x", 1);
+    g_mutex_lock(&db->lock);
+    for (guint64 id = 1; id <= 1000; id++) {
+        g_autofree char *text = g_strdup_printf("queued %" G_GUINT64_FORMAT, id);
+        ClipiumHash hash = test_hash(text);
+        ClipiumEntry *entry = clipium_entry_new(id, content, "text/plain", text, &hash,
+                                                (gint64)id, FALSE, 1);
+        clipium_db_save_async(db, entry);
+        clipium_entry_unref(entry);
+    }
+    const guint64 gone = 7;
+    clipium_db_delete_async(db, &gone, 1);
+    g_assert_false(clipium_db_flush(db, 1000));
+    g_mutex_unlock(&db->lock);
+    g_assert_true(clipium_db_flush(db, 0));
+
+    /* At most the one the writer took before the rest queued, then two
+     * full batches */
+    guint64 batches, ops;
+    clipium_db_writer_stats(db, &batches, &ops);
+    g_assert_cmpuint(ops, ==, 1001);
+    g_assert_cmpuint(batches, <=, 3);
+
+    ClipiumStore *store = clipium_store_new(2000);
+    g_assert_true(clipium_db_load_all(db, store));
+    g_assert_cmpuint(clipium_store_count(store), ==, 999);
+    g_assert_false(store_has(store, 7));
+    g_assert_true(store_has(store, 1000));
+
+    /* The synchronous calls wait for their own result */
+    g_assert_true(clipium_db_delete(db, 1000));
+    g_assert_false(clipium_db_delete(db, 1000));
+
+    g_autofree char *path = g_strdup(db->path);
+    g_bytes_unref(content);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
 static void
 test_db_clear(void)
 {
@@ -581,10 +3005,10 @@ test_db_clear(void)
     GBytes *c1 = g_bytes_new_static("aaa", 3);
     GBytes *c2 = g_bytes_new_static("bbb", 3);
     ClipiumEntry e1 = { .id = 1, .content = c1, .mime_type = "text/plain",
-                         .preview = "aaa", .hash = "h1",
+                         .preview = "aaa", .hash = test_hash("h1"),
                          .timestamp = 1, .pinned = FALSE, .size = 3 };
     ClipiumEntry e2 = { .id = 2, .content = c2, .mime_type = "text/plain",
-                         .preview = "bbb", .hash = "h2",
+                         .preview = "bbb", .hash = test_hash("h2"),
                          .timestamp = 2, .pinned = FALSE, .size = 3 };
     clipium_db_save(db, &e1);
     clipium_db_save(db, &e2);
@@ -613,7 +3037,7 @@ test_db_update_pin(void)
     GBytes *content = g_bytes_new_static("pin test", 8);
     ClipiumEntry entry = {
         .id = 10, .content = content, .mime_type = "text/plain",
-        .preview = "pin test", .hash = "pinhash",
+        .preview = "pin test", .hash = test_hash("pinhash"),
         .timestamp = g_get_real_time(), .pinned = FALSE, .size = 8,
     };
     clipium_db_save(db, &entry);
@@ -624,7 +3048,7 @@ test_db_update_pin(void)
     /* Reload and verify pinned status */
     ClipiumStore *store = clipium_store_new(100);
     clipium_db_load_all(db, store);
-    ClipiumEntry *loaded = clipium_store_get(store, 10);
+    g_autoptr(ClipiumEntry) loaded = clipium_store_get(store, 10);
     g_assert_nonnull(loaded);
     g_assert_true(loaded->pinned);
 
@@ -635,6 +3059,55 @@ test_db_update_pin(void)
     g_unlink(path);
 }
 
+static void
+test_db_usage(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+
+    ClipiumStore *store = clipium_store_new(100);
+    clipium_store_set_journal(store, TRUE);
+    guint64 used = store_add_text(store, "used often");
+    guint64 fresh = store_add_text(store, "fresh copy");
+    clipium_db_persist(db, store);
+
+    /* As the popup and IPC do after a paste or fetch */
+    ClipiumUsage usage;
+    for (guint i = 0; i < 2; i++) {
+        g_assert_true(clipium_store_touch(store, used));
+        g_assert_cmpuint(clipium_db_persist(db, store), ==, 1);
+    }
+    g_assert_true(clipium_store_get_usage(store, used, &usage));
+    g_assert_true(clipium_db_flush(db, 0));
+
+    ClipiumStore *loaded = clipium_store_new(100);
+    g_assert_true(clipium_db_load_metadata(db, loaded));
+    clipium_db_wait_indexed(db);
+    ClipiumUsage reloaded;
+    g_assert_true(clipium_store_get_usage(loaded, used, &reloaded));
+    g_assert_cmpuint(reloaded.hits, ==, 2);
+    g_assert_cmpint(reloaded.last_used, ==, usage.last_used);
+    g_assert_cmpfloat(reloaded.frecency, ==, usage.frecency);
+
+    /* Never-used rows start from their copy time */
+    g_assert_true(clipium_store_get_usage(loaded, fresh, &reloaded));
+    g_assert_cmpuint(reloaded.hits, ==, 0);
+    g_autoptr(ClipiumEntry) e = clipium_store_get(loaded, fresh);
+    g_assert_cmpint(reloaded.last_used, ==, e->timestamp);
+    g_assert_cmpfloat(reloaded.frecency, ==, clipium_frecency_add(0, e->timestamp));
+
+    GArray *frecent = clipium_store_list_frecent(loaded, 10);
+    g_assert_cmpuint(frecent->len, ==, 2);
+    g_assert_cmpuint(g_array_index(frecent, ClipiumEntry *, 0)->id, ==, used);
+    g_array_free(frecent, TRUE);
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_store_free(store);
+    clipium_store_free(loaded);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
 static void
 test_db_roundtrip_content(void)
 {
@@ -646,14 +3119,14 @@ test_db_roundtrip_content(void)
     GBytes *content = g_bytes_new(blob, sizeof(blob));
     ClipiumEntry entry = {
         .id = 7, .content = content, .mime_type = "application/octet-stream",
-        .preview = "[application/octet-stream 15B]", .hash = "blobhash",
+        .preview = "[application/octet-stream 15B]", .hash = test_hash("blobhash"),
         .timestamp = 1234567890, .pinned = TRUE, .size = sizeof(blob),
     };
     clipium_db_save(db, &entry);
 
     ClipiumStore *store = clipium_store_new(100);
     clipium_db_load_all(db, store);
-    ClipiumEntry *loaded = clipium_store_get(store, 7);
+    g_autoptr(ClipiumEntry) loaded = clipium_store_get(store, 7);
     g_assert_nonnull(loaded);
 
     /* Verify binary content roundtrip */
@@ -671,6 +3144,370 @@ test_db_roundtrip_content(void)
     g_unlink(path);
 }
 
+/* Insert n rows straight through SQLite in one transaction */
+static void
+populate_db(ClipiumDb *db, guint n)
+{
+    sqlite3_exec(db->db, "BEGIN;", NULL, NULL, NULL);
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db->db,
+        "INSERT INTO clips (id, content, mime_type, hash, preview, timestamp, pinned, size) "
+        "VALUES (?, ?, 'text/plain', ?, ?, ?, 0, ?);", -1, &stmt, NULL);
+
+    for (guint i = 1; i <= n; i++) {
+        char text[32];
+        g_snprintf(text, sizeof(text), "clip number %u", i);
+        ClipiumHash hash = test_hash(text);
+        sqlite3_bind_int64(stmt, 1, i);
+        sqlite3_bind_blob(stmt, 2, text, (int)strlen(text), SQLITE_TRANSIENT);
+        sqlite3_bind_blob(stmt, 3, hash.bytes, CLIPIUM_HASH_LEN, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, text, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 5, i);
+        sqlite3_bind_int64(stmt, 6, (sqlite3_int64)strlen(text));
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db->db, "COMMIT;", NULL, NULL, NULL);
+}
+
+static double
+time_load_all(guint n)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+    populate_db(db, n);
+
+    ClipiumStore *store = clipium_store_new(n);
+    g_test_timer_start();
+    gboolean ok = clipium_db_load_all(db, store);
+    double elapsed = g_test_timer_elapsed();
+    g_assert_true(ok);
+    g_assert_cmpuint(clipium_store_count(store), ==, n);
+
+    /* Newest row (highest timestamp) must come first */
+    GArray *list = clipium_store_list(store, 1, 0);
+    g_assert_cmpuint(g_array_index(list, ClipiumEntry *, 0)->id, ==, n);
+    g_array_free(list, TRUE);
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+    return elapsed;
+}
+
+/* One bulk load: the rows go in newest first, and the lookup tables are
+ * built and the change published once for all of them */
+static void
+test_db_load_bulk(void)
+{
+    const guint n = 2000;
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+    populate_db(db, n);
+
+    ClipiumStore *store = clipium_store_new(n);
+    gint generation = g_atomic_int_get(&store->generation);
+    g_assert_true(clipium_db_load_all(db, store));
+    g_assert_cmpint(g_atomic_int_get(&store->generation), ==, generation + 1);
+    g_assert_cmpuint(clipium_store_count(store), ==, n);
+    g_assert_cmpuint(g_hash_table_size(store->by_id), ==, n);
+    g_assert_cmpuint(g_hash_table_size(store->by_hash), ==, n);
+
+    GArray *list = clipium_store_list(store, n, 0);
+    g_assert_cmpuint(list->len, ==, n);
+    for (guint i = 0; i < list->len; i++)
+        g_assert_cmpuint(g_array_index(list, ClipiumEntry *, i)->id, ==, n - i);
+    g_array_free(list, TRUE);
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
+static void
+test_db_load_scaling(void)
+{
+    static const guint sizes[] = { 1000, 10000, 100000 };
+    double per_row[G_N_ELEMENTS(sizes)];
+
+    /* 100k rows and a timing comparison: only when asked for */
+    if (!g_test_perf()) {
+        g_test_skip("timing test, run with -m perf");
+        return;
+    }
+
+    for (guint i = 0; i < G_N_ELEMENTS(sizes); i++) {
+        double elapsed = time_load_all(sizes[i]);
+        per_row[i] = elapsed / sizes[i];
+        g_test_message("load_all %6u rows: %8.2f ms (%.2f us/row)",
+                       sizes[i], elapsed * 1000.0, per_row[i] * 1e6);
+    }
+
+    /* Linear load keeps per-row cost flat; quadratic would grow it 10x per step */
+    g_assert_cmpfloat(per_row[2], <, per_row[1] * 5.0 + 2e-6);
+}
+
+static GBytes *
+db_content_loader(guint64 id, gpointer user_data)
+{
+    return clipium_db_load_content(user_data, id);
+}
+
+static void
+test_db_load_metadata(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+    populate_db(db, 3 * CLIPIUM_DB_INDEX_CHUNK);
+    sqlite3_exec(db->db, "UPDATE clips SET preview = 'short' WHERE id = 3;", NULL, NULL, NULL);
+
+    ClipiumStore *store = clipium_store_new(1000);
+    clipium_store_set_content_loader(store, db_content_loader, db);
+    g_assert_true(clipium_db_load_metadata(db, store));
+    g_assert_cmpuint(clipium_store_count(store), ==, 3 * CLIPIUM_DB_INDEX_CHUNK);
+    g_assert_cmpuint(clipium_store_bytes(store), ==, 0);
+
+    /* Text is indexed in the background, oldest rows last; then search
+     * sees past the preview */
+    clipium_db_wait_indexed(db);
+    GArray *results = clipium_store_search(store, "number 3", 1000);
+    gboolean found = FALSE;
+    for (guint i = 0; i < results->len; i++)
+        found |= g_array_index(results, ClipiumEntry *, i)->id == 3;
+    g_assert_true(found);
+    g_array_free(results, TRUE);
+
+    g_autoptr(ClipiumEntry) e = clipium_store_get(store, 7);
+    g_assert_null(e->content);
+    g_assert_cmpstr(e->preview, ==, "clip number 7");
+
+    g_autoptr(GBytes) content = clipium_store_get_content(store, e);
+    g_assert_nonnull(content);
+    g_assert_cmpmem(g_bytes_get_data(content, NULL), g_bytes_get_size(content),
+                    "clip number 7", 13);
+
+    g_assert_null(clipium_db_load_content(db, 9999));
+
+    /* Closing stops an indexing still under way; the store outlives it */
+    ClipiumStore *again = clipium_store_new(1000);
+    g_assert_true(clipium_db_load_metadata(db, again));
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_db_close(db);
+    clipium_store_free(again);
+    clipium_store_free(store);
+    g_unlink(path);
+}
+
+static void
+test_db_migrate_hex_hash(void)
+{
+    g_autofree char *path = g_strdup_printf("%s/clipium-test-%d.db", g_get_tmp_dir(), g_random_int());
+
+    /* A version-0 database: TEXT column holding hex SHA-256 digests */
+    sqlite3 *raw;
+    g_assert_cmpint(sqlite3_open(path, &raw), ==, SQLITE_OK);
+    g_assert_cmpint(sqlite3_exec(raw,
+        "CREATE TABLE clips (id INTEGER PRIMARY KEY, content BLOB NOT NULL,"
+        " mime_type TEXT NOT NULL, hash TEXT UNIQUE NOT NULL, preview TEXT,"
+        " timestamp INTEGER NOT NULL, pinned INTEGER DEFAULT 0, size INTEGER NOT NULL);"
+        "INSERT INTO clips VALUES (1, CAST('older' AS BLOB), 'text/plain',"
+        " '2d7f1808f3b56f3d1a3bc8d2d1bbd0b6b2d1bbd0b6b2d1bbd0b6b2d1bbd0b6b2', 'older', 100, 1, 5);"
+        "INSERT INTO clips VALUES (2, CAST('newer' AS BLOB), 'text/plain',"
+        " 'a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1a1c1', 'newer', 200, 0, 5);",
+        NULL, NULL, NULL), ==, SQLITE_OK);
+    sqlite3_close(raw);
+
+    ClipiumDb *db = clipium_db_open(path);
+    g_assert_true(clipium_db_init(db));
+
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db->db, "PRAGMA user_version;", -1, &stmt, NULL);
+    g_assert_cmpint(sqlite3_step(stmt), ==, SQLITE_ROW);
+    g_assert_cmpint(sqlite3_column_int(stmt, 0), ==, 3);
+    sqlite3_finalize(stmt);
+
+    ClipiumStore *store = clipium_store_new(100);
+    g_assert_true(clipium_db_load_all(db, store));
+    g_assert_cmpuint(clipium_store_count(store), ==, 2);
+
+    g_autoptr(ClipiumEntry) older = clipium_store_get(store, 1);
+    ClipiumHash expected = test_hash("older");
+    g_assert_true(clipium_hash_equal(&older->hash, &expected));
+    g_assert_true(older->pinned);
+
+    /* Dedup works against migrated rows */
+    GBytes *again = g_bytes_new_static("newer", 5);
+    g_assert_cmpuint(clipium_store_add(store, again, "text/plain"), ==, 0);
+    g_assert_cmpuint(clipium_store_count(store), ==, 2);
+    g_bytes_unref(again);
+
+    /* Opening again is a no-op */
+    clipium_db_close(db);
+    db = clipium_db_open(path);
+    g_assert_true(clipium_db_init(db));
+    ClipiumStore *store2 = clipium_store_new(100);
+    g_assert_true(clipium_db_load_all(db, store2));
+    g_assert_cmpuint(clipium_store_count(store2), ==, 2);
+
+    clipium_store_free(store);
+    clipium_store_free(store2);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
+static void
+test_db_migrate_usage(void)
+{
+    g_autofree char *path = g_strdup_printf("%s/clipium-test-%d.db", g_get_tmp_dir(), g_random_int());
+
+    /* A version-1 database: binary hashes, no usage columns */
+    ClipiumHash hash = test_hash("kept");
+    sqlite3 *raw;
+    sqlite3_stmt *stmt;
+    g_assert_cmpint(sqlite3_open(path, &raw), ==, SQLITE_OK);
+    g_assert_cmpint(sqlite3_exec(raw,
+        "CREATE TABLE clips (id INTEGER PRIMARY KEY, content BLOB NOT NULL,"
+        " mime_type TEXT NOT NULL, hash BLOB UNIQUE NOT NULL, preview TEXT,"
+        " timestamp INTEGER NOT NULL, pinned INTEGER DEFAULT 0, size INTEGER NOT NULL);"
+        "PRAGMA user_version = 1;", NULL, NULL, NULL), ==, SQLITE_OK);
+    sqlite3_prepare_v2(raw, "INSERT INTO clips VALUES (7, CAST('kept' AS BLOB), 'text/plain',"
+                       " ?, 'kept', 100, 0, 4);", -1, &stmt, NULL);
+    sqlite3_bind_blob(stmt, 1, hash.bytes, CLIPIUM_HASH_LEN, SQLITE_STATIC);
+    g_assert_cmpint(sqlite3_step(stmt), ==, SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    sqlite3_close(raw);
+
+    ClipiumDb *db = clipium_db_open(path);
+    g_assert_true(clipium_db_init(db));
+    sqlite3_prepare_v2(db->db, "PRAGMA user_version;", -1, &stmt, NULL);
+    g_assert_cmpint(sqlite3_step(stmt), ==, SQLITE_ROW);
+    g_assert_cmpint(sqlite3_column_int(stmt, 0), ==, 3);
+    sqlite3_finalize(stmt);
+
+    /* The migrated row loads unused, and takes uses from then on */
+    ClipiumStore *store = clipium_store_new(100);
+    g_assert_true(clipium_db_load_all(db, store));
+    g_assert_cmpuint(clipium_store_count(store), ==, 1);
+    ClipiumUsage usage;
+    g_assert_true(clipium_store_get_usage(store, 7, &usage));
+    g_assert_cmpuint(usage.hits, ==, 0);
+    g_assert_cmpint(usage.last_used, ==, 100);
+    clipium_store_set_journal(store, TRUE);
+    g_assert_true(clipium_store_touch(store, 7));
+    g_assert_true(clipium_store_get_usage(store, 7, &usage));
+    clipium_db_persist(db, store);
+    g_assert_true(clipium_db_flush(db, 0));
+
+    ClipiumStore *reloaded = clipium_store_new(100);
+    g_assert_true(clipium_db_load_all(db, reloaded));
+    ClipiumUsage loaded;
+    g_assert_true(clipium_store_get_usage(reloaded, 7, &loaded));
+    g_assert_cmpuint(loaded.hits, ==, 1);
+    g_assert_cmpint(loaded.last_used, ==, usage.last_used);
+    g_assert_cmpfloat(loaded.frecency, ==, usage.frecency);
+
+    clipium_store_free(reloaded);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
+static void
+db_archive_search(const char *query, guint limit, GArray *results, gpointer user_data)
+{
+    clipium_db_search_archive(user_data, query, limit, results);
+}
+
+static GBytes *
+db_archive_content(guint64 id, gpointer user_data)
+{
+    return clipium_db_load_content(user_data, id);
+}
+
+static void
+test_db_archive(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+    g_assert_true(db->archive);
+
+    /* As the IPC ingest does: persist each add and what it evicts */
+    ClipiumStore *store = clipium_store_new(3);
+    clipium_store_set_content_loader(store, db_archive_content, db);
+    clipium_store_set_archive(store, db_archive_search, db);
+    clipium_store_set_journal(store, TRUE);
+    static const char *texts[] = { "alpha release notes", "beta \"quoted\" draft",
+                                   "gamma", "delta", "epsilon" };
+    guint64 ids[G_N_ELEMENTS(texts)];
+    for (guint i = 0; i < G_N_ELEMENTS(texts); i++) {
+        ids[i] = store_add_text(store, texts[i]);
+        clipium_db_persist(db, store);
+    }
+    g_assert_true(clipium_db_flush(db, 0));
+    g_assert_false(store_has(store, ids[0]));
+
+    /* Search falls through to the archive, and its entries read their
+     * content from disk */
+    GArray *results = clipium_store_search(store, "release ALPHA", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    ClipiumEntry *archived = g_array_index(results, ClipiumEntry *, 0);
+    g_assert_cmpuint(archived->id, ==, ids[0]);
+    g_assert_cmpstr(archived->preview, ==, texts[0]);
+    g_autoptr(GBytes) content = clipium_store_get_content(store, archived);
+    g_assert_cmpmem(g_bytes_get_data(content, NULL), g_bytes_get_size(content),
+                    texts[0], strlen(texts[0]));
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "beta \"quoted\"", 10);  /* quotes pass through */
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+
+    /* Live entries come first, and short queries skip the archive */
+    results = clipium_store_search(store, "eta", 10);
+    g_assert_cmpuint(results->len, ==, 2);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 0)->id, ==, ids[3]);
+    g_assert_cmpuint(g_array_index(results, ClipiumEntry *, 1)->id, ==, ids[1]);
+    g_array_free(results, TRUE);
+    results = clipium_store_search(store, "ta", 10);
+    g_assert_cmpuint(results->len, ==, 1);
+    g_array_free(results, TRUE);
+
+    g_autoptr(ClipiumEntry) by_id = clipium_db_get_archived(db, ids[1]);
+    g_assert_nonnull(by_id);
+    g_assert_null(clipium_db_get_archived(db, ids[4]));
+
+    /* Only live rows load */
+    ClipiumStore *loaded = clipium_store_new(100);
+    g_assert_true(clipium_db_load_metadata(db, loaded));
+    g_assert_cmpuint(clipium_store_count(loaded), ==, 3);
+    clipium_db_wait_indexed(db);
+    clipium_store_free(loaded);
+
+    /* Deleting an archived row, or copying its content again, takes it
+     * out of the index */
+    g_assert_true(clipium_db_delete(db, ids[0]));
+    g_assert_false(clipium_db_delete(db, ids[0]));
+    g_autoptr(GArray) hits = g_array_new(FALSE, FALSE, sizeof(ClipiumEntry *));
+    clipium_db_search_archive(db, "alpha", 10, hits);
+    g_assert_cmpuint(hits->len, ==, 0);
+    ClipiumEntry again = *by_id;
+    again.id = 100;
+    again.content = g_bytes_new_static(texts[1], strlen(texts[1]));
+    clipium_db_save(db, &again);
+    g_bytes_unref(again.content);
+    clipium_db_search_archive(db, "quoted", 10, hits);
+    g_assert_cmpuint(hits->len, ==, 0);
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
 /* ======== Store + DB Integration ======== */
 
 static void
@@ -687,8 +3524,8 @@ test_integration_store_db_roundtrip(void)
     guint64 id1 = clipium_store_add(store1, c1, "text/plain");
     guint64 id2 = clipium_store_add(store1, c2, "text/plain");
 
-    ClipiumEntry *e1 = clipium_store_get(store1, id1);
-    ClipiumEntry *e2 = clipium_store_get(store1, id2);
+    g_autoptr(ClipiumEntry) e1 = clipium_store_get(store1, id1);
+    g_autoptr(ClipiumEntry) e2 = clipium_store_get(store1, id2);
     clipium_db_save(db, e1);
     clipium_db_save(db, e2);
 
@@ -697,8 +3534,8 @@ test_integration_store_db_roundtrip(void)
     clipium_db_load_all(db, store2);
     g_assert_cmpuint(clipium_store_count(store2), ==, 2);
 
-    ClipiumEntry *loaded1 = clipium_store_get(store2, id1);
-    ClipiumEntry *loaded2 = clipium_store_get(store2, id2);
+    g_autoptr(ClipiumEntry) loaded1 = clipium_store_get(store2, id1);
+    g_autoptr(ClipiumEntry) loaded2 = clipium_store_get(store2, id2);
     g_assert_nonnull(loaded1);
     g_assert_nonnull(loaded2);
     g_assert_cmpstr(loaded1->preview, ==, "first item");
@@ -713,6 +3550,297 @@ test_integration_store_db_roundtrip(void)
     g_unlink(path);
 }
 
+static gint64
+db_count_rows(ClipiumDb *db, const char *where)
+{
+    g_autofree char *sql = g_strdup_printf("SELECT COUNT(*) FROM clips WHERE %s;", where);
+    sqlite3_stmt *stmt;
+    gint64 n = -1;
+    g_mutex_lock(&db->lock);
+    if (sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            n = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    g_mutex_unlock(&db->lock);
+    return n;
+}
+
+/* Every store change reaches the database through the journal, and the
+ * table stays within the history size */
+static void
+test_integration_store_db_journal(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+    clipium_db_set_history(db, 5);
+
+    ClipiumStore *store = clipium_store_new(3);
+    store_add_text(store, "before the journal");
+    clipium_store_set_journal(store, TRUE);
+
+    guint64 a = store_add_text(store, "journal a");
+    guint64 b = store_add_text(store, "journal b");
+    guint64 c = store_add_text(store, "journal c");  /* evicts the first */
+    clipium_store_pin(store, a, TRUE);
+    clipium_store_touch(store, b);
+    clipium_store_delete(store, c);
+    /* 3 adds, an eviction, a pin, a use and a delete */
+    g_assert_cmpuint(clipium_db_persist(db, store), ==, 7);
+    g_assert_cmpuint(clipium_db_persist(db, store), ==, 0);
+
+    /* Copying b again moves its row to the top as well */
+    g_usleep(2000);
+    g_assert_cmpuint(store_add_text(store, "journal b"), ==, 0);
+    clipium_db_persist(db, store);
+    g_assert_true(clipium_db_flush(db, 0));
+
+    ClipiumStore *loaded = clipium_store_new(100);
+    g_assert_true(clipium_db_load_all(db, loaded));
+    g_assert_cmpuint(clipium_store_count(loaded), ==, 2);
+    g_autoptr(ClipiumEntry) pinned = clipium_store_get(loaded, a);
+    g_assert_true(pinned->pinned);
+    g_autoptr(ClipiumEntry) bumped = clipium_store_get(store, b);
+    g_autoptr(ClipiumEntry) reloaded = clipium_store_get(loaded, b);
+    g_assert_cmpint(reloaded->timestamp, ==, bumped->timestamp);
+    ClipiumUsage usage;
+    g_assert_true(clipium_store_get_usage(loaded, b, &usage));
+    g_assert_cmpuint(usage.hits, ==, 2);
+    clipium_store_free(loaded);
+
+    /* Evictions archive; the archive gives up its oldest rows */
+    guint64 last = 0;
+    for (guint i = 0; i < 10; i++) {
+        g_autofree char *text = g_strdup_printf("filler %u", i);
+        g_autoptr(GBytes) content = g_bytes_new(text, strlen(text));
+        last = clipium_store_add(store, content, "text/plain");
+    }
+    clipium_db_persist(db, store);
+    g_assert_true(clipium_db_flush(db, 0));
+    g_assert_cmpint(db_count_rows(db, "archived = 0"), ==, 3);
+    g_assert_cmpint(db_count_rows(db, "1"), ==, 5);
+    g_assert_cmpint(db_count_rows(db, "archived = 1 AND preview LIKE 'filler 7'"), ==, 1);
+
+    /* Compaction catches up with a smaller cap; pinned rows stay live */
+    g_assert_cmpuint(clipium_db_compact(db, 2), ==, 1);
+    g_assert_cmpint(db_count_rows(db, "archived = 0"), ==, 2);
+    g_assert_cmpint(db_count_rows(db, "archived = 0 AND pinned"), ==, 1);
+    clipium_db_set_history(db, 0);
+    g_assert_cmpuint(clipium_db_compact(db, 0), ==, 0);
+
+    /* Archived rows keep their IDs from being handed out again */
+    g_assert_true(clipium_db_delete(db, last));
+    loaded = clipium_store_new(100);
+    g_assert_true(clipium_db_load_all(db, loaded));
+    g_assert_cmpuint(clipium_store_count(loaded), ==, 1);
+    g_assert_cmpuint(store_add_text(loaded, "fresh"), >, last - 1);
+    clipium_store_free(loaded);
+
+    /* A clear drops whatever was pending and empties the table */
+    store_add_text(store, "about to go");
+    clipium_store_clear(store);
+    g_assert_cmpuint(clipium_db_persist(db, store), ==, 1);
+    g_assert_true(clipium_db_flush(db, 0));
+    g_assert_cmpint(db_count_rows(db, "1"), ==, 0);
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
+typedef struct {
+    ClipiumDb    *db;
+    ClipiumStore *store;
+    guint         thread;
+} PersistRace;
+
+/* Add, persist, delete, persist: with another thread doing the same, each
+ * persist may carry the other's changes too */
+static gpointer
+persist_race_thread(gpointer data)
+{
+    PersistRace *race = data;
+    for (guint i = 0; i < 300; i++) {
+        g_autofree char *text = g_strdup_printf("race %u %u", race->thread, i);
+        g_autoptr(GBytes) content = g_bytes_new(text, strlen(text));
+        guint64 id = clipium_store_add(race->store, content, "text/plain");
+        clipium_db_persist(race->db, race->store);
+        clipium_store_delete(race->store, id);
+        clipium_db_persist(race->db, race->store);
+    }
+    return NULL;
+}
+
+/* Changes taken from the journal are queued in the order they were taken,
+ * so a delete never lands before the save it undoes */
+static void
+test_integration_store_db_persist_threads(void)
+{
+    ClipiumDb *db = create_temp_db();
+    g_assert_nonnull(db);
+    ClipiumStore *store = clipium_store_new(100);
+    clipium_store_set_journal(store, TRUE);
+
+    PersistRace races[4] = { { db, store, 0 }, { db, store, 1 }, { db, store, 2 }, { db, store, 3 } };
+    GThread *threads[G_N_ELEMENTS(races)];
+    for (guint i = 0; i < G_N_ELEMENTS(races); i++)
+        threads[i] = g_thread_new("persist-race", persist_race_thread, &races[i]);
+    for (guint i = 0; i < G_N_ELEMENTS(races); i++)
+        g_thread_join(threads[i]);
+
+    g_assert_true(clipium_db_flush(db, 0));
+    g_assert_cmpuint(clipium_store_count(store), ==, 0);
+    g_assert_cmpint(db_count_rows(db, "1"), ==, 0);
+
+    g_autofree char *path = g_strdup(db->path);
+    clipium_store_free(store);
+    clipium_db_close(db);
+    g_unlink(path);
+}
+
+/* ======== IPC Tests ======== */
+
+/* The server accepts on the main context, so the client runs on a thread of
+ * its own while the test spins the loop */
+typedef struct {
+    const char *socket_path;
+    const char *command;
+    GPtrArray  *responses;  /* char*, in the order they arrived */
+    GMainLoop  *loop;
+} IpcCall;
+
+static void
+ipc_call_collect(const char *json, gpointer user_data)
+{
+    IpcCall *call = user_data;
+    g_ptr_array_add(call->responses, g_strdup(json));
+}
+
+static gboolean
+ipc_call_quit(gpointer data)
+{
+    g_main_loop_quit(data);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer
+ipc_call_thread(gpointer data)
+{
+    IpcCall *call = data;
+    clipium_ipc_send_command_stream(call->socket_path, call->command, ipc_call_collect, call);
+    g_idle_add(ipc_call_quit, call->loop);
+    return NULL;
+}
+
+/* Every response to `command`, last one last */
+static GPtrArray *
+ipc_call(const char *socket_path, const char *command)
+{
+    IpcCall call = {
+        .socket_path = socket_path,
+        .command = command,
+        .responses = g_ptr_array_new_with_free_func(g_free),
+        .loop = g_main_loop_new(NULL, FALSE),
+    };
+    GThread *thread = g_thread_new("ipc-client", ipc_call_thread, &call);
+    g_main_loop_run(call.loop);
+    g_thread_join(thread);
+    g_main_loop_unref(call.loop);
+    return call.responses;
+}
+
+static char *
+ipc_socket_path(void)
+{
+    return g_strdup_printf("%s/clipium-test-%u.sock", g_get_tmp_dir(), g_random_int());
+}
+
+static void
+test_ipc_search_get(void)
+{
+    g_autofree char *path = ipc_socket_path();
+    ClipiumStore *store = clipium_store_new(100);
+    guint64 id = store_add_text(store, "hello");
+    store_add_text(store, "world");
+    ClipiumIpc *ipc = clipium_ipc_server_start(path, store, NULL, NULL, NULL);
+    g_assert_nonnull(ipc);
+
+    /* Without "stream", a search answers once, with the content */
+    GPtrArray *responses = ipc_call(path, "{\"cmd\":\"search\",\"query\":\"hel\"}");
+    g_assert_cmpuint(responses->len, ==, 1);
+    const char *json = g_ptr_array_index(responses, 0);
+    g_assert_nonnull(strstr(json, "\"ok\":true,\"count\":1,"));
+    g_assert_nonnull(strstr(json, "\"content\":\"aGVsbG8=\""));
+    g_assert_nonnull(strstr(json, "\"complete\":true"));
+    g_ptr_array_unref(responses);
+
+    responses = ipc_call(path, "{\"cmd\":\"search\",\"query\":\"(\",\"mode\":\"regex\"}");
+    g_assert_nonnull(strstr(g_ptr_array_index(responses, 0), "\"ok\":false"));
+    g_ptr_array_unref(responses);
+
+    /* A fetch has the content and counts as a use */
+    g_autofree char *get = g_strdup_printf("{\"cmd\":\"get\",\"id\":%" G_GUINT64_FORMAT "}", id);
+    responses = ipc_call(path, get);
+    g_assert_cmpuint(responses->len, ==, 1);
+    json = g_ptr_array_index(responses, 0);
+    g_assert_nonnull(strstr(json, "\"ok\":true,\"entry\":"));
+    g_assert_nonnull(strstr(json, "\"content\":\"aGVsbG8=\""));
+    g_ptr_array_unref(responses);
+    ClipiumUsage usage;
+    g_assert_true(clipium_store_get_usage(store, id, &usage));
+    g_assert_cmpuint(usage.hits, ==, 1);
+
+    responses = ipc_call(path, "{\"cmd\":\"get\",\"id\":12345}");
+    g_assert_nonnull(strstr(g_ptr_array_index(responses, 0), "\"error\":\"not found\""));
+    g_ptr_array_unref(responses);
+
+    clipium_store_set_max_bytes(store, 4096);
+    responses = ipc_call(path, "{\"cmd\":\"status\"}");
+    g_assert_nonnull(strstr(g_ptr_array_index(responses, 0), "\"entries\":2,"));
+    g_assert_nonnull(strstr(g_ptr_array_index(responses, 0), "\"max_bytes\":4096,"));
+    g_ptr_array_unref(responses);
+
+    clipium_ipc_server_stop(ipc);
+    clipium_store_free(store);
+}
+
+/* A streamed search sends the best so far between slices, then the final
+ * result, which alone says it is complete */
+static void
+test_ipc_search_stream(void)
+{
+    g_autofree char *path = ipc_socket_path();
+    ClipiumStore *store = clipium_store_new(2000);
+    for (guint i = 0; i < 1000; i++) {
+        g_autofree char *text = g_strdup_printf("entry %u", i);
+        g_autoptr(GBytes) content = g_bytes_new(text, strlen(text));
+        clipium_store_add(store, content, "text/plain");
+    }
+    store->search_slice = 100;
+    store->search_first_usec = 0;
+    store->search_refine_usec = 0;
+    ClipiumIpc *ipc = clipium_ipc_server_start(path, store, NULL, NULL, NULL);
+    g_assert_nonnull(ipc);
+
+    GPtrArray *responses = ipc_call(path, "{\"cmd\":\"search\",\"query\":\"ey\",\"limit\":10,\"stream\":true}");
+    g_assert_cmpuint(responses->len, ==, 10);
+    for (guint i = 0; i < responses->len; i++) {
+        const char *json = g_ptr_array_index(responses, i);
+        g_assert_nonnull(strstr(json, "\"ok\":true,\"count\":10,"));
+        gboolean final = i + 1 == responses->len;
+        g_assert_nonnull(strstr(json, final ? "\"complete\":true" : "\"complete\":false"));
+
+        /* Only the final result carries the content */
+        g_assert_nonnull(strstr(json, "\"preview\":\"entry "));
+        g_assert_true((strstr(json, "\"content\":\"ZW50cnkg") != NULL) == final);
+    }
+    g_ptr_array_unref(responses);
+
+    clipium_ipc_server_stop(ipc);
+    clipium_store_free(store);
+}
+
 /* ======== Main ======== */
 
 int
@@ -729,15 +3857,68 @@ main(int argc, char *argv[])
     g_test_add_func("/store/ordering", test_store_ordering);
     g_test_add_func("/store/eviction", test_store_eviction);
     g_test_add_func("/store/eviction-pinned", test_store_eviction_pinned);
+    g_test_add_func("/store/eviction-unpinned-order", test_store_eviction_unpinned_order);
+    g_test_add_func("/store/eviction-bytes", test_store_eviction_bytes);
+    g_test_add_func("/store/eviction-bytes-pinned-lazy", test_store_eviction_bytes_pinned_lazy);
+    g_test_add_func("/store/eviction-fifo", test_store_eviction_fifo);
+    g_test_add_func("/store/eviction-lru", test_store_eviction_lru);
+    g_test_add_func("/store/eviction-lfu", test_store_eviction_lfu);
+    g_test_add_func("/store/eviction-arc", test_store_eviction_arc);
+    g_test_add_func("/store/access-stats", test_store_access_stats);
+    g_test_add_func("/store/lazy-content", test_store_lazy_content);
+    g_test_add_func("/store/compression", test_store_compression);
     g_test_add_func("/store/delete", test_store_delete);
     g_test_add_func("/store/clear", test_store_clear);
     g_test_add_func("/store/pin", test_store_pin);
     g_test_add_func("/store/list-offset-limit", test_store_list_offset_limit);
     g_test_add_func("/store/search", test_store_search);
+    g_test_add_func("/store/search-full-text", test_store_search_full_text);
+    g_test_add_func("/store/search-full-text-confirm", test_store_search_full_text_confirm);
+    g_test_add_func("/store/search-grep-lazy", test_store_search_grep_lazy);
+    g_test_add_func("/store/search-confirm-reads", test_store_search_confirm_reads);
+    g_test_add_func("/store/index-bytes", test_store_index_bytes);
+    g_test_add_func("/store/search-narrowing", test_store_search_narrowing);
+    g_test_add_func("/store/search-parallel", test_store_search_parallel);
+    g_test_add_func("/store/search-top-k", test_store_search_top_k);
+    g_test_add_func("/store/search-cache", test_store_search_cache);
+    g_test_add_func("/store/touch-generation", test_store_touch_generation);
+    g_test_add_func("/store/match-positions", test_store_match_positions);
+    g_test_add_func("/store/search-unicode", test_store_search_unicode);
+    g_test_add_func("/store/search-filters", test_store_search_filters);
+    g_test_add_func("/store/frecency", test_store_frecency);
+    g_test_add_func("/store/search-typos", test_store_search_typos);
+    g_test_add_func("/store/search-exact", test_store_search_exact);
+    g_test_add_func("/store/search-progressive", test_store_search_progressive);
+    g_test_add_func("/store/snapshot-isolation", test_store_snapshot_isolation);
+    g_test_add_func("/store/snapshot-columns", test_store_snapshot_columns);
+    g_test_add_func("/store/ttl-rules", test_store_ttl_rules);
+    g_test_add_func("/store/ttl-expiry", test_store_ttl_expiry);
+    g_test_add_func("/store/concurrent-readers", test_store_concurrent_readers);
+
+    /* Timer wheel tests */
+    g_test_add_func("/wheel/random", test_wheel_random);
+    g_test_add_func("/wheel/past-deadline", test_wheel_past_deadline);
+
+    /* Trigram index tests */
+    g_test_add_func("/trigram/index-random", test_trigram_index_random);
+
+    /* Typo index tests */
+    g_test_add_func("/typo/distance", test_typo_distance);
+    g_test_add_func("/typo/index-random", test_typo_index_random);
+
+    /* Literal and regex matching tests */
+    g_test_add_func("/grep/literal-random", test_grep_literal_random);
+    g_test_add_func("/grep/mode-split", test_grep_mode_split);
+    g_test_add_func("/grep/regex-cache", test_grep_regex_cache);
+
+    /* Query and attribute index tests */
+    g_test_add_func("/query/parse", test_query_parse);
+    g_test_add_func("/attrs/index-random", test_attr_index);
 
     /* Entry helper tests */
     g_test_add_func("/entry/compute-hash", test_entry_compute_hash);
     g_test_add_func("/entry/compute-hash-deterministic", test_entry_compute_hash_deterministic);
+    g_test_add_func("/entry/compute-hash-streaming", test_entry_compute_hash_streaming);
     g_test_add_func("/entry/make-preview-text", test_entry_make_preview_text);
     g_test_add_func("/entry/make-preview-binary", test_entry_make_preview_binary);
     g_test_add_func("/entry/make-preview-truncates", test_entry_make_preview_truncates);
@@ -753,17 +3934,38 @@ main(int argc, char *argv[])
     g_test_add_func("/fuzzy/null-args", test_fuzzy_match_null_args);
     g_test_add_func("/fuzzy/scoring", test_fuzzy_match_scoring);
     g_test_add_func("/fuzzy/separator-bonus", test_fuzzy_match_separator_bonus);
+    g_test_add_func("/fuzzy/char-mask", test_fuzzy_char_mask);
+    g_test_add_func("/fuzzy/fold", test_fuzzy_fold);
+    g_test_add_func("/fuzzy/prefilter-benchmark", test_fuzzy_prefilter_benchmark);
+    g_test_add_func("/fuzzy/score-optimal", test_fuzzy_score_optimal);
+    g_test_add_func("/fuzzy/score-positions", test_fuzzy_score_positions);
+    g_test_add_func("/fuzzy/score-long-target", test_fuzzy_score_long_target);
 
     /* Database tests */
     g_test_add_func("/db/open-close", test_db_open_close);
     g_test_add_func("/db/save-and-load", test_db_save_and_load);
     g_test_add_func("/db/delete", test_db_delete);
+    g_test_add_func("/db/delete-many", test_db_delete_many);
+    g_test_add_func("/db/writer", test_db_writer);
     g_test_add_func("/db/clear", test_db_clear);
     g_test_add_func("/db/update-pin", test_db_update_pin);
+    g_test_add_func("/db/usage", test_db_usage);
     g_test_add_func("/db/roundtrip-content", test_db_roundtrip_content);
+    g_test_add_func("/db/load-bulk", test_db_load_bulk);
+    g_test_add_func("/db/load-scaling", test_db_load_scaling);
+    g_test_add_func("/db/load-metadata", test_db_load_metadata);
+    g_test_add_func("/db/migrate-hex-hash", test_db_migrate_hex_hash);
+    g_test_add_func("/db/migrate-usage", test_db_migrate_usage);
+    g_test_add_func("/db/archive", test_db_archive);
 
     /* Integration tests */
     g_test_add_func("/integration/store-db-roundtrip", test_integration_store_db_roundtrip);
+    g_test_add_func("/integration/store-db-journal", test_integration_store_db_journal);
+    g_test_add_func("/integration/store-db-persist-threads", test_integration_store_db_persist_threads);
+
+    /* IPC tests */
+    g_test_add_func("/ipc/search-get", test_ipc_search_get);
+    g_test_add_func("/ipc/search-stream", test_ipc_search_stream);
 
     return g_test_run();
 }